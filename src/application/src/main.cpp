@@ -20,7 +20,6 @@ struct transform
 {
 	glm::vec3 position;
 	glm::quat rotation;
-	std::string name;
 };
 
 struct a_device {};
@@ -51,6 +50,7 @@ int main(int argc, char** argv) {
 
 	ecs::registry<
 		ecs::component<transform, 1000>
+		, ecs::component<ecs::name, 1000>
 		, ecs::component<a_device, 2000>
 		// , ecs::component<b_device, 3000>
 		>
@@ -59,27 +59,13 @@ int main(int argc, char** argv) {
 	constexpr const size_t ent_count = 1'000'000;
 	using namespace std::chrono;
 	auto start = high_resolution_clock::now();
-	for(size_t i = 0; i < ent_count; i++)
+	const ecs::prefab testPrefab(transform{glm::vec3(0), glm::identity<glm::quat>()});
+	const auto testEntities = registry.instantiate(testPrefab, ent_count);
+	registry.setNames(testEntities, [](size_t a_index, std::string& r_name)
 	{
-		const std::string name = "value." + std::to_string(i);
-		auto testEntity = registry.createEntity();
-		transform* value = registry.addComponent<transform>(testEntity, glm::vec3(0), glm::identity<glm::quat>(), name);
-		//auto* value = registry.addComponent<a_device>(testEntity);
-		(void) value;
-		/*
-		{
-			transform* value = registry.addComponent<transform>(testEntity);
-			value->name = "value.A";
-		}
-		{
-			transform* value = registry.addComponent<transform>(testEntity);
-			value->name = "value.B";
-		}
-		{
-			transform* value = registry.addComponent<transform>(testEntity, glm::vec3(0), glm::identity<glm::quat>(), "value.C");
-		}
-		*/
-	}
+		r_name += "value.";
+		r_name += std::to_string(a_index);
+	});
 	auto end = high_resolution_clock::now();
 	std::printf("Creating %zu entities took : %.4f ms\n",
 		ent_count,
@@ -95,6 +81,16 @@ int main(int argc, char** argv) {
 		return EXIT_FAILURE;
 	}
 
+	renderer.setFrameUpdate([&registry]()
+	{
+		registry.endFrame();
+	});
+
+	renderer.setRegistryStats([&registry]()
+	{
+		return registry.stats();
+	});
+
 	renderer.run();
 
 	auto& components = registry.getComponentsOfType<transform>();
@@ -0,0 +1,74 @@
+# Measures how long it takes to compile a registry with many component types
+#
+# Usage:
+#   cmake -DCXX_COMPILER=<compiler> -DECS_INCLUDE_DIR=<dir> -DOUTPUT_DIR=<dir>
+#         -DTYPE_COUNTS="16;64;256" -P compile_time_bench.cmake
+#
+# Every generated registry instantiates addComponent and getComponentsOfType
+# for all of its components, this is the worst case for the component lookup.
+
+if(NOT DEFINED TYPE_COUNTS)
+	set(TYPE_COUNTS 16 64 256)
+endif()
+if(NOT DEFINED CXX_FLAGS)
+	set(CXX_FLAGS -std=c++20 -O0 -g)
+endif()
+
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+
+function(generate_registry_source a_count a_path)
+	set(source "#include \"registry.hpp\"\n\n")
+	math(EXPR last "${a_count} - 1")
+	foreach(i RANGE ${last})
+		string(APPEND source "struct bench_component_${i} { int value; };\n")
+	endforeach()
+
+	string(APPEND source "\nusing bench_registry = ecs::registry<\n")
+	foreach(i RANGE ${last})
+		if(i EQUAL last)
+			string(APPEND source "\tecs::component<bench_component_${i}, 1>>;\n")
+		else()
+			string(APPEND source "\tecs::component<bench_component_${i}, 1>,\n")
+		endif()
+	endforeach()
+
+	string(APPEND source "\nvoid bench_registry_usage(bench_registry& a_registry)\n{\n")
+	string(APPEND source "\tecs::entity entity = a_registry.createEntity();\n")
+	foreach(i RANGE ${last})
+		string(APPEND source "\ta_registry.addComponent<bench_component_${i}>(entity, ${i});\n")
+		string(APPEND source "\t(void) a_registry.getComponentsOfType<bench_component_${i}>();\n")
+	endforeach()
+	string(APPEND source "}\n")
+
+	file(WRITE "${a_path}" "${source}")
+endfunction()
+
+# Seconds and microseconds are read by one TIMESTAMP so a reading can not
+# straddle a second boundary, %f needs CMake 3.23
+function(current_time_us a_result)
+	string(TIMESTAMP value "%s%f" UTC)
+	set(${a_result} ${value} PARENT_SCOPE)
+endfunction()
+
+message(STATUS "Registry compile time benchmark (${CXX_COMPILER})")
+foreach(count ${TYPE_COUNTS})
+	set(source_path "${OUTPUT_DIR}/registry_${count}.cpp")
+	set(object_path "${OUTPUT_DIR}/registry_${count}.o")
+	generate_registry_source(${count} "${source_path}")
+
+	current_time_us(start)
+	execute_process(
+		COMMAND ${CXX_COMPILER} ${CXX_FLAGS} -I${ECS_INCLUDE_DIR} -c ${source_path} -o ${object_path}
+		RESULT_VARIABLE result
+		ERROR_VARIABLE errors)
+	current_time_us(end)
+
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "Failed to compile registry with ${count} components:\n${errors}")
+	endif()
+
+	math(EXPR elapsed_ms "(${end} - ${start}) / 1000")
+	file(SIZE "${object_path}" object_size)
+	math(EXPR object_kb "${object_size} / 1024")
+	message(STATUS "  ${count} components -> ${elapsed_ms} ms, object size ${object_kb} KiB")
+endforeach()
@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "registry.hpp"
+
+// Reproducible benchmark of the core registry operations, run it before and
+// after every storage change. Every scenario runs for each component size and
+// page size and reports percentiles over the repetitions
+//
+// Usage: ecs_bench [--count N] [--warmup N] [--repetitions N] [--seed N]
+//                  [--filter text] [--json file]
+//
+// Cases are named scenario/component size/page size, --filter only runs the
+// cases containing the text, for example --filter iterate or --filter /64/
+
+template <size_t Size, int Index>
+struct payload
+{
+	uint32_t value;
+	std::byte padding[Size - sizeof(uint32_t)];
+};
+
+constexpr const size_t c_expectedCount = 1'000'000;
+
+struct options
+{
+	size_t count{1'000'000};
+	int warmup{2};
+	int repetitions{20};
+	uint32_t seed{1};
+	std::string filter;
+	std::string json;
+};
+
+struct result
+{
+	std::string name;
+	const char* scenario;
+	size_t componentSize;
+	size_t pageSize;
+	size_t operations;
+	std::vector<double> samples;
+
+	/// Returns the nearest rank percentile of the sorted samples in milliseconds
+	double percentile(double a_percent) const
+	{
+		const size_t rank = static_cast<size_t>(std::ceil(a_percent / 100.0 * static_cast<double>(samples.size())));
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	}
+
+	double mean() const
+	{
+		double sum = 0.0;
+		for(const double sample : samples)
+		{
+			sum += sample;
+		}
+
+		return sum / static_cast<double>(samples.size());
+	}
+};
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+/// Results are summed into this so no scenario is optimized away
+static volatile size_t s_sink = 0;
+
+template <size_t ComponentSize, size_t PageSize>
+struct bench_case
+{
+	using first = payload<ComponentSize, 0>;
+	using second = payload<ComponentSize, 1>;
+	using registry_type = ecs::registry<
+		ecs::component<first, c_expectedCount, ecs::storage_policy::packed, PageSize>,
+		ecs::component<second, c_expectedCount, ecs::storage_policy::packed, PageSize>>;
+
+	const options& m_options;
+	std::vector<result>& m_results;
+	std::minstd_rand m_random;
+	std::unique_ptr<registry_type> m_registry;
+	std::vector<ecs::entity> m_entities;
+
+	bench_case(const options& a_options, std::vector<result>& r_results)
+		: m_options(a_options)
+		, m_results(r_results)
+		, m_random(a_options.seed)
+	{
+	}
+
+	/// Replace the registry with a new one holding count entities
+	/// @param a_components add first to every entity and second to every other entity
+	void populate(bool a_components)
+	{
+		m_registry.reset();
+		m_registry = std::make_unique<registry_type>();
+		m_entities.clear();
+		for(size_t i = 0; i < m_options.count; i++)
+		{
+			m_entities.push_back(create(a_components && i % 2 == 0));
+		}
+
+		if(!a_components)
+		{
+			return;
+		}
+
+		for(const ecs::entity entity : m_entities)
+		{
+			m_registry->template addComponent<first>(entity, first{1});
+		}
+	}
+
+	ecs::entity create(bool a_second)
+	{
+		const ecs::entity entity = m_registry->createEntity();
+		if(a_second)
+		{
+			m_registry->template addComponent<second>(entity, second{2});
+		}
+
+		return entity;
+	}
+
+	void shuffle()
+	{
+		std::shuffle(m_entities.begin(), m_entities.end(), m_random);
+	}
+
+	/// Time a scenario, prepare runs before every repetition and is not timed
+	/// @param a_run returns the number of operations it performed
+	template <typename Prepare, typename Run>
+	void measure(const char* a_scenario, Prepare&& a_prepare, Run&& a_run)
+	{
+		result current{std::string(a_scenario) + "/" + std::to_string(ComponentSize) + "/" + std::to_string(PageSize),
+			a_scenario, ComponentSize, PageSize, 0, {}};
+		if(current.name.find(m_options.filter) == std::string::npos)
+		{
+			return;
+		}
+
+		for(int i = 0; i < m_options.warmup + m_options.repetitions; i++)
+		{
+			a_prepare();
+			const auto start = std::chrono::high_resolution_clock::now();
+			current.operations = a_run();
+			const double time = elapsed_ms(start);
+			if(i >= m_options.warmup)
+			{
+				current.samples.push_back(time);
+			}
+		}
+
+		std::sort(current.samples.begin(), current.samples.end());
+		std::printf("  %-27s: p50 %9.4f  p90 %9.4f  p99 %9.4f  max %9.4f ms  %7.2f ns/op\n", current.name.c_str(),
+			current.percentile(50), current.percentile(90), current.percentile(99), current.samples.back(),
+			current.percentile(50) * 1'000'000.0 / static_cast<double>(std::max<size_t>(current.operations, 1)));
+		m_results.push_back(std::move(current));
+	}
+
+	void run()
+	{
+		const size_t count = m_options.count;
+		measure("create", [&]() { m_registry.reset(); m_registry = std::make_unique<registry_type>(); }, [&]()
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				s_sink = s_sink + m_registry->createEntity().id();
+			}
+			return count;
+		});
+
+		measure("add", [&]() { populate(false); }, [&]()
+		{
+			for(const ecs::entity entity : m_entities)
+			{
+				m_registry->template addComponent<first>(entity, first{1});
+			}
+			return count;
+		});
+
+		measure("remove", [&]() { populate(true); shuffle(); }, [&]()
+		{
+			for(const ecs::entity entity : m_entities)
+			{
+				m_registry->template removeComponent<first>(entity);
+			}
+			return count;
+		});
+
+		// The iteration scenarios share one populated registry
+		populate(true);
+		measure("iterate_single", []() {}, [&]()
+		{
+			size_t sum = 0;
+			m_registry->template each<first>([&sum](ecs::entity, first& r_value) { sum += r_value.value++; });
+			s_sink = s_sink + sum;
+			return count;
+		});
+
+		measure("iterate_multi", []() {}, [&]()
+		{
+			size_t sum = 0;
+			size_t visited = 0;
+			m_registry->template view<first, second>().each([&](ecs::entity, first& r_first, second& r_second)
+			{
+				sum += r_first.value + r_second.value++;
+				visited++;
+			});
+			s_sink = s_sink + sum;
+			return visited;
+		});
+
+		shuffle();
+		measure("random_access", []() {}, [&]()
+		{
+			size_t sum = 0;
+			for(const ecs::entity entity : m_entities)
+			{
+				sum += m_registry->template getComponent<first>(entity)->value;
+			}
+			s_sink = s_sink + sum;
+			return count;
+		});
+
+		// Replace a tenth of the entities, as spawning and despawning would. Every
+		// repetition starts from a fresh registry so earlier churn does not leave holes
+		measure("churn", [&]() { populate(true); }, [&]()
+		{
+			const size_t replaced = std::max<size_t>(count / 10, 1);
+			for(size_t i = 0; i < replaced; i++)
+			{
+				ecs::entity& entity = m_entities[m_random() % m_entities.size()];
+				m_registry->removeEntity(entity);
+				entity = create(i % 2 == 0);
+				m_registry->template addComponent<first>(entity, first{1});
+			}
+			return replaced;
+		});
+
+		m_registry.reset();
+	}
+};
+
+template <size_t ComponentSize>
+static void run_sizes(const options& a_options, std::vector<result>& r_results)
+{
+	bench_case<ComponentSize, 64>(a_options, r_results).run();
+	bench_case<ComponentSize, 4096>(a_options, r_results).run();
+	bench_case<ComponentSize, ecs::c_defaultPageSize>(a_options, r_results).run();
+}
+
+static bool write_json(const options& a_options, const std::vector<result>& a_results)
+{
+	std::FILE* file = std::fopen(a_options.json.c_str(), "w");
+	if(file == nullptr)
+	{
+		return false;
+	}
+
+	std::fprintf(file, "{\n  \"count\": %zu,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"seed\": %u,\n  \"results\": [",
+		a_options.count, a_options.warmup, a_options.repetitions, a_options.seed);
+	for(size_t i = 0; i < a_results.size(); i++)
+	{
+		const result& current = a_results[i];
+		std::fprintf(file, "%s\n    {\"name\": \"%s\", \"scenario\": \"%s\", \"component_size\": %zu, \"page_size\": %zu, \"operations\": %zu, "
+			"\"min_ms\": %.6f, \"p50_ms\": %.6f, \"p90_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f, \"mean_ms\": %.6f}",
+			i == 0 ? "" : ",", current.name.c_str(), current.scenario, current.componentSize, current.pageSize, current.operations,
+			current.samples.front(), current.percentile(50), current.percentile(90), current.percentile(99), current.samples.back(), current.mean());
+	}
+
+	std::fprintf(file, "\n  ]\n}\n");
+	return std::fclose(file) == 0;
+}
+
+static bool parse(int a_argc, char** a_argv, options& r_options)
+{
+	for(int i = 1; i < a_argc; i++)
+	{
+		const char* value = i + 1 < a_argc ? a_argv[i + 1] : nullptr;
+		if(value == nullptr)
+		{
+			return false;
+		}
+
+		if(std::strcmp(a_argv[i], "--count") == 0)
+		{
+			r_options.count = std::max<size_t>(std::strtoull(value, nullptr, 10), 1);
+		}
+		else if(std::strcmp(a_argv[i], "--warmup") == 0)
+		{
+			r_options.warmup = std::max(std::atoi(value), 0);
+		}
+		else if(std::strcmp(a_argv[i], "--repetitions") == 0)
+		{
+			r_options.repetitions = std::max(std::atoi(value), 1);
+		}
+		else if(std::strcmp(a_argv[i], "--seed") == 0)
+		{
+			r_options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		}
+		else if(std::strcmp(a_argv[i], "--filter") == 0)
+		{
+			r_options.filter = value;
+		}
+		else if(std::strcmp(a_argv[i], "--json") == 0)
+		{
+			r_options.json = value;
+		}
+		else
+		{
+			return false;
+		}
+
+		i++;
+	}
+
+	return true;
+}
+
+int main(int a_argc, char** a_argv)
+{
+	options current;
+	if(!parse(a_argc, a_argv, current))
+	{
+		std::fprintf(stderr, "usage: ecs_bench [--count N] [--warmup N] [--repetitions N] [--seed N] [--filter text] [--json file]\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%zu entities, %d warmup, %d repetitions, seed %u\n", current.count, current.warmup, current.repetitions, current.seed);
+	std::vector<result> results;
+	run_sizes<16>(current, results);
+	run_sizes<64>(current, results);
+	run_sizes<256>(current, results);
+
+	if(!current.json.empty() && !write_json(current, results))
+	{
+		std::fprintf(stderr, "failed to write %s\n", current.json.c_str());
+		return EXIT_FAILURE;
+	}
+
+	return 0;
+}
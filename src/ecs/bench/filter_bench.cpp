@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+
+// Compares a scalar loop collecting matching entities against the columnar
+// predicate filter on 10M rows
+
+struct geodetic
+{
+	double latitude;
+	double longitude;
+	double altitude;
+};
+
+struct velocity
+{
+	double value[3];
+};
+
+constexpr const size_t c_rowCount = 10'000'000;
+constexpr const int c_repetitions = 10;
+
+template <typename Func>
+static void measure(const char* a_name, Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	size_t result = a_func();
+
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		result = a_func();
+	}
+	const double elapsed = static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0;
+	std::printf("  %-28s: %.4f ms (%zu rows)\n", a_name, elapsed / c_repetitions, result);
+}
+
+int main()
+{
+	using bench_registry = ecs::registry<
+		ecs::component<geodetic, c_rowCount>,
+		ecs::component<velocity, c_rowCount>>;
+	auto registry = std::make_unique<bench_registry>();
+
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90, 90);
+	std::uniform_real_distribution<double> longitude(-180, 180);
+	std::uniform_real_distribution<double> altitude(0, 12'000);
+	for(size_t i = 0; i < c_rowCount; i++)
+	{
+		auto entity = registry->createEntity();
+		registry->addComponent<geodetic>(entity, latitude(random), longitude(random), altitude(random));
+		if(i % 2 == 0)
+		{
+			registry->addComponent<velocity>(entity);
+		}
+	}
+
+	std::printf("altitude between 3000 and 4000 meters\n");
+	std::vector<ecs::entity> entities;
+	measure("scalar loop", [&]() {
+		entities.clear();
+		for(auto it = registry->getComponentsOfType<geodetic>().begin(), end = registry->getComponentsOfType<geodetic>().end(); it != end; ++it)
+		{
+			if(it->altitude >= 3000.0 && it->altitude <= 4000.0)
+			{
+				entities.push_back(it.owner());
+			}
+		}
+		return entities.size();
+	});
+
+	ecs::selection selection;
+	const auto altitudeRange = ecs::predicate::between(&geodetic::altitude, 3000.0, 4000.0);
+	measure("filter bitmap", [&]() {
+		registry->filter<geodetic>(altitudeRange, selection);
+		return selection.size();
+	});
+	measure("filter bitmap + count", [&]() {
+		registry->filter<geodetic>(altitudeRange, selection);
+		return selection.count();
+	});
+
+	std::printf("latitude/longitude box\n");
+	measure("scalar loop", [&]() {
+		entities.clear();
+		for(auto it = registry->getComponentsOfType<geodetic>().begin(), end = registry->getComponentsOfType<geodetic>().end(); it != end; ++it)
+		{
+			if(it->latitude >= 50 && it->latitude <= 60 && it->longitude >= 10 && it->longitude <= 20)
+			{
+				entities.push_back(it.owner());
+			}
+		}
+		return entities.size();
+	});
+
+	const auto box = ecs::predicate::all(
+		ecs::predicate::between(&geodetic::latitude, 50.0, 60.0),
+		ecs::predicate::between(&geodetic::longitude, 10.0, 20.0));
+	measure("filter bitmap", [&]() {
+		registry->filter<geodetic>(box, selection);
+		return selection.count();
+	});
+
+	std::printf("reuse of the box selection\n");
+	measure("view<geodetic, velocity>", [&]() {
+		size_t count = 0;
+		registry->view<geodetic, velocity>().each(selection, [&count](ecs::entity, geodetic&, velocity&) { count++; });
+		return count;
+	});
+	measure("selection indices", [&]() {
+		selection.invalidate_indices();
+		return selection.indices().size();
+	});
+	return 0;
+}
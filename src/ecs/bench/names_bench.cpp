@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "registry.hpp"
+
+// Compares entity names stored inside a hot component against names interned
+// in the registry name pool
+
+struct named_transform
+{
+	float position[3];
+	float rotation[4];
+	std::string name;
+};
+
+struct transform
+{
+	float position[3];
+	float rotation[4];
+};
+
+constexpr const size_t c_entityCount = 1'000'000;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+static void bench_inline_names()
+{
+	ecs::registry<ecs::component<named_transform, c_entityCount>> registry;
+
+	size_t heapBytes = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		auto entity = registry.createEntity();
+		auto* value = registry.addComponent<named_transform>(entity, named_transform{{}, {0, 0, 0, 1}, "value." + std::to_string(i)});
+
+		// Strings that do not fit the small string buffer live on the heap
+		if(value->name.capacity() >= sizeof(std::string))
+		{
+			heapBytes += value->name.capacity() + 1;
+		}
+	}
+	const double createMs = elapsed_ms(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	size_t found = 0;
+	for(auto& item : registry.getComponentsOfType<named_transform>())
+	{
+		if(item.name == "value.999999")
+		{
+			found++;
+		}
+	}
+	const double findMs = elapsed_ms(start);
+
+	std::printf("inline std::string\n");
+	std::printf("  create      : %.4f ms\n", createMs);
+	std::printf("  find by name: %.4f ms (linear scan, found %zu)\n", findMs, found);
+	std::printf("  hot bytes   : %zu per entity\n", sizeof(named_transform));
+	std::printf("  name memory : %zu bytes inline + %zu bytes heap\n", sizeof(std::string) * c_entityCount, heapBytes);
+}
+
+static void bench_pooled_names()
+{
+	ecs::registry<
+		ecs::component<transform, c_entityCount>,
+		ecs::component<ecs::name, c_entityCount>> registry;
+
+	char buffer[32];
+	auto start = std::chrono::high_resolution_clock::now();
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		auto entity = registry.createEntity();
+		registry.addComponent<transform>(entity, transform{{}, {0, 0, 0, 1}});
+
+		const int length = std::snprintf(buffer, sizeof(buffer), "value.%zu", i);
+		registry.setName(entity, std::string_view(buffer, length));
+	}
+	const double createMs = elapsed_ms(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	ecs::entity found = registry.findByName("value.999999");
+	const double findMs = elapsed_ms(start);
+
+	std::printf("interned ecs::name\n");
+	std::printf("  create      : %.4f ms\n", createMs);
+	std::printf("  find by name: %.4f ms (hash lookup, entity %zu)\n", findMs, found.id());
+	std::printf("  hot bytes   : %zu per entity\n", sizeof(transform));
+	std::printf("  name memory : %zu bytes components + %zu bytes pool\n", sizeof(ecs::name) * c_entityCount, registry.names().bytes());
+}
+
+int main()
+{
+	bench_inline_names();
+	bench_pooled_names();
+	return 0;
+}
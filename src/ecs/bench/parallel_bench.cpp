@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <execution>
+#include <numeric>
+#include <thread>
+
+#include "registry.hpp"
+
+// Runs standard algorithms over component storage with and without parallel
+// execution policies, and the deterministic reduction with several thread counts
+
+struct altitude
+{
+	double value;
+};
+
+constexpr const size_t c_componentCount = 10'000'000;
+
+template <typename Func>
+static void measure(const char* a_name, Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	double result = a_func();
+
+	constexpr int c_repetitions = 10;
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		result += a_func();
+	}
+	const double elapsed = static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0;
+	std::printf("  %-26s: %.4f ms (checksum %.1f)\n", a_name, elapsed / c_repetitions, result);
+}
+
+int main()
+{
+	ecs::internal::registry_storage<altitude, 1 << 16> storage;
+	for(size_t i = 0; i < c_componentCount; i++)
+	{
+		storage.emplace(ecs::entity{}, static_cast<double>(i % 1000));
+	}
+
+	const auto project = [](const altitude& a_value) { return a_value.value * 0.5; };
+
+	std::printf("transform_reduce over %zu components\n", c_componentCount);
+	measure("for loop", [&]() {
+		double sum = 0;
+		for(const auto& item : storage)
+		{
+			sum += project(item);
+		}
+		return sum;
+	});
+	measure("std::execution::seq", [&]() {
+		return std::transform_reduce(std::execution::seq, storage.begin(), storage.end(), 0.0, std::plus<>{}, project);
+	});
+	measure("std::execution::unseq", [&]() {
+		return std::transform_reduce(std::execution::unseq, storage.begin(), storage.end(), 0.0, std::plus<>{}, project);
+	});
+	measure("std::execution::par", [&]() {
+		return std::transform_reduce(std::execution::par, storage.begin(), storage.end(), 0.0, std::plus<>{}, project);
+	});
+	measure("std::execution::par_unseq", [&]() {
+		return std::transform_reduce(std::execution::par_unseq, storage.begin(), storage.end(), 0.0, std::plus<>{}, project);
+	});
+
+	std::printf("deterministic reduce over %zu components\n", c_componentCount);
+	const auto add = [](double a, double b) { return a + b; };
+	for(size_t threads : {size_t(1), size_t(2), size_t(4), size_t(std::thread::hardware_concurrency())})
+	{
+		ecs::thread_pool pool(threads);
+		char name[32];
+		std::snprintf(name, sizeof(name), "reduce %zu threads", pool.size());
+		measure(name, [&]() {
+			return ecs::internal::evaluate_reduce(storage, pool, 0.0, project, add);
+		});
+		std::printf("    result %a\n", ecs::internal::evaluate_reduce(storage, pool, 0.0, project, add));
+	}
+
+	std::printf("for_each over %zu components\n", c_componentCount);
+	measure("std::execution::seq", [&]() {
+		std::for_each(std::execution::seq, storage.begin(), storage.end(), [](altitude& a_value) { a_value.value += 1.0; });
+		return 0.0;
+	});
+	measure("std::execution::par_unseq", [&]() {
+		std::for_each(std::execution::par_unseq, storage.begin(), storage.end(), [](altitude& a_value) { a_value.value += 1.0; });
+		return 0.0;
+	});
+	return 0;
+}
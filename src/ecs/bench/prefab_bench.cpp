@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "registry.hpp"
+
+// Compares spawning entities with one addComponent call per component
+// against instantiating a prefab
+
+struct transform
+{
+	float position[3];
+	float rotation[4];
+};
+
+struct velocity
+{
+	double value[3];
+};
+
+struct device
+{
+	int channel;
+	bool enabled;
+};
+
+constexpr const size_t c_entityCount = 1'000'000;
+constexpr const int c_repetitions = 5;
+
+using bench_registry = ecs::registry<
+	ecs::component<transform, c_entityCount>,
+	ecs::component<velocity, c_entityCount>,
+	ecs::component<device, c_entityCount>>;
+
+template <typename Func>
+static void measure(const char* a_name, Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	a_func(*std::make_unique<bench_registry>());
+
+	double elapsed = 0;
+	size_t result = 0;
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		// Page allocation is part of the measurement, destruction is not
+		auto registry = std::make_unique<bench_registry>();
+		auto start = high_resolution_clock::now();
+		result = a_func(*registry);
+		elapsed += static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0;
+	}
+	std::printf("  %-28s: %.4f ms (%zu entities)\n", a_name, elapsed / c_repetitions, result);
+}
+
+int main()
+{
+#if defined(__GLIBC__)
+	// Keep freed pages in the heap so every repetition writes to memory that
+	// is already mapped, otherwise page faults dominate both measurements
+	mallopt(M_MMAP_THRESHOLD, 1 << 30);
+	mallopt(M_TRIM_THRESHOLD, 1 << 30);
+#endif
+
+	std::printf("spawning %zu entities with 3 components\n", c_entityCount);
+	measure("addComponent loop", [](bench_registry& a_registry) {
+		for(size_t i = 0; i < c_entityCount; i++)
+		{
+			auto entity = a_registry.createEntity();
+			a_registry.addComponent<transform>(entity, transform{{0, 0, 0}, {0, 0, 0, 1}});
+			a_registry.addComponent<velocity>(entity, velocity{{1, 0, 0}});
+			a_registry.addComponent<device>(entity, 4, true);
+		}
+		return a_registry.getComponentsOfType<transform>().size();
+	});
+
+	const ecs::prefab formation(transform{{0, 0, 0}, {0, 0, 0, 1}}, velocity{{1, 0, 0}}, device{4, true});
+	measure("instantiate", [&formation](bench_registry& a_registry) {
+		return a_registry.instantiate(formation, c_entityCount).size();
+	});
+	measure("instantiate 1000 x 1000", [&formation](bench_registry& a_registry) {
+		for(size_t i = 0; i < 1000; i++)
+		{
+			a_registry.instantiate(formation, c_entityCount / 1000);
+		}
+		return a_registry.getComponentsOfType<transform>().size();
+	});
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "registry.hpp"
+
+// Compares rebuilding the entity lists of 50 systems every frame against
+// cached queries, on 1M entities where a few hundred change per frame
+
+template <int Index>
+struct sensor
+{
+	float value;
+};
+
+constexpr const int c_componentTypes = 10;
+constexpr const int c_queryCount = 50;
+constexpr const size_t c_entityCount = 1'000'000;
+constexpr const size_t c_churnPerFrame = 200;
+constexpr const int c_frames = 20;
+
+using bench_registry = ecs::registry<
+	ecs::component<sensor<0>, c_entityCount>, ecs::component<sensor<1>, c_entityCount>,
+	ecs::component<sensor<2>, c_entityCount>, ecs::component<sensor<3>, c_entityCount>,
+	ecs::component<sensor<4>, c_entityCount>, ecs::component<sensor<5>, c_entityCount>,
+	ecs::component<sensor<6>, c_entityCount>, ecs::component<sensor<7>, c_entityCount>,
+	ecs::component<sensor<8>, c_entityCount>, ecs::component<sensor<9>, c_entityCount>>;
+
+// Query number Q uses the component pair (first, second), every pair is unique
+constexpr int query_first(int a_query) { return a_query / (c_componentTypes - 1); }
+constexpr int query_second(int a_query)
+{
+	return (query_first(a_query) + 1 + a_query % (c_componentTypes - 1)) % c_componentTypes;
+}
+
+template <typename Func>
+static void measure(const char* a_name, Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	size_t result = a_func();
+
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_frames; i++)
+	{
+		result = a_func();
+	}
+	const double elapsed = static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0;
+	std::printf("  %-28s: %.4f ms/frame (%zu matches)\n", a_name, elapsed / c_frames, result);
+}
+
+template <int Index>
+static void toggle(bench_registry& a_registry, ecs::entity a_entity)
+{
+	if(!a_registry.removeComponent<sensor<Index>>(a_entity))
+	{
+		a_registry.addComponent<sensor<Index>>(a_entity, 1.0f);
+	}
+}
+
+int main()
+{
+	auto registry = std::make_unique<bench_registry>();
+	std::minstd_rand random{};
+	std::vector<ecs::entity> entities;
+	entities.reserve(c_entityCount);
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		auto entity = registry->createEntity();
+		[&]<int... Indices>(std::integer_sequence<int, Indices...>)
+		{
+			((random() % 2 == 0 ? (void) registry->addComponent<sensor<Indices>>(entity, 1.0f) : (void) 0), ...);
+		}(std::make_integer_sequence<int, c_componentTypes>{});
+		entities.push_back(entity);
+	}
+
+	// Toggle one component of a few random entities, as spawning and despawning would
+	const auto churn = [&]()
+	{
+		for(size_t i = 0; i < c_churnPerFrame; i++)
+		{
+			const ecs::entity entity = entities[random() % entities.size()];
+			[&]<int... Indices>(std::integer_sequence<int, Indices...>)
+			{
+				const int type = static_cast<int>(random() % c_componentTypes);
+				((type == Indices ? toggle<Indices>(*registry, entity) : (void) 0), ...);
+			}(std::make_integer_sequence<int, c_componentTypes>{});
+		}
+	};
+
+	std::printf("%d queries over %zu entities, %zu changes per frame\n", c_queryCount, c_entityCount, c_churnPerFrame);
+	std::vector<std::vector<ecs::entity>> lists(c_queryCount);
+	measure("rebuild lists with views", [&]() {
+		churn();
+		size_t matches = 0;
+		[&]<int... Queries>(std::integer_sequence<int, Queries...>)
+		{
+			([&]()
+			{
+				auto& list = lists[Queries];
+				list.clear();
+				registry->view<sensor<query_first(Queries)>, sensor<query_second(Queries)>>().each(
+					[&list](ecs::entity a_entity, auto&, auto&) { list.push_back(a_entity); });
+				matches += list.size();
+			}(), ...);
+		}(std::make_integer_sequence<int, c_queryCount>{});
+		return matches;
+	});
+
+	measure("cached queries", [&]() {
+		churn();
+		size_t matches = 0;
+		[&]<int... Queries>(std::integer_sequence<int, Queries...>)
+		{
+			((matches += registry->query<sensor<query_first(Queries)>, sensor<query_second(Queries)>>().size()), ...);
+		}(std::make_integer_sequence<int, c_queryCount>{});
+		return matches;
+	});
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "registry.hpp"
+
+// Compares a system tick over 1M entities where only 5% are active, once
+// with idle entities checked by a flag and once with idle entities asleep
+
+struct transform
+{
+	double position[3];
+	double velocity[3];
+	bool idle;
+};
+
+constexpr const size_t c_entityCount = 1'000'000;
+constexpr const size_t c_activeInterval = 20;
+constexpr const int c_repetitions = 20;
+
+template <typename Func>
+static void measure(const char* a_name, Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	size_t result = a_func();
+
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		result = a_func();
+	}
+	const double elapsed = static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0;
+	std::printf("  %-28s: %.4f ms (%zu updated)\n", a_name, elapsed / c_repetitions, result);
+}
+
+static size_t tick(transform& a_value)
+{
+	for(int i = 0; i < 3; i++)
+	{
+		a_value.position[i] += a_value.velocity[i] * 0.016;
+	}
+
+	return 1;
+}
+
+int main()
+{
+	using bench_registry = ecs::registry<ecs::component<transform, c_entityCount>>;
+	auto registry = std::make_unique<bench_registry>();
+	std::vector<ecs::entity> entities;
+	entities.reserve(c_entityCount);
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		auto entity = registry->createEntity();
+		registry->addComponent<transform>(entity, transform{{0, 0, 0}, {1, 2, 3}, i % c_activeInterval != 0});
+		entities.push_back(entity);
+	}
+
+	std::printf("%zu entities, 1 in %zu active\n", c_entityCount, c_activeInterval);
+	measure("idle flag", [&]() {
+		size_t count = 0;
+		registry->each<transform>([&count](ecs::entity, transform& a_value) {
+			if(!a_value.idle)
+			{
+				count += tick(a_value);
+			}
+		});
+		return count;
+	});
+
+	measure("sleep all idle", [&]() {
+		for(auto entity : entities)
+		{
+			if(registry->getComponent<transform>(entity)->idle)
+			{
+				registry->sleep(entity);
+			}
+		}
+		return registry->getComponentsOfType<transform>().sleeping_size();
+	});
+
+	measure("sleeping partition", [&]() {
+		size_t count = 0;
+		registry->each<transform>([&count](ecs::entity, transform& a_value) {
+			count += tick(a_value);
+		});
+		return count;
+	});
+
+	measure("wake and sleep 1000", [&]() {
+		for(size_t i = 1; i < entities.size(); i += entities.size() / 1000)
+		{
+			registry->patch<transform>(entities[i], [](transform& a_value) { a_value.velocity[0] = 0; });
+			registry->sleep(entities[i]);
+		}
+		return size_t(1000);
+	});
+	return 0;
+}
@@ -0,0 +1,41 @@
+
+#ifndef ECS_COLD_H
+#define ECS_COLD_H
+
+#include <type_traits>
+
+namespace ecs
+{
+
+/// Declares the cold part of a component. Specialize it with a member type
+/// naming the cold fields, the registry then keeps them in a parallel storage
+/// so iterating the component only touches the hot fields
+///
+///     template <>
+///     struct ecs::cold_traits<transform>
+///     {
+///         using type = transform_metadata;
+///     };
+template <typename Component>
+struct cold_traits
+{
+	using type = void;
+};
+
+/// The cold part of a component or void
+template <typename Component>
+using cold_t = typename cold_traits<Component>::type;
+
+/// True if the component declares a cold part
+template <typename Component>
+constexpr const bool has_cold_v = !std::is_void_v<cold_t<Component>>;
+
+namespace internal
+{
+	/// Placeholder storage of components without a cold part
+	struct no_cold_storage {};
+}
+
+} // ecs
+
+#endif  // ECS_COLD_H
@@ -0,0 +1,51 @@
+
+#ifndef ECS_ENTITY_H
+#define ECS_ENTITY_H
+
+#include <cstdint>
+#include <limits>
+
+namespace ecs
+{
+
+struct entity
+{
+	template<typename...> friend class registry;
+	friend struct entity_range;
+	// template<typename...> friend class storage::storage;
+
+	static constexpr size_t invalid{std::numeric_limits<size_t>::max()};
+
+	entity() = default;
+	size_t id() const
+	{
+		return m_id;
+	}
+
+private:
+	explicit entity(size_t a_id)
+		: m_id{a_id}
+	{}
+
+	size_t m_id{invalid};
+};
+
+/// Entities with consecutive ids that were created together
+struct entity_range
+{
+	size_t first{entity::invalid};
+	size_t count{0};
+
+	[[nodiscard]] size_t size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+
+	/// Returns the entity at an offset inside the range
+	[[nodiscard]] entity operator[](size_t a_offset) const
+	{
+		return entity(first + a_offset);
+	}
+};
+
+} // ecs
+
+#endif  // ECS_ENTITY_H
@@ -0,0 +1,135 @@
+
+#ifndef ECS_ENTITY_SET_H
+#define ECS_ENTITY_SET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "entity.hpp"
+
+namespace ecs
+{
+
+/// Sparse set of entities. Entities are stored densely for iteration and a
+/// paged sparse array maps entity ids to dense positions, so inserting,
+/// erasing and lookups are O(1). Erasing moves the last entity into the gap
+class entity_set
+{
+	static constexpr size_t PageSize = 4096;
+	static constexpr uint32_t npos{std::numeric_limits<uint32_t>::max()};
+
+public:
+	using iterator = std::vector<entity>::const_iterator;
+
+	[[nodiscard]] iterator begin() const { return m_dense.begin(); }
+	[[nodiscard]] iterator end() const { return m_dense.end(); }
+	[[nodiscard]] size_t size() const { return m_dense.size(); }
+	[[nodiscard]] bool empty() const { return m_dense.empty(); }
+	[[nodiscard]] entity operator[](size_t a_index) const { return m_dense[a_index]; }
+
+	/// Returns true if the entity is part of the set
+	[[nodiscard]] bool contains(entity a_entity) const
+	{
+		return position(a_entity.id()) != npos;
+	}
+
+	/// Returns the dense index of an entity, or size() if the entity is not part of the set
+	[[nodiscard]] size_t index_of(entity a_entity) const
+	{
+		const uint32_t index = position(a_entity.id());
+		return index == npos ? m_dense.size() : index;
+	}
+
+	/// Add an entity
+	/// @return false if the entity was already part of the set
+	bool insert(entity a_entity)
+	{
+		const size_t id = a_entity.id();
+		if(position(id) != npos)
+		{
+			return false;
+		}
+
+		sparse(id) = static_cast<uint32_t>(m_dense.size());
+		m_dense.push_back(a_entity);
+		return true;
+	}
+
+	/// Remove an entity
+	/// @return false if the entity was not part of the set
+	bool erase(entity a_entity)
+	{
+		const size_t id = a_entity.id();
+		const uint32_t index = position(id);
+		if(index == npos)
+		{
+			return false;
+		}
+
+		const entity last = m_dense.back();
+		m_dense[index] = last;
+		sparse(last.id()) = index;
+		sparse(id) = npos;
+		m_dense.pop_back();
+		return true;
+	}
+
+	/// Remove every entity, keeps the allocated memory
+	void clear()
+	{
+		for(entity value : m_dense)
+		{
+			sparse(value.id()) = npos;
+		}
+
+		m_dense.clear();
+	}
+
+	/// Returns the number of bytes reserved by the set
+	[[nodiscard]] size_t bytes_reserved() const
+	{
+		size_t pages = 0;
+		for(const auto& page : m_sparse)
+		{
+			pages += page != nullptr;
+		}
+
+		return m_dense.capacity() * sizeof(entity)
+			+ m_sparse.capacity() * sizeof(std::unique_ptr<uint32_t[]>)
+			+ pages * PageSize * sizeof(uint32_t);
+	}
+
+private:
+	std::vector<entity> m_dense;
+	std::vector<std::unique_ptr<uint32_t[]>> m_sparse;
+
+	uint32_t position(size_t a_id) const
+	{
+		const size_t page = a_id / PageSize;
+		return page < m_sparse.size() && m_sparse[page] != nullptr ? m_sparse[page][a_id % PageSize] : npos;
+	}
+
+	uint32_t& sparse(size_t a_id)
+	{
+		const size_t page = a_id / PageSize;
+		if(page >= m_sparse.size())
+		{
+			m_sparse.resize(page + 1);
+		}
+
+		if(m_sparse[page] == nullptr)
+		{
+			m_sparse[page] = std::make_unique_for_overwrite<uint32_t[]>(PageSize);
+			std::fill_n(m_sparse[page].get(), PageSize, npos);
+		}
+
+		return m_sparse[page][a_id % PageSize];
+	}
+};
+
+} // ecs
+
+#endif  // ECS_ENTITY_SET_H
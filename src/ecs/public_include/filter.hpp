@@ -0,0 +1,270 @@
+
+#ifndef ECS_FILTER_H
+#define ECS_FILTER_H
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace ecs
+{
+
+/// Set of selected slots of a component storage, stored as a bitmap with a
+/// lazily built index list. A selection is valid until the storage it was
+/// built from changes structure
+class selection
+{
+public:
+	/// Clear the selection and size it for a storage
+	/// @param a_size the number of slots in the storage
+	void reset(size_t a_size)
+	{
+		m_size = a_size;
+		m_words.assign((a_size + 63) >> 6, 0);
+		m_indices.clear();
+		m_indicesValid = false;
+	}
+
+	/// Returns the number of slots the selection covers
+	[[nodiscard]] size_t size() const { return m_size; }
+
+	/// Returns true if the slot is selected
+	[[nodiscard]] bool test(size_t a_index) const
+	{
+		return a_index < m_size && ((m_words[a_index >> 6] >> (a_index & 63)) & 1) != 0;
+	}
+
+	/// Returns the number of selected slots
+	[[nodiscard]] size_t count() const
+	{
+		size_t result = 0;
+		for(uint64_t word : m_words)
+		{
+			result += static_cast<size_t>(std::popcount(word));
+		}
+
+		return result;
+	}
+
+	/// Returns the bitmap words, bit i of word w is slot (w * 64 + i)
+	[[nodiscard]] std::span<uint64_t> words() { return m_words; }
+	[[nodiscard]] std::span<const uint64_t> words() const { return m_words; }
+
+	/// Returns the selected slot indices in ascending order
+	[[nodiscard]] const std::vector<uint32_t>& indices() const
+	{
+		if(!m_indicesValid)
+		{
+			m_indices.clear();
+			m_indices.reserve(count());
+			for_each([this](size_t a_index) { m_indices.push_back(static_cast<uint32_t>(a_index)); });
+			m_indicesValid = true;
+		}
+
+		return m_indices;
+	}
+
+	/// Call a function for every selected slot in ascending order
+	/// @param a_func function called with (size_t index)
+	template <typename Func>
+	void for_each(Func&& a_func) const
+	{
+		for(size_t w = 0; w < m_words.size(); w++)
+		{
+			uint64_t word = m_words[w];
+			while(word != 0)
+			{
+				a_func((w << 6) + static_cast<size_t>(std::countr_zero(word)));
+				word &= word - 1;
+			}
+		}
+	}
+
+	/// Keep only slots selected in both selections
+	selection& operator&=(const selection& a_other)
+	{
+		for(size_t i = 0; i < m_words.size(); i++)
+		{
+			m_words[i] &= i < a_other.m_words.size() ? a_other.m_words[i] : 0;
+		}
+
+		m_indicesValid = false;
+		return *this;
+	}
+
+	/// Keep slots selected in any of the selections
+	selection& operator|=(const selection& a_other)
+	{
+		for(size_t i = 0; i < m_words.size() && i < a_other.m_words.size(); i++)
+		{
+			m_words[i] |= a_other.m_words[i];
+		}
+
+		m_indicesValid = false;
+		return *this;
+	}
+
+	/// Mark the index list as outdated after the words were written directly
+	void invalidate_indices()
+	{
+		m_indicesValid = false;
+	}
+
+private:
+	size_t m_size{0};
+	std::vector<uint64_t> m_words;
+	mutable std::vector<uint32_t> m_indices;
+	mutable bool m_indicesValid{false};
+};
+
+/// Simple predicates over a projected field of a component. Predicates are
+/// evaluated without branches so the filter loop can be vectorized
+namespace predicate
+{
+	template <typename Projection, typename Value>
+	struct between_t
+	{
+		Projection projection;
+		Value min;
+		Value max;
+
+		template <typename Type>
+		constexpr bool operator()(const Type& a_value) const
+		{
+			const auto value = std::invoke(projection, a_value);
+			return (value >= min) & (value <= max);
+		}
+	};
+
+	template <typename Projection, typename Value>
+	struct less_t
+	{
+		Projection projection;
+		Value value;
+
+		template <typename Type>
+		constexpr bool operator()(const Type& a_value) const
+		{
+			return std::invoke(projection, a_value) < value;
+		}
+	};
+
+	template <typename Projection, typename Value>
+	struct greater_t
+	{
+		Projection projection;
+		Value value;
+
+		template <typename Type>
+		constexpr bool operator()(const Type& a_value) const
+		{
+			return std::invoke(projection, a_value) > value;
+		}
+	};
+
+	template <typename... Predicates>
+	struct all_t
+	{
+		std::tuple<Predicates...> predicates;
+
+		template <typename Type>
+		constexpr bool operator()(const Type& a_value) const
+		{
+			return std::apply([&a_value](const auto&... a_predicate) { return (a_predicate(a_value) & ...); }, predicates);
+		}
+	};
+
+	/// Selects values where min <= projection(value) <= max
+	/// @param a_projection member pointer or function returning the field
+	template <typename Projection, typename Value>
+	constexpr between_t<Projection, Value> between(Projection a_projection, Value a_min, Value a_max)
+	{
+		return {a_projection, a_min, a_max};
+	}
+
+	/// Selects values where projection(value) < a_value
+	template <typename Projection, typename Value>
+	constexpr less_t<Projection, Value> less(Projection a_projection, Value a_value)
+	{
+		return {a_projection, a_value};
+	}
+
+	/// Selects values where projection(value) > a_value
+	template <typename Projection, typename Value>
+	constexpr greater_t<Projection, Value> greater(Projection a_projection, Value a_value)
+	{
+		return {a_projection, a_value};
+	}
+
+	/// Selects values matching all predicates, for example a latitude and longitude box
+	template <typename... Predicates>
+	constexpr all_t<Predicates...> all(Predicates... a_predicates)
+	{
+		return {std::tuple<Predicates...>(a_predicates...)};
+	}
+}
+
+namespace internal
+{
+	/// Evaluate a predicate over every active element of a component storage
+	/// @param a_storage a registry storage
+	/// @param a_predicate predicate called with the component
+	/// @param r_selection the selection to write to
+	template <typename Storage, typename Predicate>
+	void evaluate_filter(Storage& a_storage, const Predicate& a_predicate, selection& r_selection)
+	{
+		r_selection.reset(a_storage.slot_count());
+		const auto words = r_selection.words();
+
+		size_t base = 0;
+		for(size_t p = 0; p < a_storage.page_count(); p++)
+		{
+			const auto page = a_storage.page(p);
+			const size_t count = page.size();
+			size_t i = 0;
+
+			// Whole words are built without touching memory in between so the
+			// inner loop can be vectorized
+			if((base & 63) == 0)
+			{
+				for(; i + 64 <= count; i += 64)
+				{
+					uint64_t word = 0;
+					for(size_t j = 0; j < 64; j++)
+					{
+						word |= static_cast<uint64_t>(a_predicate(page[i + j].value)) << j;
+					}
+
+					words[(base + i) >> 6] = word;
+				}
+			}
+
+			for(; i < count; i++)
+			{
+				const size_t index = base + i;
+				words[index >> 6] |= static_cast<uint64_t>(a_predicate(page[i].value)) << (index & 63);
+			}
+
+			base += count;
+		}
+
+		// Stable storages keep holes and sleeping components between active ones
+		if constexpr(Storage::stable)
+		{
+			const auto& active = a_storage.active_words();
+			for(size_t w = 0; w < words.size(); w++)
+			{
+				words[w] &= active[w];
+			}
+		}
+
+		r_selection.invalidate_indices();
+	}
+}
+
+} // ecs
+
+#endif  // ECS_FILTER_H
@@ -6,10 +6,26 @@
 #include <array>
 #include <type_traits>
 #include <memory>
+#include <string_view>
 
 namespace ecs::helper
 {
 
+/// Returns the readable name of a type at compile time
+template <typename Type>
+constexpr std::string_view type_name()
+{
+#if defined(__clang__) || defined(__GNUC__)
+	constexpr std::string_view function = __PRETTY_FUNCTION__;
+	constexpr std::string_view prefix = "Type = ";
+	constexpr size_t start = function.find(prefix) + prefix.size();
+	constexpr size_t end = function.find_first_of(";]", start);
+	return function.substr(start, end - start);
+#else
+	return "unknown";
+#endif
+}
+
 template <auto Value>
 constexpr void print_error() { static_assert(false); }
 
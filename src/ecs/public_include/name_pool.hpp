@@ -0,0 +1,278 @@
+
+#ifndef ECS_NAME_POOL_H
+#define ECS_NAME_POOL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ecs
+{
+
+/// Component holding a handle to a string interned in a name_pool
+struct name
+{
+	static constexpr uint32_t invalid{std::numeric_limits<uint32_t>::max()};
+
+	uint32_t handle{invalid};
+};
+
+/// Append only string pool, every unique string is stored once and is
+/// referenced by a 32 bit handle. Strings are never moved so views returned
+/// by the pool stay valid for the lifetime of the pool. The arena is made of
+/// blocks of 64 KiB, larger strings take a block of their own
+class name_pool
+{
+	/// Size of a single character block in the arena
+	static constexpr size_t BlockShift = 16;
+	static constexpr size_t BlockSize = size_t(1) << BlockShift;
+
+	/// Number of strings whose table slots are prefetched together
+	static constexpr size_t BatchSize = 32;
+
+	/// A string in the arena. The block index has its own field so the arena
+	/// is not limited by the bits left next to the position inside the block
+	struct entry
+	{
+		uint32_t block;
+		uint32_t position;
+		uint32_t length;
+	};
+
+	struct slot
+	{
+		uint32_t handle{name::invalid};
+		uint32_t hash{0};
+	};
+
+public:
+	name_pool() = default;
+	name_pool(const name_pool&) = delete;
+	name_pool& operator=(const name_pool&) = delete;
+
+	/// Intern a string
+	/// @param a_value the string to intern
+	/// @return the handle of the string, equal strings return the same handle
+	uint32_t intern(std::string_view a_value)
+	{
+		// Grown before probing so the probe also finds the slot of a new string
+		if((m_entries.size() + 1) * 4 > m_table.size() * 3)
+		{
+			rehash(m_table.empty() ? 64 : m_table.size() * 2);
+		}
+
+		return insert(a_value, hash_string(a_value));
+	}
+
+	/// Intern a group of strings. The table slots of up to BatchSize strings
+	/// are prefetched before the first of them is probed so their cache misses
+	/// overlap, interning new strings one by one waits for every miss in turn
+	/// @param a_values the strings to intern
+	/// @param r_handles receives the handle of every string, same size as a_values
+	void intern(std::span<const std::string_view> a_values, std::span<uint32_t> r_handles)
+	{
+		reserve(a_values.size());
+
+		uint32_t hashes[BatchSize];
+		const size_t mask = m_table.size() - 1;
+		for(size_t first = 0; first < a_values.size(); first += BatchSize)
+		{
+			const size_t count = std::min(BatchSize, a_values.size() - first);
+			for(size_t i = 0; i < count; i++)
+			{
+				hashes[i] = hash_string(a_values[first + i]);
+				prefetch(&m_table[hashes[i] & mask]);
+			}
+
+			for(size_t i = 0; i < count; i++)
+			{
+				r_handles[first + i] = insert(a_values[first + i], hashes[i]);
+			}
+		}
+	}
+
+	/// Grow the table once so the next strings are interned without a rehash
+	/// @param a_count the number of strings that will be interned
+	void reserve(size_t a_count)
+	{
+		const size_t count = m_entries.size() + a_count;
+		size_t size = m_table.empty() ? 64 : m_table.size();
+		while(count * 4 > size * 3)
+		{
+			size *= 2;
+		}
+
+		if(size != m_table.size())
+		{
+			rehash(size);
+		}
+
+		m_entries.reserve(count);
+	}
+
+	/// Find the handle of an interned string
+	/// @param a_value the string to find
+	/// @return the handle or name::invalid if the string was never interned
+	[[nodiscard]] uint32_t find(std::string_view a_value) const
+	{
+		return find(a_value, hash_string(a_value));
+	}
+
+	/// Returns the string of a handle
+	[[nodiscard]] std::string_view get(uint32_t a_handle) const
+	{
+		if(a_handle >= m_entries.size())
+		{
+			return {};
+		}
+
+		const auto& item = m_entries[a_handle];
+		return std::string_view(m_blocks[item.block].get() + item.position, item.length);
+	}
+
+	/// Returns the number of unique strings in the pool
+	[[nodiscard]] size_t size() const { return m_entries.size(); }
+
+	/// Returns the number of bytes reserved by the pool
+	[[nodiscard]] size_t bytes() const
+	{
+		return m_arenaBytes
+			+ m_blocks.capacity() * sizeof(std::unique_ptr<char[]>)
+			+ m_entries.capacity() * sizeof(entry)
+			+ m_table.capacity() * sizeof(slot);
+	}
+
+private:
+	/// Blocks of BlockSize characters and strings too large to share a block
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	size_t m_currentBlock{0};
+	size_t m_blockUsed{BlockSize};
+	size_t m_arenaBytes{0};
+	std::vector<entry> m_entries;
+
+	/// Open addressing table of handles, size is always a power of two
+	std::vector<slot> m_table;
+
+	static constexpr uint32_t hash_string(std::string_view a_value)
+	{
+		// FNV-1a followed by a finalizer so the low bits used by the table are well mixed
+		uint32_t hash = 2166136261u;
+		for(char c : a_value)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 16777619u;
+		}
+
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35u;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	/// Find or add a string, the table must have room for one more string
+	uint32_t insert(std::string_view a_value, uint32_t a_hash)
+	{
+		slot& item = m_table[find_slot(a_value, a_hash)];
+		if(item.handle == name::invalid)
+		{
+			item = slot{static_cast<uint32_t>(m_entries.size()), a_hash};
+			m_entries.push_back(allocate(a_value));
+		}
+
+		return item.handle;
+	}
+
+	static void prefetch(const void* a_address)
+	{
+#if defined(__clang__) || defined(__GNUC__)
+		__builtin_prefetch(a_address);
+#else
+		(void) a_address;
+#endif
+	}
+
+	uint32_t find(std::string_view a_value, uint32_t a_hash) const
+	{
+		return m_table.empty() ? name::invalid : m_table[find_slot(a_value, a_hash)].handle;
+	}
+
+	/// Returns the index of the slot holding a string or of the empty slot
+	/// where it would be inserted, the table must not be empty
+	size_t find_slot(std::string_view a_value, uint32_t a_hash) const
+	{
+		const size_t mask = m_table.size() - 1;
+		for(size_t index = a_hash & mask;; index = (index + 1) & mask)
+		{
+			const slot& item = m_table[index];
+
+			// Compare the hash stored in the table before touching the entry
+			if(item.handle == name::invalid || (item.hash == a_hash && get(item.handle) == a_value))
+			{
+				return index;
+			}
+		}
+	}
+
+	void rehash(size_t a_size)
+	{
+		// The slots keep the hashes, the strings are not read again
+		std::vector<slot> previous(a_size, slot{});
+		previous.swap(m_table);
+
+		const size_t mask = m_table.size() - 1;
+		for(const slot& item : previous)
+		{
+			if(item.handle == name::invalid)
+			{
+				continue;
+			}
+
+			size_t index = item.hash & mask;
+			while(m_table[index].handle != name::invalid)
+			{
+				index = (index + 1) & mask;
+			}
+
+			m_table[index] = item;
+		}
+	}
+
+	/// Copy a string into the arena
+	/// @return the entry of the string
+	entry allocate(std::string_view a_value)
+	{
+		// Strings larger than a quarter block get their own allocation
+		if(a_value.size() > BlockSize / 4)
+		{
+			auto& large = m_blocks.emplace_back(std::make_unique<char[]>(a_value.size()));
+			m_arenaBytes += a_value.size();
+			std::memcpy(large.get(), a_value.data(), a_value.size());
+			return entry{static_cast<uint32_t>(m_blocks.size() - 1), 0, static_cast<uint32_t>(a_value.size())};
+		}
+
+		// A full block has no position left for empty strings either
+		if(m_blockUsed == BlockSize || m_blockUsed + a_value.size() > BlockSize)
+		{
+			m_blocks.emplace_back(std::make_unique<char[]>(BlockSize));
+			m_arenaBytes += BlockSize;
+			m_currentBlock = m_blocks.size() - 1;
+			m_blockUsed = 0;
+		}
+
+		std::memcpy(m_blocks[m_currentBlock].get() + m_blockUsed, a_value.data(), a_value.size());
+		const entry result{static_cast<uint32_t>(m_currentBlock), static_cast<uint32_t>(m_blockUsed), static_cast<uint32_t>(a_value.size())};
+		m_blockUsed += a_value.size();
+		return result;
+	}
+};
+
+} // ecs
+
+#endif  // ECS_NAME_POOL_H
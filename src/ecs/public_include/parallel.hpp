@@ -0,0 +1,318 @@
+
+#ifndef ECS_PARALLEL_H
+#define ECS_PARALLEL_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ecs
+{
+
+/// Fixed set of worker threads that run indexed tasks. The calling thread
+/// takes part in the work so a pool of one thread runs everything inline.
+/// Tasks may call run again, on this or any other pool, the nested calls run
+/// inline on the thread of the task
+class thread_pool
+{
+public:
+	/// @param a_threads number of threads including the calling thread, 0 uses all hardware threads
+	explicit thread_pool(size_t a_threads = 0)
+	{
+		if(a_threads == 0)
+		{
+			a_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		}
+
+		m_workers.reserve(a_threads - 1);
+		for(size_t i = 1; i < a_threads; i++)
+		{
+			m_workers.emplace_back([this]() { worker(); });
+		}
+	}
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	~thread_pool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_wake.notify_all();
+		for(auto& thread : m_workers)
+		{
+			thread.join();
+		}
+	}
+
+	/// Returns the number of threads including the calling thread
+	[[nodiscard]] size_t size() const { return m_workers.size() + 1; }
+
+	/// Call a function for every index in [0, a_count) and wait for all calls to finish.
+	/// Calls run concurrently in no particular order
+	/// @param a_func function called with (size_t index)
+	void run(size_t a_count, const std::function<void(size_t)>& a_func)
+	{
+		// A nested call would wait for workers that are busy running the task
+		// making it, or for a pool whose tasks wait for this one
+		if(m_workers.empty() || a_count <= 1 || s_insideTask)
+		{
+			for(size_t i = 0; i < a_count; i++)
+			{
+				a_func(i);
+			}
+
+			return;
+		}
+
+		std::unique_lock run_lock(m_runMutex);
+		{
+			std::lock_guard lock(m_mutex);
+			m_task = &a_func;
+			m_count = a_count;
+			m_next.store(0, std::memory_order_relaxed);
+			m_busy = m_workers.size();
+			m_generation++;
+		}
+
+		m_wake.notify_all();
+		work();
+
+		std::unique_lock lock(m_mutex);
+		m_done.wait(lock, [this]() { return m_busy == 0; });
+		m_task = nullptr;
+	}
+
+	/// Returns a pool shared by all registries
+	static thread_pool& shared()
+	{
+		static thread_pool pool;
+		return pool;
+	}
+
+private:
+	std::vector<std::thread> m_workers;
+	std::mutex m_runMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const std::function<void(size_t)>* m_task{nullptr};
+	size_t m_count{0};
+	size_t m_busy{0};
+	uint64_t m_generation{0};
+	std::atomic<size_t> m_next{0};
+	bool m_stop{false};
+
+	/// True while the thread runs a task of any pool
+	static inline thread_local bool s_insideTask{false};
+
+	void work()
+	{
+		s_insideTask = true;
+		for(size_t i = m_next.fetch_add(1, std::memory_order_relaxed); i < m_count; i = m_next.fetch_add(1, std::memory_order_relaxed))
+		{
+			(*m_task)(i);
+		}
+
+		s_insideTask = false;
+	}
+
+	void worker()
+	{
+		uint64_t generation = 0;
+		while(true)
+		{
+			{
+				std::unique_lock lock(m_mutex);
+				m_wake.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+				if(m_stop)
+				{
+					return;
+				}
+
+				generation = m_generation;
+			}
+
+			work();
+
+			std::lock_guard lock(m_mutex);
+			if(--m_busy == 0)
+			{
+				m_done.notify_one();
+			}
+		}
+	}
+};
+
+namespace internal
+{
+	/// Number of elements folded by one leaf of a reduction. The leaf size does
+	/// not depend on the number of threads so results are reproducible
+	constexpr const size_t c_reduceLeafSize = 16384;
+
+	/// Number of interleaved accumulators inside a leaf, element i of a leaf is
+	/// folded into lane (i % c_reduceLanes) so the fold can be vectorized
+	constexpr const size_t c_reduceLanes = 8;
+
+	/// Combine a_count values pairwise in index order, overwrites the values
+	template <typename Result, typename Combine>
+	Result combine_tree(Result* a_values, size_t a_count, const Combine& a_combine)
+	{
+		for(size_t stride = 1; stride < a_count; stride <<= 1)
+		{
+			for(size_t i = 0; i + stride < a_count; i += stride << 1)
+			{
+				a_values[i] = a_combine(a_values[i], a_values[i + stride]);
+			}
+		}
+
+		return a_values[0];
+	}
+
+	/// Fold the elements [a_first, a_last) of a storage
+	template <typename Storage, typename Result, typename Map, typename Combine>
+	Result reduce_leaf(Storage& a_storage, size_t a_first, size_t a_last, const Map& a_map, const Combine& a_combine)
+	{
+		constexpr size_t PageSize = Storage::page_size;
+		const auto element = [&a_storage, &a_map](size_t a_index) { return Result(a_map(std::as_const(*a_storage.get(a_index)))); };
+		if(a_last - a_first < c_reduceLanes)
+		{
+			Result result = element(a_first);
+			for(size_t i = a_first + 1; i < a_last; i++)
+			{
+				result = a_combine(result, element(i));
+			}
+
+			return result;
+		}
+
+		auto lanes = [&]<size_t... Lanes>(std::index_sequence<Lanes...>)
+		{
+			return std::array<Result, c_reduceLanes>{element(a_first + Lanes)...};
+		}(std::make_index_sequence<c_reduceLanes>{});
+
+		size_t index = a_first + c_reduceLanes;
+		while(index < a_last)
+		{
+			const auto page = a_storage.page(index / PageSize);
+			const size_t offset = index % PageSize;
+			const size_t end = offset + std::min(a_last - index, page.size() - offset);
+			size_t i = offset;
+
+			// Leaves and pages start at a multiple of the lane count so whole
+			// blocks always map element k to lane k
+			if constexpr(PageSize % c_reduceLanes == 0)
+			{
+				for(; i + c_reduceLanes <= end; i += c_reduceLanes)
+				{
+					for(size_t k = 0; k < c_reduceLanes; k++)
+					{
+						lanes[k] = a_combine(lanes[k], a_map(std::as_const(page[i + k].value)));
+					}
+				}
+			}
+
+			for(; i < end; i++)
+			{
+				const size_t lane = (index + i - offset - a_first) % c_reduceLanes;
+				lanes[lane] = a_combine(lanes[lane], a_map(std::as_const(page[i].value)));
+			}
+
+			index += end - offset;
+		}
+
+		return combine_tree(lanes.data(), c_reduceLanes, a_combine);
+	}
+
+	/// Reduce the active elements of a stable storage, which keeps holes and sleeping
+	/// elements between active ones. The leaves cover fixed slot ranges and leaves
+	/// without active elements are skipped when combining
+	template <typename Storage, typename Result, typename Map, typename Combine>
+	Result evaluate_sparse_reduce(Storage& a_storage, thread_pool& a_pool, Result a_init, const Map& a_map, const Combine& a_combine)
+	{
+		const size_t count = a_storage.slot_count();
+		const size_t leaves = (count + c_reduceLeafSize - 1) / c_reduceLeafSize;
+		std::vector<std::optional<Result>> results(leaves);
+		a_pool.run(leaves, [&](size_t a_leaf)
+		{
+			const size_t first = a_leaf * c_reduceLeafSize;
+			const size_t last = std::min(first + c_reduceLeafSize, count);
+			std::optional<Result> result;
+			for(size_t i = first; i < last; i++)
+			{
+				if(a_storage.is_active(i))
+				{
+					const auto value = a_map(std::as_const(*a_storage.get(i)));
+					result = result.has_value() ? a_combine(*result, value) : Result(value);
+				}
+			}
+
+			results[a_leaf] = std::move(result);
+		});
+
+		const auto combine = [&a_combine](const std::optional<Result>& a, const std::optional<Result>& b) -> std::optional<Result>
+		{
+			if(!a.has_value() || !b.has_value())
+			{
+				return a.has_value() ? a : b;
+			}
+
+			return a_combine(*a, *b);
+		};
+
+		const auto result = leaves == 0 ? std::optional<Result>{} : combine_tree(results.data(), leaves, combine);
+		return result.has_value() ? a_combine(a_init, *result) : a_init;
+	}
+
+	/// Reduce the active elements of a component storage with a fixed reduction tree.
+	/// The elements are split into leaves of c_reduceLeafSize, every leaf folds its
+	/// elements into c_reduceLanes interleaved lanes, lanes and leaves are then combined
+	/// pairwise in index order. The result only depends on the order of the elements
+	/// and is bit identical for any number of threads
+	/// @param a_storage a registry storage
+	/// @param a_pool the threads evaluating the leaves
+	/// @param a_init value combined with the reduction of all elements
+	/// @param a_map function called with (const Component&) returning a Result
+	/// @param a_combine associative function called with (Result, Result) returning a Result
+	template <typename Storage, typename Result, typename Map, typename Combine>
+	Result evaluate_reduce(Storage& a_storage, thread_pool& a_pool, Result a_init, const Map& a_map, const Combine& a_combine)
+	{
+		if constexpr(Storage::stable)
+		{
+			return evaluate_sparse_reduce(a_storage, a_pool, a_init, a_map, a_combine);
+		}
+		else
+		{
+			const size_t count = a_storage.size();
+			if(count == 0)
+			{
+				return a_init;
+			}
+
+			const size_t leaves = (count + c_reduceLeafSize - 1) / c_reduceLeafSize;
+			std::vector<Result> results(leaves, a_init);
+			a_pool.run(leaves, [&](size_t a_leaf)
+			{
+				const size_t first = a_leaf * c_reduceLeafSize;
+				results[a_leaf] = reduce_leaf<Storage, Result>(a_storage, first, std::min(first + c_reduceLeafSize, count), a_map, a_combine);
+			});
+
+			return a_combine(a_init, combine_tree(results.data(), leaves, a_combine));
+		}
+	}
+}
+
+} // ecs
+
+#endif  // ECS_PARALLEL_H
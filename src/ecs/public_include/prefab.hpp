@@ -0,0 +1,43 @@
+
+#ifndef ECS_PREFAB_H
+#define ECS_PREFAB_H
+
+#include <tuple>
+#include <utility>
+
+namespace ecs
+{
+
+/// Captured set of component values used to instantiate many identical
+/// entities, see registry::instantiate
+template <typename... Components>
+class prefab
+{
+	static_assert(sizeof...(Components) > 0, "Prefab without components");
+
+public:
+	prefab() = default;
+	explicit prefab(Components... a_values)
+		: m_values{std::move(a_values)...}
+	{}
+
+	/// Returns the value of a component
+	template <typename Component>
+	[[nodiscard]] Component& get()
+	{
+		return std::get<Component>(m_values);
+	}
+
+	template <typename Component>
+	[[nodiscard]] const Component& get() const
+	{
+		return std::get<Component>(m_values);
+	}
+
+private:
+	std::tuple<Components...> m_values;
+};
+
+} // ecs
+
+#endif  // ECS_PREFAB_H
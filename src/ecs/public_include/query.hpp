@@ -0,0 +1,205 @@
+
+#ifndef ECS_QUERY_H
+#define ECS_QUERY_H
+
+#include <atomic>
+#include <tuple>
+#include <vector>
+
+#include "entity.hpp"
+#include "entity_set.hpp"
+
+namespace ecs
+{
+
+namespace internal
+{
+	/// Returns the next free query index, shared by every registry
+	inline size_t next_query_index()
+	{
+		static std::atomic<size_t> s_count{0};
+		return s_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// Dense index of the cached query of a component list, registries keep
+	/// their queries in a vector at this index
+	template <typename... Types>
+	size_t query_index()
+	{
+		static const size_t s_index = next_query_index();
+		return s_index;
+	}
+
+	/// Part of a cached query the registry notifies about structural changes
+	class query_base
+	{
+	public:
+		virtual ~query_base() = default;
+
+		/// Record that the components or the sleep state of an entity changed
+		void invalidate(entity a_entity)
+		{
+			// Changes of several components of one entity arrive back to back
+			if(m_rebuild || (!m_pending.empty() && m_pending.back().id() == a_entity.id()))
+			{
+				return;
+			}
+
+			if(m_pending.size() == MaxPending)
+			{
+				mark_for_rebuild();
+				return;
+			}
+
+			m_pending.push_back(a_entity);
+		}
+
+		/// Record that the components of consecutive entities changed
+		void invalidate(const entity_range& a_entities)
+		{
+			if(m_rebuild)
+			{
+				return;
+			}
+
+			if(m_pending.size() + a_entities.size() > MaxPending)
+			{
+				mark_for_rebuild();
+				return;
+			}
+
+			m_pending.reserve(m_pending.size() + a_entities.size());
+			for(size_t i = 0; i < a_entities.size(); i++)
+			{
+				m_pending.push_back(a_entities[i]);
+			}
+		}
+
+	protected:
+		/// Number of recorded entities after which a query that is not used
+		/// stops recording and is rebuilt from the storage on its next use
+		static constexpr size_t MaxPending = 1 << 16;
+
+		std::vector<entity> m_pending;
+		bool m_rebuild{false};
+
+	private:
+		void mark_for_rebuild()
+		{
+			m_rebuild = true;
+			m_pending.clear();
+			m_pending.shrink_to_fit();
+		}
+	};
+}
+
+/// Persistent set of the awake entities that have every listed component.
+/// The registry records structural changes of the listed components and the
+/// set is updated with only those entities the next time it is used, so a
+/// query without changes costs nothing to set up. Queries are owned by the
+/// registry, see registry::query
+template <typename Registry, typename... Types>
+class query : public internal::query_base
+{
+	static_assert(sizeof...(Types) > 0, "Query without components");
+
+public:
+	explicit query(Registry& a_registry)
+		: m_registry{a_registry}
+	{
+		rebuild();
+	}
+
+	/// Returns the matching entities in no particular order
+	[[nodiscard]] const entity_set& entities()
+	{
+		refresh();
+		return m_entities;
+	}
+
+	/// Returns the number of matching entities
+	[[nodiscard]] size_t size()
+	{
+		return entities().size();
+	}
+
+	/// Call a function for every matching entity
+	/// @param a_func function called with (entity, Types&...)
+	template <typename Func>
+	void each(Func&& a_func)
+	{
+		refresh();
+		for(entity value : m_entities)
+		{
+			const auto* record = m_registry.entity_record(value);
+			a_func(value, *m_registry.template component_of<Types>(record)...);
+		}
+	}
+
+	/// Returns the number of entities waiting to be checked
+	[[nodiscard]] size_t pending() const
+	{
+		return m_pending.size();
+	}
+
+	/// Returns true if too many entities changed and the next use rebuilds the set
+	[[nodiscard]] bool needs_rebuild() const
+	{
+		return m_rebuild;
+	}
+
+private:
+	using first_type = std::tuple_element_t<0, std::tuple<Types...>>;
+
+	Registry& m_registry;
+	entity_set m_entities;
+
+	/// Check every entity that changed since the last use
+	void refresh()
+	{
+		if(m_rebuild)
+		{
+			rebuild();
+			return;
+		}
+
+		if(m_pending.empty())
+		{
+			return;
+		}
+
+		for(entity value : m_pending)
+		{
+			if(m_registry.template matches<Types...>(value))
+			{
+				m_entities.insert(value);
+			}
+			else
+			{
+				m_entities.erase(value);
+			}
+		}
+
+		m_pending.clear();
+	}
+
+	/// Build the set from the storage of the first component
+	void rebuild()
+	{
+		m_entities.clear();
+		m_pending.clear();
+		m_rebuild = false;
+		auto& storage = m_registry.template getComponentsOfType<first_type>();
+		for(auto it = storage.begin(), end = storage.end(); it != end; ++it)
+		{
+			if(m_registry.template matches<Types...>(it.owner()))
+			{
+				m_entities.insert(it.owner());
+			}
+		}
+	}
+};
+
+} // ecs
+
+#endif  // ECS_QUERY_H
@@ -8,34 +8,33 @@
 #include <iostream>
 #include <type_traits>
 #include <cstring>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <bit>
 
 #include "helper.hpp"
+#include "entity.hpp"
 #include "storage.hpp"
+#include "name_pool.hpp"
+#include "stats.hpp"
+#include "filter.hpp"
+#include "parallel.hpp"
+#include "view.hpp"
+#include "prefab.hpp"
+#include "cold.hpp"
+#include "query.hpp"
 
 namespace ecs
 {
 
-struct entity
-{
-	template<typename...> friend class registry;
-	// template<typename...> friend class storage::storage;
-
-	static constexpr size_t invalid{std::numeric_limits<size_t>::max()};
-
-	entity() = default;
-	size_t id() const
-	{
-		return m_id;
-	}
-
-private:
-	explicit entity(size_t a_id)
-		: m_id{a_id}
-	{}
-
-	size_t m_id{invalid};
-};
-
 namespace internal
 {
 
@@ -51,206 +50,1657 @@ struct internal_component
 template <typename... Components>
 struct internal_entity
 {
+	static constexpr size_t invalid_slot{std::numeric_limits<size_t>::max()};
+
 	entity value;
-	void* components[sizeof...(Components)]{};
+	bool sleeping{false};
+	bool removed{false};
+
+	/// Slot of every component inside its storage or invalid_slot
+	size_t components[sizeof...(Components)]{};
 };
 
-template <typename Type, template<typename> class InternalType = internal::internal_component>
+/// Random access iterator over the values of a component storage. The owner
+/// of a slot never changes, so algorithms that permute the range such as
+/// std::sort would move components to other entities, use registry::sort
+template <typename Type, typename BaseIterator>
 struct registry_storage_iterator
 {
-	using iterator_category = std::forward_iterator_tag;
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept  = std::random_access_iterator_tag;
 	using difference_type   = std::ptrdiff_t;
-	using value_type        = Type;
+	using value_type        = std::remove_cv_t<Type>;
 	using pointer           = std::add_pointer_t<Type>;
 	using reference         = std::add_lvalue_reference_t<Type>;
 
-	using self_iterator     = registry_storage_iterator<Type>;
-	using that_iterator     = storage::storage_node_iterator<InternalType<Type>>;
+	using self_iterator     = registry_storage_iterator<Type, BaseIterator>;
+	using that_iterator     = BaseIterator;
 
 public:
-	registry_storage_iterator(that_iterator a_ptr)
+	registry_storage_iterator() = default;
+	explicit registry_storage_iterator(that_iterator a_ptr)
 		: m_ptr{a_ptr}
 	{}
 
 	reference operator*() const { return (*m_ptr).value; }
-    pointer operator->() { return &((*m_ptr).value); }
+	pointer operator->() const { return &((*m_ptr).value); }
+	reference operator[](difference_type a_offset) const { return m_ptr[a_offset].value; }
 
-	self_iterator& operator++() {
-		m_ptr.operator++();
-		return *this;
-	}
+	/// Returns the entity owning the current component
+	[[nodiscard]] entity owner() const { return (*m_ptr).entity_id; }
+
+	self_iterator& operator++() { ++m_ptr; return *this; }
+	self_iterator operator++(int) { self_iterator copy = *this; ++m_ptr; return copy; }
+	self_iterator& operator--() { --m_ptr; return *this; }
+	self_iterator operator--(int) { self_iterator copy = *this; --m_ptr; return copy; }
+	self_iterator& operator+=(difference_type a_offset) { m_ptr += a_offset; return *this; }
+	self_iterator& operator-=(difference_type a_offset) { m_ptr -= a_offset; return *this; }
 
-	friend bool operator== (const self_iterator& a, const self_iterator& b) { return a.m_ptr == b.m_ptr; };
-    friend bool operator!= (const self_iterator& a, const self_iterator& b) { return a.m_ptr != b.m_ptr; };
+	friend self_iterator operator+(self_iterator a, difference_type b) { return a += b; }
+	friend self_iterator operator+(difference_type a, self_iterator b) { return b += a; }
+	friend self_iterator operator-(self_iterator a, difference_type b) { return a -= b; }
+	friend difference_type operator-(const self_iterator& a, const self_iterator& b) { return a.m_ptr - b.m_ptr; }
+
+	friend bool operator==(const self_iterator& a, const self_iterator& b) { return a.m_ptr == b.m_ptr; }
+	friend auto operator<=>(const self_iterator& a, const self_iterator& b) { return a.m_ptr <=> b.m_ptr; }
 private:
 	that_iterator m_ptr;
 };
 
+/// Number of elements per page of the cold part of a component, cold fields
+/// are rarely touched so small pages keep the reserved memory low
+constexpr const size_t c_coldPageSize = 4096;
+
+/// Storage of a single component type. Slots are partitioned into active
+/// components [0, size()) followed by sleeping components, iteration only
+/// visits active components. The cold part of a component, see cold_traits,
+/// is kept in a parallel storage at the same slot index
 template <typename Type, size_t PageSize, size_t ExpectedSize = 0>
 struct registry_storage
 {
-	using iterator = registry_storage_iterator<Type>;
+	using storage_type = storage::storage<internal::internal_component<Type>, PageSize, ExpectedSize>;
+	using cold_type = cold_t<Type>;
+	using cold_storage_type = std::conditional_t<has_cold_v<Type>,
+		storage::storage<std::conditional_t<has_cold_v<Type>, cold_type, char>, c_coldPageSize>,
+		no_cold_storage>;
+	using iterator = registry_storage_iterator<Type, typename storage_type::iterator>;
+	using const_iterator = registry_storage_iterator<const Type, typename storage_type::const_iterator>;
+
+	static constexpr size_t page_size = PageSize;
+
+	/// Slots move when components sleep, wake or are removed
+	static constexpr bool stable = false;
 
 public:
 	[[nodiscard]] iterator begin() { return iterator(m_storage.begin()); }
-	[[nodiscard]] iterator end() { return iterator(m_storage.end()); }
-	[[nodiscard]] size_t size() const { return m_storage.count(); }
+	[[nodiscard]] iterator end() { return iterator(m_storage.begin() + active_offset()); }
+	[[nodiscard]] const_iterator begin() const { return const_iterator(m_storage.begin()); }
+	[[nodiscard]] const_iterator end() const { return const_iterator(m_storage.begin() + active_offset()); }
+
+	/// Returns the number of active components
+	[[nodiscard]] size_t size() const { return m_active; }
+
+	/// Returns the number of sleeping components
+	[[nodiscard]] size_t sleeping_size() const { return m_storage.size() - m_active; }
+
+	/// Returns the number of active and sleeping components
+	[[nodiscard]] size_t total_size() const { return m_storage.size(); }
+
+	/// Returns the number of slots iteration and filters cover, the active components
+	[[nodiscard]] size_t slot_count() const { return m_active; }
+
+	/// Returns the sleeping components
+	[[nodiscard]] auto sleeping()
+	{
+		return std::ranges::subrange(end(), iterator(m_storage.end()));
+	}
+
 	[[nodiscard]] Type* get(const size_t a_index)
 	{
 		return &m_storage.get(a_index)->value;
 	}
 
+	/// Returns the slot at an index
+	[[nodiscard]] internal::internal_component<Type>& slot(const size_t a_index)
+	{
+		return *m_storage.get(a_index);
+	}
+
+	/// Returns the cold part of the component at an index
+	[[nodiscard]] cold_type* cold(const size_t a_index) requires has_cold_v<Type>
+	{
+		return m_cold.get(a_index);
+	}
+
+	/// Add an active component, if there are sleeping components the first one
+	/// is moved to the end of the storage to make room
+	/// @return the slot index of the new component
 	template <typename... Args>
-	internal::internal_component<Type>* emplace(entity a_entity, Args&&... a_arguments)
+	size_t emplace(entity a_entity, Args&&... a_arguments)
+	{
+		m_storage.emplace(a_entity, a_arguments...);
+		if constexpr(has_cold_v<Type>)
+		{
+			m_cold.emplace();
+		}
+
+		return activate(m_storage.size() - 1);
+	}
+
+	/// Append active slots and let a_stamp assign them one page range at a
+	/// time, so the slots are written in a single pass. The storage must not
+	/// contain sleeping components
+	/// @param a_count the number of slots
+	/// @param a_stamp function called with (std::span<internal_component<Type>>, size_t offset)
+	///                for every page range, offset is the index of the first slot
+	///                of the range. It must assign the owner and value of every slot
+	/// @return the slot index of the first appended slot
+	template <typename Stamp>
+	size_t emplace_stamp(size_t a_count, const Stamp& a_stamp)
+	{
+		const size_t first = m_storage.grow(a_count);
+		m_active += a_count;
+		if constexpr(has_cold_v<Type>)
+		{
+			m_cold.fill(m_cold.grow(a_count), a_count, cold_type{});
+		}
+
+		m_storage.for_each_range(first, a_count, a_stamp);
+		return first;
+	}
+
+	/// Append active copies of a value owned by consecutive entities, see emplace_stamp
+	/// @param a_owners the owners of the copies
+	/// @param a_value the value to copy
+	/// @return the slot index of the first copy
+	size_t emplace_fill(const entity_range& a_owners, const Type& a_value)
+	{
+		return emplace_stamp(a_owners.size(), [&](std::span<internal::internal_component<Type>> r_slots, size_t a_offset)
+		{
+			// Local copies, the slots could alias the references for the compiler
+			const entity_range owners = a_owners;
+			const Type value = a_value;
+			for(size_t i = 0; i < r_slots.size(); i++)
+			{
+				r_slots[i].entity_id = owners[a_offset + i];
+				r_slots[i].value = value;
+			}
+		});
+	}
+
+	/// Remove the component at an index. The last active component moves into
+	/// the freed slot and the last sleeping component into the freed active slot,
+	/// the owners of slots a_index and size() must be updated afterwards
+	void erase(size_t a_index)
+	{
+		if(a_index < m_active)
+		{
+			m_active--;
+			swap_slots(a_index, m_active);
+			a_index = m_active;
+		}
+
+		swap_slots(a_index, m_storage.size() - 1);
+		m_storage.pop_back();
+		if constexpr(has_cold_v<Type>)
+		{
+			m_cold.pop_back();
+		}
+	}
+
+	/// Move an active slot into the sleeping partition by swapping it with the
+	/// last active slot
+	/// @return the new index of the slot
+	size_t deactivate(size_t a_index)
+	{
+		m_active--;
+		swap_slots(a_index, m_active);
+		return m_active;
+	}
+
+	/// Move a sleeping slot into the active partition by swapping it with the
+	/// first sleeping slot
+	/// @return the new index of the slot
+	size_t activate(size_t a_index)
+	{
+		swap_slots(a_index, m_active);
+		return m_active++;
+	}
+
+	/// Sort the active slots by value. Whole slots move so every owner keeps
+	/// its component and cold part, the owners of the active slots must be
+	/// updated afterwards
+	/// @param a_compare strict weak ordering called with (const Type&, const Type&)
+	template <typename Compare>
+	void sort(const Compare& a_compare)
 	{
-		return m_storage.emplace(a_entity, a_arguments...);
+		std::vector<size_t> order(m_active);
+		for(size_t i = 0; i < m_active; i++)
+		{
+			order[i] = i;
+		}
+
+		std::sort(order.begin(), order.end(), [this, &a_compare](size_t a_first, size_t a_second)
+		{
+			return a_compare(std::as_const(*get(a_first)), std::as_const(*get(a_second)));
+		});
+
+		// Slot i takes the value of slot order[i], every cycle of the
+		// permutation is applied with swaps
+		for(size_t i = 0; i < m_active; i++)
+		{
+			size_t current = i;
+			while(order[current] != i)
+			{
+				const size_t next = order[current];
+				swap_slots(current, next);
+				order[current] = current;
+				current = next;
+			}
+
+			order[current] = current;
+		}
+	}
+
+	/// Returns the number of allocated pages
+	[[nodiscard]] size_t page_count() const { return m_storage.page_count(); }
+
+	/// Returns the active slots of a page as a contiguous span
+	[[nodiscard]] std::span<internal::internal_component<Type>> page(size_t a_page)
+	{
+		const size_t first = a_page * PageSize;
+		const size_t count = m_active > first ? std::min(m_active - first, PageSize) : 0;
+		return m_storage.page(a_page).first(count);
+	}
+
+	/// Returns the entity owning a slot
+	[[nodiscard]] entity owner(const size_t a_index)
+	{
+		return m_storage.get(a_index)->entity_id;
+	}
+
+	/// Add time spent iterating the storage outside of each
+	void add_iteration_time(std::chrono::nanoseconds a_elapsed)
+	{
+		m_timer.add(a_elapsed);
+	}
+
+	/// Call a function for every element, the time spent is added to the frame iteration time
+	/// @param a_func function called with (entity, Type&)
+	template <typename Func>
+	void each(Func&& a_func)
+	{
+		using namespace std::chrono;
+		const auto start = high_resolution_clock::now();
+		for(auto it = begin(), last = end(); it != last; ++it)
+		{
+			a_func(it.owner(), *it);
+		}
+		m_timer.add(duration_cast<nanoseconds>(high_resolution_clock::now() - start));
+	}
+
+	/// Mark the end of a frame for the iteration timer
+	void end_frame()
+	{
+		m_timer.end_frame();
+	}
+
+	/// Returns memory and occupancy statistics of the storage
+	[[nodiscard]] storage_stats stats() const
+	{
+		storage_stats result;
+		result.name = helper::type_name<Type>();
+		result.element_size = sizeof(Type);
+		result.page_size = PageSize;
+		result.pages = m_storage.page_count();
+		result.live = m_storage.size();
+		result.sleeping = sleeping_size();
+		result.capacity = m_storage.capacity();
+		result.bytes_reserved = m_storage.bytes_reserved();
+		if constexpr(has_cold_v<Type>)
+		{
+			result.cold_element_size = sizeof(cold_type);
+			result.bytes_reserved += m_cold.bytes_reserved();
+		}
+
+		result.fragmentation = result.capacity == 0
+			? 0.0
+			: 1.0 - static_cast<double>(result.live) / static_cast<double>(result.capacity);
+		result.last_frame_iteration_ms = m_timer.last_frame_ms();
+		return result;
 	}
 private:
-	storage::storage<internal::internal_component<Type>, PageSize, ExpectedSize> m_storage;
+	storage_type m_storage;
+	[[no_unique_address]] cold_storage_type m_cold;
+	size_t m_active{0};
+	iteration_timer m_timer;
+
+	std::ptrdiff_t active_offset() const
+	{
+		return static_cast<std::ptrdiff_t>(m_active);
+	}
+
+	void swap_slots(size_t a_first, size_t a_second)
+	{
+		if(a_first != a_second)
+		{
+			std::swap(*m_storage.get(a_first), *m_storage.get(a_second));
+			if constexpr(has_cold_v<Type>)
+			{
+				std::swap(*m_cold.get(a_first), *m_cold.get(a_second));
+			}
+		}
+	}
 };
 
-}
+/// Forward iterator over the slots of a stable storage whose bit is set in a mask
+template <typename Type, typename Storage>
+struct stable_storage_iterator
+{
+	using iterator_category = std::forward_iterator_tag;
+	using iterator_concept  = std::forward_iterator_tag;
+	using difference_type   = std::ptrdiff_t;
+	using value_type        = std::remove_cv_t<Type>;
+	using pointer           = std::add_pointer_t<Type>;
+	using reference         = std::add_lvalue_reference_t<Type>;
+
+	using self_iterator     = stable_storage_iterator<Type, Storage>;
+
+public:
+	stable_storage_iterator() = default;
+	stable_storage_iterator(Storage* a_storage, const std::vector<uint64_t>* a_mask, size_t a_index)
+		: m_storage{a_storage}
+		, m_mask{a_mask}
+		, m_index{a_index}
+	{
+		skip();
+	}
 
-// mingw64    (1) -> 767.2480 ms
-// mingw64    (4096) -> 254.9370 
+	reference operator*() const { return *m_storage->get(m_index); }
+	pointer operator->() const { return m_storage->get(m_index); }
 
-// llvm-clang (1) -> 1442.4755 ms
-// llvm-clang (4096) -> 808.6714 ms
+	/// Returns the entity owning the current component
+	[[nodiscard]] entity owner() const { return m_storage->owner(m_index); }
 
-constexpr const size_t TEST_SIZE = 1024 * 1024;//4096;
+	/// Returns the slot of the current component
+	[[nodiscard]] size_t index() const { return m_index; }
 
-template <typename Type, size_t Size>
-struct component
-{
-	using type = Type;
-	using storage_type = internal::registry_storage<Type, TEST_SIZE, Size>;
-	using pointer_type = std::add_pointer_t<Type>;
+	self_iterator& operator++() { ++m_index; skip(); return *this; }
+	self_iterator operator++(int) { self_iterator copy = *this; ++*this; return copy; }
+
+	friend bool operator==(const self_iterator& a, const self_iterator& b) { return a.m_index == b.m_index; }
+
+private:
+	Storage* m_storage{nullptr};
+	const std::vector<uint64_t>* m_mask{nullptr};
+	size_t m_index{0};
+
+	/// Move to the next set bit at or after the current index
+	void skip()
+	{
+		const auto& mask = *m_mask;
+		const size_t end = m_storage->slot_count();
+		size_t word = m_index >> 6;
+		if(m_index >= end || word >= mask.size())
+		{
+			m_index = end;
+			return;
+		}
+
+		uint64_t bits = mask[word] & (~uint64_t(0) << (m_index & 63));
+		while(bits == 0)
+		{
+			if(++word >= mask.size())
+			{
+				m_index = end;
+				return;
+			}
+
+			bits = mask[word];
+		}
+
+		m_index = std::min(end, (word << 6) + static_cast<size_t>(std::countr_zero(bits)));
+	}
 };
 
-namespace details
+/// Pointer stable storage of a single component type. Components never move
+/// once added, removed slots become holes that are reused by later components
+/// and sleeping components stay in place. Bitmaps of the live and the active
+/// slots let iteration skip holes and sleeping components, so iteration is
+/// slower than the packed registry_storage when many slots are not active
+template <typename Type, size_t PageSize, size_t ExpectedSize = 0>
+struct stable_registry_storage
 {
-	template <typename Find, size_t Index, bool Found>
-	struct find_result
+	using storage_type = storage::storage<internal::internal_component<Type>, PageSize, ExpectedSize>;
+	using cold_type = cold_t<Type>;
+	using cold_storage_type = std::conditional_t<has_cold_v<Type>,
+		storage::storage<std::conditional_t<has_cold_v<Type>, cold_type, char>, c_coldPageSize>,
+		no_cold_storage>;
+	using self_type = stable_registry_storage<Type, PageSize, ExpectedSize>;
+	using iterator = stable_storage_iterator<Type, self_type>;
+	using const_iterator = stable_storage_iterator<const Type, const self_type>;
+
+	static constexpr size_t page_size = PageSize;
+
+	/// Slots never move, the registry does not need to update entity records
+	static constexpr bool stable = true;
+
+public:
+	[[nodiscard]] iterator begin() { return iterator(this, &m_activeMask, 0); }
+	[[nodiscard]] iterator end() { return iterator(this, &m_activeMask, slot_count()); }
+	[[nodiscard]] const_iterator begin() const { return const_iterator(this, &m_activeMask, 0); }
+	[[nodiscard]] const_iterator end() const { return const_iterator(this, &m_activeMask, slot_count()); }
+
+	/// Returns the number of active components
+	[[nodiscard]] size_t size() const { return m_active; }
+
+	/// Returns the number of sleeping components
+	[[nodiscard]] size_t sleeping_size() const { return m_live - m_active; }
+
+	/// Returns the number of active and sleeping components
+	[[nodiscard]] size_t total_size() const { return m_live; }
+
+	/// Returns the number of slots including holes, slot indices are below this value
+	[[nodiscard]] size_t slot_count() const { return m_storage.size(); }
+
+	/// Returns the sleeping components
+	[[nodiscard]] auto sleeping()
 	{
-		static constexpr size_t index{Index};
-		static constexpr bool found{Found};
-		using type = Find;
-	};
+		return std::ranges::subrange(iterator(this, &m_sleepingMask, 0), iterator(this, &m_sleepingMask, slot_count()));
+	}
 
-	template <size_t Index, typename... Components>
-	struct find_component {};
-	
-	template <size_t Index, typename Find, typename Check>
-	struct find_component<Index, Find, Check>
+	/// Returns true if the slot holds an active component
+	[[nodiscard]] bool is_active(size_t a_index) const
 	{
-		using type = std::conditional_t<
-			std::is_same_v<Find, typename Check::type>,
-			find_result<Check, Index, true>,
-			find_result<component<void, 0>, Index, false>>;
-	};
+		return ((m_activeMask[a_index >> 6] >> (a_index & 63)) & 1) != 0;
+	}
 
-	template <size_t Index, typename Find, typename Check, typename... Components>
-	struct find_component<Index, Find, Check, Components...>
+	/// Returns the bitmap of active slots, bit i of word w is slot (w * 64 + i)
+	[[nodiscard]] const std::vector<uint64_t>& active_words() const { return m_activeMask; }
+
+	[[nodiscard]] Type* get(const size_t a_index)
 	{
-		using type = std::conditional_t<
-			std::is_same_v<Find, typename Check::type>,
-			find_result<Check, Index, true>,
-			typename find_component<Index + 1, Find, Components...>::type>;
-	};
+		return &m_storage.get(a_index)->value;
+	}
 
-	
-	template <typename Find, typename... Components>
-	using find_component_t = find_component<0, Find, Components...>::type;
-}
+	[[nodiscard]] const Type* get(const size_t a_index) const
+	{
+		return &const_cast<storage_type&>(m_storage).get(a_index)->value;
+	}
 
-template <typename... Components>
-class registry
-{
-public:
-	template <typename Component>
-	constexpr void testing()
+	/// Returns the slot at an index
+	[[nodiscard]] internal::internal_component<Type>& slot(const size_t a_index)
 	{
-		// details::print_error<details::get_type_index<Component, Components...>>();
-		// details::print_error<details::get_type_array<Component, Components...>>();
+		return *m_storage.get(a_index);
 	}
 
-	template <typename Component>
-	inline constexpr auto& getComponentsOfType()
+	/// Returns the cold part of the component at an index
+	[[nodiscard]] cold_type* cold(const size_t a_index) requires has_cold_v<Type>
 	{
-		using result = details::find_component_t<Component, Components...>;
-		static_assert(result::found, "Component not part of registry");
-		return std::get<result::index>(m_componentStorage);
+		return m_cold.get(a_index);
 	}
 
-	template <typename Component, typename... Args>
-	constexpr Component* addComponent(entity a_entity, Args&&... a_arguments)
+	/// Add an active component into a hole or at the end of the storage
+	/// @return the slot index of the new component
+	template <typename... Args>
+	size_t emplace(entity a_entity, Args&&... a_arguments)
 	{
-		using result = details::find_component_t<Component, Components...>;
-		static_assert(result::found, "Component not part of registry");
-		if(a_entity.m_id == entity::invalid)
+		size_t index;
+		if(!m_free.empty())
 		{
-			return nullptr;
+			index = m_free.back();
+			m_free.pop_back();
+			*m_storage.get(index) = internal::internal_component<Type>{a_entity, Type{a_arguments...}};
+		}
+		else
+		{
+			m_storage.emplace(a_entity, a_arguments...);
+			if constexpr(has_cold_v<Type>)
+			{
+				m_cold.emplace();
+			}
+
+			index = m_storage.size() - 1;
+			grow_masks();
 		}
 
-		// std::printf("Trying to get entity %zu\n", a_entity.m_id);
-		auto* entity = m_entities.get(a_entity.m_id);
-		void* curr = entity->components[result::index];
+		m_live++;
+		set_bit(m_activeMask, index, true);
+		m_active++;
+		return index;
+	}
 
-		// helper::print_error<decltype(entity)>();
-		// std::printf("B registry.addComponent m_id=%zu entity(%p) index=%zu ptr=%p\n", a_entity.m_id, (void*) entity, result::index, (void*) curr);
-		// for(size_t i = 0; i < sizeof...(Components); i++)
-		// {
-		// 	std::printf("- i=%ld, ptr=%p\n", i, entity->components[i]);
-		// }
-		if(curr == nullptr)
+	/// Append active slots, see registry_storage::emplace_stamp
+	template <typename Stamp>
+	size_t emplace_stamp(size_t a_count, const Stamp& a_stamp)
+	{
+		const size_t first = m_storage.grow(a_count);
+		if constexpr(has_cold_v<Type>)
+		{
+			m_cold.fill(m_cold.grow(a_count), a_count, cold_type{});
+		}
+
+		grow_masks();
+		m_storage.for_each_range(first, a_count, a_stamp);
+		set_bits(m_activeMask, first, a_count);
+		m_live += a_count;
+		m_active += a_count;
+		return first;
+	}
+
+	/// Append active copies of a value, see registry_storage::emplace_fill
+	size_t emplace_fill(const entity_range& a_owners, const Type& a_value)
+	{
+		return emplace_stamp(a_owners.size(), [&](std::span<internal::internal_component<Type>> r_slots, size_t a_offset)
+		{
+			// Local copies, the slots could alias the references for the compiler
+			const entity_range owners = a_owners;
+			const Type value = a_value;
+			for(size_t i = 0; i < r_slots.size(); i++)
+			{
+				r_slots[i].entity_id = owners[a_offset + i];
+				r_slots[i].value = value;
+			}
+		});
+	}
+
+	/// Remove the component at an index, the slot becomes a hole
+	void erase(size_t a_index)
+	{
+		if(is_active(a_index))
 		{
-			auto& data = std::get<result::index>(m_componentStorage);
-			auto* comp = data.emplace(a_entity, a_arguments...);
-			// std::printf("stack? %p\n", (void*) comp);
-			curr = &comp->value;
+			m_active--;
+			set_bit(m_activeMask, a_index, false);
 		}
 		else
 		{
-			*static_cast<Component*>(curr) = Component {a_arguments...};
+			set_bit(m_sleepingMask, a_index, false);
+		}
+
+		if constexpr(!std::is_trivially_destructible_v<Type>)
+		{
+			m_storage.get(a_index)->value = Type{};
 		}
-		// std::printf("aftrrr\n");
 
-		return static_cast<Component*>(curr);
+		if constexpr(has_cold_v<Type>)
+		{
+			*m_cold.get(a_index) = cold_type{};
+		}
+
+		m_storage.get(a_index)->entity_id = entity{};
+		m_free.push_back(a_index);
+		m_live--;
 	}
 
-	[[nodiscard]] entity createEntity()
+	/// Mark an active slot as sleeping
+	/// @return the index of the slot, it does not change
+	size_t deactivate(size_t a_index)
 	{
-		// std::printf("\n=========================================\n");
+		set_bit(m_activeMask, a_index, false);
+		set_bit(m_sleepingMask, a_index, true);
+		m_active--;
+		return a_index;
+	}
 
-		entity value(m_uniqueEntity++);
-		auto& entity = m_entities.emplace(value, internal::internal_entity<typename Components::type...>(value))->value;
-		std::memset(&entity.components, 0, sizeof(void*) * sizeof...(Components));
-		// std::printf("  \nentity(%zu) -> %p\n", value.m_id, (void*) &entity);
+	/// Mark a sleeping slot as active
+	/// @return the index of the slot, it does not change
+	size_t activate(size_t a_index)
+	{
+		set_bit(m_sleepingMask, a_index, false);
+		set_bit(m_activeMask, a_index, true);
+		m_active++;
+		return a_index;
+	}
 
-		// auto* check = m_entities.get(value.m_id);
-		// helper::print_error<decltype(check)>();
+	/// Returns the number of allocated pages
+	[[nodiscard]] size_t page_count() const { return m_storage.page_count(); }
 
-		// if(check != &entity)
-		// {
-		// 	std::printf("AAOSDFAOSIDUFOAISDUFOAUDFOIAUSDFOIUASDOFIUASDF\n");
-		// 	std::printf("emplace %p\n", (void*) &entity);
-		// 	std::printf("get     %p\n", (void*) check);
-		// }
+	/// Returns all slots of a page including holes and sleeping components,
+	/// use active_words to find the active ones
+	[[nodiscard]] std::span<internal::internal_component<Type>> page(size_t a_page)
+	{
+		return m_storage.page(a_page);
+	}
 
-		return entity.value;
+	/// Returns the entity owning a slot
+	[[nodiscard]] entity owner(const size_t a_index) const
+	{
+		return const_cast<storage_type&>(m_storage).get(a_index)->entity_id;
 	}
 
-	void removeEntity(entity a_entity)
+	/// Add time spent iterating the storage outside of each
+	void add_iteration_time(std::chrono::nanoseconds a_elapsed)
+	{
+		m_timer.add(a_elapsed);
+	}
+
+	/// Call a function for every active element, the time spent is added to the frame iteration time
+	/// @param a_func function called with (entity, Type&)
+	template <typename Func>
+	void each(Func&& a_func)
 	{
-		std::printf("Getting index %zu\n", a_entity.m_id);
-		m_entities.get(a_entity.m_id);
+		using namespace std::chrono;
+		const auto start = high_resolution_clock::now();
+		for(auto it = begin(), last = end(); it != last; ++it)
+		{
+			a_func(it.owner(), *it);
+		}
+		m_timer.add(duration_cast<nanoseconds>(high_resolution_clock::now() - start));
+	}
 
+	/// Mark the end of a frame for the iteration timer
+	void end_frame()
+	{
+		m_timer.end_frame();
 	}
 
+	/// Returns memory and occupancy statistics of the storage
+	[[nodiscard]] storage_stats stats() const
+	{
+		storage_stats result;
+		result.name = helper::type_name<Type>();
+		result.element_size = sizeof(Type);
+		result.page_size = PageSize;
+		result.pages = m_storage.page_count();
+		result.live = m_live;
+		result.sleeping = sleeping_size();
+		result.capacity = m_storage.capacity();
+		result.bytes_reserved = m_storage.bytes_reserved()
+			+ (m_activeMask.capacity() + m_sleepingMask.capacity()) * sizeof(uint64_t)
+			+ m_free.capacity() * sizeof(size_t);
+		if constexpr(has_cold_v<Type>)
+		{
+			result.cold_element_size = sizeof(cold_type);
+			result.bytes_reserved += m_cold.bytes_reserved();
+		}
+
+		result.fragmentation = result.capacity == 0
+			? 0.0
+			: 1.0 - static_cast<double>(result.live) / static_cast<double>(result.capacity);
+		result.last_frame_iteration_ms = m_timer.last_frame_ms();
+		return result;
+	}
 private:
+	storage_type m_storage;
+	[[no_unique_address]] cold_storage_type m_cold;
+	std::vector<uint64_t> m_activeMask;
+	std::vector<uint64_t> m_sleepingMask;
+	std::vector<size_t> m_free;
+	size_t m_live{0};
+	size_t m_active{0};
+	iteration_timer m_timer;
+
+	void grow_masks()
+	{
+		const size_t words = (m_storage.size() + 63) >> 6;
+		if(words > m_activeMask.size())
+		{
+			m_activeMask.resize(words, 0);
+			m_sleepingMask.resize(words, 0);
+		}
+	}
+
+	static void set_bit(std::vector<uint64_t>& r_mask, size_t a_index, bool a_value)
+	{
+		const uint64_t bit = uint64_t(1) << (a_index & 63);
+		r_mask[a_index >> 6] = a_value ? (r_mask[a_index >> 6] | bit) : (r_mask[a_index >> 6] & ~bit);
+	}
+
+	/// Set a range of bits, whole words are written at once
+	static void set_bits(std::vector<uint64_t>& r_mask, size_t a_first, size_t a_count)
+	{
+		const size_t last = a_first + a_count;
+		for(size_t index = a_first; index < last;)
+		{
+			const size_t bit = index & 63;
+			const size_t count = std::min<size_t>(64 - bit, last - index);
+			const uint64_t word = count == 64 ? ~uint64_t(0) : ((uint64_t(1) << count) - 1);
+			r_mask[index >> 6] |= word << bit;
+			index += count;
+		}
+	}
+};
+
+}
+
+/// Default number of components per storage page, measure changes with ecs_bench
+constexpr const size_t c_defaultPageSize = 1024 * 1024;
+
+/// How the components of a type are stored
+namespace storage_policy
+{
+	/// Components are kept densely, active components first. Iteration is the
+	/// fastest but components move on sleep, wake and removal, hold handles
+	/// instead of pointers across structural changes
+	struct packed {};
+
+	/// Components never move until they are removed, pointers stay valid.
+	/// Iteration skips holes and sleeping components
+	struct stable {};
+}
+
+/// @tparam Size expected number of components
+/// @tparam PageSize number of components per page, a power of two
+template <typename Type, size_t Size, typename Policy = storage_policy::packed, size_t PageSize = c_defaultPageSize>
+struct component
+{
+	static_assert(std::is_same_v<Policy, storage_policy::packed> || std::is_same_v<Policy, storage_policy::stable>,
+		"Unknown storage policy");
+
+	using type = Type;
+	using policy = Policy;
+	using storage_type = std::conditional_t<std::is_same_v<Policy, storage_policy::stable>,
+		internal::stable_registry_storage<Type, PageSize, Size>,
+		internal::registry_storage<Type, PageSize, Size>>;
+	using pointer_type = std::add_pointer_t<Type>;
+};
+
+/// Reference to the component of an entity that stays valid when components
+/// move, resolve it with registry::resolve
+template <typename Component>
+struct handle
+{
+	entity owner;
+};
+
+namespace details
+{
+	static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+
+	/// A single slot of a type table, binds a type to its index
+	template <size_t Index, typename Type>
+	struct type_slot
+	{
+		static constexpr size_t index{Index};
+		using type = Type;
+	};
+
+	/// Flat type to index table, every type inherits its own slot so a lookup
+	/// is a single base class deduction instead of a recursive instantiation
+	template <typename Sequence, typename... Types>
+	struct type_table_impl;
+
+	template <size_t... Indices, typename... Types>
+	struct type_table_impl<std::index_sequence<Indices...>, Types...>
+		: type_slot<Indices, Types>...
+	{};
+
+	template <typename... Types>
+	using type_table = type_table_impl<std::index_sequence_for<Types...>, Types...>;
+
+	template <typename Find, size_t Index>
+	constexpr size_t type_table_lookup(const type_slot<Index, Find>*) { return Index; }
+
+	template <typename Find>
+	constexpr size_t type_table_lookup(...) { return npos; }
+
+	/// Returns the index of the type inside the table or npos
+	template <typename Find, typename Table>
+	constexpr size_t type_index_v = type_table_lookup<Find>(static_cast<const Table*>(nullptr));
+
+	/// Check that every type inside the list only exists once
+	template <typename... Types>
+	constexpr bool is_unique_v = ((type_index_v<Types, type_table<Types...>> != npos) && ...);
+}
+
+template <typename... Components>
+class registry
+{
+	template <typename, typename, typename...> friend class ecs::view;
+	template <typename, typename...> friend class ecs::query;
+
+	/// Static type to index table of all components in this registry
+	using component_table = details::type_table<typename Components::type...>;
+	static_assert(details::is_unique_v<typename Components::type...>, "Component added more than once to registry");
+
+public:
+	/// Index of the component inside the registry or details::npos
+	template <typename Component>
+	static constexpr size_t component_index = details::type_index_v<Component, component_table>;
+
+	/// Returns true if the component is part of the registry
+	template <typename Component>
+	static constexpr bool has_component = component_index<Component> != details::npos;
+
+	template <typename Component>
+	inline constexpr auto& getComponentsOfType()
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		return std::get<component_index<Component>>(m_componentStorage);
+	}
+
+	/// Add a component to an entity or overwrite the existing one, wakes the entity if it is sleeping.
+	/// The returned pointer is valid until the next structural change of the storage
+	template <typename Component, typename... Args>
+	constexpr Component* addComponent(entity a_entity, Args&&... a_arguments)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		constexpr size_t index = component_index<Component>;
+		if(!isValid(a_entity))
+		{
+			return nullptr;
+		}
+
+		wake(a_entity);
+
+		auto& data = std::get<index>(m_componentStorage);
+		auto* record = entity_record(a_entity);
+		size_t slot = record->components[index];
+		if(slot == entity_record_type::invalid_slot)
+		{
+			slot = data.emplace(a_entity, a_arguments...);
+			record->components[index] = slot;
+
+			// A sleeping component may have been moved to the end to make room
+			if constexpr(!std::remove_reference_t<decltype(data)>::stable)
+			{
+				update_slot<index>(data.total_size() - 1);
+			}
+
+			notify_queries(index, a_entity);
+		}
+		else
+		{
+			*data.get(slot) = Component {a_arguments...};
+		}
+
+		return data.get(slot);
+	}
+
+	/// Returns the component of an entity or nullptr if the entity does not have it.
+	/// Modifying a sleeping entity through this pointer does not wake it, use patch
+	template <typename Component>
+	[[nodiscard]] Component* getComponent(entity a_entity)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		if(!isValid(a_entity))
+		{
+			return nullptr;
+		}
+
+		return component_of<Component>(entity_record(a_entity));
+	}
+
+	/// Returns the cold part of a component of an entity or nullptr if the entity
+	/// does not have the component, see cold_traits
+	template <typename Component>
+	[[nodiscard]] cold_t<Component>* getCold(entity a_entity)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		static_assert(has_cold_v<Component>, "Component has no cold part, specialize ecs::cold_traits");
+		if(!isValid(a_entity))
+		{
+			return nullptr;
+		}
+
+		constexpr size_t index = component_index<Component>;
+		const size_t slot = entity_record(a_entity)->components[index];
+		return slot == entity_record_type::invalid_slot ? nullptr : std::get<index>(m_componentStorage).cold(slot);
+	}
+
+	/// Returns a handle to the component of an entity that stays valid when the
+	/// component moves, or an empty handle if the entity does not have it
+	template <typename Component>
+	[[nodiscard]] handle<Component> getHandle(entity a_entity)
+	{
+		return getComponent<Component>(a_entity) != nullptr ? handle<Component>{a_entity} : handle<Component>{};
+	}
+
+	/// Returns the component a handle refers to or nullptr if it was removed
+	template <typename Component>
+	[[nodiscard]] Component* resolve(handle<Component> a_handle)
+	{
+		return getComponent<Component>(a_handle.owner);
+	}
+
+	/// Modify a component of an entity, wakes the entity if it is sleeping
+	/// @param a_func function called with (Component&)
+	/// @return the component or nullptr if the entity does not have it
+	template <typename Component, typename Func>
+	Component* patch(entity a_entity, Func&& a_func)
+	{
+		wake(a_entity);
+		Component* component = getComponent<Component>(a_entity);
+		if(component != nullptr)
+		{
+			a_func(*component);
+		}
+
+		return component;
+	}
+
+	/// Create entities with a copy of every component of a prefab. Components are
+	/// stamped in bulk into freshly reserved pages one page range at a time
+	/// @param a_prefab the component values of every entity
+	/// @param a_count the number of entities to create
+	/// @return the created entities, their ids are consecutive
+	template <typename... Types>
+	entity_range instantiate(const prefab<Types...>& a_prefab, size_t a_count)
+	{
+		static_assert((has_component<Types> && ...), "Component not part of registry");
+		static_assert((!std::is_same_v<Types, name> && ...), "Names are unique per entity, use setName");
+		const entity_range result{m_uniqueEntity, a_count};
+		if(a_count == 0)
+		{
+			return result;
+		}
+
+		m_uniqueEntity += a_count;
+
+		// Stamp the components into storages without sleeping components, their
+		// slots are consecutive
+		constexpr size_t typeCount = sizeof...(Types);
+		constexpr std::array<size_t, typeCount> indices{component_index<Types>...};
+		std::array<size_t, typeCount> firstSlots{};
+		size_t type = 0;
+		([&]()
+		{
+			auto& data = getComponentsOfType<Types>();
+			firstSlots[type++] = std::remove_reference_t<decltype(data)>::stable || data.sleeping_size() == 0
+				? data.emplace_fill(result, a_prefab.template get<Types>())
+				: entity_record_type::invalid_slot;
+		}(), ...);
+
+		entity_record_type pattern{entity{}, false, false, {}};
+		std::fill(std::begin(pattern.components), std::end(pattern.components), entity_record_type::invalid_slot);
+		m_entities.emplace_stamp(a_count, [&](auto r_slots, size_t a_offset)
+		{
+			// Local copies, the slots could alias the captures for the compiler
+			const entity_record_type record = pattern;
+			const std::array<size_t, typeCount> first = firstSlots;
+			const entity_range owners = result;
+			for(size_t i = 0; i < r_slots.size(); i++)
+			{
+				auto& slot = r_slots[i];
+				slot.entity_id = owners[a_offset + i];
+				slot.value = record;
+				slot.value.value = slot.entity_id;
+				for(size_t t = 0; t < typeCount; t++)
+				{
+					if(first[t] != entity_record_type::invalid_slot)
+					{
+						slot.value.components[indices[t]] = first[t] + a_offset + i;
+					}
+				}
+			}
+		});
+
+		type = 0;
+		([&]()
+		{
+			if(firstSlots[type++] != entity_record_type::invalid_slot)
+			{
+				for(auto* query : m_queryWatchers[component_index<Types>])
+				{
+					query->invalidate(result);
+				}
+			}
+		}(), ...);
+
+		// Storages with sleeping components add one entity at a time so the
+		// sleeping partition stays behind the active one
+		type = 0;
+		([&]()
+		{
+			if(firstSlots[type++] == entity_record_type::invalid_slot)
+			{
+				for(size_t i = 0; i < a_count; i++)
+				{
+					addComponent<Types>(result[i], a_prefab.template get<Types>());
+				}
+			}
+		}(), ...);
+
+		return result;
+	}
+
+	/// Capture components of an entity into a prefab, missing components are value initialized
+	template <typename... Types>
+	[[nodiscard]] prefab<Types...> capture(entity a_entity)
+	{
+		static_assert((has_component<Types> && ...), "Component not part of registry");
+		const auto value = [this, a_entity]<typename Type>(std::type_identity<Type>)
+		{
+			const Type* component = getComponent<Type>(a_entity);
+			return component != nullptr ? *component : Type{};
+		};
+
+		return prefab<Types...>(value(std::type_identity<Types>{})...);
+	}
+
+	/// Put an entity to sleep, its components are moved to the sleeping
+	/// partition of every storage and are skipped by iteration
+	void sleep(entity a_entity)
+	{
+		if(!isValid(a_entity) || entity_record(a_entity)->sleeping)
+		{
+			return;
+		}
+
+		entity_record(a_entity)->sleeping = true;
+		move_partition<false>(a_entity, std::index_sequence_for<Components...>{});
+		notify_queries(a_entity);
+	}
+
+	/// Wake a sleeping entity, its components are moved back to the active
+	/// partition of every storage
+	void wake(entity a_entity)
+	{
+		if(!isValid(a_entity) || !entity_record(a_entity)->sleeping)
+		{
+			return;
+		}
+
+		entity_record(a_entity)->sleeping = false;
+		move_partition<true>(a_entity, std::index_sequence_for<Components...>{});
+		notify_queries(a_entity);
+	}
+
+	/// Returns true if the entity is sleeping
+	[[nodiscard]] bool isSleeping(entity a_entity)
+	{
+		return isValid(a_entity) && entity_record(a_entity)->sleeping;
+	}
+
+	/// Set the name of an entity, the string is interned in the name pool of the registry
+	/// @param a_entity the entity to name
+	/// @param a_name the new name of the entity
+	/// @return the name component of the entity
+	name* setName(entity a_entity, std::string_view a_name)
+	{
+		static_assert(has_component<name>, "ecs::name not part of registry");
+		if(!isValid(a_entity))
+		{
+			return nullptr;
+		}
+
+		return assign_name(a_entity, m_names.intern(a_name));
+	}
+
+	/// Name a range of entities, the batched form of setName. Names are interned
+	/// in groups whose table lookups overlap, and when none of the entities has
+	/// a name their name components are stamped in bulk
+	/// @param a_entities the entities to name
+	/// @param a_generator function called with (size_t offset, std::string&) that writes
+	///                    the name of the entity at an offset into the empty string
+	template <typename Generator>
+	void setNames(const entity_range& a_entities, const Generator& a_generator)
+	{
+		static_assert(has_component<name>, "ecs::name not part of registry");
+		constexpr size_t index = component_index<name>;
+		constexpr size_t groupSize = 64;
+		auto& data = std::get<index>(m_componentStorage);
+		m_names.reserve(a_entities.size());
+
+		std::array<std::string, groupSize> buffers;
+		std::array<std::string_view, groupSize> views;
+		std::array<uint32_t, groupSize> handles;
+		const auto intern_group = [&](size_t a_offset, size_t a_count)
+		{
+			for(size_t i = 0; i < a_count; i++)
+			{
+				buffers[i].clear();
+				a_generator(a_offset + i, buffers[i]);
+				views[i] = buffers[i];
+			}
+
+			m_names.intern(std::span(views.data(), a_count), std::span(handles.data(), a_count));
+		};
+
+		bool bulk = (std::remove_reference_t<decltype(data)>::stable || data.sleeping_size() == 0)
+			&& a_entities.first + a_entities.size() <= m_uniqueEntity;
+		for(size_t i = 0; bulk && i < a_entities.size(); i++)
+		{
+			const auto* record = entity_record(a_entities[i]);
+			bulk = !record->removed && !record->sleeping && record->components[index] == entity_record_type::invalid_slot;
+		}
+
+		if(!bulk)
+		{
+			for(size_t offset = 0; offset < a_entities.size(); offset += groupSize)
+			{
+				const size_t count = std::min(groupSize, a_entities.size() - offset);
+				intern_group(offset, count);
+				for(size_t i = 0; i < count; i++)
+				{
+					if(isValid(a_entities[offset + i]))
+					{
+						assign_name(a_entities[offset + i], handles[i]);
+					}
+				}
+			}
+
+			return;
+		}
+
+		m_nameOwners.reserve(m_names.size() + a_entities.size());
+		m_nameCounts.reserve(m_names.size() + a_entities.size());
+		const size_t first = data.emplace_stamp(a_entities.size(), [&](auto r_slots, size_t a_offset)
+		{
+			for(size_t offset = 0; offset < r_slots.size(); offset += groupSize)
+			{
+				const size_t count = std::min(groupSize, r_slots.size() - offset);
+				intern_group(a_offset + offset, count);
+				for(size_t i = 0; i < count; i++)
+				{
+					const entity owner = a_entities[a_offset + offset + i];
+					claim_name(handles[i], owner);
+					r_slots[offset + i].entity_id = owner;
+					r_slots[offset + i].value = name{handles[i]};
+				}
+			}
+		});
+
+		for(size_t i = 0; i < a_entities.size(); i++)
+		{
+			entity_record(a_entities[i])->components[index] = first + i;
+		}
+
+		for(auto* query : m_queryWatchers[index])
+		{
+			query->invalidate(a_entities);
+		}
+	}
+
+	/// Returns the name of an entity or an empty string if it does not have one
+	[[nodiscard]] std::string_view getName(entity a_entity)
+	{
+		const name* value = getComponent<name>(a_entity);
+		return value == nullptr ? std::string_view{} : m_names.get(value->handle);
+	}
+
+	/// Find an entity by its name in constant time
+	/// @param a_name the name to find
+	/// @return the last entity given this name, another entity with the name
+	///         if that one was renamed or removed, or an invalid entity
+	[[nodiscard]] entity findByName(std::string_view a_name) const
+	{
+		static_assert(has_component<name>, "ecs::name not part of registry");
+		const uint32_t handle = m_names.find(a_name);
+		return handle == name::invalid ? entity{} : m_nameOwners[handle];
+	}
+
+	/// Call a function for every component of a type
+	/// @param a_func function called with (entity, Component&)
+	template <typename Component, typename Func>
+	void each(Func&& a_func)
+	{
+		getComponentsOfType<Component>().each(a_func);
+	}
+
+	/// Call a function for every selected component of a type
+	/// @param a_selection a selection built from the storage of the component
+	/// @param a_func function called with (entity, Component&)
+	template <typename Component, typename Func>
+	void each(const selection& a_selection, Func&& a_func)
+	{
+		view<Component>().each(a_selection, a_func);
+	}
+
+	/// Sort the active components of a type. Components move with their
+	/// entities, so iteration visits them in order and every entity keeps its
+	/// own component. Sleeping components stay in place and selections taken
+	/// before the sort no longer match the slots
+	/// @param a_compare strict weak ordering called with (const Component&, const Component&)
+	template <typename Component, typename Compare>
+	void sort(Compare&& a_compare)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		constexpr size_t index = component_index<Component>;
+		auto& data = std::get<index>(m_componentStorage);
+		static_assert(!std::remove_reference_t<decltype(data)>::stable, "Slots of pointer stable storages never move");
+
+		data.sort(a_compare);
+		for(size_t slot = 0; slot < data.size(); slot++)
+		{
+			update_slot<index>(slot);
+		}
+	}
+
+	/// Returns a view over all entities that have every listed component
+	template <typename... Types>
+	[[nodiscard]] ecs::view<registry, Types...> view()
+	{
+		static_assert((has_component<Types> && ...), "Component not part of registry");
+		return ecs::view<registry, Types...>(*this);
+	}
+
+	/// Select the components of a type matching a predicate
+	/// @param a_predicate predicate called with the component, see ecs::predicate
+	/// @param r_selection the selection to write to, reuse it to avoid allocations
+	template <typename Component, typename Predicate>
+	void filter(const Predicate& a_predicate, selection& r_selection)
+	{
+		internal::evaluate_filter(getComponentsOfType<Component>(), a_predicate, r_selection);
+	}
+
+	/// Select the components of a type matching a predicate
+	/// @param a_predicate predicate called with the component, see ecs::predicate
+	/// @return the selection over the storage of the component
+	template <typename Component, typename Predicate>
+	[[nodiscard]] selection filter(const Predicate& a_predicate)
+	{
+		selection result;
+		filter<Component>(a_predicate, result);
+		return result;
+	}
+
+	/// Reduce the active components of a type in parallel. The reduction tree is
+	/// fixed so floating point results are bit identical for any number of threads
+	/// @param a_init value combined with the reduction of all components
+	/// @param a_map function called with (const Component&) returning a Result
+	/// @param a_combine associative function called with (Result, Result) returning a Result
+	template <typename Component, typename Result, typename Map, typename Combine>
+	[[nodiscard]] Result reduce(Result a_init, Map&& a_map, Combine&& a_combine)
+	{
+		return reduce<Component>(thread_pool::shared(), a_init, a_map, a_combine);
+	}
+
+	/// Reduce the active components of a type in parallel on a specific pool
+	/// @param a_pool the threads evaluating the reduction
+	template <typename Component, typename Result, typename Map, typename Combine>
+	[[nodiscard]] Result reduce(thread_pool& a_pool, Result a_init, Map&& a_map, Combine&& a_combine)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		auto& data = getComponentsOfType<Component>();
+		using namespace std::chrono;
+		const auto start = high_resolution_clock::now();
+		Result result = internal::evaluate_reduce(data, a_pool, a_init, a_map, a_combine);
+		data.add_iteration_time(duration_cast<nanoseconds>(high_resolution_clock::now() - start));
+		return result;
+	}
+
+	/// Mark the end of a frame, rolls over the per frame iteration timers
+	void endFrame()
+	{
+		m_entities.end_frame();
+		std::apply([](auto&... a_storage) { (a_storage.end_frame(), ...); }, m_componentStorage);
+	}
+
+	/// Returns memory and occupancy statistics of every storage in the registry
+	[[nodiscard]] registry_stats stats() const
+	{
+		registry_stats result;
+		result.entities = m_uniqueEntity - m_removedEntities;
+		result.entity_storage = m_entities.stats();
+		result.entity_storage.name = "ecs::entity";
+		result.bytes_reserved = result.entity_storage.bytes_reserved;
+		result.component_storages.reserve(sizeof...(Components));
+		std::apply([&result](const auto&... a_storage) {
+			(result.component_storages.push_back(a_storage.stats()), ...);
+		}, m_componentStorage);
+
+		for(const auto& item : result.component_storages)
+		{
+			result.bytes_reserved += item.bytes_reserved;
+		}
+
+		result.names = m_names.size();
+		result.name_pool_bytes = m_names.bytes()
+			+ m_nameOwners.capacity() * sizeof(entity)
+			+ m_nameCounts.capacity() * sizeof(uint32_t);
+		result.bytes_reserved += result.name_pool_bytes;
+		return result;
+	}
+
+	/// Returns the name pool of the registry
+	[[nodiscard]] const name_pool& names() const
+	{
+		return m_names;
+	}
+
+	[[nodiscard]] entity createEntity()
+	{
+		// std::printf("\n=========================================\n");
+
+		entity value(m_uniqueEntity++);
+		auto& entity = *m_entities.get(m_entities.emplace(value, entity_record_type{value, false, false, {}}));
+		std::fill(std::begin(entity.components), std::end(entity.components), entity_record_type::invalid_slot);
+		// std::printf("  \nentity(%zu) -> %p\n", value.m_id, (void*) &entity);
+
+		// auto* check = m_entities.get(value.m_id);
+		// helper::print_error<decltype(check)>();
+
+		// if(check != &entity)
+		// {
+		// 	std::printf("AAOSDFAOSIDUFOAISDUFOAUDFOIAUSDFOIUASDOFIUASDF\n");
+		// 	std::printf("emplace %p\n", (void*) &entity);
+		// 	std::printf("get     %p\n", (void*) check);
+		// }
+
+		return entity.value;
+	}
+
+	/// Remove a component from an entity. Pointers to the last component of the
+	/// storage are invalidated
+	/// @return false if the entity did not have the component
+	template <typename Component>
+	bool removeComponent(entity a_entity)
+	{
+		static_assert(has_component<Component>, "Component not part of registry");
+		if(!isValid(a_entity))
+		{
+			return false;
+		}
+
+		constexpr size_t index = component_index<Component>;
+		auto* record = entity_record(a_entity);
+		const size_t slot = record->components[index];
+		if(slot == entity_record_type::invalid_slot)
+		{
+			return false;
+		}
+
+		if constexpr(std::is_same_v<Component, name>)
+		{
+			release_name(a_entity);
+		}
+
+		notify_queries(index, a_entity);
+		remove_slot<index>(record);
+		return true;
+	}
+
+	/// Remove an entity and all of its components, the id is not reused
+	void removeEntity(entity a_entity)
+	{
+		if(!isValid(a_entity))
+		{
+			return;
+		}
+
+		if constexpr(has_component<name>)
+		{
+			release_name(a_entity);
+		}
+
+		notify_queries(a_entity);
+		auto* record = entity_record(a_entity);
+		[this, record]<size_t... Indices>(std::index_sequence<Indices...>)
+		{
+			(remove_slot<Indices>(record), ...);
+		}(std::index_sequence_for<Components...>{});
+
+		record->removed = true;
+		record->sleeping = false;
+		m_removedEntities++;
+	}
+
+	/// Move an entity with all of its components, cold data, name and sleep state to
+	/// another registry. The entity is removed from this registry
+	/// @param r_target the registry receiving the entity
+	/// @return the entity inside the target registry or an invalid entity
+	entity moveEntity(entity a_entity, registry& r_target)
+	{
+		if(!isValid(a_entity) || &r_target == this)
+		{
+			return isValid(a_entity) ? a_entity : entity{};
+		}
+
+		const entity result = r_target.createEntity();
+		const auto* record = entity_record(a_entity);
+		([&]()
+		{
+			using type = typename Components::type;
+			constexpr size_t index = component_index<type>;
+			if(record->components[index] == entity_record_type::invalid_slot)
+			{
+				return;
+			}
+
+			if constexpr(std::is_same_v<type, name>)
+			{
+				r_target.setName(result, getName(a_entity));
+			}
+			else
+			{
+				r_target.template addComponent<type>(result, std::move(*component_of<type>(record)));
+				if constexpr(has_cold_v<type>)
+				{
+					*r_target.template getCold<type>(result) = std::move(*getCold<type>(a_entity));
+				}
+			}
+		}(), ...);
+
+		if(record->sleeping)
+		{
+			r_target.sleep(result);
+		}
+
+		removeEntity(a_entity);
+		return result;
+	}
+
+	/// Returns true if the entity was created by this registry and not removed
+	[[nodiscard]] bool isValid(entity a_entity)
+	{
+		return a_entity.m_id < m_uniqueEntity && !entity_record(a_entity)->removed;
+	}
+
+	/// Returns a cached query over all awake entities that have every listed component.
+	/// The query is created on first use and lives as long as the registry, structural
+	/// changes of the listed components are applied the next time it is used
+	template <typename... Types>
+	[[nodiscard]] ecs::query<registry, Types...>& query()
+	{
+		static_assert((has_component<Types> && ...), "Component not part of registry");
+		using query_type = ecs::query<registry, Types...>;
+		const size_t index = internal::query_index<Types...>();
+		if(index >= m_queries.size())
+		{
+			m_queries.resize(index + 1);
+		}
+
+		auto& result = m_queries[index];
+		if(result == nullptr)
+		{
+			result = std::make_unique<query_type>(*this);
+			(m_queryWatchers[component_index<Types>].push_back(result.get()), ...);
+		}
+
+		return static_cast<query_type&>(*result);
+	}
+
+private:
+	using entity_record_type = internal::internal_entity<typename Components::type...>;
+
+	/// Returns the record of a valid entity
+	[[nodiscard]] entity_record_type* entity_record(entity a_entity)
+	{
+		return m_entities.get(a_entity.m_id);
+	}
+
+	/// Returns true if the entity is awake and has every listed component
+	template <typename... Types>
+	[[nodiscard]] bool matches(entity a_entity)
+	{
+		if(!isValid(a_entity))
+		{
+			return false;
+		}
+
+		const auto* record = entity_record(a_entity);
+		return !record->sleeping
+			&& ((record->components[component_index<Types>] != entity_record_type::invalid_slot) && ...);
+	}
+
+	/// Tell the cached queries using a component that an entity changed
+	void notify_queries(size_t a_component, entity a_entity)
+	{
+		for(auto* query : m_queryWatchers[a_component])
+		{
+			query->invalidate(a_entity);
+		}
+	}
+
+	/// Tell the cached queries using any component of an entity that it changed
+	void notify_queries(entity a_entity)
+	{
+		const auto* record = entity_record(a_entity);
+		for(size_t i = 0; i < sizeof...(Components); i++)
+		{
+			if(record->components[i] != entity_record_type::invalid_slot)
+			{
+				notify_queries(i, a_entity);
+			}
+		}
+	}
+
+	/// Remove the component of a record from its storage
+	template <size_t Index>
+	void remove_slot(entity_record_type* a_record)
+	{
+		const size_t slot = a_record->components[Index];
+		if(slot == entity_record_type::invalid_slot)
+		{
+			return;
+		}
+
+		auto& data = std::get<Index>(m_componentStorage);
+		a_record->components[Index] = entity_record_type::invalid_slot;
+		data.erase(slot);
+		if constexpr(!std::remove_reference_t<decltype(data)>::stable)
+		{
+			if(slot < data.total_size())
+			{
+				update_slot<Index>(slot);
+			}
+
+			if(data.size() < data.total_size())
+			{
+				update_slot<Index>(data.size());
+			}
+		}
+	}
+
+	/// Give a valid entity an interned name, see setName
+	name* assign_name(entity a_entity, uint32_t a_handle)
+	{
+		if(name* previous = getComponent<name>(a_entity); previous != nullptr)
+		{
+			if(previous->handle == a_handle)
+			{
+				m_nameOwners[a_handle] = a_entity;
+				return previous;
+			}
+
+			release_name(a_entity);
+		}
+
+		claim_name(a_handle, a_entity);
+		return addComponent<name>(a_entity, a_handle);
+	}
+
+	/// Record an entity as owner of a name, it is the one findByName returns
+	void claim_name(uint32_t a_handle, entity a_entity)
+	{
+		if(a_handle >= m_nameOwners.size())
+		{
+			m_nameOwners.resize(a_handle + 1);
+			m_nameCounts.resize(a_handle + 1);
+		}
+
+		m_nameOwners[a_handle] = a_entity;
+		m_nameCounts[a_handle]++;
+	}
+
+	/// Forget the entity as owner of its name. When other entities share the
+	/// name and this entity was the one findByName returns, another one takes
+	/// its place
+	void release_name(entity a_entity)
+	{
+		const name* current = getComponent<name>(a_entity);
+		if(current == nullptr)
+		{
+			return;
+		}
+
+		const uint32_t handle = current->handle;
+		if(--m_nameCounts[handle] == 0)
+		{
+			m_nameOwners[handle] = entity{};
+		}
+		else if(m_nameOwners[handle].m_id == a_entity.m_id)
+		{
+			m_nameOwners[handle] = find_name_owner(handle, a_entity);
+		}
+	}
+
+	/// Find an entity other than a_except with a name, the first match is
+	/// returned so entities released in creation order stop the scan early
+	[[nodiscard]] entity find_name_owner(uint32_t a_handle, entity a_except)
+	{
+		auto& data = std::get<component_index<name>>(m_componentStorage);
+		const auto find = [a_handle, a_except](auto a_first, auto a_last)
+		{
+			for(; a_first != a_last; ++a_first)
+			{
+				if(a_first->handle == a_handle && a_first.owner().m_id != a_except.m_id)
+				{
+					return a_first.owner();
+				}
+			}
+
+			return entity{};
+		};
+
+		if(const entity owner = find(data.begin(), data.end()); owner.m_id != entity::invalid)
+		{
+			return owner;
+		}
+
+		auto sleeping = data.sleeping();
+		return find(sleeping.begin(), sleeping.end());
+	}
+
+	/// Returns the component referenced by a record or nullptr
+	template <typename Component>
+	[[nodiscard]] Component* component_of(const entity_record_type* a_record)
+	{
+		constexpr size_t index = component_index<Component>;
+		const size_t slot = a_record->components[index];
+		return slot == entity_record_type::invalid_slot ? nullptr : std::get<index>(m_componentStorage).get(slot);
+	}
+
+	/// Point the record of the owner of a slot to the slot
+	template <size_t Index>
+	void update_slot(size_t a_slot)
+	{
+		auto& data = std::get<Index>(m_componentStorage);
+		entity_record(data.owner(a_slot))->components[Index] = a_slot;
+	}
+
+	/// Move every component of an entity between the active and sleeping partitions
+	template <bool Activate, size_t... Indices>
+	void move_partition(entity a_entity, std::index_sequence<Indices...>)
+	{
+		auto* record = entity_record(a_entity);
+		([this, record]()
+		{
+			const size_t slot = record->components[Indices];
+			if(slot == entity_record_type::invalid_slot)
+			{
+				return;
+			}
+
+			auto& data = std::get<Indices>(m_componentStorage);
+			const size_t moved = Activate ? data.activate(slot) : data.deactivate(slot);
+			update_slot<Indices>(slot);
+			update_slot<Indices>(moved);
+		}(), ...);
+	}
+
 	size_t m_uniqueEntity{0};
-	internal::registry_storage<internal::internal_entity<typename Components::type...>, TEST_SIZE> m_entities;
+	internal::registry_storage<internal::internal_entity<typename Components::type...>, c_defaultPageSize> m_entities;
 	std::tuple<typename Components::storage_type...> m_componentStorage;
+	name_pool m_names;
+	/// The entity findByName returns and the number of entities of every name handle
+	std::vector<entity> m_nameOwners;
+	std::vector<uint32_t> m_nameCounts;
+	size_t m_removedEntities{0};
+	/// Cached queries at their internal::query_index, empty for lists this registry never queried
+	std::vector<std::unique_ptr<internal::query_base>> m_queries;
+	std::array<std::vector<internal::query_base*>, sizeof...(Components)> m_queryWatchers;
 };
 
 }
@@ -0,0 +1,869 @@
+
+#ifndef ECS_SNAPSHOT_H
+#define ECS_SNAPSHOT_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "entity.hpp"
+
+namespace ecs
+{
+
+/// Converts a component to the value written into snapshots. Specialize it to
+/// quantize fields, the default writes the bytes of the component
+///
+///     template <>
+///     struct ecs::snapshot_traits<transform>
+///     {
+///         using packed = packed_transform;
+///         static packed pack(const transform& a_value);
+///         static void unpack(const packed& a_packed, transform& r_value);
+///     };
+///
+/// Packed values are compared and written as bytes, they must have unique object
+/// representations. Components with padding or floating point fields need a
+/// specialization, for example one that quantizes them or packs their bits
+template <typename Component>
+struct snapshot_traits
+{
+	using packed = Component;
+
+	static packed pack(const Component& a_value) { return a_value; }
+	static void unpack(const packed& a_packed, Component& r_value) { r_value = a_packed; }
+};
+
+/// The value written into snapshots for a component
+template <typename Component>
+using snapshot_packed_t = typename snapshot_traits<Component>::packed;
+
+namespace internal
+{
+	/// First bytes of every encoded snapshot, "WSNP"
+	constexpr const uint32_t c_snapshotMagic = 0x504E5357;
+
+	/// Set in the mask of a snapshot entity that is sleeping
+	constexpr const uint32_t c_snapshotSleeping = uint32_t(1) << 31;
+
+	/// Snapshots kept by the encoder while waiting for an acknowledgement
+	constexpr const size_t c_snapshotPending = 64;
+
+	/// Bytes of a packed value that are compared and written, tags have none
+	template <typename Packed>
+	constexpr const size_t c_packedSize = std::is_empty_v<Packed> ? 0 : sizeof(Packed);
+
+	/// Entities and packed component values of one snapshot sorted by entity id
+	template <typename... Components>
+	struct snapshot_state
+	{
+		uint64_t sequence{0};
+		std::vector<size_t> ids;
+
+		/// Bit i is set if the entity has component i, see c_snapshotSleeping
+		std::vector<uint32_t> masks;
+		std::tuple<std::vector<snapshot_packed_t<Components>>...> values;
+
+		void clear()
+		{
+			ids.clear();
+			masks.clear();
+			std::apply([](auto&... r_values) { (r_values.clear(), ...); }, values);
+		}
+
+		/// Append an entity of another snapshot
+		void push(const snapshot_state& a_source, size_t a_index)
+		{
+			ids.push_back(a_source.ids[a_index]);
+			masks.push_back(a_source.masks[a_index]);
+			([&]()
+			{
+				using packed = snapshot_packed_t<Components>;
+				std::get<std::vector<packed>>(values).push_back(std::get<std::vector<packed>>(a_source.values)[a_index]);
+			}(), ...);
+		}
+	};
+
+	/// Packed values of the acknowledged snapshot indexed by entity id, entities that
+	/// are not part of it have an empty mask. Later snapshots are kept as the entities
+	/// that differ from it, so only one complete snapshot is kept
+	template <typename... Components>
+	struct snapshot_baseline
+	{
+		using state = snapshot_state<Components...>;
+
+		std::vector<uint32_t> masks;
+		std::tuple<std::vector<snapshot_packed_t<Components>>...> values;
+
+		[[nodiscard]] uint32_t mask(size_t a_id) const { return a_id < masks.size() ? masks[a_id] : 0; }
+
+		/// Grow the arrays to hold an id, they never shrink
+		void reserve(size_t a_id)
+		{
+			if(a_id < masks.size())
+			{
+				return;
+			}
+
+			const size_t size = std::max(a_id + 1, masks.size() * 2);
+			masks.resize(size, 0);
+			std::apply([size](auto&... r_values) { (r_values.resize(size), ...); }, values);
+		}
+
+		/// Remove every entity
+		void clear()
+		{
+			std::fill(masks.begin(), masks.end(), 0);
+		}
+
+		/// Append the baseline entity of an id to a snapshot
+		void push(size_t a_id, state& r_state) const
+		{
+			const uint32_t current = mask(a_id);
+			r_state.ids.push_back(a_id);
+			r_state.masks.push_back(current);
+			uint32_t bit = 1;
+			([&]()
+			{
+				using packed = snapshot_packed_t<Components>;
+				std::get<std::vector<packed>>(r_state.values).push_back((current & bit) != 0 ? std::get<std::vector<packed>>(values)[a_id] : packed{});
+				bit <<= 1;
+			}(), ...);
+		}
+
+		/// Write the entities of a snapshot holding changes against the baseline into it
+		void apply(const state& a_changes)
+		{
+			for(size_t i = 0; i < a_changes.ids.size(); i++)
+			{
+				const size_t id = a_changes.ids[i];
+				const uint32_t current = a_changes.masks[i];
+				reserve(id);
+				masks[id] = current;
+				uint32_t bit = 1;
+				([&]()
+				{
+					using packed = snapshot_packed_t<Components>;
+					if((current & bit) != 0)
+					{
+						std::get<std::vector<packed>>(values)[id] = std::get<std::vector<packed>>(a_changes.values)[i];
+					}
+
+					bit <<= 1;
+				}(), ...);
+			}
+		}
+
+		/// Make a snapshot holding changes against the baseline hold them against the
+		/// baseline with a_next applied. Entities a_next changes and r_later does not
+		/// are added to r_later with their baseline value, call it before apply(a_next)
+		/// @param r_scratch snapshot the result is built in, swapped with r_later
+		void rebase(const state& a_next, state& r_later, state& r_scratch) const
+		{
+			r_scratch.clear();
+			r_scratch.sequence = r_later.sequence;
+			size_t n = 0;
+			size_t l = 0;
+			while(n < a_next.ids.size() || l < r_later.ids.size())
+			{
+				const size_t nextId = n < a_next.ids.size() ? a_next.ids[n] : std::numeric_limits<size_t>::max();
+				const size_t laterId = l < r_later.ids.size() ? r_later.ids[l] : std::numeric_limits<size_t>::max();
+				if(laterId <= nextId)
+				{
+					r_scratch.push(r_later, l++);
+					n += laterId == nextId ? 1 : 0;
+					continue;
+				}
+
+				push(nextId, r_scratch);
+				n++;
+			}
+
+			std::swap(r_scratch, r_later);
+		}
+	};
+
+	inline void write_varint(std::vector<std::byte>& r_out, uint64_t a_value)
+	{
+		while(a_value >= 0x80)
+		{
+			r_out.push_back(std::byte(static_cast<uint8_t>(a_value | 0x80)));
+			a_value >>= 7;
+		}
+
+		r_out.push_back(std::byte(static_cast<uint8_t>(a_value)));
+	}
+
+	/// Write a value as the XOR against its previous value. A mask marks the non zero
+	/// bytes and only those are written, so bytes that did not change cost one bit
+	/// @param a_previous the previous value or nullptr if there is none
+	template <size_t Size>
+	void write_xor(std::vector<std::byte>& r_out, const std::byte* a_value, const std::byte* a_previous)
+	{
+		std::array<std::byte, Size> delta;
+		for(size_t i = 0; i < Size; i++)
+		{
+			delta[i] = a_previous != nullptr ? a_value[i] ^ a_previous[i] : a_value[i];
+		}
+
+		const size_t maskOffset = r_out.size();
+		r_out.resize(maskOffset + (Size + 7) / 8, std::byte{0});
+		for(size_t i = 0; i < Size; i++)
+		{
+			if(delta[i] != std::byte{0})
+			{
+				r_out[maskOffset + i / 8] |= std::byte(static_cast<uint8_t>(1u << (i % 8)));
+				r_out.push_back(delta[i]);
+			}
+		}
+	}
+
+	/// Bounds checked reader over the bytes of a snapshot
+	struct snapshot_reader
+	{
+		const std::byte* it;
+		const std::byte* end;
+		bool failed{false};
+
+		uint64_t varint()
+		{
+			uint64_t result = 0;
+			for(int shift = 0; shift < 64 && it != end; shift += 7)
+			{
+				const auto byte = static_cast<uint8_t>(*it++);
+				result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if((byte & 0x80) == 0)
+				{
+					return result;
+				}
+			}
+
+			failed = true;
+			return 0;
+		}
+
+		/// Apply a value written by write_xor
+		/// @param r_value the previous value, replaced by the new value
+		template <size_t Size>
+		void apply_xor(std::byte* r_value)
+		{
+			constexpr size_t maskSize = (Size + 7) / 8;
+			if(static_cast<size_t>(end - it) < maskSize)
+			{
+				failed = true;
+				return;
+			}
+
+			const std::byte* mask = it;
+			it += maskSize;
+			for(size_t i = 0; i < Size; i++)
+			{
+				if((static_cast<uint8_t>(mask[i / 8]) >> (i % 8) & 1) == 0)
+				{
+					continue;
+				}
+
+				if(it == end)
+				{
+					failed = true;
+					return;
+				}
+
+				r_value[i] ^= *it++;
+			}
+		}
+	};
+}
+
+/// Writes the state of a registry as a stream of snapshots. Every snapshot only
+/// holds the entities and components that differ from the last snapshot the
+/// receiver acknowledged, changed values are written as XOR against the
+/// acknowledged value so quantized values that move slowly take a few bytes.
+/// Only entities with one of the listed components are part of the snapshot,
+/// see snapshot_decoder for the receiving side.
+///
+/// The registry does not track changes, so every encode packs and compares
+/// every listed component and costs O(entities) however few of them changed.
+/// The acknowledged state is kept once, indexed by entity id, and snapshots
+/// waiting for an acknowledgement only keep the entities that changed
+template <typename Registry, typename... Components>
+class snapshot_encoder
+{
+	static_assert(sizeof...(Components) > 0 && sizeof...(Components) < 32, "Snapshots need 1 to 31 components");
+	static_assert((std::is_trivially_copyable_v<snapshot_packed_t<Components>> && ...), "Packed components are written as bytes");
+	static_assert(((std::is_empty_v<snapshot_packed_t<Components>> || std::has_unique_object_representations_v<snapshot_packed_t<Components>>) && ...),
+		"Packed components are compared as bytes, they must not have padding or floating point fields, see snapshot_traits");
+
+	using state = internal::snapshot_state<Components...>;
+	using baseline = internal::snapshot_baseline<Components...>;
+	using value_arrays = std::tuple<std::vector<snapshot_packed_t<Components>>...>;
+
+public:
+	/// Append a snapshot of the registry to a buffer
+	/// @param a_registry the registry to capture
+	/// @param r_out buffer the snapshot is appended to
+	/// @return the sequence number of the snapshot, acknowledge it once the receiver applied it
+	uint64_t encode(Registry& a_registry, std::vector<std::byte>& r_out)
+	{
+		state current = spare_state();
+		current.sequence = m_sequence++;
+		capture(a_registry);
+
+		m_body.clear();
+		const size_t records = write_changes(current, m_body);
+
+		m_header.clear();
+		internal::write_varint(m_header, current.sequence);
+		internal::write_varint(m_header, m_hasBaseline ? m_baselineSequence + 1 : 0);
+		internal::write_varint(m_header, records);
+
+		const uint32_t magic = internal::c_snapshotMagic;
+		const size_t offset = r_out.size();
+		r_out.resize(offset + sizeof(magic));
+		std::memcpy(r_out.data() + offset, &magic, sizeof(magic));
+		internal::write_varint(r_out, m_header.size() + m_body.size());
+		r_out.insert(r_out.end(), m_header.begin(), m_header.end());
+		r_out.insert(r_out.end(), m_body.begin(), m_body.end());
+
+		const uint64_t result = current.sequence;
+		m_pending.push_back(std::move(current));
+		if(m_pending.size() > internal::c_snapshotPending)
+		{
+			recycle(std::move(m_pending.front()));
+			m_pending.pop_front();
+		}
+
+		return result;
+	}
+
+	/// Mark a snapshot as applied by the receiver, later snapshots are encoded
+	/// against it. Acknowledging an old or unknown snapshot does nothing
+	void acknowledge(uint64_t a_sequence)
+	{
+		const auto it = std::find_if(m_pending.begin(), m_pending.end(), [a_sequence](const state& a_state) { return a_state.sequence == a_sequence; });
+		if(it == m_pending.end())
+		{
+			return;
+		}
+
+		state scratch = spare_state();
+		for(auto later = it + 1; later != m_pending.end(); ++later)
+		{
+			m_baseline.rebase(*it, *later, scratch);
+		}
+
+		recycle(std::move(scratch));
+		m_baseline.apply(*it);
+		m_baselineSequence = it->sequence;
+		m_hasBaseline = true;
+		for(auto old = m_pending.begin(); old != it + 1; ++old)
+		{
+			recycle(std::move(*old));
+		}
+
+		m_pending.erase(m_pending.begin(), it + 1);
+	}
+
+	/// Forget the acknowledged snapshot so the next snapshot is complete, for example for a new receiver
+	void reset()
+	{
+		m_baseline.clear();
+		m_hasBaseline = false;
+		m_pending.clear();
+	}
+
+private:
+	/// Masks of an entity id, see c_snapshotSleeping
+	struct slot
+	{
+		/// Components in the registry, valid if stamp is the current stamp
+		uint32_t current{0};
+
+		/// Components whose value differs from the acknowledged snapshot
+		uint32_t changed{0};
+		uint32_t stamp{0};
+	};
+
+	uint64_t m_sequence{0};
+	uint64_t m_baselineSequence{0};
+	bool m_hasBaseline{false};
+
+	baseline m_baseline;
+
+	/// Values captured by the last encode, indexed by entity id
+	value_arrays m_captured;
+	std::vector<slot> m_slots;
+	uint32_t m_stamp{0};
+
+	/// Entities each snapshot changed against the acknowledged snapshot, removed entities have an empty mask
+	std::deque<state> m_pending;
+	std::vector<state> m_spare;
+	std::vector<std::byte> m_header;
+	std::vector<std::byte> m_body;
+
+	state spare_state()
+	{
+		if(m_spare.empty())
+		{
+			return state{};
+		}
+
+		state result = std::move(m_spare.back());
+		m_spare.pop_back();
+		result.clear();
+		return result;
+	}
+
+	void recycle(state&& a_state)
+	{
+		if(m_spare.size() < 2)
+		{
+			m_spare.push_back(std::move(a_state));
+		}
+	}
+
+	/// Grow the arrays indexed by entity id, they never shrink
+	void reserve(size_t a_id)
+	{
+		if(a_id < m_slots.size())
+		{
+			return;
+		}
+
+		const size_t size = std::max(a_id + 1, m_slots.size() * 2);
+		m_slots.resize(size);
+		m_baseline.reserve(size - 1);
+		std::apply([size](auto&... r_values) { (r_values.resize(size), ...); }, m_captured);
+	}
+
+	/// Pack every component and keep the values that differ from the acknowledged snapshot
+	void capture(Registry& a_registry)
+	{
+		if(++m_stamp == 0)
+		{
+			for(slot& current : m_slots)
+			{
+				current.stamp = 0;
+			}
+
+			m_stamp = 1;
+		}
+
+		uint32_t bit = 1;
+		([&]()
+		{
+			using traits = snapshot_traits<Components>;
+			using packed = snapshot_packed_t<Components>;
+			auto& storage = a_registry.template getComponentsOfType<Components>();
+			const auto scan = [&](auto a_begin, auto a_end, uint32_t a_bits)
+			{
+				for(auto it = a_begin; it != a_end; ++it)
+				{
+					const size_t id = it.owner().id();
+					reserve(id);
+
+					slot& current = m_slots[id];
+					if(current.stamp != m_stamp)
+					{
+						current = slot{0, 0, m_stamp};
+					}
+
+					current.current |= a_bits;
+					const packed value = traits::pack(*it);
+					const auto& previous = std::get<std::vector<packed>>(m_baseline.values);
+					if((m_baseline.masks[id] & bit) == 0 || std::memcmp(&value, &previous[id], internal::c_packedSize<packed>) != 0)
+					{
+						current.changed |= bit;
+						std::get<std::vector<packed>>(m_captured)[id] = value;
+					}
+				}
+			};
+
+			scan(storage.begin(), storage.end(), bit);
+			auto sleeping = storage.sleeping();
+			scan(sleeping.begin(), sleeping.end(), bit | internal::c_snapshotSleeping);
+			bit <<= 1;
+		}(), ...);
+	}
+
+	/// Write a record for every entity that differs from the acknowledged snapshot
+	/// and keep the entities in the pending snapshot
+	/// @return the number of records
+	size_t write_changes(state& r_current, std::vector<std::byte>& r_out)
+	{
+		size_t records = 0;
+		size_t previousId = 0;
+		for(size_t id = 0; id < m_slots.size(); id++)
+		{
+			const slot& current = m_slots[id];
+			const bool captured = current.stamp == m_stamp;
+			const uint32_t mask = captured ? current.current : 0;
+			const uint32_t changed = captured ? current.changed : 0;
+			const uint32_t previousMask = m_baseline.masks[id];
+			if(mask == previousMask && changed == 0)
+			{
+				continue;
+			}
+
+			// Removed entities are written with an empty mask
+			internal::write_varint(r_out, id - previousId);
+			internal::write_varint(r_out, mask);
+			internal::write_varint(r_out, changed);
+			previousId = id;
+			records++;
+
+			r_current.ids.push_back(id);
+			r_current.masks.push_back(mask);
+			uint32_t bit = 1;
+			([&]()
+			{
+				using packed = snapshot_packed_t<Components>;
+				const auto& previous = std::get<std::vector<packed>>(m_baseline.values);
+				const auto& values = std::get<std::vector<packed>>(m_captured);
+				auto& pending = std::get<std::vector<packed>>(r_current.values);
+				if((changed & bit) != 0)
+				{
+					internal::write_xor<internal::c_packedSize<packed>>(r_out, reinterpret_cast<const std::byte*>(&values[id]),
+						(previousMask & bit) != 0 ? reinterpret_cast<const std::byte*>(&previous[id]) : nullptr);
+					pending.push_back(values[id]);
+				}
+				else
+				{
+					pending.push_back((mask & bit) != 0 ? previous[id] : packed{});
+				}
+
+				bit <<= 1;
+			}(), ...);
+		}
+
+		return records;
+	}
+};
+
+/// Outcome of snapshot_decoder::decode
+enum class snapshot_status : uint8_t
+{
+	/// The snapshot was applied to the registry
+	applied,
+
+	/// The bytes do not hold a complete snapshot yet
+	incomplete,
+
+	/// The bytes do not hold a valid snapshot
+	invalid,
+
+	/// The snapshot was encoded against a snapshot the decoder does not hold, it
+	/// joined late, missed snapshots or the sender fell more than c_snapshotPending
+	/// snapshots behind. Every later delta fails the same way until the sender calls
+	/// snapshot_encoder::reset and sends a complete snapshot
+	missing_baseline,
+};
+
+/// Result of snapshot_decoder::decode
+struct snapshot_result
+{
+	/// Bytes of the snapshot, known for applied snapshots and missing baselines so
+	/// the caller can skip to the next snapshot of a stream, 0 otherwise
+	size_t bytes;
+	snapshot_status status;
+};
+
+/// Applies snapshots written by a snapshot_encoder with the same components to
+/// another registry. Entities are created, changed and removed so the registry
+/// matches the encoded one, their ids differ from the encoded registry.
+///
+/// Like the encoder the decoder keeps one complete snapshot, the latest one a
+/// delta was encoded against, and the entities that differ from it for each of
+/// the last c_snapshotPending + 1 snapshots, as any of them can become the
+/// baseline of a later delta. A delta against an older snapshot reports
+/// snapshot_status::missing_baseline
+template <typename Registry, typename... Components>
+class snapshot_decoder
+{
+	using state = internal::snapshot_state<Components...>;
+	using baseline = internal::snapshot_baseline<Components...>;
+
+public:
+	/// Apply one snapshot
+	/// @param a_bytes bytes starting at a snapshot, more snapshots may follow
+	/// @param r_registry the registry to update
+	/// @return the bytes of the snapshot and whether it was applied
+	snapshot_result decode(std::span<const std::byte> a_bytes, Registry& r_registry)
+	{
+		internal::snapshot_reader reader{a_bytes.data(), a_bytes.data() + a_bytes.size()};
+		uint32_t magic = 0;
+		if(a_bytes.size() < sizeof(magic))
+		{
+			return {0, snapshot_status::incomplete};
+		}
+
+		std::memcpy(&magic, reader.it, sizeof(magic));
+		reader.it += sizeof(magic);
+		if(magic != internal::c_snapshotMagic)
+		{
+			return {0, snapshot_status::invalid};
+		}
+
+		const uint64_t length = reader.varint();
+		if(reader.failed || static_cast<uint64_t>(reader.end - reader.it) < length)
+		{
+			return {0, snapshot_status::incomplete};
+		}
+
+		reader.end = reader.it + length;
+		const size_t bytes = static_cast<size_t>(reader.end - a_bytes.data());
+		const uint64_t sequence = reader.varint();
+		const uint64_t baselineSequence = reader.varint();
+		const uint64_t records = reader.varint();
+		if(reader.failed)
+		{
+			return {0, snapshot_status::invalid};
+		}
+
+		if(baselineSequence == 0)
+		{
+			forget_baseline();
+		}
+		else if(!m_hasBaseline || m_baselineSequence != baselineSequence - 1)
+		{
+			const auto it = std::find_if(m_received.begin(), m_received.end(), [baselineSequence](const state& a_state) { return a_state.sequence == baselineSequence - 1; });
+			if(it == m_received.end())
+			{
+				return {bytes, snapshot_status::missing_baseline};
+			}
+
+			// The encoder only moves its baseline forward, older snapshots are never referenced again
+			promote(it);
+		}
+
+		state next;
+		next.sequence = sequence;
+		if(!rebuild(reader, records, next))
+		{
+			return {0, snapshot_status::invalid};
+		}
+
+		apply(next, r_registry);
+		m_current = next;
+		m_received.push_back(std::move(next));
+		if(m_received.size() > internal::c_snapshotPending + 1)
+		{
+			m_received.pop_front();
+		}
+
+		return {bytes, snapshot_status::applied};
+	}
+
+	/// Returns the entity created for an entity of the encoded registry or an invalid entity
+	[[nodiscard]] entity local(size_t a_encodedId) const
+	{
+		return a_encodedId < m_locals.size() ? m_locals[a_encodedId] : entity{};
+	}
+
+private:
+	baseline m_baseline;
+	uint64_t m_baselineSequence{0};
+	bool m_hasBaseline{false};
+
+	/// Snapshots decoded after the baseline as the entities that differ from it
+	std::deque<state> m_received;
+
+	/// The snapshot the registry matches as the entities that differ from the baseline
+	state m_current;
+	state m_scratch;
+	std::vector<entity> m_locals;
+
+	/// Make a received snapshot the baseline
+	void promote(typename std::deque<state>::iterator a_snapshot)
+	{
+		for(auto later = a_snapshot + 1; later != m_received.end(); ++later)
+		{
+			m_baseline.rebase(*a_snapshot, *later, m_scratch);
+		}
+
+		m_baseline.rebase(*a_snapshot, m_current, m_scratch);
+		m_baseline.apply(*a_snapshot);
+		m_baselineSequence = a_snapshot->sequence;
+		m_hasBaseline = true;
+		m_received.erase(m_received.begin(), a_snapshot + 1);
+	}
+
+	/// Complete snapshots are encoded against no snapshot, the applied snapshot is
+	/// kept as every entity that differs from an empty baseline
+	void forget_baseline()
+	{
+		if(m_hasBaseline)
+		{
+			m_scratch.clear();
+			size_t c = 0;
+			for(size_t id = 0; id < m_baseline.masks.size() || c < m_current.ids.size(); id++)
+			{
+				if(c < m_current.ids.size() && m_current.ids[c] == id)
+				{
+					if(m_current.masks[c] != 0)
+					{
+						m_scratch.push(m_current, c);
+					}
+
+					c++;
+				}
+				else if(m_baseline.mask(id) != 0)
+				{
+					m_baseline.push(id, m_scratch);
+				}
+			}
+
+			std::swap(m_scratch, m_current);
+			m_baseline.clear();
+			m_hasBaseline = false;
+		}
+
+		m_received.clear();
+	}
+
+	/// Build the entities that differ from the baseline from the records
+	bool rebuild(internal::snapshot_reader& r_reader, uint64_t a_records, state& r_next) const
+	{
+		size_t id = 0;
+		for(uint64_t i = 0; i < a_records; i++)
+		{
+			const uint64_t offset = r_reader.varint();
+			const auto mask = static_cast<uint32_t>(r_reader.varint());
+			const auto changed = static_cast<uint32_t>(r_reader.varint());
+			if(r_reader.failed || (i > 0 && offset == 0))
+			{
+				return false;
+			}
+
+			id += offset;
+			const uint32_t previousMask = m_baseline.mask(id);
+			m_baseline.push(id, r_next);
+			r_next.masks.back() = mask;
+			uint32_t bit = 1;
+			([&]()
+			{
+				using packed = snapshot_packed_t<Components>;
+				auto& value = std::get<std::vector<packed>>(r_next.values).back();
+				if((changed & bit) != 0)
+				{
+					if((previousMask & bit) == 0)
+					{
+						std::memset(static_cast<void*>(&value), 0, sizeof(packed));
+					}
+
+					r_reader.template apply_xor<internal::c_packedSize<packed>>(reinterpret_cast<std::byte*>(&value));
+				}
+
+				bit <<= 1;
+			}(), ...);
+		}
+
+		return !r_reader.failed && r_reader.it == r_reader.end;
+	}
+
+	/// Returns the value of an entity in a snapshot or in the baseline if the snapshot
+	/// does not hold it, only read components in the mask so the baseline holds the id
+	template <typename Packed>
+	[[nodiscard]] const Packed& value_of(const state& a_state, bool a_inState, size_t a_index, size_t a_id) const
+	{
+		return a_inState ? std::get<std::vector<Packed>>(a_state.values)[a_index] : std::get<std::vector<Packed>>(m_baseline.values)[a_id];
+	}
+
+	/// Change the registry from the applied snapshot to the next one, only entities
+	/// that differ from the baseline in either of them can change
+	void apply(const state& a_next, Registry& r_registry)
+	{
+		size_t c = 0;
+		size_t n = 0;
+		while(c < m_current.ids.size() || n < a_next.ids.size())
+		{
+			const size_t currentId = c < m_current.ids.size() ? m_current.ids[c] : std::numeric_limits<size_t>::max();
+			const size_t nextId = n < a_next.ids.size() ? a_next.ids[n] : std::numeric_limits<size_t>::max();
+			const size_t id = std::min(currentId, nextId);
+			const bool inCurrent = currentId == id;
+			const bool inNext = nextId == id;
+			const uint32_t previousMask = inCurrent ? m_current.masks[c] : m_baseline.mask(id);
+			const uint32_t mask = inNext ? a_next.masks[n] : m_baseline.mask(id);
+			const size_t currentIndex = c;
+			const size_t nextIndex = n;
+			c += inCurrent ? 1 : 0;
+			n += inNext ? 1 : 0;
+			if(mask == 0)
+			{
+				if(previousMask != 0)
+				{
+					r_registry.removeEntity(m_locals[id]);
+					m_locals[id] = entity{};
+				}
+
+				continue;
+			}
+
+			if(previousMask == 0)
+			{
+				if(id >= m_locals.size())
+				{
+					m_locals.resize(id + 1);
+				}
+
+				m_locals[id] = r_registry.createEntity();
+			}
+
+			const entity local = m_locals[id];
+			uint32_t bit = 1;
+			([&]()
+			{
+				using traits = snapshot_traits<Components>;
+				using packed = snapshot_packed_t<Components>;
+				if((mask & bit) == 0)
+				{
+					if((previousMask & bit) != 0)
+					{
+						r_registry.template removeComponent<Components>(local);
+					}
+				}
+				else if((previousMask & bit) == 0)
+				{
+					Components component{};
+					traits::unpack(value_of<packed>(a_next, inNext, nextIndex, id), component);
+					r_registry.template addComponent<Components>(local, std::move(component));
+				}
+				else
+				{
+					const packed& value = value_of<packed>(a_next, inNext, nextIndex, id);
+					const packed& previous = value_of<packed>(m_current, inCurrent, currentIndex, id);
+					if(std::memcmp(&value, &previous, internal::c_packedSize<packed>) != 0)
+					{
+						traits::unpack(value, *r_registry.template getComponent<Components>(local));
+					}
+				}
+
+				bit <<= 1;
+			}(), ...);
+
+			// Adding components wakes the entity so the sleep state is applied last
+			const bool sleeping = (mask & internal::c_snapshotSleeping) != 0;
+			if(sleeping && !r_registry.isSleeping(local))
+			{
+				r_registry.sleep(local);
+			}
+			else if(!sleeping && r_registry.isSleeping(local))
+			{
+				r_registry.wake(local);
+			}
+		}
+	}
+};
+
+} // ecs
+
+#endif  // ECS_SNAPSHOT_H
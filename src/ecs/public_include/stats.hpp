@@ -0,0 +1,115 @@
+
+#ifndef ECS_STATS_H
+#define ECS_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ecs
+{
+
+/// Memory and occupancy statistics of a single storage
+struct storage_stats
+{
+	/// Name of the stored type
+	std::string_view name;
+
+	/// Size of a single stored element in bytes
+	size_t element_size{0};
+
+	/// Size of the cold part of an element in bytes, kept in a parallel storage
+	size_t cold_element_size{0};
+
+	/// Number of elements per page
+	size_t page_size{0};
+
+	/// Number of allocated pages
+	size_t pages{0};
+
+	/// Number of live elements
+	size_t live{0};
+
+	/// Number of live elements that belong to sleeping entities
+	size_t sleeping{0};
+
+	/// Number of elements the allocated pages can hold
+	size_t capacity{0};
+
+	/// Number of bytes reserved by the storage
+	size_t bytes_reserved{0};
+
+	/// Fraction of reserved slots that do not hold a live element [0, 1]
+	double fragmentation{0};
+
+	/// Time spent iterating the storage during the last frame
+	double last_frame_iteration_ms{0};
+};
+
+/// Statistics of a whole registry
+struct registry_stats
+{
+	/// Number of created entities
+	size_t entities{0};
+
+	/// Number of bytes reserved by the registry
+	size_t bytes_reserved{0};
+
+	/// Statistics of the entity storage
+	storage_stats entity_storage;
+
+	/// Statistics of every component storage in registry order
+	std::vector<storage_stats> component_storages;
+
+	/// Number of unique names and bytes reserved by the name pool
+	size_t names{0};
+	size_t name_pool_bytes{0};
+};
+
+/// Accumulates iteration time of a storage over a frame. Reductions running
+/// on several threads at once may add to the same timer
+class iteration_timer
+{
+public:
+	iteration_timer() = default;
+
+	iteration_timer(const iteration_timer& a_other)
+		: m_current{a_other.m_current.load(std::memory_order_relaxed)}
+		, m_last{a_other.m_last}
+	{}
+
+	iteration_timer& operator=(const iteration_timer& a_other)
+	{
+		m_current.store(a_other.m_current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_last = a_other.m_last;
+		return *this;
+	}
+
+	/// Add time spent iterating during the current frame
+	void add(std::chrono::nanoseconds a_elapsed)
+	{
+		m_current.fetch_add(a_elapsed.count(), std::memory_order_relaxed);
+	}
+
+	/// Move the current frame time into the last frame time
+	void end_frame()
+	{
+		m_last = std::chrono::nanoseconds(m_current.exchange(0, std::memory_order_relaxed));
+	}
+
+	/// Returns the time spent iterating during the last frame in milliseconds
+	[[nodiscard]] double last_frame_ms() const
+	{
+		return static_cast<double>(m_last.count()) / 1'000'000.0;
+	}
+
+private:
+	std::atomic<std::chrono::nanoseconds::rep> m_current{0};
+	std::chrono::nanoseconds m_last{0};
+};
+
+} // ecs
+
+#endif  // ECS_STATS_H
@@ -6,6 +6,11 @@
 #include <array>
 #include <type_traits>
 #include <memory>
+#include <vector>
+#include <span>
+#include <iterator>
+#include <algorithm>
+#include <compare>
 
 #include <iostream>
 
@@ -44,115 +49,181 @@ namespace internal
 	constexpr const auto max = Number > Other ? Number : Other;
 }
 
-template <typename Type>
-struct storage_node
+/// Random access iterator over the elements of a paged storage. Iterators are
+/// invalidated when the storage allocates a new page
+template <typename Type, size_t PageSize>
+struct storage_iterator
 {
-	using type = Type;
-	storage_node<Type>* next;
-	storage_node<Type>* prev;
-	Type data;
-};
-
-template <typename Type>
-struct storage_node_iterator
-{
-	using iterator_category = std::forward_iterator_tag;
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept  = std::random_access_iterator_tag;
 	using difference_type   = std::ptrdiff_t;
-	using value_type        = Type;
+	using value_type        = std::remove_cv_t<Type>;
 	using pointer           = std::add_pointer_t<Type>;
 	using reference         = std::add_lvalue_reference_t<Type>;
 
-	using self_iterator     = storage_node_iterator<Type>;
-	using node_type         = storage_node<Type>;
+	using self_iterator     = storage_iterator<Type, PageSize>;
+	using page_type         = std::array<value_type, PageSize>;
+
+	static constexpr int PageShift = internal::log2<PageSize>();
+	static constexpr size_t PageMask = PageSize - 1;
 
 public:
-	explicit storage_node_iterator(node_type* a_ptr)
-		: m_ptr{a_ptr}
+	storage_iterator() = default;
+	explicit storage_iterator(const std::unique_ptr<page_type>* a_pages, difference_type a_index)
+		: m_pages{a_pages}
+		, m_index{a_index}
 	{}
 
-	reference operator*() const { return m_ptr->data; }
-    pointer operator->() { return &m_ptr->data; }
+	reference operator*() const { return (*m_pages[m_index >> PageShift])[m_index & PageMask]; }
+	pointer operator->() const { return &**this; }
+	reference operator[](difference_type a_offset) const { return *(*this + a_offset); }
 
-	self_iterator& operator++() {
-		m_ptr = m_ptr->next;
-		return *this;
-	}
+	self_iterator& operator++() { ++m_index; return *this; }
+	self_iterator operator++(int) { self_iterator copy = *this; ++m_index; return copy; }
+	self_iterator& operator--() { --m_index; return *this; }
+	self_iterator operator--(int) { self_iterator copy = *this; --m_index; return copy; }
+	self_iterator& operator+=(difference_type a_offset) { m_index += a_offset; return *this; }
+	self_iterator& operator-=(difference_type a_offset) { m_index -= a_offset; return *this; }
 
-	friend bool operator== (const self_iterator& a, const self_iterator& b) { return a.m_ptr == b.m_ptr; };
-    friend bool operator!= (const self_iterator& a, const self_iterator& b) { return a.m_ptr != b.m_ptr; };
+	friend self_iterator operator+(self_iterator a, difference_type b) { return a += b; }
+	friend self_iterator operator+(difference_type a, self_iterator b) { return b += a; }
+	friend self_iterator operator-(self_iterator a, difference_type b) { return a -= b; }
+	friend difference_type operator-(const self_iterator& a, const self_iterator& b) { return a.m_index - b.m_index; }
+
+	friend bool operator==(const self_iterator& a, const self_iterator& b) { return a.m_index == b.m_index; }
+	friend auto operator<=>(const self_iterator& a, const self_iterator& b) { return a.m_index <=> b.m_index; }
+
+	/// Returns the index of the element inside the storage
+	[[nodiscard]] size_t index() const { return static_cast<size_t>(m_index); }
 private:
-	node_type* m_ptr;
+	const std::unique_ptr<page_type>* m_pages{nullptr};
+	difference_type m_index{0};
 };
 
+/// Paged storage, elements never move once added and pages are allocated on demand
 template <typename Type, size_t PageSize, size_t ExpectedSize = 0>
 struct storage
 {
 	static constexpr int PageShift = internal::log2<PageSize>();
-	static constexpr int PageMask = ~((~0) << internal::max<PageShift - 1, 0>);
+	static constexpr size_t PageMask = PageSize - 1;
 	static_assert(internal::is_power_of_two<PageSize> && PageShift >= 0, "PageSize is not a power of two");
-	static_assert((1 << PageShift) == PageSize);
+	static_assert((size_t(1) << PageShift) == PageSize);
 
-	using iterator = storage_node_iterator<Type>;
+	using iterator = storage_iterator<Type, PageSize>;
+	using const_iterator = storage_iterator<const Type, PageSize>;
 	using element_type = Type;
-	using node_type = storage_node<Type>;
-	using page_type = std::array<node_type, PageSize>;
+	using page_type = std::array<Type, PageSize>;
 
-	storage()
-	{
-		create_page<true>();
-	}
+	storage() = default;
 
 private:
 	size_t m_count{0};
-	node_type* m_tailPrev{nullptr};
-	node_type* m_head{nullptr};
-	node_type* m_tail{nullptr}; // Element to be written to
 	std::vector<std::unique_ptr<page_type>> m_pages;
 
-	template <bool First>
-	constexpr void create_page()
+	void create_page()
 	{
-		auto& page = *m_pages.emplace_back(std::make_unique<page_type>());
-
-		auto& first = page[0];
-		auto& last = page[PageSize - 1];
-		if constexpr(First)
+		// Pages of trivial elements are left uninitialized, writing a whole page
+		// up front costs as much as filling it. Every slot is assigned before it
+		// is read
+		if constexpr(std::is_trivially_copyable_v<Type> && std::is_trivially_destructible_v<Type>
+			&& alignof(page_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
 		{
-			first.prev = nullptr;
-			m_head = &first;
+			m_pages.emplace_back(static_cast<page_type*>(::operator new(sizeof(page_type))));
 		}
 		else
 		{
-			first.prev = m_tailPrev;
-			m_tailPrev->next = &first;
+			m_pages.emplace_back(std::make_unique<page_type>());
 		}
+	}
+public:
+	iterator begin() { return iterator(m_pages.data(), 0); }
+	iterator end() { return iterator(m_pages.data(), static_cast<std::ptrdiff_t>(m_count)); }
+	const_iterator begin() const { return const_iterator(m_pages.data(), 0); }
+	const_iterator end() const { return const_iterator(m_pages.data(), static_cast<std::ptrdiff_t>(m_count)); }
+	size_t size() const { return m_count; }
+
+	/// Returns the number of allocated pages
+	size_t page_count() const { return m_pages.size(); }
 
-		m_tail = &first;
-		if constexpr(PageSize > 1)
+	/// Returns the number of elements the allocated pages can hold
+	size_t capacity() const { return m_pages.size() * PageSize; }
+
+	/// Returns the number of bytes reserved by the storage
+	size_t bytes_reserved() const
+	{
+		return m_pages.size() * sizeof(page_type)
+			+ m_pages.capacity() * sizeof(typename decltype(m_pages)::value_type);
+	}
+
+	/// Returns the elements of a page as a contiguous span
+	/// @param a_page the index of the page
+	std::span<Type> page(size_t a_page)
+	{
+		const size_t first = a_page << PageShift;
+		const size_t count = m_count > first ? std::min(m_count - first, PageSize) : 0;
+		return std::span<Type>(m_pages[a_page]->data(), count);
+	}
+
+	/// Returns an element at the specified position 
+	Type* get(size_t a_index)
+	{
+		auto& page = *(m_pages[a_index >> PageShift]);
+		return &page[a_index & PageMask];
+	}
+
+	/// Append elements without assigning them and allocate the pages they need
+	/// @return the index of the first appended element
+	size_t grow(size_t a_count)
+	{
+		const size_t first = m_count;
+		m_count += a_count;
+		m_pages.reserve((m_count + PageSize - 1) >> PageShift);
+		while(capacity() < m_count)
 		{
-			first.next = &page[1];
-			last.prev = &page[PageSize - 2];
+			create_page();
 		}
 
-		last.next = nullptr;
-		for(size_t i = 1; i < PageSize - 1; i++)
+		return first;
+	}
+
+	/// Call a function with every page part of a range of elements
+	/// @param a_first the index of the first element
+	/// @param a_count the number of elements
+	/// @param a_func function called with (std::span<Type>, size_t offset), the
+	///               offset of the first element of the span inside the range
+	template <typename Func>
+	void for_each_range(size_t a_first, size_t a_count, Func&& a_func)
+	{
+		size_t offset = 0;
+		while(offset < a_count)
 		{
-			auto& item = page[i];
-			item.prev = &(page[i - 1]);
-			item.next = &(page[i + 1]);
+			const size_t index = a_first + offset;
+			const size_t count = std::min(a_count - offset, PageSize - (index & PageMask));
+			a_func(std::span<Type>(m_pages[index >> PageShift]->data() + (index & PageMask), count), offset);
+			offset += count;
 		}
 	}
-public:
-	iterator begin() { return iterator(m_head); }
-	iterator end() { return iterator(m_tail); }
-	size_t size() const { return m_count; }
-	
-	/// Returns an element at the specified position 
-	Type* get(size_t a_index)
+
+	/// Assign a value to a range of elements, one fill per page
+	/// @param a_first the index of the first element
+	/// @param a_count the number of elements
+	/// @param a_value the value to copy
+	void fill(size_t a_first, size_t a_count, const Type& a_value)
 	{
-		auto& page = *(m_pages[a_index >> PageShift]);
-		auto result = &page[a_index & PageMask].data;
-		return result;
+		for_each_range(a_first, a_count, [&a_value](std::span<Type> r_elements, size_t)
+		{
+			std::fill(r_elements.begin(), r_elements.end(), a_value);
+		});
+	}
+
+	/// Remove the last element, its slot is reset to release resources it holds
+	void pop_back()
+	{
+		m_count--;
+		if constexpr(!std::is_trivially_destructible_v<Type>)
+		{
+			*get(m_count) = Type{};
+		}
 	}
 
 	template <typename... Args>
@@ -161,16 +232,12 @@ public:
 		size_t pages_requred = m_count >> PageShift;
 		if(pages_requred >= m_pages.size())
 		{
-			create_page<false>();
+			create_page();
 		}
 
-		m_count++;
-		auto* current = m_tail;
-		current->data = typename node_type::type {a_arguments...};
-
-		m_tailPrev = m_tail;
-		m_tail = m_tail->next;
-		return &current->data;
+		auto* current = get(m_count++);
+		*current = Type {a_arguments...};
+		return current;
 	}
 };
 
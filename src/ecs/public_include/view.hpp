@@ -0,0 +1,91 @@
+
+#ifndef ECS_VIEW_H
+#define ECS_VIEW_H
+
+#include <chrono>
+#include <tuple>
+
+#include "entity.hpp"
+#include "filter.hpp"
+
+namespace ecs
+{
+
+/// Iterates all entities that have every listed component. The first
+/// component drives the iteration, put the rarest component first
+template <typename Registry, typename Driver, typename... Others>
+class view
+{
+public:
+	explicit view(Registry& a_registry)
+		: m_registry{a_registry}
+	{}
+
+	/// Call a function for every entity that has all components
+	/// @param a_func function called with (entity, Driver&, Others&...)
+	template <typename Func>
+	void each(Func&& a_func)
+	{
+		using namespace std::chrono;
+		auto& storage = m_registry.template getComponentsOfType<Driver>();
+		const auto start = high_resolution_clock::now();
+		for(auto it = storage.begin(), end = storage.end(); it != end; ++it)
+		{
+			visit(it.owner(), *it, a_func);
+		}
+		storage.add_iteration_time(duration_cast<nanoseconds>(high_resolution_clock::now() - start));
+	}
+
+	/// Call a function for every selected entity that has all components
+	/// @param a_selection a selection built from the storage of the driving component
+	/// @param a_func function called with (entity, Driver&, Others&...)
+	template <typename Func>
+	void each(const selection& a_selection, Func&& a_func)
+	{
+		using namespace std::chrono;
+		auto& storage = m_registry.template getComponentsOfType<Driver>();
+		const auto start = high_resolution_clock::now();
+		a_selection.for_each([this, &storage, &a_func](size_t a_index)
+		{
+			visit(storage.owner(a_index), *storage.get(a_index), a_func);
+		});
+		storage.add_iteration_time(duration_cast<nanoseconds>(high_resolution_clock::now() - start));
+	}
+
+	/// Select the entities whose driving component matches a predicate
+	/// @param a_predicate predicate called with the driving component, see ecs::predicate
+	/// @param r_selection the selection to write to, reuse it to avoid allocations
+	template <typename Predicate>
+	void filter(const Predicate& a_predicate, selection& r_selection)
+	{
+		internal::evaluate_filter(m_registry.template getComponentsOfType<Driver>(), a_predicate, r_selection);
+	}
+
+private:
+	template <typename Func>
+	void visit(entity a_entity, Driver& a_driver, Func& a_func)
+	{
+		if constexpr(sizeof...(Others) == 0)
+		{
+			a_func(a_entity, a_driver);
+		}
+		else
+		{
+			const auto* record = m_registry.entity_record(a_entity);
+			const std::tuple<Others*...> others{
+				m_registry.template component_of<Others>(record)...
+			};
+
+			if(((std::get<Others*>(others) != nullptr) && ...))
+			{
+				a_func(a_entity, a_driver, *std::get<Others*>(others)...);
+			}
+		}
+	}
+
+	Registry& m_registry;
+};
+
+} // ecs
+
+#endif  // ECS_VIEW_H
@@ -0,0 +1,1041 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <utility>
+
+#include "registry.hpp"
+#include "snapshot.hpp"
+
+struct position
+{
+	float x, y, z;
+};
+
+struct velocity
+{
+	float x, y, z;
+};
+
+struct marker {};
+
+struct aircraft
+{
+	float heading;
+};
+
+struct aircraft_metadata
+{
+	std::string callsign;
+	std::string operator_name;
+};
+
+template <>
+struct ecs::cold_traits<aircraft>
+{
+	using type = aircraft_metadata;
+};
+
+using test_registry = ecs::registry<
+	ecs::component<position, 16>,
+	ecs::component<velocity, 16>,
+	ecs::component<marker, 16>>;
+
+TEST(ecs_registry_test, component_index)
+{
+	static_assert(test_registry::component_index<position> == 0);
+	static_assert(test_registry::component_index<velocity> == 1);
+	static_assert(test_registry::component_index<marker> == 2);
+	static_assert(test_registry::component_index<int> == ecs::details::npos);
+
+	static_assert(test_registry::has_component<position>);
+	static_assert(!test_registry::has_component<double>);
+
+	static_assert(ecs::details::is_unique_v<int, float, double>);
+	static_assert(!ecs::details::is_unique_v<int, float, int>);
+}
+
+TEST(ecs_registry_test, add_component)
+{
+	test_registry registry;
+
+	ecs::entity entity = registry.createEntity();
+	position* pos = registry.addComponent<position>(entity, 1.0f, 2.0f, 3.0f);
+	ASSERT_NE(pos, nullptr);
+	EXPECT_EQ(pos->x, 1.0f);
+	EXPECT_EQ(pos->y, 2.0f);
+	EXPECT_EQ(pos->z, 3.0f);
+
+	// Adding the component again overwrites the old value
+	position* same = registry.addComponent<position>(entity, 4.0f, 5.0f, 6.0f);
+	EXPECT_EQ(pos, same);
+	EXPECT_EQ(pos->x, 4.0f);
+
+	EXPECT_EQ(registry.addComponent<position>(ecs::entity{}), nullptr);
+}
+
+TEST(ecs_registry_test, name_pool)
+{
+	ecs::name_pool pool;
+
+	const uint32_t a = pool.intern("value.1");
+	const uint32_t b = pool.intern("value.2");
+	EXPECT_NE(a, b);
+	EXPECT_EQ(pool.intern("value.1"), a);
+	EXPECT_EQ(pool.find("value.2"), b);
+	EXPECT_EQ(pool.find("value.3"), ecs::name::invalid);
+	EXPECT_EQ(pool.get(a), "value.1");
+	EXPECT_EQ(pool.get(ecs::name::invalid), "");
+	EXPECT_EQ(pool.size(), 2u);
+
+	// Views stay valid while the pool grows
+	std::string_view first = pool.get(a);
+	for(int i = 0; i < 100'000; i++)
+	{
+		pool.intern("grow." + std::to_string(i));
+	}
+	EXPECT_EQ(first, "value.1");
+	EXPECT_EQ(pool.find("grow.99999"), pool.size() - 1);
+
+	const std::string large(100'000, 'x');
+	EXPECT_EQ(pool.get(pool.intern(large)), large);
+	EXPECT_EQ(pool.get(pool.intern("")), "");
+	EXPECT_EQ(pool.find("grow.5"), a + 7);
+
+	// Batched interning returns the same handles
+	const std::string_view batch[] = {"value.2", "batch.1", "value.1", "batch.1"};
+	uint32_t handles[4]{};
+	pool.intern(batch, handles);
+	EXPECT_EQ(handles[0], b);
+	EXPECT_EQ(handles[1], pool.find("batch.1"));
+	EXPECT_EQ(handles[2], a);
+	EXPECT_EQ(handles[3], handles[1]);
+}
+
+TEST(ecs_registry_test, find_by_name)
+{
+	ecs::registry<
+		ecs::component<position, 16>,
+		ecs::component<ecs::name, 16>> registry;
+
+	ecs::entity a = registry.createEntity();
+	ecs::entity b = registry.createEntity();
+	registry.setName(a, "alpha");
+	registry.setName(b, "beta");
+
+	EXPECT_EQ(registry.findByName("alpha").id(), a.id());
+	EXPECT_EQ(registry.findByName("beta").id(), b.id());
+	EXPECT_EQ(registry.findByName("gamma").id(), ecs::entity::invalid);
+	EXPECT_EQ(registry.getName(a), "alpha");
+
+	// Renaming releases the old name
+	registry.setName(a, "gamma");
+	EXPECT_EQ(registry.findByName("alpha").id(), ecs::entity::invalid);
+	EXPECT_EQ(registry.findByName("gamma").id(), a.id());
+	EXPECT_EQ(registry.getName(a), "gamma");
+	EXPECT_EQ(registry.names().size(), 3u);
+
+	// Shared names are found while any entity still has them
+	ecs::entity c = registry.createEntity();
+	ecs::entity d = registry.createEntity();
+	registry.setName(c, "beta");
+	registry.setName(d, "beta");
+	EXPECT_EQ(registry.findByName("beta").id(), d.id());
+	registry.setName(d, "delta");
+	EXPECT_NE(registry.findByName("beta").id(), ecs::entity::invalid);
+	EXPECT_EQ(registry.getName(registry.findByName("beta")), "beta");
+	registry.removeEntity(registry.findByName("beta"));
+	EXPECT_EQ(registry.getName(registry.findByName("beta")), "beta");
+	registry.removeComponent<ecs::name>(registry.findByName("beta"));
+	EXPECT_EQ(registry.findByName("beta").id(), ecs::entity::invalid);
+
+	// Setting the same name again keeps the count
+	registry.setName(d, "delta");
+	registry.removeEntity(d);
+	EXPECT_EQ(registry.findByName("delta").id(), ecs::entity::invalid);
+
+	// Batched names stamped over several pages
+	const auto group = registry.instantiate(ecs::prefab(position{}), 100);
+	registry.setNames(group, [](size_t a_offset, std::string& r_name)
+	{
+		r_name += "unit." + std::to_string(a_offset % 50);
+	});
+	EXPECT_EQ(registry.getName(group[7]), "unit.7");
+	EXPECT_EQ(registry.getName(group[57]), "unit.7");
+	EXPECT_EQ(registry.findByName("unit.7").id(), group[57].id());
+	registry.removeEntity(group[57]);
+	EXPECT_EQ(registry.findByName("unit.7").id(), group[7].id());
+
+	// Ranges with named entities rename one entity at a time
+	registry.setNames(group, [](size_t a_offset, std::string& r_name)
+	{
+		r_name += a_offset == 3 ? "alpha" : "unit.x";
+	});
+	EXPECT_EQ(registry.getName(group[3]), "alpha");
+	EXPECT_EQ(registry.getName(group[99]), "unit.x");
+	EXPECT_EQ(registry.findByName("unit.7").id(), ecs::entity::invalid);
+	EXPECT_EQ(registry.getComponentsOfType<ecs::name>().size(), 100u);
+}
+
+TEST(ecs_registry_test, stats)
+{
+	test_registry registry;
+	for(int i = 0; i < 10; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		if(i % 2 == 0)
+		{
+			registry.addComponent<velocity>(entity, 1.0f, 0.0f, 0.0f);
+		}
+	}
+
+	float sum = 0;
+	registry.each<position>([&sum](ecs::entity, position& a_value) { sum += a_value.x; });
+	EXPECT_EQ(sum, 45.0f);
+	registry.endFrame();
+
+	ecs::registry_stats stats = registry.stats();
+	EXPECT_EQ(stats.entities, 10u);
+	EXPECT_EQ(stats.entity_storage.live, 10u);
+	ASSERT_EQ(stats.component_storages.size(), 3u);
+
+	const ecs::storage_stats& positions = stats.component_storages[0];
+	EXPECT_EQ(positions.name, "position");
+	EXPECT_EQ(positions.live, 10u);
+	EXPECT_EQ(positions.pages, 1u);
+	EXPECT_EQ(positions.capacity, positions.page_size);
+	EXPECT_GE(positions.bytes_reserved, positions.capacity * sizeof(position));
+	EXPECT_NEAR(positions.fragmentation, 1.0 - 10.0 / positions.capacity, 1e-9);
+	EXPECT_GE(positions.last_frame_iteration_ms, 0.0);
+
+	EXPECT_EQ(stats.component_storages[1].name, "velocity");
+	EXPECT_EQ(stats.component_storages[1].live, 5u);
+	EXPECT_EQ(stats.component_storages[2].live, 0u);
+}
+
+TEST(ecs_registry_test, random_access_iterators)
+{
+	using storage_type = ecs::internal::registry_storage<position, 4>;
+	static_assert(std::random_access_iterator<ecs::storage::storage<int, 4>::iterator>);
+	static_assert(std::random_access_iterator<storage_type::iterator>);
+	static_assert(std::random_access_iterator<storage_type::const_iterator>);
+	static_assert(std::ranges::random_access_range<storage_type>);
+	static_assert(std::ranges::sized_range<storage_type>);
+
+	// Use a small page size so the components span several pages
+	storage_type storage;
+	for(int i = 0; i < 10; i++)
+	{
+		storage.emplace(ecs::entity{}, float(9 - i), 0.0f, 0.0f);
+	}
+
+	EXPECT_EQ(storage.stats().pages, 3u);
+	EXPECT_EQ(storage.end() - storage.begin(), 10);
+	EXPECT_EQ(storage.begin()[5].x, 4.0f);
+	EXPECT_EQ((storage.end() - 1)->x, 0.0f);
+
+	const float sum = std::transform_reduce(storage.begin(), storage.end(), 0.0f, std::plus<>{},
+		[](const position& a_value) { return a_value.x; });
+	EXPECT_EQ(sum, 45.0f);
+
+	auto filtered = storage | std::views::filter([](const position& a_value) { return a_value.x > 6.0f; });
+	EXPECT_EQ(std::ranges::distance(filtered), 3);
+}
+
+TEST(ecs_registry_test, sort)
+{
+	test_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		entities.push_back(registry.createEntity());
+		registry.addComponent<position>(entities.back(), float((i * 7) % 10), float(i), 0.0f);
+	}
+
+	registry.sleep(entities[3]);
+	registry.sort<position>([](const position& a, const position& b) { return a.x < b.x; });
+
+	// Components keep their owners and iteration follows the order
+	auto& positions = registry.getComponentsOfType<position>();
+	float previous = -1.0f;
+	for(auto it = positions.begin(); it != positions.end(); ++it)
+	{
+		EXPECT_LT(previous, it->x);
+		EXPECT_EQ(registry.getComponent<position>(it.owner()), &*it);
+		previous = it->x;
+	}
+
+	for(int i = 0; i < 10; i++)
+	{
+		EXPECT_EQ(registry.getComponent<position>(entities[i])->y, float(i));
+	}
+}
+
+TEST(ecs_registry_test, view)
+{
+	test_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 100; i++)
+	{
+		ecs::entity entity = entities.emplace_back(registry.createEntity());
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		if(i % 3 == 0)
+		{
+			registry.addComponent<velocity>(entity, 1.0f, 0.0f, 0.0f);
+		}
+	}
+
+	size_t count = 0;
+	registry.view<velocity, position>().each([&count](ecs::entity a_entity, velocity& a_velocity, position& a_position)
+	{
+		EXPECT_EQ(a_entity.id() % 3, 0u);
+		EXPECT_EQ(a_position.x, float(a_entity.id()));
+		a_position.x += a_velocity.x;
+		count++;
+	});
+	EXPECT_EQ(count, 34u);
+	EXPECT_EQ(registry.getComponent<position>(entities[3])->x, 4.0f);
+	EXPECT_EQ(registry.getComponent<position>(entities[4])->x, 4.0f);
+}
+
+TEST(ecs_registry_test, filter)
+{
+	ecs::selection selection;
+	selection.reset(130);
+	selection.words()[0] = 0b1010;
+	selection.words()[2] = 0b1;
+	selection.invalidate_indices();
+	EXPECT_EQ(selection.count(), 3u);
+	EXPECT_TRUE(selection.test(128));
+	EXPECT_FALSE(selection.test(129));
+	EXPECT_EQ(selection.indices(), (std::vector<uint32_t>{1, 3, 128}));
+
+	test_registry registry;
+	for(int i = 0; i < 1000; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), float(i % 10), 0.0f);
+		if(i % 2 == 0)
+		{
+			registry.addComponent<velocity>(entity, 1.0f, 0.0f, 0.0f);
+		}
+	}
+
+	// Single range over a member
+	registry.filter<position>(ecs::predicate::between(&position::x, 100.0f, 199.0f), selection);
+	EXPECT_EQ(selection.size(), 1000u);
+	EXPECT_EQ(selection.count(), 100u);
+	EXPECT_EQ(selection.indices().front(), 100u);
+	EXPECT_EQ(selection.indices().back(), 199u);
+
+	// Box made of two ranges
+	auto box = registry.filter<position>(ecs::predicate::all(
+		ecs::predicate::less(&position::x, 500.0f),
+		ecs::predicate::between([](const position& a_value) { return a_value.y; }, 2.0f, 3.0f)));
+	EXPECT_EQ(box.count(), 100u);
+
+	// The selection is reused by a multi component view
+	size_t count = 0;
+	registry.view<position, velocity>().each(box, [&count](ecs::entity, position& a_position, velocity&)
+	{
+		EXPECT_LT(a_position.x, 500.0f);
+		EXPECT_EQ(static_cast<int>(a_position.x) % 2, 0);
+		count++;
+	});
+	EXPECT_EQ(count, 50u);
+
+	size_t single = 0;
+	registry.each<position>(box, [&single](ecs::entity, position&) { single++; });
+	EXPECT_EQ(single, 100u);
+}
+
+TEST(ecs_registry_test, sleep)
+{
+	test_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		registry.addComponent<velocity>(entity, 1.0f, 0.0f, 0.0f);
+		entities.push_back(entity);
+	}
+
+	for(int i = 0; i < 10; i += 2)
+	{
+		registry.sleep(entities[i]);
+	}
+
+	auto& positions = registry.getComponentsOfType<position>();
+	EXPECT_TRUE(registry.isSleeping(entities[0]));
+	EXPECT_FALSE(registry.isSleeping(entities[1]));
+	EXPECT_EQ(positions.size(), 5u);
+	EXPECT_EQ(positions.sleeping_size(), 5u);
+	EXPECT_EQ(registry.stats().component_storages[0].sleeping, 5u);
+
+	// Iteration only visits awake entities and records still resolve
+	size_t count = 0;
+	registry.view<position, velocity>().each([&count](ecs::entity a_entity, position& a_position, velocity&)
+	{
+		EXPECT_EQ(a_entity.id() % 2, 1u);
+		EXPECT_EQ(a_position.x, float(a_entity.id()));
+		count++;
+	});
+	EXPECT_EQ(count, 5u);
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		EXPECT_EQ(registry.getComponent<position>(entities[i])->x, float(i));
+	}
+
+	// Mutation wakes the entity
+	registry.patch<position>(entities[4], [](position& a_value) { a_value.y = 1.0f; });
+	EXPECT_FALSE(registry.isSleeping(entities[4]));
+	registry.addComponent<marker>(entities[6]);
+	EXPECT_FALSE(registry.isSleeping(entities[6]));
+	EXPECT_EQ(positions.size(), 7u);
+	EXPECT_EQ(registry.getComponent<position>(entities[4])->y, 1.0f);
+
+	// Adding a component to an awake entity keeps sleeping components intact
+	registry.sleep(entities[1]);
+	registry.sleep(entities[6]);
+	registry.addComponent<marker>(entities[3]);
+	registry.addComponent<marker>(entities[5]);
+	EXPECT_TRUE(registry.isSleeping(entities[1]));
+	EXPECT_EQ(registry.getComponent<position>(entities[1])->x, 1.0f);
+	auto& markers = registry.getComponentsOfType<marker>();
+	EXPECT_EQ(markers.size(), 2u);
+	EXPECT_EQ(markers.sleeping_size(), 1u);
+	EXPECT_EQ(markers.sleeping().begin().owner().id(), entities[6].id());
+	EXPECT_EQ(registry.getComponent<marker>(entities[6]), &*markers.sleeping().begin());
+
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		registry.wake(entities[i]);
+		EXPECT_EQ(registry.getComponent<position>(entities[i])->x, float(i));
+		EXPECT_EQ(registry.getComponent<velocity>(entities[i])->x, 1.0f);
+	}
+	EXPECT_EQ(positions.sleeping_size(), 0u);
+}
+
+TEST(ecs_registry_test, reduce)
+{
+	test_registry registry;
+	for(int i = 0; i < 100'000; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, 1.0f / float(i + 1), float(i % 1000) - 500.0f, 0.0f);
+	}
+
+	const auto map = [](const position& a_value) { return a_value.x; };
+	const auto combine = [](float a, float b) { return a + b; };
+
+	// The result does not depend on the number of threads
+	ecs::thread_pool single(1);
+	const float expected = registry.reduce<position>(single, 0.0f, map, combine);
+	for(size_t threads : {2, 3, 8})
+	{
+		ecs::thread_pool pool(threads);
+		for(int i = 0; i < 4; i++)
+		{
+			const float value = registry.reduce<position>(pool, 0.0f, map, combine);
+			EXPECT_EQ(std::bit_cast<uint32_t>(value), std::bit_cast<uint32_t>(expected));
+		}
+	}
+	EXPECT_NEAR(expected, 12.09f, 0.01f);
+
+	// Bounds of a field
+	using bounds = std::pair<float, float>;
+	const bounds range = registry.reduce<position>(bounds{0.0f, 0.0f},
+		[](const position& a_value) { return bounds{a_value.y, a_value.y}; },
+		[](const bounds& a, const bounds& b) { return bounds{std::min(a.first, b.first), std::max(a.second, b.second)}; });
+	EXPECT_EQ(range.first, -500.0f);
+	EXPECT_EQ(range.second, 499.0f);
+
+	// An empty storage returns the initial value
+	test_registry empty;
+	EXPECT_EQ(empty.reduce<position>(5.0f, map, combine), 5.0f);
+}
+
+TEST(ecs_registry_test, nested_pool_run)
+{
+	// Tasks calling run again on the same pool must not wait for themselves
+	ecs::thread_pool pool(4);
+	std::atomic<size_t> calls{0};
+	pool.run(4, [&](size_t)
+	{
+		pool.run(4, [&](size_t) { calls++; });
+	});
+	EXPECT_EQ(calls.load(), 16u);
+
+	// Nor when the nested call is a reduction on the pool
+	test_registry registry;
+	for(int i = 0; i < 40'000; i++)
+	{
+		registry.addComponent<position>(registry.createEntity(), 1.0f, 0.0f, 0.0f);
+	}
+
+	std::vector<float> sums(8);
+	pool.run(sums.size(), [&](size_t a_index)
+	{
+		sums[a_index] = registry.reduce<position>(pool, 0.0f,
+			[](const position& a_value) { return a_value.x; },
+			[](float a, float b) { return a + b; });
+	});
+	for(float sum : sums)
+	{
+		EXPECT_EQ(sum, 40'000.0f);
+	}
+}
+
+TEST(ecs_registry_test, prefab)
+{
+	struct label
+	{
+		std::string text;
+	};
+	static_assert(!std::is_trivially_copyable_v<label>);
+
+	using prefab_registry = ecs::registry<
+		ecs::component<position, 16>,
+		ecs::component<velocity, 16>,
+		ecs::component<label, 16>>;
+	prefab_registry registry;
+	const ecs::entity single = registry.createEntity();
+	registry.addComponent<position>(single, 9.0f, 9.0f, 9.0f);
+
+	// A sleeping velocity forces the per entity path for that storage
+	const ecs::entity sleeping = registry.createEntity();
+	registry.addComponent<velocity>(sleeping, 7.0f, 7.0f, 7.0f);
+	registry.sleep(sleeping);
+
+	const ecs::prefab formation(position{1.0f, 2.0f, 3.0f}, velocity{0.0f, 0.0f, 1.0f}, label{"formation"});
+	const auto entities = registry.instantiate(formation, 1000);
+	ASSERT_EQ(entities.size(), 1000u);
+	EXPECT_EQ(entities[0].id(), sleeping.id() + 1);
+
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		EXPECT_EQ(registry.getComponent<position>(entities[i])->z, 3.0f);
+		EXPECT_EQ(registry.getComponent<velocity>(entities[i])->z, 1.0f);
+		EXPECT_EQ(registry.getComponent<label>(entities[i])->text, "formation");
+	}
+	EXPECT_EQ(registry.getComponentsOfType<position>().size(), 1001u);
+	EXPECT_EQ(registry.getComponentsOfType<velocity>().size(), 1000u);
+	EXPECT_EQ(registry.getComponent<velocity>(sleeping)->x, 7.0f);
+	EXPECT_TRUE(registry.isSleeping(sleeping));
+
+	size_t count = 0;
+	registry.view<position, velocity>().each([&count, &entities](ecs::entity a_entity, position&, velocity&)
+	{
+		EXPECT_GE(a_entity.id(), entities[0].id());
+		count++;
+	});
+	EXPECT_EQ(count, 1000u);
+
+	// Capture an existing entity
+	const auto captured = registry.capture<position, velocity>(single);
+	EXPECT_EQ(captured.get<position>().x, 9.0f);
+	EXPECT_EQ(captured.get<velocity>().x, 0.0f);
+	const auto copies = registry.instantiate(captured, 3);
+	EXPECT_EQ(registry.getComponent<position>(copies[2])->y, 9.0f);
+	EXPECT_EQ(registry.getComponent<label>(copies[2]), nullptr);
+}
+
+TEST(ecs_registry_test, cold)
+{
+	static_assert(ecs::has_cold_v<aircraft>);
+	static_assert(!ecs::has_cold_v<position>);
+	static_assert(sizeof(ecs::internal::internal_component<aircraft>) <= 16);
+
+	using cold_registry = ecs::registry<
+		ecs::component<position, 16>,
+		ecs::component<aircraft, 16>>;
+	cold_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		registry.addComponent<aircraft>(entity, float(i) * 10.0f);
+		registry.getCold<aircraft>(entity)->callsign = "AC" + std::to_string(i);
+		entities.push_back(entity);
+	}
+
+	EXPECT_EQ(registry.getCold<aircraft>(ecs::entity{}), nullptr);
+	EXPECT_EQ(registry.stats().component_storages[1].cold_element_size, sizeof(aircraft_metadata));
+
+	// The cold part follows its component when slots are swapped
+	registry.sleep(entities[2]);
+	registry.sleep(entities[5]);
+	registry.wake(entities[2]);
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		EXPECT_EQ(registry.getComponent<aircraft>(entities[i])->heading, float(i) * 10.0f);
+		EXPECT_EQ(registry.getCold<aircraft>(entities[i])->callsign, "AC" + std::to_string(i));
+	}
+
+	// Iteration only sees the hot part
+	float sum = 0;
+	registry.view<aircraft, position>().each([&sum](ecs::entity, aircraft& a_aircraft, position&) { sum += a_aircraft.heading; });
+	EXPECT_EQ(sum, 400.0f);
+
+	const auto copies = registry.instantiate(ecs::prefab(aircraft{1.0f}), 3);
+	EXPECT_TRUE(registry.getCold<aircraft>(copies[2])->callsign.empty());
+}
+
+TEST(ecs_registry_test, remove)
+{
+	test_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		registry.addComponent<velocity>(entity, float(i), 0.0f, 0.0f);
+		entities.push_back(entity);
+	}
+
+	registry.sleep(entities[8]);
+	EXPECT_TRUE(registry.removeComponent<velocity>(entities[2]));
+	EXPECT_FALSE(registry.removeComponent<velocity>(entities[2]));
+	EXPECT_TRUE(registry.removeComponent<velocity>(entities[8]));
+	EXPECT_EQ(registry.getComponent<velocity>(entities[2]), nullptr);
+	EXPECT_EQ(registry.getComponentsOfType<velocity>().size(), 8u);
+	EXPECT_EQ(registry.getComponentsOfType<velocity>().sleeping_size(), 0u);
+
+	registry.sleep(entities[4]);
+	registry.removeEntity(entities[5]);
+	registry.removeEntity(entities[4]);
+	EXPECT_FALSE(registry.isValid(entities[5]));
+	EXPECT_FALSE(registry.isValid(entities[4]));
+	EXPECT_EQ(registry.addComponent<position>(entities[5], 1.0f, 1.0f, 1.0f), nullptr);
+	EXPECT_EQ(registry.stats().entities, 8u);
+	EXPECT_EQ(registry.getComponentsOfType<position>().size(), 7u);
+	EXPECT_EQ(registry.getComponentsOfType<position>().sleeping_size(), 1u);
+
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		if(i == 4 || i == 5)
+		{
+			continue;
+		}
+
+		EXPECT_EQ(registry.getComponent<position>(entities[i])->x, float(i));
+		if(i != 2 && i != 8)
+		{
+			EXPECT_EQ(registry.getComponent<velocity>(entities[i])->x, float(i));
+		}
+	}
+}
+
+TEST(ecs_registry_test, move_entity)
+{
+	using move_registry = ecs::registry<
+		ecs::component<position, 16>,
+		ecs::component<aircraft, 16>,
+		ecs::component<ecs::name, 16>>;
+	move_registry source;
+	move_registry target;
+
+	const ecs::entity other = target.createEntity();
+	const ecs::entity entity = source.createEntity();
+	source.addComponent<position>(entity, 1.0f, 2.0f, 3.0f);
+	source.addComponent<aircraft>(entity, 90.0f);
+	source.getCold<aircraft>(entity)->callsign = "SAS123";
+	source.setName(entity, "plane");
+	source.sleep(entity);
+
+	const ecs::entity moved = source.moveEntity(entity, target);
+	EXPECT_NE(moved.id(), other.id());
+	EXPECT_FALSE(source.isValid(entity));
+	EXPECT_NE(source.findByName("plane").id(), entity.id());
+	EXPECT_EQ(source.getComponentsOfType<position>().total_size(), 0u);
+
+	EXPECT_EQ(target.getComponent<position>(moved)->z, 3.0f);
+	EXPECT_EQ(target.getComponent<aircraft>(moved)->heading, 90.0f);
+	EXPECT_EQ(target.getCold<aircraft>(moved)->callsign, "SAS123");
+	EXPECT_EQ(target.findByName("plane").id(), moved.id());
+	EXPECT_TRUE(target.isSleeping(moved));
+	EXPECT_EQ(source.moveEntity(entity, target).id(), ecs::entity::invalid);
+}
+
+TEST(ecs_registry_test, query)
+{
+	test_registry registry;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 100; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		registry.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		if(i % 2 == 0)
+		{
+			registry.addComponent<velocity>(entity, 1.0f, 0.0f, 0.0f);
+		}
+		entities.push_back(entity);
+	}
+
+	auto& moving = registry.query<position, velocity>();
+	EXPECT_EQ(&moving, (&registry.query<position, velocity>()));
+	EXPECT_EQ(moving.size(), 50u);
+
+	// Changes of other components do not touch the query
+	registry.addComponent<marker>(entities[1]);
+	EXPECT_EQ(moving.pending(), 0u);
+
+	registry.addComponent<velocity>(entities[1], 1.0f, 0.0f, 0.0f);
+	registry.removeComponent<velocity>(entities[2]);
+	registry.removeEntity(entities[4]);
+	registry.sleep(entities[6]);
+	EXPECT_EQ(moving.pending(), 4u);
+	EXPECT_EQ(moving.size(), 48u);
+	EXPECT_TRUE(moving.entities().contains(entities[1]));
+	EXPECT_FALSE(moving.entities().contains(entities[6]));
+
+	registry.wake(entities[6]);
+	const auto spawned = registry.instantiate(ecs::prefab(position{}, velocity{}), 10);
+	EXPECT_EQ(moving.size(), 59u);
+	EXPECT_TRUE(moving.entities().contains(spawned[9]));
+
+	size_t count = 0;
+	moving.each([&count](ecs::entity, position&, velocity& a_velocity)
+	{
+		a_velocity.y = 1.0f;
+		count++;
+	});
+	EXPECT_EQ(count, 59u);
+	EXPECT_EQ(registry.getComponent<velocity>(entities[8])->y, 1.0f);
+
+	// A second query with the same components in another order is separate
+	EXPECT_EQ((registry.query<velocity, position>().size()), 59u);
+
+	// A query that is not used stops recording changes and is rebuilt instead
+	const auto many = registry.instantiate(ecs::prefab(position{}, velocity{}), 40'000);
+	registry.instantiate(ecs::prefab(position{}, velocity{}), 40'000);
+	registry.removeEntity(many[0]);
+	EXPECT_TRUE(moving.needs_rebuild());
+	EXPECT_EQ(moving.pending(), 0u);
+	EXPECT_EQ(moving.size(), 80'058u);
+	EXPECT_FALSE(moving.needs_rebuild());
+	EXPECT_FALSE(moving.entities().contains(many[0]));
+}
+
+TEST(ecs_registry_test, storage_policy)
+{
+	using policy_registry = ecs::registry<
+		ecs::component<position, 16, ecs::storage_policy::stable>,
+		ecs::component<velocity, 16, ecs::storage_policy::packed>>;
+	policy_registry registry;
+	std::vector<ecs::entity> entities;
+	std::vector<position*> pointers;
+	for(int i = 0; i < 100; i++)
+	{
+		ecs::entity entity = registry.createEntity();
+		pointers.push_back(registry.addComponent<position>(entity, float(i), 0.0f, 0.0f));
+		registry.addComponent<velocity>(entity, float(i), 0.0f, 0.0f);
+		entities.push_back(entity);
+	}
+
+	const auto handle = registry.getHandle<velocity>(entities[99]);
+	for(int i = 0; i < 100; i += 3)
+	{
+		registry.sleep(entities[i]);
+	}
+	registry.removeEntity(entities[1]);
+	registry.removeComponent<position>(entities[2]);
+
+	// Stable components did not move, packed ones are found through handles
+	for(size_t i = 3; i < entities.size(); i++)
+	{
+		EXPECT_EQ(registry.getComponent<position>(entities[i]), pointers[i]);
+		EXPECT_EQ(pointers[i]->x, float(i));
+	}
+	EXPECT_EQ(registry.resolve(handle)->x, 99.0f);
+	EXPECT_EQ(registry.resolve(registry.getHandle<velocity>(entities[1])), nullptr);
+
+	auto& positions = registry.getComponentsOfType<position>();
+	EXPECT_EQ(positions.size(), 64u);
+	EXPECT_EQ(positions.sleeping_size(), 34u);
+	EXPECT_EQ(std::ranges::distance(positions.begin(), positions.end()), 64);
+	EXPECT_EQ(std::ranges::distance(positions.sleeping()), 34);
+
+	// Holes are reused
+	const ecs::entity reused = registry.createEntity();
+	EXPECT_EQ(registry.addComponent<position>(reused, -1.0f, 0.0f, 0.0f), pointers[2]);
+
+	size_t count = 0;
+	registry.view<position, velocity>().each([&count](ecs::entity a_entity, position& a_position, velocity& a_velocity)
+	{
+		EXPECT_NE(a_entity.id() % 3, 0u);
+		EXPECT_EQ(a_position.x, a_velocity.x);
+		count++;
+	});
+	EXPECT_EQ(count, 64u);
+
+	const auto selection = registry.filter<position>(ecs::predicate::less(&position::x, 10.0f));
+	EXPECT_EQ(selection.count(), 5u);
+	EXPECT_EQ((registry.query<position, velocity>().size()), 64u);
+
+	const auto map = [](const position& a_value) { return a_value.x; };
+	const auto combine = [](float a, float b) { return a + b; };
+	ecs::thread_pool pool(3);
+	EXPECT_EQ(registry.reduce<position>(pool, 0.0f, map, combine), registry.reduce<position>(0.0f, map, combine));
+	EXPECT_EQ(registry.reduce<position>(0.0f, map, combine), 3263.0f);
+
+	// Bulk instantiate appends behind the holes and sleeping components
+	const auto spawned = registry.instantiate(ecs::prefab(position{5.0f, 0.0f, 0.0f}), 10);
+	EXPECT_EQ(registry.getComponent<position>(spawned[9])->x, 5.0f);
+	EXPECT_EQ(positions.size(), 75u);
+}
+
+/// Floats have no unique object representation, snapshots carry their bits
+template <typename Vector>
+struct float_bits_traits
+{
+	struct packed
+	{
+		uint32_t x, y, z;
+	};
+
+	static packed pack(const Vector& a_value)
+	{
+		return {std::bit_cast<uint32_t>(a_value.x), std::bit_cast<uint32_t>(a_value.y), std::bit_cast<uint32_t>(a_value.z)};
+	}
+
+	static void unpack(const packed& a_packed, Vector& r_value)
+	{
+		r_value = {std::bit_cast<float>(a_packed.x), std::bit_cast<float>(a_packed.y), std::bit_cast<float>(a_packed.z)};
+	}
+};
+
+template <>
+struct ecs::snapshot_traits<position> : float_bits_traits<position> {};
+
+template <>
+struct ecs::snapshot_traits<velocity> : float_bits_traits<velocity> {};
+
+using snapshot_encoder = ecs::snapshot_encoder<test_registry, position, velocity, marker>;
+using snapshot_decoder = ecs::snapshot_decoder<test_registry, position, velocity, marker>;
+
+static void expect_replica(test_registry& a_source, test_registry& a_replica, const snapshot_decoder& a_decoder)
+{
+	auto& positions = a_source.getComponentsOfType<position>();
+	EXPECT_EQ(positions.total_size(), a_replica.getComponentsOfType<position>().total_size());
+	EXPECT_EQ(a_source.getComponentsOfType<velocity>().total_size(), a_replica.getComponentsOfType<velocity>().total_size());
+	EXPECT_EQ(a_source.getComponentsOfType<marker>().total_size(), a_replica.getComponentsOfType<marker>().total_size());
+
+	const auto check = [&](auto a_begin, auto a_end)
+	{
+		for(auto it = a_begin; it != a_end; ++it)
+		{
+			const ecs::entity local = a_decoder.local(it.owner().id());
+			ASSERT_TRUE(a_replica.isValid(local));
+			EXPECT_EQ(a_replica.getComponent<position>(local)->x, it->x);
+			EXPECT_EQ(a_replica.isSleeping(local), a_source.isSleeping(it.owner()));
+
+			const velocity* expected = a_source.getComponent<velocity>(it.owner());
+			const velocity* actual = a_replica.getComponent<velocity>(local);
+			ASSERT_EQ(expected == nullptr, actual == nullptr);
+			if(expected != nullptr)
+			{
+				EXPECT_EQ(actual->y, expected->y);
+			}
+
+			EXPECT_EQ(a_source.getComponent<marker>(it.owner()) == nullptr, a_replica.getComponent<marker>(local) == nullptr);
+		}
+	};
+
+	check(positions.begin(), positions.end());
+	auto sleeping = positions.sleeping();
+	check(sleeping.begin(), sleeping.end());
+}
+
+TEST(ecs_registry_test, snapshot_round_trip)
+{
+	test_registry source;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 40; i++)
+	{
+		const ecs::entity entity = source.createEntity();
+		source.addComponent<position>(entity, float(i), 0.0f, 0.0f);
+		if(i % 2 == 0)
+		{
+			source.addComponent<velocity>(entity, 0.0f, float(i), 0.0f);
+		}
+
+		if(i % 5 == 0)
+		{
+			source.addComponent<marker>(entity);
+			source.sleep(entity);
+		}
+
+		entities.push_back(entity);
+	}
+
+	snapshot_encoder encoder;
+	snapshot_decoder decoder;
+	test_registry replica;
+	std::vector<std::byte> full;
+	encoder.acknowledge(encoder.encode(source, full));
+	EXPECT_EQ(decoder.decode(full, replica).bytes, full.size());
+	expect_replica(source, replica, decoder);
+
+	// An unchanged registry only costs the header
+	std::vector<std::byte> unchanged;
+	encoder.acknowledge(encoder.encode(source, unchanged));
+	EXPECT_LT(unchanged.size(), 16u);
+	EXPECT_EQ(decoder.decode(unchanged, replica).bytes, unchanged.size());
+
+	source.getComponent<position>(entities[3])->x += 0.5f;
+	source.removeComponent<velocity>(entities[4]);
+	source.addComponent<marker>(entities[7]);
+	source.removeEntity(entities[8]);
+	source.wake(entities[10]);
+	const ecs::entity added = source.createEntity();
+	source.addComponent<position>(added, 100.0f, 0.0f, 0.0f);
+
+	std::vector<std::byte> delta;
+	encoder.encode(source, delta);
+	EXPECT_LT(delta.size(), full.size() / 4);
+	EXPECT_EQ(decoder.decode(delta, replica).bytes, delta.size());
+	expect_replica(source, replica, decoder);
+
+	// Without an acknowledgement the next snapshot is still encoded against the
+	// last acknowledged one, which the decoder kept
+	source.getComponent<position>(entities[3])->x = 3.0f;
+	std::vector<std::byte> next;
+	encoder.encode(source, next);
+	EXPECT_EQ(decoder.decode(next, replica).bytes, next.size());
+	expect_replica(source, replica, decoder);
+}
+
+TEST(ecs_registry_test, snapshot_late_acknowledgement)
+{
+	test_registry source;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		entities.push_back(source.createEntity());
+		source.addComponent<position>(entities.back(), float(i), 0.0f, 0.0f);
+	}
+
+	snapshot_encoder encoder;
+	snapshot_decoder decoder;
+	test_registry replica;
+	std::vector<std::byte> stream;
+	encoder.acknowledge(encoder.encode(source, stream));
+
+	// Acknowledgements arrive two snapshots late, the snapshots in between are
+	// rebased onto every new baseline
+	std::vector<uint64_t> sequences;
+	for(int tick = 0; tick < 6; tick++)
+	{
+		source.getComponent<position>(entities[tick % 3])->x += 1.0f;
+		if(tick == 2)
+		{
+			source.removeEntity(entities[9]);
+		}
+
+		sequences.push_back(encoder.encode(source, stream));
+		if(tick >= 2)
+		{
+			encoder.acknowledge(sequences[tick - 2]);
+		}
+	}
+
+	size_t offset = 0;
+	while(offset < stream.size())
+	{
+		const auto result = decoder.decode(std::span(stream).subspan(offset), replica);
+		ASSERT_EQ(result.status, ecs::snapshot_status::applied);
+		offset += result.bytes;
+	}
+
+	expect_replica(source, replica, decoder);
+
+	// Only the entity changed since the acknowledged snapshot is written
+	encoder.acknowledge(sequences[5]);
+	source.getComponent<position>(entities[4])->x = 40.0f;
+	std::vector<std::byte> delta;
+	encoder.encode(source, delta);
+	EXPECT_EQ(decoder.decode(delta, replica).bytes, delta.size());
+	EXPECT_LT(delta.size(), 24u);
+	expect_replica(source, replica, decoder);
+
+	// More unacknowledged snapshots than the encoder keeps, the baseline stays usable
+	stream.clear();
+	for(int tick = 0; tick < 70; tick++)
+	{
+		source.getComponent<position>(entities[tick % 9])->y += 1.0f;
+		sequences.push_back(encoder.encode(source, stream));
+	}
+
+	offset = 0;
+	while(offset < stream.size())
+	{
+		const auto result = decoder.decode(std::span(stream).subspan(offset), replica);
+		ASSERT_EQ(result.status, ecs::snapshot_status::applied);
+		offset += result.bytes;
+	}
+
+	encoder.acknowledge(sequences.back());
+	source.getComponent<position>(entities[1])->z = 1.0f;
+	delta.clear();
+	encoder.encode(source, delta);
+	EXPECT_EQ(decoder.decode(delta, replica).status, ecs::snapshot_status::applied);
+	expect_replica(source, replica, decoder);
+}
+
+TEST(ecs_registry_test, snapshot_needs_baseline)
+{
+	test_registry source;
+	source.addComponent<position>(source.createEntity(), 1.0f, 2.0f, 3.0f);
+
+	snapshot_encoder encoder;
+	std::vector<std::byte> stream;
+	encoder.acknowledge(encoder.encode(source, stream));
+	const size_t fullSize = stream.size();
+	source.addComponent<position>(source.createEntity(), 4.0f, 5.0f, 6.0f);
+	encoder.encode(source, stream);
+
+	// A decoder joining late cannot apply the delta and reports the size to skip it
+	test_registry lateReplica;
+	snapshot_decoder late;
+	const auto missing = late.decode(std::span(stream).subspan(fullSize), lateReplica);
+	EXPECT_EQ(missing.status, ecs::snapshot_status::missing_baseline);
+	EXPECT_EQ(missing.bytes, stream.size() - fullSize);
+
+	// Snapshots are read back to back from one stream
+	test_registry replica;
+	snapshot_decoder decoder;
+	const size_t first = decoder.decode(stream, replica).bytes;
+	ASSERT_EQ(first, fullSize);
+	EXPECT_EQ(decoder.decode(std::span(stream).subspan(first), replica).bytes, stream.size() - first);
+	EXPECT_EQ(replica.getComponentsOfType<position>().size(), 2u);
+
+	// Truncated snapshots are rejected
+	const auto truncated = decoder.decode(std::span(stream).first(fullSize - 1), replica);
+	EXPECT_EQ(truncated.status, ecs::snapshot_status::incomplete);
+	EXPECT_EQ(truncated.bytes, 0u);
+
+	// Resetting the encoder sends a complete snapshot the late decoder can apply
+	encoder.reset();
+	std::vector<std::byte> full;
+	encoder.acknowledge(encoder.encode(source, full));
+	EXPECT_EQ(late.decode(full, lateReplica).status, ecs::snapshot_status::applied);
+	EXPECT_EQ(lateReplica.getComponentsOfType<position>().size(), 2u);
+
+	// The decoder that holds the previous snapshots applies it as well
+	source.removeEntity(source.getComponentsOfType<position>().begin().owner());
+	std::vector<std::byte> after;
+	encoder.encode(source, after);
+	EXPECT_EQ(decoder.decode(full, replica).status, ecs::snapshot_status::applied);
+	EXPECT_EQ(decoder.decode(after, replica).status, ecs::snapshot_status::applied);
+	EXPECT_EQ(late.decode(after, lateReplica).status, ecs::snapshot_status::applied);
+	EXPECT_EQ(replica.getComponentsOfType<position>().size(), 1u);
+	EXPECT_EQ(lateReplica.getComponentsOfType<position>().size(), 1u);
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "wgs84.hpp"
+
+// Converts 1M positions from 1000 km below the surface out to geostationary
+// orbit one at a time and through the batched conversions of every
+// instruction set the cpu supports
+
+constexpr const size_t c_pointCount = 1'000'000;
+constexpr const int c_repetitions = 10;
+
+static const char* const c_levelNames[] = {"scalar", "avx2", "avx512"};
+
+template <typename Func>
+static double measure(Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	a_func();
+
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		a_func();
+	}
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000.0 / c_repetitions;
+}
+
+static void print(const char* a_name, double a_time, double a_baseline)
+{
+	std::printf("  %-28s: %8.3f ms (%6.1f M points/s, %5.1fx)\n", a_name, a_time,
+		static_cast<double>(c_pointCount) / a_time / 1000.0, a_baseline / a_time);
+}
+
+int main()
+{
+	using geodecy::wgs84;
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+	std::uniform_real_distribution<double> altitude(-1'000'000.0, 36'000'000.0);
+
+	std::vector<double> lat(c_pointCount), lon(c_pointCount), alt(c_pointCount);
+	for(size_t i = 0; i < c_pointCount; i++)
+	{
+		lat[i] = latitude(random);
+		lon[i] = longitude(random);
+		alt[i] = altitude(random);
+	}
+
+	std::vector<double> x(c_pointCount), y(c_pointCount), z(c_pointCount);
+	const double scalarTo = measure([&]() {
+		for(size_t i = 0; i < c_pointCount; i++)
+		{
+			const glm::dvec3 xyz = wgs84::deg::lla2xyz(lat[i], lon[i], alt[i]);
+			x[i] = xyz.x;
+			y[i] = xyz.y;
+			z[i] = xyz.z;
+		}
+	});
+
+	std::vector<double> outLat(c_pointCount), outLon(c_pointCount), outAlt(c_pointCount);
+	const double scalarFrom = measure([&]() {
+		for(size_t i = 0; i < c_pointCount; i++)
+		{
+			const glm::dvec3 lla = wgs84::deg::xyz2lla(x[i], y[i], z[i]);
+			outLat[i] = lla.x;
+			outLon[i] = lla.y;
+			outAlt[i] = lla.z;
+		}
+	});
+
+	std::printf("%zu points\n", c_pointCount);
+	print("lla2xyz scalar loop", scalarTo, scalarTo);
+	print("xyz2lla scalar loop", scalarFrom, scalarFrom);
+
+	const geodecy::simd_level supported = geodecy::supported_simd_level();
+	for(int level = 0; level <= static_cast<int>(supported); level++)
+	{
+		geodecy::set_batch_simd_level(static_cast<geodecy::simd_level>(level));
+		const double to = measure([&]() { wgs84::deg::lla2xyz(lat, lon, alt, x, y, z); });
+		const double from = measure([&]() { wgs84::deg::xyz2lla(x, y, z, outLat, outLon, outAlt); });
+
+		char name[64];
+		std::snprintf(name, sizeof(name), "lla2xyz batch %s", c_levelNames[level]);
+		print(name, to, scalarTo);
+		std::snprintf(name, sizeof(name), "xyz2lla batch %s", c_levelNames[level]);
+		print(name, from, scalarFrom);
+	}
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "wgs84.hpp"
+
+// Distance matrix between random points, 10k x 10k by default or the sizes
+// given on the command line. The batched inverse fills blocks of rows with
+// every instruction set the cpu supports. The naive loop solves one pair at a
+// time and only runs the first rows, its time for the full matrix is scaled
+// from them. The batched distances are compared with the naive ones
+
+constexpr const size_t c_blockRows = 16;
+constexpr const size_t c_naiveRows = 64;
+
+static const char* const c_levelNames[] = {"scalar", "avx2", "avx512"};
+
+template <typename Func>
+static double measure(Func&& a_func)
+{
+	using namespace std::chrono;
+
+	auto start = high_resolution_clock::now();
+	a_func();
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / 1'000'000'000.0;
+}
+
+int main(int argc, char** argv)
+{
+	using geodecy::wgs84_geodesic;
+	const size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+	const size_t columns = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : rows;
+
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+
+	std::vector<double> lat1(rows), lon1(rows), lat2(columns), lon2(columns);
+	for(size_t i = 0; i < rows; i++)
+	{
+		lat1[i] = latitude(random);
+		lon1[i] = longitude(random);
+	}
+	for(size_t i = 0; i < columns; i++)
+	{
+		lat2[i] = latitude(random);
+		lon2[i] = longitude(random);
+	}
+
+	// One pair at a time
+	const size_t naiveRows = std::min(rows, c_naiveRows);
+	std::vector<double> naive(naiveRows * columns);
+	const double naiveTime = measure([&]() {
+		for(size_t row = 0; row < naiveRows; row++)
+		{
+			for(size_t column = 0; column < columns; column++)
+			{
+				naive[row * columns + column] = wgs84_geodesic::deg::inverse(lat1[row], lon1[row], lat2[column], lon2[column]).x;
+			}
+		}
+	}) * static_cast<double>(rows) / static_cast<double>(naiveRows);
+
+	const double pairs = static_cast<double>(rows) * static_cast<double>(columns);
+	std::printf("%zu x %zu distances, naive loop scaled from %zu rows\n", rows, columns, naiveRows);
+	std::printf("  %-14s: %8.2f s (%6.2f M distances/s)\n", "naive", naiveTime, pairs / naiveTime / 1'000'000.0);
+
+	const geodecy::simd_level supported = geodecy::supported_simd_level();
+	std::vector<double> block(c_blockRows * columns);
+	for(int level = 0; level <= static_cast<int>(supported); level++)
+	{
+		geodecy::set_batch_simd_level(static_cast<geodecy::simd_level>(level));
+
+		double error = 0.0;
+		const double time = measure([&]() {
+			for(size_t row = 0; row < rows; row += c_blockRows)
+			{
+				const size_t count = std::min(c_blockRows, rows - row);
+				wgs84_geodesic::deg::distances(
+					std::span<const double>(lat1).subspan(row, count),
+					std::span<const double>(lon1).subspan(row, count),
+					lat2, lon2, block);
+
+				// The first rows are checked against the naive loop
+				for(size_t i = row * columns; i < std::min(row + count, naiveRows) * columns; i++)
+				{
+					error = std::max(error, std::abs(block[i - row * columns] - naive[i]));
+				}
+			}
+		});
+
+		std::printf("  %-14s: %8.2f s (%6.2f M distances/s, %5.1fx), max difference %.1e m\n", c_levelNames[level], time,
+			pairs / time / 1'000'000.0, naiveTime / time, error);
+	}
+
+	geodecy::set_batch_simd_level(supported);
+	return 0;
+}
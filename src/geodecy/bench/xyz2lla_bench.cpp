@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "wgs84.hpp"
+
+// Compares the geodetic policies. For every altitude band the positions are
+// made from random latitudes and longitudes in long double so the errors are
+// those of the policy, then converted one at a time and through the batched
+// conversions of the widest instruction set the cpu supports
+
+constexpr const size_t c_pointCount = 1'000'000;
+constexpr const int c_repetitions = 5;
+
+struct band
+{
+	const char* name;
+	double minimum;
+	double maximum;
+};
+
+static const band c_bands[] = {
+	{"-1000 km to 0",     -1'000'000.0,          0.0},
+	{"0 to 10 km",                 0.0,     10'000.0},
+	{"10 km to 2000 km",      10'000.0,  2'000'000.0},
+	{"2000 km to GEO",     2'000'000.0, 35'786'000.0},
+};
+
+template <typename Func>
+static double measure(Func&& a_func)
+{
+	using namespace std::chrono;
+
+	// Warmup
+	a_func();
+
+	auto start = high_resolution_clock::now();
+	for(int i = 0; i < c_repetitions; i++)
+	{
+		a_func();
+	}
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count()) / c_repetitions;
+}
+
+struct points
+{
+	std::vector<double> lat, lon, alt, x, y, z;
+};
+
+static points make_points(const band& a_band)
+{
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+	std::uniform_real_distribution<double> altitude(a_band.minimum, a_band.maximum);
+
+	const long double a = geodecy::wgs84::c_A;
+	const long double b = geodecy::wgs84::c_B;
+	const long double es = 1 - (b * b) / (a * a);
+	const long double deg2rad = 3.14159265358979323846264338327950288L / 180;
+
+	points result;
+	for(size_t i = 0; i < c_pointCount; i++)
+	{
+		const double lat = latitude(random);
+		const double lon = longitude(random);
+		const double alt = altitude(random);
+
+		const long double sinLat = std::sin(lat * deg2rad);
+		const long double n = a / std::sqrt(1 - es * sinLat * sinLat);
+		const long double horizontal = (n + alt) * std::cos(lat * deg2rad);
+		result.lat.push_back(lat);
+		result.lon.push_back(lon);
+		result.alt.push_back(alt);
+		result.x.push_back(static_cast<double>(horizontal * std::cos(lon * deg2rad)));
+		result.y.push_back(static_cast<double>(horizontal * std::sin(lon * deg2rad)));
+		result.z.push_back(static_cast<double>(((1 - es) * n + alt) * sinLat));
+	}
+	return result;
+}
+
+template <typename TSpheroid>
+static void run(const char* a_name, const points& a_points, bool a_batched)
+{
+	std::vector<double> lat(c_pointCount), lon(c_pointCount), alt(c_pointCount);
+	const double scalar = measure([&]() {
+		for(size_t i = 0; i < c_pointCount; i++)
+		{
+			const glm::dvec3 lla = TSpheroid::deg::xyz2lla(a_points.x[i], a_points.y[i], a_points.z[i]);
+			lat[i] = lla.x;
+			lon[i] = lla.y;
+			alt[i] = lla.z;
+		}
+	});
+
+	double latError = 0.0;
+	double altError = 0.0;
+	for(size_t i = 0; i < c_pointCount; i++)
+	{
+		latError = std::max(latError, std::abs(lat[i] - a_points.lat[i]));
+		altError = std::max(altError, std::abs(alt[i] - a_points.alt[i]));
+	}
+
+	const double batch = measure([&]() {
+		TSpheroid::deg::xyz2lla(a_points.x, a_points.y, a_points.z, lat, lon, alt);
+	});
+
+	for(size_t i = 0; i < c_pointCount; i++)
+	{
+		latError = std::max(latError, std::abs(lat[i] - a_points.lat[i]));
+		altError = std::max(altError, std::abs(alt[i] - a_points.alt[i]));
+	}
+
+	std::printf("  %-12s: %7.2f ns/point, batch %7.2f ns/point%s, max error %.1e deg %.1e m\n", a_name,
+		scalar / c_pointCount, batch / c_pointCount, a_batched ? "" : " (one at a time)", latError, altError);
+}
+
+int main()
+{
+	using namespace geodecy;
+	using wgs84_iterative = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, geodetic_policy::iterative>;
+	using wgs84_bowring1 = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, geodetic_policy::bowring<1>>;
+	using wgs84_bowring2 = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, geodetic_policy::bowring<2>>;
+	using wgs84_heikkinen = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, geodetic_policy::heikkinen>;
+	using wgs84_vermeille = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, geodetic_policy::vermeille>;
+
+	static const char* const levelNames[] = {"scalar", "avx2", "avx512"};
+	std::printf("%zu points per band, batches use %s\n", c_pointCount, levelNames[static_cast<int>(batch_simd_level())]);
+	for(const band& range : c_bands)
+	{
+		const points values = make_points(range);
+		std::printf("%s\n", range.name);
+		run<wgs84_iterative>("iterative", values, false);
+		run<wgs84_bowring1>("bowring<1>", values, true);
+		run<wgs84_bowring2>("bowring<2>", values, true);
+		run<wgs84_heikkinen>("heikkinen", values, true);
+		run<wgs84_vermeille>("vermeille", values, true);
+	}
+
+	return 0;
+}
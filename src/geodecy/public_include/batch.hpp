@@ -0,0 +1,69 @@
+
+#ifndef GEODECY_BATCH
+#define GEODECY_BATCH
+
+#include <cstddef>
+
+namespace geodecy
+{
+
+/// Instruction sets the batched conversions are compiled for
+enum class simd_level
+{
+	scalar = 0,
+	avx2   = 1,
+	avx512 = 2,
+};
+
+/// Returns the widest instruction set supported by both the cpu and the build
+simd_level supported_simd_level();
+
+/// Returns the instruction set used by the batched conversions
+simd_level batch_simd_level();
+
+/// Select the instruction set used by the batched conversions, the widest
+/// supported set is used by default
+/// @param a_level the instruction set to use
+/// @return false if the level is not supported and nothing changed
+bool set_batch_simd_level(simd_level a_level);
+
+namespace internal
+{
+	/// Batchable algorithms of geodetic_policy
+	enum class xyz2lla_method
+	{
+		bowring1,
+		bowring2,
+		heikkinen,
+		vermeille,
+	};
+
+	/// Structure of arrays passed to the batch kernels, the three outputs must
+	/// not overlap the inputs
+	struct batch_arguments
+	{
+		const double* input[3];
+		double* output[3];
+		size_t count;
+
+		/// Semi major and semi minor axis of the spheroid
+		double a;
+		double b;
+
+		/// Angles are multiplied by this on input of lla2xyz and divided by it on output of xyz2lla
+		double angle_scale;
+
+		/// The algorithm used by xyz2lla
+		xyz2lla_method method;
+	};
+
+	/// Convert latitude, longitude and altitude to x, y and z
+	void lla2xyz_batch(const batch_arguments& a_arguments);
+
+	/// Convert x, y and z to latitude, longitude and altitude
+	void xyz2lla_batch(const batch_arguments& a_arguments);
+}
+
+} // geodecy
+
+#endif  // GEODECY_BATCH
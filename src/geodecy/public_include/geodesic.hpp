@@ -0,0 +1,1429 @@
+
+#ifndef GEODECY_GEODESIC
+#define GEODECY_GEODESIC
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "spheroid.hpp"
+#include "trig.hpp"
+
+/// Geodesics on a spheroid with the algorithms of C. F. F. Karney, Algorithms
+/// for geodesics, J. Geodesy 87 (2013). The series are of sixth order in the
+/// third flattening which is accurate to 15 nm for the flattening of the earth
+namespace geodecy
+{
+
+namespace internal
+{
+	constexpr const double c_degree = math::internal::c_pi / 180.0;
+	constexpr const double c_geodesicTiny = 1.4916681462400413e-154; // sqrt(DBL_MIN)
+	constexpr const double c_geodesicTol0 = DBL_EPSILON;
+	constexpr const double c_geodesicTol1 = 200 * c_geodesicTol0;
+	constexpr const double c_geodesicTol2 = 1.4901161193847656e-08; // sqrt(DBL_EPSILON)
+	constexpr const double c_geodesicTolb = c_geodesicTol0 * c_geodesicTol2;
+	constexpr const double c_geodesicXthresh = 1000 * c_geodesicTol2;
+
+	/// Newton iterations before the inverse solution falls back to bisection
+	constexpr const int c_geodesicMaxit1 = 20;
+	constexpr const int c_geodesicMaxit2 = c_geodesicMaxit1 + DBL_MANT_DIG + 10;
+
+	/// Properties of a spheroid and the coefficients of the series of the
+	/// longitude that only depend on it
+	struct geodesic_constants
+	{
+		double a;
+		double b;
+		double f;
+		double f1;
+		double e2;
+		double ep2;
+		double n;
+		double etol2;
+		double A3x[6];
+		double C3x[15];
+	};
+
+	inline geodesic_constants make_geodesic_constants(double a_a, double a_b)
+	{
+		geodesic_constants result{};
+		result.a = a_a;
+		result.b = a_b;
+		result.f = 1.0 - a_b / a_a;
+		result.f1 = a_b / a_a;
+		result.e2 = result.f * (2.0 - result.f);
+		result.ep2 = result.e2 / (result.f1 * result.f1);
+		result.n = result.f / (2.0 - result.f);
+		result.etol2 = 0.1 * c_geodesicTol2 /
+			std::sqrt(std::max(0.001, std::abs(result.f)) * std::min(1.0, 1.0 - result.f / 2.0) / 2.0);
+
+		const auto polyval = [](int a_order, const double* a_coeff, double a_x) {
+			double y = a_order < 0 ? 0.0 : *a_coeff++;
+			while(--a_order >= 0)
+			{
+				y = y * a_x + *a_coeff++;
+			}
+			return y;
+		};
+
+		// Coefficients of eps^5 to eps^0 as polynomials in n
+		static const double s_A3[] = {
+			-3, 128,
+			-2, -3, 64,
+			-1, -3, -1, 16,
+			3, -1, -2, 8,
+			1, -1, 2,
+			1, 1,
+		};
+		for(int j = 5, k = 0, o = 0; j >= 0; j--)
+		{
+			const int m = std::min(6 - j - 1, j);
+			result.A3x[k++] = polyval(m, s_A3 + o, result.n) / s_A3[o + m + 1];
+			o += m + 2;
+		}
+
+		// C3[1] to C3[5], coefficients of eps^5 down to eps^l as polynomials in n
+		static const double s_C3[] = {
+			3, 128,
+			2, 5, 128,
+			-1, 3, 3, 64,
+			-1, 0, 1, 8,
+			-1, 1, 4,
+			5, 256,
+			1, 3, 128,
+			-3, -2, 3, 64,
+			1, -3, 2, 32,
+			7, 512,
+			-10, 9, 384,
+			5, -9, 5, 192,
+			7, 512,
+			-14, 7, 512,
+			21, 2560,
+		};
+		for(int l = 1, k = 0, o = 0; l < 6; l++)
+		{
+			for(int j = 5; j >= l; j--)
+			{
+				const int m = std::min(6 - j - 1, j);
+				result.C3x[k++] = polyval(m, s_C3 + o, result.n) / s_C3[o + m + 1];
+				o += m + 2;
+			}
+		}
+		return result;
+	}
+
+	/// (1 - eps) * A1 - 1
+	GEODECY_INLINE double A1m1f(double a_eps)
+	{
+		const double e2 = a_eps * a_eps;
+		const double t = e2 * (e2 * (e2 + 4.0) + 64.0) / 256.0;
+		return (t + a_eps) / (1.0 - a_eps);
+	}
+
+	GEODECY_INLINE void C1f(double a_eps, double (&r_c)[7])
+	{
+		const double e2 = a_eps * a_eps;
+		double d = a_eps;
+		r_c[1] = d * (e2 * (6.0 - e2) - 16.0) / 32.0;
+		d *= a_eps;
+		r_c[2] = d * (e2 * (64.0 - 9.0 * e2) - 128.0) / 2048.0;
+		d *= a_eps;
+		r_c[3] = d * (9.0 * e2 - 16.0) / 768.0;
+		d *= a_eps;
+		r_c[4] = d * (3.0 * e2 - 5.0) / 512.0;
+		d *= a_eps;
+		r_c[5] = d * -7.0 / 1280.0;
+		d *= a_eps;
+		r_c[6] = d * -7.0 / 2048.0;
+	}
+
+	GEODECY_INLINE void C1pf(double a_eps, double (&r_c)[7])
+	{
+		const double e2 = a_eps * a_eps;
+		double d = a_eps;
+		r_c[1] = d * (e2 * (205.0 * e2 - 432.0) + 768.0) / 1536.0;
+		d *= a_eps;
+		r_c[2] = d * (e2 * (4005.0 * e2 - 4736.0) + 3840.0) / 12288.0;
+		d *= a_eps;
+		r_c[3] = d * (116.0 - 225.0 * e2) / 384.0;
+		d *= a_eps;
+		r_c[4] = d * (2695.0 - 7173.0 * e2) / 7680.0;
+		d *= a_eps;
+		r_c[5] = d * 3467.0 / 7680.0;
+		d *= a_eps;
+		r_c[6] = d * 38081.0 / 61440.0;
+	}
+
+	/// (1 + eps) * A2 - 1
+	GEODECY_INLINE double A2m1f(double a_eps)
+	{
+		const double e2 = a_eps * a_eps;
+		const double t = e2 * (e2 * (-11.0 * e2 - 28.0) - 192.0) / 256.0;
+		return (t - a_eps) / (1.0 + a_eps);
+	}
+
+	GEODECY_INLINE void C2f(double a_eps, double (&r_c)[7])
+	{
+		const double e2 = a_eps * a_eps;
+		double d = a_eps;
+		r_c[1] = d * (e2 * (e2 + 2.0) + 16.0) / 32.0;
+		d *= a_eps;
+		r_c[2] = d * (e2 * (35.0 * e2 + 64.0) + 384.0) / 2048.0;
+		d *= a_eps;
+		r_c[3] = d * (15.0 * e2 + 80.0) / 768.0;
+		d *= a_eps;
+		r_c[4] = d * (7.0 * e2 + 35.0) / 512.0;
+		d *= a_eps;
+		r_c[5] = d * 63.0 / 1280.0;
+		d *= a_eps;
+		r_c[6] = d * 77.0 / 2048.0;
+	}
+
+	GEODECY_INLINE double A3f(const geodesic_constants& a_constants, double a_eps)
+	{
+		const double* x = a_constants.A3x;
+		return ((((x[0] * a_eps + x[1]) * a_eps + x[2]) * a_eps + x[3]) * a_eps + x[4]) * a_eps + x[5];
+	}
+
+	GEODECY_INLINE void C3f(const geodesic_constants& a_constants, double a_eps, double (&r_c)[7])
+	{
+		const double* x = a_constants.C3x;
+		double mult = a_eps;
+		r_c[1] = mult * ((((x[0] * a_eps + x[1]) * a_eps + x[2]) * a_eps + x[3]) * a_eps + x[4]);
+		mult *= a_eps;
+		r_c[2] = mult * (((x[5] * a_eps + x[6]) * a_eps + x[7]) * a_eps + x[8]);
+		mult *= a_eps;
+		r_c[3] = mult * ((x[9] * a_eps + x[10]) * a_eps + x[11]);
+		mult *= a_eps;
+		r_c[4] = mult * (x[12] * a_eps + x[13]);
+		mult *= a_eps;
+		r_c[5] = mult * x[14];
+		r_c[6] = 0.0;
+	}
+
+	/// Clenshaw summation of c[1] sin(2x) + ... + c[6] sin(12x)
+	GEODECY_INLINE double sin_series(double a_sin, double a_cos, const double (&a_c)[7])
+	{
+		const double ar = 2.0 * (a_cos - a_sin) * (a_cos + a_sin);
+		double y0 = 0.0;
+		double y1 = 0.0;
+		y1 = ar * y0 - y1 + a_c[6];
+		y0 = ar * y1 - y0 + a_c[5];
+		y1 = ar * y0 - y1 + a_c[4];
+		y0 = ar * y1 - y0 + a_c[3];
+		y1 = ar * y0 - y1 + a_c[2];
+		y0 = ar * y1 - y0 + a_c[1];
+		return 2.0 * a_sin * a_cos * y0;
+	}
+
+	GEODECY_INLINE void norm2(double& r_sin, double& r_cos)
+	{
+		const double length = std::sqrt(r_sin * r_sin + r_cos * r_cos);
+		r_sin /= length;
+		r_cos /= length;
+	}
+
+	/// Distance and reduced length divided by b between two points of a geodesic
+	/// @param r_s12b the distance, skipped if null
+	/// @param r_m12b the reduced length, skipped if null
+	GEODECY_INLINE void geodesic_lengths(
+		double a_eps,
+		double a_sig12,
+		double a_ssig1, double a_csig1, double a_dn1,
+		double a_ssig2, double a_csig2, double a_dn2,
+		double* r_s12b,
+		double* r_m12b)
+	{
+		double c1[7];
+		double A1 = A1m1f(a_eps);
+		C1f(a_eps, c1);
+		if(r_m12b)
+		{
+			double c2[7];
+			double A2 = A2m1f(a_eps);
+			C2f(a_eps, c2);
+			const double m0 = A1 - A2;
+			A1 += 1.0;
+			A2 += 1.0;
+
+			double j12;
+			if(r_s12b)
+			{
+				const double b1 = sin_series(a_ssig2, a_csig2, c1) - sin_series(a_ssig1, a_csig1, c1);
+				const double b2 = sin_series(a_ssig2, a_csig2, c2) - sin_series(a_ssig1, a_csig1, c2);
+				*r_s12b = A1 * (a_sig12 + b1);
+				j12 = m0 * a_sig12 + (A1 * b1 - A2 * b2);
+			}
+			else
+			{
+				// Unrolled so the batch kernels stay free of inner loops
+				c2[1] = A1 * c1[1] - A2 * c2[1];
+				c2[2] = A1 * c1[2] - A2 * c2[2];
+				c2[3] = A1 * c1[3] - A2 * c2[3];
+				c2[4] = A1 * c1[4] - A2 * c2[4];
+				c2[5] = A1 * c1[5] - A2 * c2[5];
+				c2[6] = A1 * c1[6] - A2 * c2[6];
+				j12 = m0 * a_sig12 + (sin_series(a_ssig2, a_csig2, c2) - sin_series(a_ssig1, a_csig1, c2));
+			}
+
+			// Parentheses keep the cancellation of coincident points exact
+			*r_m12b = a_dn2 * (a_csig1 * a_ssig2) - a_dn1 * (a_ssig1 * a_csig2) - a_csig1 * a_csig2 * j12;
+		}
+		else if(r_s12b)
+		{
+			const double b1 = sin_series(a_ssig2, a_csig2, c1) - sin_series(a_ssig1, a_csig1, c1);
+			*r_s12b = (1.0 + A1) * (a_sig12 + b1);
+		}
+	}
+
+	/// Longitude difference of a geodesic leaving point 1 with the azimuth
+	/// alp1 when it reaches the latitude of point 2, see Karney (2013) eq. 55.
+	/// Equatorial lines need a tiny negative cos(alp1) instead of 0
+	/// @param a_diffp also return the derivative by alp1 in r_dlam12
+	/// @return lam12 minus the longitude difference of the points
+	GEODECY_INLINE double geodesic_lambda12(
+		const geodesic_constants& a_constants,
+		double a_sbet1, double a_cbet1, double a_dn1,
+		double a_sbet2, double a_cbet2, double a_dn2,
+		double a_salp1, double a_calp1,
+		double a_slam120, double a_clam120,
+		double& r_salp2, double& r_calp2,
+		double& r_sig12,
+		double& r_ssig1, double& r_csig1,
+		double& r_ssig2, double& r_csig2,
+		double& r_eps,
+		bool a_diffp,
+		double& r_dlam12)
+	{
+		const double f = a_constants.f;
+
+		// sin(alp1) * cos(bet1) = sin(alp0)
+		const double salp0 = a_salp1 * a_cbet1;
+		const double calp0 = std::sqrt(a_calp1 * a_calp1 + (a_salp1 * a_sbet1) * (a_salp1 * a_sbet1));
+
+		// tan(bet1) = tan(sig1) * cos(alp1), tan(omg1) = sin(alp0) * tan(sig1)
+		double ssig1 = a_sbet1;
+		const double somg1 = salp0 * a_sbet1;
+		double csig1 = a_calp1 * a_cbet1;
+		const double comg1 = a_calp1 * a_cbet1;
+		norm2(ssig1, csig1);
+
+		// Enforce the symmetries of |bet2| = -bet1, sin(alp2) * cos(bet2) = sin(alp0).
+		// Nested selects instead of || keep the batch kernels vectorizable
+		const bool mirrored = a_cbet2 == a_cbet1;
+		const double salp2 = mirrored ? a_salp1 : salp0 / a_cbet2;
+		const double calp2x = std::sqrt((a_calp1 * a_cbet1) * (a_calp1 * a_cbet1) +
+			(a_cbet1 < -a_sbet1
+				? (a_cbet2 - a_cbet1) * (a_cbet1 + a_cbet2)
+				: (a_sbet1 - a_sbet2) * (a_sbet1 + a_sbet2))) / a_cbet2;
+		const double calp2 = mirrored ? (std::abs(a_sbet2) == -a_sbet1 ? std::abs(a_calp1) : calp2x) : calp2x;
+
+		// tan(bet2) = tan(sig2) * cos(alp2), tan(omg2) = sin(alp0) * tan(sig2)
+		double ssig2 = a_sbet2;
+		const double somg2 = salp0 * a_sbet2;
+		double csig2 = calp2 * a_cbet2;
+		const double comg2 = calp2 * a_cbet2;
+		norm2(ssig2, csig2);
+
+		// sig12 = sig2 - sig1 and omg12 = omg2 - omg1, limited to [0, pi]
+		const double ssig12 = csig1 * ssig2 - ssig1 * csig2;
+		const double sig12 = math::atan2((ssig12 > 0.0 ? ssig12 : 0.0) + 0.0, csig1 * csig2 + ssig1 * ssig2);
+		const double somg12r = comg1 * somg2 - somg1 * comg2;
+		const double somg12 = (somg12r > 0.0 ? somg12r : 0.0) + 0.0;
+		const double comg12 = comg1 * comg2 + somg1 * somg2;
+
+		// eta = omg12 - lam120
+		const double eta = math::atan2(
+			somg12 * a_clam120 - comg12 * a_slam120,
+			comg12 * a_clam120 + somg12 * a_slam120);
+		const double k2 = calp0 * calp0 * a_constants.ep2;
+		const double eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+
+		double c3[7];
+		C3f(a_constants, eps, c3);
+		const double b312 = sin_series(ssig2, csig2, c3) - sin_series(ssig1, csig1, c3);
+		const double domg12 = -f * A3f(a_constants, eps) * salp0 * (sig12 + b312);
+
+		if(a_diffp)
+		{
+			double m12b = 0.0;
+			geodesic_lengths(eps, sig12, ssig1, csig1, a_dn1, ssig2, csig2, a_dn2, nullptr, &m12b);
+			r_dlam12 = calp2 == 0.0
+				? -2.0 * a_constants.f1 * a_dn1 / a_sbet1
+				: m12b * a_constants.f1 / (calp2 * a_cbet2);
+		}
+
+		r_salp2 = salp2;
+		r_calp2 = calp2;
+		r_sig12 = sig12;
+		r_ssig1 = ssig1;
+		r_csig1 = csig1;
+		r_ssig2 = ssig2;
+		r_csig2 = csig2;
+		r_eps = eps;
+		return eta + domg12;
+	}
+
+	/// Sine and cosine of an angle in degrees, exact for multiples of 90
+	inline void sincosd(double a_degree, double& r_sin, double& r_cos)
+	{
+		int quadrant = 0;
+		const double r = std::remquo(a_degree, 90.0, &quadrant) * c_degree;
+		const double s = std::sin(r);
+		const double c = std::cos(r);
+		switch(static_cast<unsigned>(quadrant) & 3u)
+		{
+		case 0: r_sin = s; r_cos = c; break;
+		case 1: r_sin = c; r_cos = -s; break;
+		case 2: r_sin = -s; r_cos = -c; break;
+		default: r_sin = -c; r_cos = s; break;
+		}
+		r_cos += 0.0;
+		r_sin = a_degree == 0.0 ? a_degree : r_sin;
+	}
+
+	/// atan2 in degrees reduced to [-45, 45] before the conversion
+	inline double atan2d(double a_y, double a_x)
+	{
+		int quadrant = 0;
+		if(std::abs(a_y) > std::abs(a_x))
+		{
+			std::swap(a_x, a_y);
+			quadrant = 2;
+		}
+		if(std::signbit(a_x))
+		{
+			a_x = -a_x;
+			quadrant++;
+		}
+
+		const double angle = std::atan2(a_y, a_x) / c_degree;
+		switch(quadrant)
+		{
+		case 1: return std::copysign(180.0, a_y) - angle;
+		case 2: return 90.0 - angle;
+		case 3: return -90.0 + angle;
+		default: return angle;
+		}
+	}
+
+	/// Rounds tiny angles so that values below 1/16 deg keep 1e-17 deg of precision
+	inline double round_angle(double a_degree)
+	{
+		const double z = 1.0 / 16.0;
+		double y = std::abs(a_degree);
+		const double w = z - y;
+		y = w > 0.0 ? z - w : y;
+		return std::copysign(y, a_degree);
+	}
+
+	inline double normalize_angle(double a_degree)
+	{
+		const double y = std::remainder(a_degree, 360.0);
+		return std::abs(y) == 180.0 ? std::copysign(180.0, a_degree) : y;
+	}
+
+	/// Error free sum, r_error is the rounding error of the result
+	inline double error_free_sum(double a_u, double a_v, double& r_error)
+	{
+		const double s = a_u + a_v;
+		double up = s - a_v;
+		double vpp = s - up;
+		up -= a_u;
+		vpp -= a_v;
+		r_error = s != 0.0 ? 0.0 - (up + vpp) : s;
+		return s;
+	}
+
+	/// The difference y - x in [-180, 180] and its rounding error
+	inline double angle_difference(double a_x, double a_y, double& r_error)
+	{
+		double t = 0.0;
+		double d = error_free_sum(std::remainder(-a_x, 360.0), std::remainder(a_y, 360.0), t);
+		d = error_free_sum(std::remainder(d, 360.0), t, t);
+		if(d == 0.0 || std::abs(d) == 180.0)
+		{
+			d = std::copysign(d, t == 0.0 ? a_y - a_x : -t);
+		}
+		r_error = t;
+		return d;
+	}
+
+	/// Solves the astroid problem of nearly antipodal points, the positive root of
+	/// k^4 + 2k^3 - (x^2 + y^2 - 1)k^2 - 2y^2k - y^2 = 0
+	inline double astroid(double a_x, double a_y)
+	{
+		const double p = a_x * a_x;
+		const double q = a_y * a_y;
+		const double r = (p + q - 1.0) / 6.0;
+		if(q == 0.0 && r <= 0.0)
+		{
+			return 0.0;
+		}
+
+		const double s = p * q / 4.0;
+		const double r2 = r * r;
+		const double r3 = r * r2;
+		const double disc = s * (s + 2.0 * r3);
+		double u = r;
+		if(disc >= 0.0)
+		{
+			double t3 = s + r3;
+			t3 += t3 < 0.0 ? -std::sqrt(disc) : std::sqrt(disc);
+			const double t = std::cbrt(t3);
+			u += t + (t != 0.0 ? r2 / t : 0.0);
+		}
+		else
+		{
+			const double angle = std::atan2(std::sqrt(-disc), -(s + r3));
+			u += 2.0 * r * std::cos(angle / 3.0);
+		}
+
+		const double v = std::sqrt(u * u + q);
+		const double uv = u < 0.0 ? q / (v - u) : u + v;
+		const double w = (uv - q) / (2.0 * v);
+		return uv / (std::sqrt(uv + w * w) + w);
+	}
+
+	/// Starting point of Newton's method for the inverse problem
+	/// @return sig12 if the line is short enough to be solved directly, else -1
+	inline double geodesic_inverse_start(
+		const geodesic_constants& a_constants,
+		double a_sbet1, double a_cbet1, double a_dn1,
+		double a_sbet2, double a_cbet2, double a_dn2,
+		double a_lam12, double a_slam12, double a_clam12,
+		double& r_salp1, double& r_calp1,
+		double& r_salp2, double& r_calp2,
+		double& r_dnm)
+	{
+		const double f = a_constants.f;
+		const double n = a_constants.n;
+
+		double sig12 = -1.0;
+		double salp1, calp1, salp2 = 0.0, calp2 = 0.0, dnm = 0.0;
+
+		// bet12 = bet2 - bet1 in [0, pi), bet12a = bet2 + bet1 in (-pi, 0]
+		const double sbet12 = a_sbet2 * a_cbet1 - a_cbet2 * a_sbet1;
+		const double cbet12 = a_cbet2 * a_cbet1 + a_sbet2 * a_sbet1;
+		const double sbet12a = a_sbet2 * a_cbet1 + a_cbet2 * a_sbet1;
+		const bool shortline = cbet12 >= 0.0 && sbet12 < 0.5 && a_cbet2 * a_lam12 < 0.5;
+
+		double somg12, comg12;
+		if(shortline)
+		{
+			double sbetm2 = (a_sbet1 + a_sbet2) * (a_sbet1 + a_sbet2);
+			sbetm2 /= sbetm2 + (a_cbet1 + a_cbet2) * (a_cbet1 + a_cbet2);
+			dnm = std::sqrt(1.0 + a_constants.ep2 * sbetm2);
+			const double omg12 = a_lam12 / (a_constants.f1 * dnm);
+			somg12 = std::sin(omg12);
+			comg12 = std::cos(omg12);
+		}
+		else
+		{
+			somg12 = a_slam12;
+			comg12 = a_clam12;
+		}
+
+		salp1 = a_cbet2 * somg12;
+		calp1 = comg12 >= 0.0
+			? sbet12 + a_cbet2 * a_sbet1 * somg12 * somg12 / (1.0 + comg12)
+			: sbet12a - a_cbet2 * a_sbet1 * somg12 * somg12 / (1.0 - comg12);
+
+		const double ssig12 = std::hypot(salp1, calp1);
+		const double csig12 = a_sbet1 * a_sbet2 + a_cbet1 * a_cbet2 * comg12;
+
+		if(shortline && ssig12 < a_constants.etol2)
+		{
+			// Really short lines
+			salp2 = a_cbet1 * somg12;
+			calp2 = sbet12 - a_cbet1 * a_sbet2 *
+				(comg12 >= 0.0 ? somg12 * somg12 / (1.0 + comg12) : 1.0 - comg12);
+			norm2(salp2, calp2);
+			sig12 = std::atan2(ssig12, csig12);
+		}
+		else if(std::abs(n) > 0.1 || csig12 >= 0.0 ||
+			ssig12 >= 6.0 * std::abs(n) * math::internal::c_pi * a_cbet1 * a_cbet1)
+		{
+			// The zeroth order spherical approximation is good enough
+		}
+		else
+		{
+			// Scale lam12 and bet2 to coordinates where the antipodal point is
+			// at the origin and the singular point at y = 0, x = -1
+			const double lam12x = std::atan2(-a_slam12, -a_clam12);
+			double x, y, lamscale, betscale;
+			if(f >= 0.0)
+			{
+				const double k2 = a_sbet1 * a_sbet1 * a_constants.ep2;
+				const double eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+				lamscale = f * a_cbet1 * A3f(a_constants, eps) * math::internal::c_pi;
+				betscale = lamscale * a_cbet1;
+				x = lam12x / lamscale;
+				y = sbet12a / betscale;
+			}
+			else
+			{
+				const double cbet12a = a_cbet2 * a_cbet1 - a_sbet2 * a_sbet1;
+				const double bet12a = std::atan2(sbet12a, cbet12a);
+				double m12b = 0.0;
+				geodesic_lengths(n, math::internal::c_pi + bet12a,
+					a_sbet1, -a_cbet1, a_dn1, a_sbet2, a_cbet2, a_dn2, nullptr, &m12b);
+				const double m0 = A1m1f(n) - A2m1f(n);
+				x = -1.0 + m12b / (a_cbet1 * a_cbet2 * m0 * math::internal::c_pi);
+				betscale = x < -0.01 ? sbet12a / x : -f * a_cbet1 * a_cbet1 * math::internal::c_pi;
+				lamscale = betscale / a_cbet1;
+				y = lam12x / lamscale;
+			}
+
+			if(y > -c_geodesicTol1 && x > -1.0 - c_geodesicXthresh)
+			{
+				// Strip near the cut
+				if(f >= 0.0)
+				{
+					salp1 = std::min(1.0, -x);
+					calp1 = -std::sqrt(1.0 - salp1 * salp1);
+				}
+				else
+				{
+					calp1 = std::max(x > -c_geodesicTol1 ? 0.0 : -1.0, x);
+					salp1 = std::sqrt(1.0 - calp1 * calp1);
+				}
+			}
+			else
+			{
+				const double k = astroid(x, y);
+				const double omg12a = lamscale * (f >= 0.0 ? -x * k / (1.0 + k) : -y * (1.0 + k) / k);
+				somg12 = std::sin(omg12a);
+				comg12 = -std::cos(omg12a);
+
+				// Update the spherical estimate of alp1 with omg12 instead of lam12
+				salp1 = a_cbet2 * somg12;
+				calp1 = sbet12a - a_cbet2 * a_sbet1 * somg12 * somg12 / (1.0 - comg12);
+			}
+		}
+
+		// Sanity check on the starting guess, the backwards test lets NaN through
+		if(!(salp1 <= 0.0))
+		{
+			norm2(salp1, calp1);
+		}
+		else
+		{
+			salp1 = 1.0;
+			calp1 = 0.0;
+		}
+
+		r_salp1 = salp1;
+		r_calp1 = calp1;
+		if(shortline)
+		{
+			r_dnm = dnm;
+		}
+		if(sig12 >= 0.0)
+		{
+			r_salp2 = salp2;
+			r_calp2 = calp2;
+		}
+		return sig12;
+	}
+
+	/// Solve the inverse problem, all angles are in degrees
+	/// @param r_s12 the distance in meters
+	/// @param r_azi1 the azimuth at point 1
+	/// @param r_azi2 the azimuth at point 2
+	inline void geodesic_inverse(
+		const geodesic_constants& a_constants,
+		double a_lat1, double a_lon1,
+		double a_lat2, double a_lon2,
+		double& r_s12, double& r_azi1, double& r_azi2)
+	{
+		const double a = a_constants.a;
+		const double b = a_constants.b;
+		const double f = a_constants.f;
+		const double f1 = a_constants.f1;
+
+		// Longitude difference in [-180, 180] computed without rounding
+		double lon12s = 0.0;
+		double lon12 = angle_difference(a_lon1, a_lon2, lon12s);
+		double lonsign = std::signbit(lon12) ? -1.0 : 1.0;
+		lon12 *= lonsign;
+		lon12s *= lonsign;
+		const double lam12 = lon12 * c_degree;
+		double slam12, clam12;
+		{
+			int quadrant = 0;
+			const double r = round_angle(std::remquo(lon12, 90.0, &quadrant) + lon12s);
+			double s, c;
+			sincosd(r, s, c);
+			switch(static_cast<unsigned>(quadrant) & 3u)
+			{
+			case 0: slam12 = s; clam12 = c; break;
+			case 1: slam12 = c; clam12 = -s; break;
+			case 2: slam12 = -s; clam12 = -c; break;
+			default: slam12 = -c; clam12 = s; break;
+			}
+			clam12 += 0.0;
+			slam12 += 0.0;
+		}
+		lon12s = (180.0 - lon12) - lon12s;
+
+		// Treat points really close to the equator as on the equator
+		double lat1 = round_angle(std::abs(a_lat1) > 90.0 ? std::numeric_limits<double>::quiet_NaN() : a_lat1);
+		double lat2 = round_angle(std::abs(a_lat2) > 90.0 ? std::numeric_limits<double>::quiet_NaN() : a_lat2);
+
+		// Swap the points so that point 1 has the larger absolute latitude
+		const double swapp = (std::abs(lat1) < std::abs(lat2) || lat2 != lat2) ? -1.0 : 1.0;
+		if(swapp < 0.0)
+		{
+			lonsign *= -1.0;
+			std::swap(lat1, lat2);
+		}
+
+		// Make lat1 <= -0. Now 0 <= lon12 <= 180, -90 <= lat1 <= -0 and lat1 <= lat2 <= -lat1
+		const double latsign = std::signbit(lat1) ? 1.0 : -1.0;
+		lat1 *= latsign;
+		lat2 *= latsign;
+
+		double sbet1, cbet1, sbet2, cbet2;
+		sincosd(lat1, sbet1, cbet1);
+		sbet1 *= f1;
+		norm2(sbet1, cbet1);
+		cbet1 = std::max(c_geodesicTiny, cbet1);
+
+		sincosd(lat2, sbet2, cbet2);
+		sbet2 *= f1;
+		norm2(sbet2, cbet2);
+		cbet2 = std::max(c_geodesicTiny, cbet2);
+
+		// Force bet2 = +-bet1 when the measure of |bet1| - |bet2| vanishes
+		if(cbet1 < -sbet1)
+		{
+			if(cbet2 == cbet1)
+			{
+				sbet2 = std::copysign(sbet1, sbet2);
+			}
+		}
+		else if(std::abs(sbet2) == -sbet1)
+		{
+			cbet2 = cbet1;
+		}
+
+		const double dn1 = std::sqrt(1.0 + a_constants.ep2 * sbet1 * sbet1);
+		const double dn2 = std::sqrt(1.0 + a_constants.ep2 * sbet2 * sbet2);
+
+		double s12x = 0.0, m12x = 0.0, sig12 = 0.0;
+		double salp1 = 0.0, calp1 = 0.0, salp2 = 0.0, calp2 = 0.0;
+		bool meridian = lat1 == -90.0 || slam12 == 0.0;
+		if(meridian)
+		{
+			// Both points are on one meridian, head to the target longitude
+			// and arrive heading north
+			calp1 = clam12;
+			salp1 = slam12;
+			calp2 = 1.0;
+			salp2 = 0.0;
+
+			const double ssig1 = sbet1;
+			const double csig1 = calp1 * cbet1;
+			const double ssig2 = sbet2;
+			const double csig2 = calp2 * cbet2;
+			sig12 = std::atan2(std::max(0.0, csig1 * ssig2 - ssig1 * csig2) + 0.0, csig1 * csig2 + ssig1 * ssig2);
+			geodesic_lengths(a_constants.n, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, &s12x, &m12x);
+
+			// Meridians longer than half a circle are not the shortest path
+			if(sig12 < 1.0 || m12x >= 0.0)
+			{
+				if(sig12 < 3.0 * c_geodesicTiny || (sig12 < c_geodesicTol0 && (s12x < 0.0 || m12x < 0.0)))
+				{
+					sig12 = m12x = s12x = 0.0;
+				}
+				m12x *= b;
+				s12x *= b;
+			}
+			else
+			{
+				meridian = false;
+			}
+		}
+
+		if(!meridian && sbet1 == 0.0 && (f <= 0.0 || lon12s >= f * 180.0))
+		{
+			// The geodesic runs along the equator
+			calp1 = calp2 = 0.0;
+			salp1 = salp2 = 1.0;
+			s12x = a * lam12;
+		}
+		else if(!meridian)
+		{
+			double dnm = 0.0;
+			sig12 = geodesic_inverse_start(a_constants,
+				sbet1, cbet1, dn1, sbet2, cbet2, dn2,
+				lam12, slam12, clam12,
+				salp1, calp1, salp2, calp2, dnm);
+
+			if(sig12 >= 0.0)
+			{
+				// Short lines
+				s12x = sig12 * b * dnm;
+			}
+			else
+			{
+				// Newton's method on lambda12(alp1) - lam12 = 0 which has one root
+				// in (0, pi) with a positive derivative. A bracket of the root is
+				// kept and bisected when Newton's method leaves it
+				double ssig1 = 0.0, csig1 = 0.0, ssig2 = 0.0, csig2 = 0.0, eps = 0.0;
+				double salp1a = c_geodesicTiny, calp1a = 1.0, salp1b = c_geodesicTiny, calp1b = -1.0;
+				bool tripn = false;
+				bool tripb = false;
+				for(int numit = 0;; numit++)
+				{
+					double dv = 0.0;
+					// Break the degeneracy of equatorial lines
+					const double v = geodesic_lambda12(a_constants,
+						sbet1, cbet1, dn1, sbet2, cbet2, dn2,
+						salp1, (sbet1 == 0.0 && calp1 == 0.0) ? -c_geodesicTiny : calp1, slam12, clam12,
+						salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps,
+						numit < c_geodesicMaxit1, dv);
+
+					// Reversed test to escape with NaN
+					if(tripb || !(std::abs(v) >= (tripn ? 8.0 : 1.0) * c_geodesicTol0) || numit == c_geodesicMaxit2)
+					{
+						break;
+					}
+
+					if(v > 0.0 && (numit > c_geodesicMaxit1 || calp1 / salp1 > calp1b / salp1b))
+					{
+						salp1b = salp1;
+						calp1b = calp1;
+					}
+					else if(v < 0.0 && (numit > c_geodesicMaxit1 || calp1 / salp1 < calp1a / salp1a))
+					{
+						salp1a = salp1;
+						calp1a = calp1;
+					}
+
+					if(numit < c_geodesicMaxit1 && dv > 0.0)
+					{
+						const double dalp1 = -v / dv;
+						if(std::abs(dalp1) < math::internal::c_pi)
+						{
+							const double sdalp1 = std::sin(dalp1);
+							const double cdalp1 = std::cos(dalp1);
+							const double nsalp1 = salp1 * cdalp1 + calp1 * sdalp1;
+							if(nsalp1 > 0.0)
+							{
+								calp1 = calp1 * cdalp1 - salp1 * sdalp1;
+								salp1 = nsalp1;
+								norm2(salp1, calp1);
+
+								// Convergence can be linear where the slope vanishes
+								tripn = std::abs(v) <= 16.0 * c_geodesicTol0;
+								continue;
+							}
+						}
+					}
+
+					// Bisect the bracket
+					salp1 = (salp1a + salp1b) / 2.0;
+					calp1 = (calp1a + calp1b) / 2.0;
+					norm2(salp1, calp1);
+					tripn = false;
+					tripb = std::abs(salp1a - salp1) + (calp1a - calp1) < c_geodesicTolb ||
+						std::abs(salp1 - salp1b) + (calp1 - calp1b) < c_geodesicTolb;
+				}
+
+				geodesic_lengths(eps, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, &s12x, nullptr);
+				s12x *= b;
+			}
+		}
+
+		r_s12 = 0.0 + s12x;
+
+		// Undo the swap and the sign changes
+		if(swapp < 0.0)
+		{
+			std::swap(salp1, salp2);
+			std::swap(calp1, calp2);
+		}
+		salp1 *= swapp * lonsign;
+		calp1 *= swapp * latsign;
+		salp2 *= swapp * lonsign;
+		calp2 *= swapp * latsign;
+
+		r_azi1 = atan2d(salp1, calp1);
+		r_azi2 = atan2d(salp2, calp2);
+	}
+
+	/// Solve the direct problem, all angles are in degrees
+	/// @param r_lat2 the latitude of point 2
+	/// @param r_lon2 the longitude of point 2
+	/// @param r_azi2 the azimuth at point 2
+	inline void geodesic_direct(
+		const geodesic_constants& a_constants,
+		double a_lat1, double a_lon1,
+		double a_azi1, double a_s12,
+		double& r_lat2, double& r_lon2, double& r_azi2)
+	{
+		const double f = a_constants.f;
+		const double f1 = a_constants.f1;
+		const double b = a_constants.b;
+
+		double salp1, calp1;
+		sincosd(round_angle(normalize_angle(a_azi1)), salp1, calp1);
+
+		const double lat1 = std::abs(a_lat1) > 90.0 ? std::numeric_limits<double>::quiet_NaN() : a_lat1;
+		double sbet1, cbet1;
+		sincosd(round_angle(lat1), sbet1, cbet1);
+		sbet1 *= f1;
+		norm2(sbet1, cbet1);
+		cbet1 = std::max(c_geodesicTiny, cbet1);
+
+		// sin(alp1) * cos(bet1) = sin(alp0)
+		const double salp0 = salp1 * cbet1;
+		const double calp0 = std::hypot(calp1, salp1 * sbet1);
+
+		// tan(bet1) = tan(sig1) * cos(alp1), sig = 0 is the northward
+		// crossing of the equator, tan(omg1) = sin(alp0) * tan(sig1)
+		double ssig1 = sbet1;
+		const double somg1 = salp0 * sbet1;
+		double csig1 = sbet1 != 0.0 || calp1 != 0.0 ? cbet1 * calp1 : 1.0;
+		const double comg1 = csig1;
+		norm2(ssig1, csig1);
+
+		const double k2 = calp0 * calp0 * a_constants.ep2;
+		const double eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+
+		double c1[7], c1p[7], c3[7];
+		const double A1m1 = A1m1f(eps);
+		C1f(eps, c1);
+		C1pf(eps, c1p);
+		C3f(a_constants, eps, c3);
+		const double A3c = -f * salp0 * A3f(a_constants, eps);
+		const double B11 = sin_series(ssig1, csig1, c1);
+		const double B31 = sin_series(ssig1, csig1, c3);
+
+		// tau1 = sig1 + B11
+		const double sB11 = std::sin(B11);
+		const double cB11 = std::cos(B11);
+		const double stau1 = ssig1 * cB11 + csig1 * sB11;
+		const double ctau1 = csig1 * cB11 - ssig1 * sB11;
+
+		// tau2 = tau1 + tau12, the series of C1p reverts the series of C1
+		const double tau12 = a_s12 / (b * (1.0 + A1m1));
+		const double s = std::sin(tau12);
+		const double c = std::cos(tau12);
+		double B12 = -sin_series(stau1 * c + ctau1 * s, ctau1 * c - stau1 * s, c1p);
+		double sig12 = tau12 - (B12 - B11);
+		double ssig12 = std::sin(sig12);
+		double csig12 = std::cos(sig12);
+		if(std::abs(f) > 0.01)
+		{
+			// The reverted series is inaccurate for larger flattening, one
+			// Newton iteration corrects sig12
+			const double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+			const double csig2 = csig1 * csig12 - ssig1 * ssig12;
+			B12 = sin_series(ssig2, csig2, c1);
+			const double serr = (1.0 + A1m1) * (sig12 + (B12 - B11)) - a_s12 / b;
+			sig12 = sig12 - serr / std::sqrt(1.0 + k2 * ssig2 * ssig2);
+			ssig12 = std::sin(sig12);
+			csig12 = std::cos(sig12);
+		}
+
+		// sig2 = sig1 + sig12
+		const double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+		double csig2 = csig1 * csig12 - ssig1 * ssig12;
+
+		// sin(bet2) = cos(alp0) * sin(sig2)
+		const double sbet2 = calp0 * ssig2;
+		double cbet2 = std::hypot(salp0, calp0 * csig2);
+		if(cbet2 == 0.0)
+		{
+			cbet2 = csig2 = c_geodesicTiny;
+		}
+
+		// tan(alp0) = cos(sig2) * tan(alp2)
+		const double salp2 = salp0;
+		const double calp2 = calp0 * csig2;
+
+		// tan(omg2) = sin(alp0) * tan(sig2), omg12 = omg2 - omg1
+		const double somg2 = salp0 * ssig2;
+		const double comg2 = csig2;
+		const double omg12 = std::atan2(somg2 * comg1 - comg2 * somg1, comg2 * comg1 + somg2 * somg1);
+		const double lam12 = omg12 + A3c * (sig12 + (sin_series(ssig2, csig2, c3) - B31));
+		const double lon12 = lam12 / c_degree;
+
+		r_lat2 = atan2d(sbet2, f1 * cbet2);
+		r_lon2 = normalize_angle(normalize_angle(a_lon1) + normalize_angle(lon12));
+		r_azi2 = atan2d(salp2, calp2);
+	}
+
+	/// Points of the batched geodesic solutions, outputs must not overlap inputs
+	struct geodesic_arguments
+	{
+		/// Inverse: latitudes and longitudes of point 2.
+		/// Direct: azimuths at point 1 and distances in meters
+		const double* input[2];
+
+		/// Inverse: distances in meters and azimuths at point 1 and 2, the azimuths may be null.
+		/// Direct: latitudes, longitudes and azimuths at point 2
+		double* output[3];
+		size_t count;
+
+		/// Point 1
+		double latitude;
+		double longitude;
+
+		/// Angles are multiplied by this to get degrees on input and divided by it on output
+		double angle_scale;
+
+		const geodesic_constants* constants;
+	};
+
+	/// Solve the inverse problem from one point to many
+	void geodesic_inverse_batch(const geodesic_arguments& a_arguments);
+
+	/// Solve the direct problem from one point along many azimuths and distances
+	void geodesic_direct_batch(const geodesic_arguments& a_arguments);
+}
+
+/// Geodesics between points on the spheroid with the same parameters
+template <typename TAllocator, db_wrp A, db_wrp B>
+struct geodesic
+{
+public:
+	using Type = typename TAllocator::Type;
+	using Vec3 = typename TAllocator::Vec3;
+
+	static constexpr const Type c_A{A.value};
+	static constexpr const Type c_B{B.value};
+protected:
+	static const internal::geodesic_constants& constants()
+	{
+		static const internal::geodesic_constants s_constants = internal::make_geodesic_constants(c_A, c_B);
+		return s_constants;
+	}
+
+	static Vec3 inverse_scaled(Type a_lat1, Type a_lon1, Type a_lat2, Type a_lon2, Type a_angle_scale);
+	static Vec3 direct_scaled(Type a_lat1, Type a_lon1, Type a_azi1, Type a_distance_meter, Type a_angle_scale);
+
+	static void inverse_batch(
+		Type a_lat1,
+		Type a_lon1,
+		std::span<const Type> a_lat2,
+		std::span<const Type> a_lon2,
+		std::span<Type> r_distance_meter,
+		std::span<Type> r_azi1,
+		std::span<Type> r_azi2,
+		Type a_angle_scale);
+
+	static void distances_batch(
+		std::span<const Type> a_lat1,
+		std::span<const Type> a_lon1,
+		std::span<const Type> a_lat2,
+		std::span<const Type> a_lon2,
+		std::span<Type> r_distance_meter,
+		Type a_angle_scale);
+
+	static void direct_batch(
+		Type a_lat1,
+		Type a_lon1,
+		std::span<const Type> a_azi1,
+		std::span<const Type> a_distance_meter,
+		std::span<Type> r_lat2,
+		std::span<Type> r_lon2,
+		std::span<Type> r_azi2,
+		Type a_angle_scale);
+
+	static_assert(c_A > 0);
+	static_assert(c_B > 0);
+public:
+	struct rad
+	{
+		/// Solve the inverse problem, the shortest path between two points
+		/// @param a_lat1_rad the latitude of point 1 in radians
+		/// @param a_lon1_rad the longitude of point 1 in radians
+		/// @param a_lat2_rad the latitude of point 2 in radians
+		/// @param a_lon2_rad the longitude of point 2 in radians
+		/// @return the distance in meters and the azimuths at point 1 and 2 in radians
+		static Vec3 inverse(
+			Type a_lat1_rad,
+			Type a_lon1_rad,
+			Type a_lat2_rad,
+			Type a_lon2_rad);
+
+		/// Solve the direct problem, the end of a geodesic
+		/// @param a_lat1_rad the latitude of point 1 in radians
+		/// @param a_lon1_rad the longitude of point 1 in radians
+		/// @param a_azi1_rad the azimuth at point 1 in radians
+		/// @param a_distance_meter the distance in meters
+		/// @return the latitude, longitude and azimuth of point 2 in radians
+		static Vec3 direct(
+			Type a_lat1_rad,
+			Type a_lon1_rad,
+			Type a_azi1_rad,
+			Type a_distance_meter);
+
+		/// Solve the inverse problem from one point to many with the widest
+		/// instruction set available, see set_batch_simd_level. The smallest
+		/// span decides the number of points and outputs must not overlap inputs.
+		/// Pass both azimuth spans empty to only compute the distances
+		/// @param a_lat1_rad the latitude of point 1 in radians
+		/// @param a_lon1_rad the longitude of point 1 in radians
+		/// @param a_lat2_rad the latitudes of the points 2 in radians
+		/// @param a_lon2_rad the longitudes of the points 2 in radians
+		/// @param r_distance_meter the distances in meters
+		/// @param r_azi1_rad the azimuths at point 1 in radians, empty to skip the azimuths
+		/// @param r_azi2_rad the azimuths at the points 2 in radians, empty to skip the azimuths
+		static void inverse(
+			Type a_lat1_rad,
+			Type a_lon1_rad,
+			std::span<const Type> a_lat2_rad,
+			std::span<const Type> a_lon2_rad,
+			std::span<Type> r_distance_meter,
+			std::span<Type> r_azi1_rad,
+			std::span<Type> r_azi2_rad);
+
+		/// Distances from every point 1 to every point 2, row i of r_distance_meter
+		/// holds the distances from point 1 i. r_distance_meter needs the size of
+		/// both point counts multiplied or the last rows are skipped
+		/// @param a_lat1_rad the latitudes of the points 1 in radians
+		/// @param a_lon1_rad the longitudes of the points 1 in radians
+		/// @param a_lat2_rad the latitudes of the points 2 in radians
+		/// @param a_lon2_rad the longitudes of the points 2 in radians
+		/// @param r_distance_meter the distances in meters
+		static void distances(
+			std::span<const Type> a_lat1_rad,
+			std::span<const Type> a_lon1_rad,
+			std::span<const Type> a_lat2_rad,
+			std::span<const Type> a_lon2_rad,
+			std::span<Type> r_distance_meter);
+
+		/// Solve the direct problem from one point along many azimuths and distances
+		/// @param a_lat1_rad the latitude of point 1 in radians
+		/// @param a_lon1_rad the longitude of point 1 in radians
+		/// @param a_azi1_rad the azimuths at point 1 in radians
+		/// @param a_distance_meter the distances in meters
+		/// @param r_lat2_rad the latitudes of the points 2 in radians
+		/// @param r_lon2_rad the longitudes of the points 2 in radians
+		/// @param r_azi2_rad the azimuths at the points 2 in radians
+		static void direct(
+			Type a_lat1_rad,
+			Type a_lon1_rad,
+			std::span<const Type> a_azi1_rad,
+			std::span<const Type> a_distance_meter,
+			std::span<Type> r_lat2_rad,
+			std::span<Type> r_lon2_rad,
+			std::span<Type> r_azi2_rad);
+	};
+
+	struct deg
+	{
+		/// Solve the inverse problem, see rad::inverse
+		/// @return the distance in meters and the azimuths at point 1 and 2 in degrees
+		static Vec3 inverse(
+			Type a_lat1_deg,
+			Type a_lon1_deg,
+			Type a_lat2_deg,
+			Type a_lon2_deg);
+
+		/// Solve the direct problem, see rad::direct
+		/// @return the latitude, longitude and azimuth of point 2 in degrees
+		static Vec3 direct(
+			Type a_lat1_deg,
+			Type a_lon1_deg,
+			Type a_azi1_deg,
+			Type a_distance_meter);
+
+		/// Solve the inverse problem from one point to many, see rad::inverse
+		static void inverse(
+			Type a_lat1_deg,
+			Type a_lon1_deg,
+			std::span<const Type> a_lat2_deg,
+			std::span<const Type> a_lon2_deg,
+			std::span<Type> r_distance_meter,
+			std::span<Type> r_azi1_deg,
+			std::span<Type> r_azi2_deg);
+
+		/// Distances from every point 1 to every point 2, see rad::distances
+		static void distances(
+			std::span<const Type> a_lat1_deg,
+			std::span<const Type> a_lon1_deg,
+			std::span<const Type> a_lat2_deg,
+			std::span<const Type> a_lon2_deg,
+			std::span<Type> r_distance_meter);
+
+		/// Solve the direct problem from one point along many azimuths and distances, see rad::direct
+		static void direct(
+			Type a_lat1_deg,
+			Type a_lon1_deg,
+			std::span<const Type> a_azi1_deg,
+			std::span<const Type> a_distance_meter,
+			std::span<Type> r_lat2_deg,
+			std::span<Type> r_lon2_deg,
+			std::span<Type> r_azi2_deg);
+	};
+};
+
+} // geodecy
+
+/// Implementation of geodesic
+namespace geodecy
+{
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::inverse_scaled(
+	Type a_lat1,
+	Type a_lon1,
+	Type a_lat2,
+	Type a_lon2,
+	Type a_angle_scale)
+{
+	double s12, azi1, azi2;
+	internal::geodesic_inverse(constants(),
+		a_lat1 * a_angle_scale, a_lon1 * a_angle_scale,
+		a_lat2 * a_angle_scale, a_lon2 * a_angle_scale,
+		s12, azi1, azi2);
+	return TAllocator::to_vec(Type(s12), Type(azi1 / a_angle_scale), Type(azi2 / a_angle_scale));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::direct_scaled(
+	Type a_lat1,
+	Type a_lon1,
+	Type a_azi1,
+	Type a_distance_meter,
+	Type a_angle_scale)
+{
+	double lat2, lon2, azi2;
+	internal::geodesic_direct(constants(),
+		a_lat1 * a_angle_scale, a_lon1 * a_angle_scale,
+		a_azi1 * a_angle_scale, a_distance_meter,
+		lat2, lon2, azi2);
+	return TAllocator::to_vec(Type(lat2 / a_angle_scale), Type(lon2 / a_angle_scale), Type(azi2 / a_angle_scale));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::inverse_batch(
+	Type a_lat1,
+	Type a_lon1,
+	std::span<const Type> a_lat2,
+	std::span<const Type> a_lon2,
+	std::span<Type> r_distance_meter,
+	std::span<Type> r_azi1,
+	std::span<Type> r_azi2,
+	Type a_angle_scale)
+{
+	// Empty azimuth spans only compute the distances, the kernels skip the azimuths for null outputs
+	const bool azimuths = !r_azi1.empty() || !r_azi2.empty();
+	size_t count = std::min({a_lat2.size(), a_lon2.size(), r_distance_meter.size()});
+	if(azimuths)
+	{
+		count = std::min({count, r_azi1.size(), r_azi2.size()});
+	}
+
+	if constexpr(std::is_same_v<Type, double>)
+	{
+		internal::geodesic_inverse_batch({
+			{a_lat2.data(), a_lon2.data()},
+			{r_distance_meter.data(), azimuths ? r_azi1.data() : nullptr, azimuths ? r_azi2.data() : nullptr},
+			count, a_lat1, a_lon1, a_angle_scale, &constants()});
+	}
+	else
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			const Vec3 result = inverse_scaled(a_lat1, a_lon1, a_lat2[i], a_lon2[i], a_angle_scale);
+			r_distance_meter[i] = TAllocator::get_x(result);
+			if(azimuths)
+			{
+				r_azi1[i] = TAllocator::get_y(result);
+				r_azi2[i] = TAllocator::get_z(result);
+			}
+		}
+	}
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::distances_batch(
+	std::span<const Type> a_lat1,
+	std::span<const Type> a_lon1,
+	std::span<const Type> a_lat2,
+	std::span<const Type> a_lon2,
+	std::span<Type> r_distance_meter,
+	Type a_angle_scale)
+{
+	const size_t columns = std::min(a_lat2.size(), a_lon2.size());
+	const size_t rows = std::min({a_lat1.size(), a_lon1.size(), columns == 0 ? 0 : r_distance_meter.size() / columns});
+	for(size_t row = 0; row < rows; row++)
+	{
+		const std::span<Type> distances = r_distance_meter.subspan(row * columns, columns);
+		if constexpr(std::is_same_v<Type, double>)
+		{
+			internal::geodesic_inverse_batch({
+				{a_lat2.data(), a_lon2.data()},
+				{distances.data(), nullptr, nullptr},
+				columns, a_lat1[row], a_lon1[row], a_angle_scale, &constants()});
+		}
+		else
+		{
+			for(size_t i = 0; i < columns; i++)
+			{
+				distances[i] = TAllocator::get_x(inverse_scaled(a_lat1[row], a_lon1[row], a_lat2[i], a_lon2[i], a_angle_scale));
+			}
+		}
+	}
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::direct_batch(
+	Type a_lat1,
+	Type a_lon1,
+	std::span<const Type> a_azi1,
+	std::span<const Type> a_distance_meter,
+	std::span<Type> r_lat2,
+	std::span<Type> r_lon2,
+	std::span<Type> r_azi2,
+	Type a_angle_scale)
+{
+	const size_t count = std::min({a_azi1.size(), a_distance_meter.size(), r_lat2.size(), r_lon2.size(), r_azi2.size()});
+	if constexpr(std::is_same_v<Type, double>)
+	{
+		internal::geodesic_direct_batch({
+			{a_azi1.data(), a_distance_meter.data()},
+			{r_lat2.data(), r_lon2.data(), r_azi2.data()},
+			count, a_lat1, a_lon1, a_angle_scale, &constants()});
+	}
+	else
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			const Vec3 result = direct_scaled(a_lat1, a_lon1, a_azi1[i], a_distance_meter[i], a_angle_scale);
+			r_lat2[i] = TAllocator::get_x(result);
+			r_lon2[i] = TAllocator::get_y(result);
+			r_azi2[i] = TAllocator::get_z(result);
+		}
+	}
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::rad::inverse(
+	Type a_lat1_rad,
+	Type a_lon1_rad,
+	Type a_lat2_rad,
+	Type a_lon2_rad)
+{
+	return inverse_scaled(a_lat1_rad, a_lon1_rad, a_lat2_rad, a_lon2_rad, Type(1.0 / internal::c_degree));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::rad::direct(
+	Type a_lat1_rad,
+	Type a_lon1_rad,
+	Type a_azi1_rad,
+	Type a_distance_meter)
+{
+	return direct_scaled(a_lat1_rad, a_lon1_rad, a_azi1_rad, a_distance_meter, Type(1.0 / internal::c_degree));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::rad::inverse(
+	Type a_lat1_rad,
+	Type a_lon1_rad,
+	std::span<const Type> a_lat2_rad,
+	std::span<const Type> a_lon2_rad,
+	std::span<Type> r_distance_meter,
+	std::span<Type> r_azi1_rad,
+	std::span<Type> r_azi2_rad)
+{
+	inverse_batch(a_lat1_rad, a_lon1_rad, a_lat2_rad, a_lon2_rad, r_distance_meter, r_azi1_rad, r_azi2_rad, Type(1.0 / internal::c_degree));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::rad::distances(
+	std::span<const Type> a_lat1_rad,
+	std::span<const Type> a_lon1_rad,
+	std::span<const Type> a_lat2_rad,
+	std::span<const Type> a_lon2_rad,
+	std::span<Type> r_distance_meter)
+{
+	distances_batch(a_lat1_rad, a_lon1_rad, a_lat2_rad, a_lon2_rad, r_distance_meter, Type(1.0 / internal::c_degree));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::rad::direct(
+	Type a_lat1_rad,
+	Type a_lon1_rad,
+	std::span<const Type> a_azi1_rad,
+	std::span<const Type> a_distance_meter,
+	std::span<Type> r_lat2_rad,
+	std::span<Type> r_lon2_rad,
+	std::span<Type> r_azi2_rad)
+{
+	direct_batch(a_lat1_rad, a_lon1_rad, a_azi1_rad, a_distance_meter, r_lat2_rad, r_lon2_rad, r_azi2_rad, Type(1.0 / internal::c_degree));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::deg::inverse(
+	Type a_lat1_deg,
+	Type a_lon1_deg,
+	Type a_lat2_deg,
+	Type a_lon2_deg)
+{
+	return inverse_scaled(a_lat1_deg, a_lon1_deg, a_lat2_deg, a_lon2_deg, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+typename TAllocator::Vec3 geodesic<TAllocator, A, B>::deg::direct(
+	Type a_lat1_deg,
+	Type a_lon1_deg,
+	Type a_azi1_deg,
+	Type a_distance_meter)
+{
+	return direct_scaled(a_lat1_deg, a_lon1_deg, a_azi1_deg, a_distance_meter, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::deg::inverse(
+	Type a_lat1_deg,
+	Type a_lon1_deg,
+	std::span<const Type> a_lat2_deg,
+	std::span<const Type> a_lon2_deg,
+	std::span<Type> r_distance_meter,
+	std::span<Type> r_azi1_deg,
+	std::span<Type> r_azi2_deg)
+{
+	inverse_batch(a_lat1_deg, a_lon1_deg, a_lat2_deg, a_lon2_deg, r_distance_meter, r_azi1_deg, r_azi2_deg, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::deg::distances(
+	std::span<const Type> a_lat1_deg,
+	std::span<const Type> a_lon1_deg,
+	std::span<const Type> a_lat2_deg,
+	std::span<const Type> a_lon2_deg,
+	std::span<Type> r_distance_meter)
+{
+	distances_batch(a_lat1_deg, a_lon1_deg, a_lat2_deg, a_lon2_deg, r_distance_meter, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B>
+void geodesic<TAllocator, A, B>::deg::direct(
+	Type a_lat1_deg,
+	Type a_lon1_deg,
+	std::span<const Type> a_azi1_deg,
+	std::span<const Type> a_distance_meter,
+	std::span<Type> r_lat2_deg,
+	std::span<Type> r_lon2_deg,
+	std::span<Type> r_azi2_deg)
+{
+	direct_batch(a_lat1_deg, a_lon1_deg, a_azi1_deg, a_distance_meter, r_lat2_deg, r_lon2_deg, r_azi2_deg, Type(1));
+}
+
+} // geodecy
+
+#endif  // GEODECY_GEODESIC
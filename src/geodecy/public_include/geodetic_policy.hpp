@@ -0,0 +1,297 @@
+
+#ifndef GEODECY_GEODETIC_POLICY
+#define GEODECY_GEODETIC_POLICY
+
+#include <cmath>
+
+#include "batch.hpp"
+#include "trig.hpp"
+
+namespace geodecy
+{
+
+namespace internal
+{
+	/// Added to squared lengths so the center of the spheroid does not divide by zero
+	constexpr const double c_tiny = 1.0e-300;
+
+	/// One update of Bowring's method. Latitudes are unnormalized (sin, cos) pairs
+	/// so the poles need no special case
+	/// @param a_p the distance from the polar axis
+	/// @param a_z the distance from the equatorial plane
+	GEODECY_INLINE constexpr void bowring_step(
+		double a_p,
+		double a_z,
+		double a_a,
+		double a_b,
+		double a_sinLat,
+		double a_cosLat,
+		double& r_sinLat,
+		double& r_cosLat)
+	{
+		// Parametric latitude, tan(beta) = b / a * tan(latitude)
+		const double sinBeta = a_sinLat * a_b;
+		const double cosBeta = a_cosLat * a_a;
+		const double length = 1.0 / math::sqrt(sinBeta * sinBeta + cosBeta * cosBeta + c_tiny);
+		const double s = sinBeta * length;
+		const double c = cosBeta * length;
+		const double es = 1.0 - (a_b * a_b) / (a_a * a_a);
+		const double eps = (a_a * a_a) / (a_b * a_b) - 1.0;
+		r_sinLat = a_z + eps * a_b * s * s * s;
+		r_cosLat = a_p - es * a_a * c * c * c;
+	}
+
+	/// Cube root of values in [1, 2], the closed form solutions take it of
+	/// values below 1.25 for points further than 1000 km from the center
+	GEODECY_INLINE constexpr double cbrt_reduced(double a_value)
+	{
+		// The chord through the end points is within 1%, Halley's method
+		// triples the correct digits every step
+		double root = 0.74 + 0.26 * a_value;
+		for(int i = 0; i < 2; i++)
+		{
+			const double cube = root * root * root;
+			root *= (cube + 2.0 * a_value) / (2.0 * cube + a_value);
+		}
+		return root;
+	}
+}
+
+/// Algorithms converting xyz to latitude and altitude, selected by the last
+/// template parameter of spheroid. Every policy has the function
+///
+///     static void solve(double a, double b, double p, double z, double& r_latitude_rad, double& r_altitude_meter)
+///
+/// where p is the distance from the polar axis. Policies with a c_method are
+/// branch free and also used by the batched conversions, the others convert
+/// batches one point at a time. The maximum errors are for wgs84 from 1000 km
+/// below the surface out to geostationary orbit, measured by geodecy_bench_xyz2lla
+namespace geodetic_policy
+{
+	/// Fixed point iteration seeded with the geocentric latitude that stops
+	/// when the latitude changes less than 1e-14 radians, at most seven
+	/// updates. Not branch free and its altitude loses precision to cancellation,
+	/// the only policy that can not be used in constant expressions.
+	/// Max error 2.1e-14 deg and 6.4e-3 m
+	struct iterative
+	{
+		static void solve(
+			double a_a,
+			double a_b,
+			double a_p,
+			double a_z,
+			double& r_latitude_rad,
+			double& r_altitude_meter);
+	};
+
+	/// Bowring's method started from the latitude of the surface point in the
+	/// geocentric direction. Branch free.
+	/// One step: max error 4.8e-7 deg and 2.2e-8 m, 8e-12 deg within 10 km of the surface.
+	/// Two steps: max error 2.8e-14 deg and 2.2e-8 m
+	/// @tparam Steps the number of updates, 1 or 2
+	template <int Steps>
+	struct bowring
+	{
+		static_assert(Steps == 1 || Steps == 2, "Bowring's method takes 1 or 2 steps, more do not change a double");
+
+		static constexpr const internal::xyz2lla_method c_method = Steps == 1
+			? internal::xyz2lla_method::bowring1
+			: internal::xyz2lla_method::bowring2;
+
+		GEODECY_INLINE static constexpr void solve(
+			double a_a,
+			double a_b,
+			double a_p,
+			double a_z,
+			double& r_latitude_rad,
+			double& r_altitude_meter);
+	};
+
+	/// Heikkinen's closed form (1982) as given by Zhu (1994), Ferrari's solution
+	/// of the quartic. Branch free, valid further than 1000 km from the center.
+	/// Max error 2.8e-14 deg and 1.9e-8 m
+	struct heikkinen
+	{
+		static constexpr const internal::xyz2lla_method c_method = internal::xyz2lla_method::heikkinen;
+
+		GEODECY_INLINE static constexpr void solve(
+			double a_a,
+			double a_b,
+			double a_p,
+			double a_z,
+			double& r_latitude_rad,
+			double& r_altitude_meter);
+	};
+
+	/// Vermeille's closed form (2004). Branch free, valid further than 1000 km
+	/// from the center.
+	/// Max error 3.6e-14 deg and 1.9e-8 m
+	struct vermeille
+	{
+		static constexpr const internal::xyz2lla_method c_method = internal::xyz2lla_method::vermeille;
+
+		GEODECY_INLINE static constexpr void solve(
+			double a_a,
+			double a_b,
+			double a_p,
+			double a_z,
+			double& r_latitude_rad,
+			double& r_altitude_meter);
+	};
+}
+
+} // geodecy
+
+/// Implementation of the policies
+namespace geodecy
+{
+
+inline void geodetic_policy::iterative::solve(
+	double a_a,
+	double a_b,
+	double a_p,
+	double a_z,
+	double& r_latitude_rad,
+	double& r_altitude_meter)
+{
+	const double es = 1.0 - (a_b * a_b) / (a_a * a_a);
+	const double rp = std::sqrt(a_p * a_p + a_z * a_z);
+	if(a_p < 1.0e-10)
+	{
+		r_latitude_rad = a_z < 0.0 ? -math::internal::c_pio2 : math::internal::c_pio2;
+		r_altitude_meter = rp - a_b;
+		return;
+	}
+
+	const double flatgc_rad = std::asin(a_z / rp);
+	const double slat_0     = std::sin(flatgc_rad);
+	const double first_rn   = a_a / std::sqrt(1.0 - es * slat_0 * slat_0);
+
+	const double b4_a4 = (1.0 - es) * (1.0 - es) - 1;
+	double alt_meter = rp - first_rn * std::sqrt(1 + b4_a4 * slat_0 * slat_0);
+	double lat_rad{};
+	{
+		const double flatgd_rad = std::atan(std::tan(flatgc_rad) / (1 - es * first_rn / (first_rn + alt_meter)));
+		const double slat_1 = std::sin(flatgd_rad);
+		const double rn = a_a / std::sqrt(1.0 - es * slat_1 * slat_1);
+		lat_rad = std::atan(std::tan(flatgc_rad) / (1 - es * rn / (rn + alt_meter)));
+	}
+
+	double slat = std::sin(lat_rad);
+	double rn   = a_a / std::sqrt(1.0 - es * slat * slat);
+
+	for(int i = 0; i < 5; i++)
+	{
+		double lat_new_rad = std::atan((a_z + rn * es * slat) / a_p);
+
+		slat      = std::sin(lat_new_rad);
+		rn        = a_a / std::sqrt(1.0 - es * slat * slat);
+		alt_meter = (a_p / std::cos(lat_new_rad)) - rn;
+
+		double dlat_rad = lat_new_rad - lat_rad;
+		lat_rad = lat_new_rad;
+		if(std::abs(dlat_rad) < 1.0e-14)
+		{
+			break;
+		}
+	}
+
+	r_latitude_rad = lat_rad;
+	r_altitude_meter = alt_meter;
+}
+
+template <int Steps>
+GEODECY_INLINE constexpr void geodetic_policy::bowring<Steps>::solve(
+	double a_a,
+	double a_b,
+	double a_p,
+	double a_z,
+	double& r_latitude_rad,
+	double& r_altitude_meter)
+{
+	double sinLat = a_a * a_a * a_z;
+	double cosLat = a_b * a_b * a_p;
+	internal::bowring_step(a_p, a_z, a_a, a_b, sinLat, cosLat, sinLat, cosLat);
+	if constexpr(Steps == 2)
+	{
+		internal::bowring_step(a_p, a_z, a_a, a_b, sinLat, cosLat, sinLat, cosLat);
+	}
+
+	r_latitude_rad = math::atan2(sinLat, cosLat);
+
+	// Distance to the foot point along the normal, it has no cancellation
+	// unlike p / cos(latitude) - N
+	const double es = 1.0 - (a_b * a_b) / (a_a * a_a);
+	const double length = 1.0 / math::sqrt(sinLat * sinLat + cosLat * cosLat + internal::c_tiny);
+	sinLat *= length;
+	cosLat *= length;
+	r_altitude_meter = a_p * cosLat + a_z * sinLat - a_a * math::sqrt(1.0 - es * sinLat * sinLat);
+}
+
+GEODECY_INLINE constexpr void geodetic_policy::heikkinen::solve(
+	double a_a,
+	double a_b,
+	double a_p,
+	double a_z,
+	double& r_latitude_rad,
+	double& r_altitude_meter)
+{
+	const double a2 = a_a * a_a;
+	const double b2 = a_b * a_b;
+	const double es = 1.0 - b2 / a2;
+	const double eps = a2 / b2 - 1.0;
+	const double p2 = a_p * a_p;
+	const double z2 = a_z * a_z;
+
+	const double f = 54.0 * b2 * z2;
+	const double g = p2 + (1.0 - es) * z2 - es * (a2 - b2);
+	const double c = es * es * f * p2 / (g * g * g);
+	const double s = internal::cbrt_reduced(1.0 + c + math::sqrt(c * c + 2.0 * c));
+	const double k = s + 1.0 + 1.0 / s;
+	const double pk = f / (3.0 * k * k * g * g);
+	const double q = math::sqrt(1.0 + 2.0 * es * es * pk);
+
+	// Rounding takes the radicand slightly below zero at the poles
+	const double radicand = 0.5 * a2 * (1.0 + 1.0 / q) - pk * (1.0 - es) * z2 / (q * (1.0 + q)) - 0.5 * pk * p2;
+	const double r0 = -(pk * es * a_p) / (1.0 + q) + math::sqrt(radicand > 0.0 ? radicand : 0.0);
+
+	const double pe = a_p - es * r0;
+	const double u = math::sqrt(pe * pe + z2);
+	const double v = math::sqrt(pe * pe + (1.0 - es) * z2);
+	const double z0 = b2 * a_z / (a_a * v);
+
+	r_latitude_rad = math::atan2(a_z + eps * z0, a_p);
+	r_altitude_meter = u * (1.0 - b2 / (a_a * v));
+}
+
+GEODECY_INLINE constexpr void geodetic_policy::vermeille::solve(
+	double a_a,
+	double a_b,
+	double a_p,
+	double a_z,
+	double& r_latitude_rad,
+	double& r_altitude_meter)
+{
+	const double a2 = a_a * a_a;
+	const double es = 1.0 - (a_b * a_b) / a2;
+	const double e4 = es * es;
+
+	const double p = a_p * a_p / a2;
+	const double q = (1.0 - es) * a_z * a_z / a2;
+	const double r = (p + q - e4) / 6.0;
+	const double s = e4 * p * q / (4.0 * r * r * r);
+	const double t = internal::cbrt_reduced(1.0 + s + math::sqrt(s * (2.0 + s)));
+	const double u = r * (1.0 + t + 1.0 / t);
+	const double v = math::sqrt(u * u + e4 * q);
+	const double w = es * (u + v - q) / (2.0 * v);
+	const double k = math::sqrt(u + v + w * w) - w;
+	const double d = k * a_p / (k + es);
+	const double distance = math::sqrt(d * d + a_z * a_z);
+
+	r_latitude_rad = 2.0 * math::atan2(a_z, d + distance);
+	r_altitude_meter = (k + es - 1.0) / k * distance;
+}
+
+} // geodecy
+
+#endif  // GEODECY_GEODETIC_POLICY
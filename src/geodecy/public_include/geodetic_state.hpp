@@ -0,0 +1,234 @@
+
+#ifndef GEODECY_GEODETIC_STATE
+#define GEODECY_GEODETIC_STATE
+
+#include <algorithm>
+#include <concepts>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#include "spheroid.hpp"
+
+namespace geodecy
+{
+
+namespace internal
+{
+	/// Allocators with a quaternion type, see the README
+	template <typename TAllocator>
+	concept has_quaternion = requires(const typename TAllocator::Mat3& a_mat)
+	{
+		typename TAllocator::Quat;
+		{ TAllocator::to_quat(a_mat) } -> std::same_as<typename TAllocator::Quat>;
+	};
+
+	/// Stored in place of the quaternion when the allocator has none
+	struct no_quaternion {};
+
+	template <typename TAllocator>
+	struct quaternion_type
+	{
+		using type = no_quaternion;
+	};
+
+	template <typename TAllocator>
+		requires has_quaternion<TAllocator>
+	struct quaternion_type<TAllocator>
+	{
+		using type = typename TAllocator::Quat;
+	};
+}
+
+/// The position of a moving body with the geodetic values derived from it.
+/// Every value is computed on first use after the position changed, so a body
+/// pays for one xyz2lla per update however many values are read. Copyable
+/// data without pointers that can be stored as an ecs component
+/// @tparam TSpheroid the spheroid converting positions
+template <typename TSpheroid>
+class geodetic_state
+{
+public:
+	using Type = typename TSpheroid::Type;
+	using Vec3 = typename TSpheroid::Vec3;
+	using Mat3 = typename TSpheroid::Mat3;
+	using Allocator = typename TSpheroid::Allocator;
+	using Quat = typename internal::quaternion_type<Allocator>::type;
+
+	geodetic_state() = default;
+
+	/// @param a_xyz the position in meters
+	explicit geodetic_state(const Vec3& a_xyz)
+		: m_position{a_xyz}
+	{
+	}
+
+	/// @return the position in meters
+	[[nodiscard]] const Vec3& position() const
+	{
+		return m_position;
+	}
+
+	/// Move the body, the cached values are computed again when read
+	/// @param a_xyz the position in meters
+	void set_position(const Vec3& a_xyz)
+	{
+		m_position = a_xyz;
+		m_cached = 0;
+	}
+
+	/// Move the body to a known lla. The lla is kept as given so no xyz2lla is
+	/// needed, it differs from converting the new position back by nanometers
+	/// @param a_latitude_deg the latitude in degrees
+	/// @param a_longitude_deg the longitude in degrees
+	/// @param a_altitude_meter the altitude in meters
+	void set_lla(
+		Type a_latitude_deg,
+		Type a_longitude_deg,
+		Type a_altitude_meter)
+	{
+		m_position = TSpheroid::deg::lla2xyz(a_latitude_deg, a_longitude_deg, a_altitude_meter);
+		m_lla = Allocator::to_vec(a_latitude_deg, a_longitude_deg, a_altitude_meter);
+		m_cached = c_llaCached;
+		update_prime_vertical_radius();
+	}
+
+	/// @return the latitude, longitude in degrees and the altitude in meters
+	[[nodiscard]] const Vec3& lla() const
+	{
+		resolve_lla();
+		return m_lla;
+	}
+
+	/// @return the latitude in degrees
+	[[nodiscard]] Type latitude() const
+	{
+		return Allocator::get_x(lla());
+	}
+
+	/// @return the longitude in degrees
+	[[nodiscard]] Type longitude() const
+	{
+		return Allocator::get_y(lla());
+	}
+
+	/// @return the altitude in meters
+	[[nodiscard]] Type altitude() const
+	{
+		return Allocator::get_z(lla());
+	}
+
+	/// The radius of curvature in the prime vertical, the distance from the
+	/// surface to the polar axis along the normal
+	/// @return the radius in meters
+	[[nodiscard]] Type prime_vertical_radius() const
+	{
+		resolve_lla();
+		return m_primeVerticalRadius;
+	}
+
+	/// @return the north west up local tangent plane at the position
+	[[nodiscard]] const Mat3& nwu() const
+	{
+		if(!(m_cached & c_nwuCached))
+		{
+			m_nwu = TSpheroid::deg::lla2nwu(latitude(), longitude());
+			m_cached |= c_nwuCached;
+		}
+
+		return m_nwu;
+	}
+
+	/// @return the north west up local tangent plane as a quaternion
+	[[nodiscard]] const Quat& nwu_quaternion() const
+		requires internal::has_quaternion<Allocator>
+	{
+		if(!(m_cached & c_quaternionCached))
+		{
+			m_quaternion = Allocator::to_quat(nwu());
+			m_cached |= c_quaternionCached;
+		}
+
+		return m_quaternion;
+	}
+
+	/// Compute the lla of every state that moved since it was last read with
+	/// the batched xyz2lla, see set_batch_simd_level. Bodies updated together
+	/// can call this once instead of converting one at a time
+	/// @param a_states the states to update
+	static void update(std::span<geodetic_state> a_states)
+	{
+		constexpr const size_t c_chunk = 256;
+
+		geodetic_state* stale[c_chunk];
+		Type x[c_chunk], y[c_chunk], z[c_chunk];
+		Type lat[c_chunk], lon[c_chunk], alt[c_chunk];
+
+		size_t index = 0;
+		while(index < a_states.size())
+		{
+			size_t count = 0;
+			for(; index < a_states.size() && count < c_chunk; index++)
+			{
+				geodetic_state& state = a_states[index];
+				if(state.m_cached & c_llaCached)
+				{
+					continue;
+				}
+
+				stale[count] = &state;
+				x[count] = Allocator::get_x(state.m_position);
+				y[count] = Allocator::get_y(state.m_position);
+				z[count] = Allocator::get_z(state.m_position);
+				count++;
+			}
+
+			TSpheroid::deg::xyz2lla(
+				std::span<const Type>(x, count),
+				std::span<const Type>(y, count),
+				std::span<const Type>(z, count),
+				std::span<Type>(lat, count),
+				std::span<Type>(lon, count),
+				std::span<Type>(alt, count));
+
+			for(size_t i = 0; i < count; i++)
+			{
+				stale[i]->m_lla = Allocator::to_vec(lat[i], lon[i], alt[i]);
+				stale[i]->m_cached |= c_llaCached;
+				stale[i]->update_prime_vertical_radius();
+			}
+		}
+	}
+
+private:
+	static constexpr const uint8_t c_llaCached = 1;
+	static constexpr const uint8_t c_nwuCached = 2;
+	static constexpr const uint8_t c_quaternionCached = 4;
+
+	void resolve_lla() const
+	{
+		if(!(m_cached & c_llaCached))
+		{
+			m_lla = TSpheroid::deg::xyz2lla(m_position);
+			m_cached |= c_llaCached;
+			update_prime_vertical_radius();
+		}
+	}
+
+	void update_prime_vertical_radius() const
+	{
+		const Type s_lat = std::sin(Allocator::get_x(m_lla) * Type(0.01745329251994329576923690768489));
+		m_primeVerticalRadius = TSpheroid::c_A / std::sqrt(1 - TSpheroid::c_ES * s_lat * s_lat);
+	}
+
+	Vec3 m_position{};
+	mutable Vec3 m_lla{};
+	mutable Type m_primeVerticalRadius{};
+	mutable Mat3 m_nwu{};
+	[[no_unique_address]] mutable Quat m_quaternion{};
+	mutable uint8_t m_cached{0};
+};
+
+} // geodecy
+
+#endif  // GEODECY_GEODETIC_STATE
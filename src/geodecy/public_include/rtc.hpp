@@ -0,0 +1,103 @@
+
+#ifndef GEODECY_RTC
+#define GEODECY_RTC
+
+#include <cstddef>
+#include <limits>
+#include <span>
+
+/// Relative to center. Coordinates at planet scale lose meters as float, so a
+/// batch of points is stored as float offsets from a double precision anchor.
+/// A float rounds an offset component to within 2^-24 of its length: 6 mm at
+/// 100 km from the anchor, 1 cm at 168 km and 6 cm at 1000 km. Use one anchor
+/// per tile or group of entities and keep the groups small enough for the
+/// error they can accept
+namespace geodecy
+{
+
+/// The anchor of a batch of offsets, every point is anchor + offset
+struct rtc_anchor
+{
+	/// The anchor in meters
+	double x;
+	double y;
+	double z;
+
+	/// Bound of the rounding error of every offset component in meters
+	double max_error_meter;
+};
+
+/// Bounding box of points in meters, grown one batch at a time
+struct rtc_bounds
+{
+	double minimum[3] = {
+		std::numeric_limits<double>::infinity(),
+		std::numeric_limits<double>::infinity(),
+		std::numeric_limits<double>::infinity()};
+	double maximum[3] = {
+		-std::numeric_limits<double>::infinity(),
+		-std::numeric_limits<double>::infinity(),
+		-std::numeric_limits<double>::infinity()};
+
+	/// Grow the box to contain the points, the smallest span decides the number of points
+	/// @param a_x the x coordinates in meters
+	/// @param a_y the y coordinates in meters
+	/// @param a_z the z coordinates in meters
+	void add(
+		std::span<const double> a_x,
+		std::span<const double> a_y,
+		std::span<const double> a_z);
+
+	/// Returns the center of the box, no other anchor has a smaller largest
+	/// offset. An empty box returns the origin
+	rtc_anchor anchor() const;
+};
+
+/// Store points as float offsets from an anchor. The smallest span decides the
+/// number of points and outputs must not overlap inputs
+/// @param a_anchor the anchor, see rtc_bounds::anchor
+/// @param a_x the x coordinates in meters
+/// @param a_y the y coordinates in meters
+/// @param a_z the z coordinates in meters
+/// @param r_x the x offsets in meters
+/// @param r_y the y offsets in meters
+/// @param r_z the z offsets in meters
+void xyz2rtc(
+	const rtc_anchor& a_anchor,
+	std::span<const double> a_x,
+	std::span<const double> a_y,
+	std::span<const double> a_z,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z);
+
+/// Store points as float offsets from the center of their bounding box
+/// @return the anchor of the offsets
+rtc_anchor xyz2rtc(
+	std::span<const double> a_x,
+	std::span<const double> a_y,
+	std::span<const double> a_z,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z);
+
+/// Restore points from float offsets, see xyz2rtc
+/// @param a_anchor the anchor of the offsets
+/// @param a_x the x offsets in meters
+/// @param a_y the y offsets in meters
+/// @param a_z the z offsets in meters
+/// @param r_x the x coordinates in meters
+/// @param r_y the y coordinates in meters
+/// @param r_z the z coordinates in meters
+void rtc2xyz(
+	const rtc_anchor& a_anchor,
+	std::span<const float> a_x,
+	std::span<const float> a_y,
+	std::span<const float> a_z,
+	std::span<double> r_x,
+	std::span<double> r_y,
+	std::span<double> r_z);
+
+} // geodecy
+
+#endif  // GEODECY_RTC
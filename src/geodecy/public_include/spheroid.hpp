@@ -2,6 +2,16 @@
 #ifndef GEODECY_SPHEROID
 #define GEODECY_SPHEROID
 
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <type_traits>
+
+#include "batch.hpp"
+#include "geodetic_policy.hpp"
+#include "rtc.hpp"
+#include "trig.hpp"
+
 namespace geodecy
 {
 
@@ -23,10 +33,12 @@ public:
 	const double value;
 };
 
-template <typename TAllocator, db_wrp A, db_wrp B>
+/// @tparam TPolicy the algorithm converting xyz to lla, see geodetic_policy
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy = geodetic_policy::bowring<2>>
 struct spheroid
 {
 public:
+	using Allocator = TAllocator;
 	using Type = typename TAllocator::Type;
 	using Vec3 = typename TAllocator::Vec3;
 	using Mat3 = typename TAllocator::Mat3;
@@ -45,6 +57,52 @@ protected:
 		return a_radians * Type(57.295779513082320876798154814105);
 	}
 
+	/// The standard library at runtime and the functions of trig.hpp in
+	/// constant expressions, where the standard library can not be used
+	static constexpr void sin_cos(double a_angle, double& r_sin, double& r_cos)
+	{
+		if(std::is_constant_evaluated())
+		{
+			math::sin_cos(a_angle, r_sin, r_cos);
+			return;
+		}
+
+		r_sin = std::sin(a_angle);
+		r_cos = std::cos(a_angle);
+	}
+
+	static constexpr double atan2(double a_y, double a_x)
+	{
+		return std::is_constant_evaluated() ? math::atan2(a_y, a_x) : std::atan2(a_y, a_x);
+	}
+
+	static void lla2xyz_batch(
+		std::span<const Type> a_latitude,
+		std::span<const Type> a_longitude,
+		std::span<const Type> a_altitude_meter,
+		std::span<Type> r_x,
+		std::span<Type> r_y,
+		std::span<Type> r_z,
+		Type a_angle_scale);
+
+	static void xyz2lla_batch(
+		std::span<const Type> a_x,
+		std::span<const Type> a_y,
+		std::span<const Type> a_z,
+		std::span<Type> r_latitude,
+		std::span<Type> r_longitude,
+		std::span<Type> r_altitude_meter,
+		Type a_angle_scale);
+
+	static rtc_anchor lla2rtc_batch(
+		std::span<const Type> a_latitude,
+		std::span<const Type> a_longitude,
+		std::span<const Type> a_altitude_meter,
+		std::span<float> r_x,
+		std::span<float> r_y,
+		std::span<float> r_z,
+		Type a_angle_scale);
+
 	static_assert(c_A > 0);
 	static_assert(c_B > 0);
 
@@ -72,6 +130,23 @@ public:
 		static constexpr Vec3 lla2xyz(
 			const Vec3& a_lla);
 
+		/// Convert a batch of lla to xyz coordinates in meters with the widest
+		/// instruction set available, see set_batch_simd_level. The smallest
+		/// span decides the number of points and outputs must not overlap inputs
+		/// @param a_latitude_rad the latitudes in radians
+		/// @param a_longitude_rad the longitudes in radians
+		/// @param a_altitude_meter the altitudes in meters
+		/// @param r_x the x coordinates in meters
+		/// @param r_y the y coordinates in meters
+		/// @param r_z the z coordinates in meters
+		static void lla2xyz(
+			std::span<const Type> a_latitude_rad,
+			std::span<const Type> a_longitude_rad,
+			std::span<const Type> a_altitude_meter,
+			std::span<Type> r_x,
+			std::span<Type> r_y,
+			std::span<Type> r_z);
+
 		/// Convert xyz to lla
 		/// @param a_x the x coordinate in meters
 		/// @param a_y the y coordinate in meters
@@ -88,6 +163,39 @@ public:
 		static constexpr Vec3 xyz2lla(
 			const Vec3& a_xyz);
 
+		/// Convert a batch of xyz to lla, see the batched lla2xyz
+		/// @param a_x the x coordinates in meters
+		/// @param a_y the y coordinates in meters
+		/// @param a_z the z coordinates in meters
+		/// @param r_latitude_rad the latitudes in radians
+		/// @param r_longitude_rad the longitudes in radians
+		/// @param r_altitude_meter the altitudes in meters
+		static void xyz2lla(
+			std::span<const Type> a_x,
+			std::span<const Type> a_y,
+			std::span<const Type> a_z,
+			std::span<Type> r_latitude_rad,
+			std::span<Type> r_longitude_rad,
+			std::span<Type> r_altitude_meter);
+
+		/// Convert a batch of lla to float offsets from the center of their
+		/// bounding box, see rtc.hpp for the error bounds. The points are
+		/// converted twice, once to find the anchor and once for the offsets
+		/// @param a_latitude_rad the latitudes in radians
+		/// @param a_longitude_rad the longitudes in radians
+		/// @param a_altitude_meter the altitudes in meters
+		/// @param r_x the x offsets in meters
+		/// @param r_y the y offsets in meters
+		/// @param r_z the z offsets in meters
+		/// @return the anchor of the offsets
+		static rtc_anchor lla2rtc(
+			std::span<const Type> a_latitude_rad,
+			std::span<const Type> a_longitude_rad,
+			std::span<const Type> a_altitude_meter,
+			std::span<float> r_x,
+			std::span<float> r_y,
+			std::span<float> r_z);
+
 		/// Convert lla to ltp (local tangent plane)
 		/// @tparam X the direction of the X axis
 		/// @tparam Y the direction of the Y axis
@@ -136,6 +244,21 @@ public:
 		/// @return the xyz coordinate in meters
 		static constexpr Vec3 lla2xyz(const Vec3& a_lla);
 
+		/// Convert a batch of lla to xyz coordinates in meters, see rad::lla2xyz
+		/// @param a_latitude_deg the latitudes in degrees
+		/// @param a_longitude_deg the longitudes in degrees
+		/// @param a_altitude_meter the altitudes in meters
+		/// @param r_x the x coordinates in meters
+		/// @param r_y the y coordinates in meters
+		/// @param r_z the z coordinates in meters
+		static void lla2xyz(
+			std::span<const Type> a_latitude_deg,
+			std::span<const Type> a_longitude_deg,
+			std::span<const Type> a_altitude_meter,
+			std::span<Type> r_x,
+			std::span<Type> r_y,
+			std::span<Type> r_z);
+
 		/// Convert xyz to lla
 		/// @param a_x the x coordinate in meters
 		/// @param a_y the y coordinate in meters
@@ -151,6 +274,37 @@ public:
 		/// @return the lla in degrees and meters
 		static constexpr Vec3 xyz2lla(const Vec3& a_xyz);
 
+		/// Convert a batch of xyz to lla, see rad::lla2xyz
+		/// @param a_x the x coordinates in meters
+		/// @param a_y the y coordinates in meters
+		/// @param a_z the z coordinates in meters
+		/// @param r_latitude_deg the latitudes in degrees
+		/// @param r_longitude_deg the longitudes in degrees
+		/// @param r_altitude_meter the altitudes in meters
+		static void xyz2lla(
+			std::span<const Type> a_x,
+			std::span<const Type> a_y,
+			std::span<const Type> a_z,
+			std::span<Type> r_latitude_deg,
+			std::span<Type> r_longitude_deg,
+			std::span<Type> r_altitude_meter);
+
+		/// Convert a batch of lla to float offsets, see rad::lla2rtc
+		/// @param a_latitude_deg the latitudes in degrees
+		/// @param a_longitude_deg the longitudes in degrees
+		/// @param a_altitude_meter the altitudes in meters
+		/// @param r_x the x offsets in meters
+		/// @param r_y the y offsets in meters
+		/// @param r_z the z offsets in meters
+		/// @return the anchor of the offsets
+		static rtc_anchor lla2rtc(
+			std::span<const Type> a_latitude_deg,
+			std::span<const Type> a_longitude_deg,
+			std::span<const Type> a_altitude_meter,
+			std::span<float> r_x,
+			std::span<float> r_y,
+			std::span<float> r_z);
+
 		/// Convert lla to ltp (local tangent plane)
 		/// @tparam X the direction of the X axis
 		/// @tparam Y the direction of the Y axis
@@ -189,25 +343,24 @@ public:
 namespace geodecy
 {
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::lla2xyz(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::rad::lla2xyz(
 	Type a_latitude_rad,
 	Type a_longitude_rad,
 	Type a_altitude_meter)
 {
-	const double c_lat = std::cos(a_latitude_rad);
-	const double s_lat = std::sin(a_latitude_rad);
-	const double c_lon = std::cos(a_longitude_rad);
-	const double s_lon = std::sin(a_longitude_rad);
-	const double N = c_A / std::sqrt(1 - c_ES * s_lat * s_lat);
+	double s_lat{}, c_lat{}, s_lon{}, c_lon{};
+	sin_cos(a_latitude_rad, s_lat, c_lat);
+	sin_cos(a_longitude_rad, s_lon, c_lon);
+	const double N = c_A / math::sqrt(1 - c_ES * s_lat * s_lat);
 	const double x = (N + a_altitude_meter) * c_lat * c_lon;
 	const double y = (N + a_altitude_meter) * c_lat * s_lon;
 	const double z = ((1 - c_ES) * N + a_altitude_meter) * s_lat;
 	return TAllocator::to_vec(Type(x), Type(y), Type(z));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::lla2xyz(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::rad::lla2xyz(
 	const Vec3& a_lla)
 {
 	return rad::lla2xyz(
@@ -216,8 +369,8 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::lla2xyz(
 		TAllocator::get_z(a_lla));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::lla2xyz(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::deg::lla2xyz(
 	Type a_latitude_deg,
 	Type a_longitude_deg,
 	Type a_altitude_meter)
@@ -228,8 +381,8 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::lla2xyz(
 		a_altitude_meter);
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::lla2xyz(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::deg::lla2xyz(
 	const Vec3& a_lla)
 {
 	return deg::lla2xyz(
@@ -238,9 +391,8 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::lla2xyz(
 		TAllocator::get_z(a_lla));
 }
 
-// TODO: Use a known approximation
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::xyz2lla(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::rad::xyz2lla(
 	Type a_x,
 	Type a_y,
 	Type a_z)
@@ -249,58 +401,19 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::xyz2lla(
 	const double y = a_y;
 	const double z = a_z;
 
-	const double rp = std::sqrt(x*x + y*y + z*z);
-	const double p = std::sqrt(x*x + y*y);
-
-	const double lon_rad = (std::abs(x) + std::abs(y) < 1.0e-10)
+	const double p = math::sqrt(x*x + y*y);
+	const double lon_rad = p < 1.0e-10
 		? 0.0
-		: std::atan2(y, x);
-
-	if(p < 1.0e-10)
-	{
-		double lat_rad   = radians(z < 0.0 ? -90 : 90.0);
-		double alt_meter = rp - c_B;
-		return TAllocator::to_vec(Type(lat_rad), Type(lon_rad), Type(alt_meter));
-	}
-
-	const double flatgc_rad = std::asin(z / rp);
-	const double slat_0	 = std::sin(flatgc_rad);
-	const double first_rn   = c_A / std::sqrt(1.0 - c_ES * slat_0 * slat_0);
+		: atan2(y, x);
 
-	constexpr const double c_B4_A4 = (1.0 - c_ES) * (1.0 - c_ES) - 1;
-	double alt_meter = rp - first_rn * std::sqrt(1 + c_B4_A4 * slat_0 * slat_0);
 	double lat_rad{};
-	{
-		const double flatgd_rad = std::atan(std::tan(flatgc_rad) / (1 - c_ES * first_rn / (first_rn + alt_meter)));
-		const double slat_1 = std::sin(flatgd_rad);
-		const double rn = c_A / std::sqrt(1.0 - c_ES * slat_1 * slat_1);
-		lat_rad = std::atan(std::tan(flatgc_rad) / (1 - c_ES * rn / (rn + alt_meter)));
-	}
-
-	double slat = std::sin(lat_rad);
-	double rn   = c_A / std::sqrt(1.0 - c_ES * slat * slat);
-
-	for(int i = 0; i < 5; i++)
-	{
-		double lat_new_rad = std::atan((z + rn * c_ES * slat) / p);
-
-		slat	  = std::sin(lat_new_rad);
-		rn		= c_A / std::sqrt(1.0 - c_ES * slat * slat);
-		alt_meter = (p / std::cos(lat_new_rad)) - rn; // Not needed in loop could be removed
-
-		double dlat_rad = lat_new_rad - lat_rad;
-		lat_rad = lat_new_rad;
-		if(std::abs(dlat_rad) < 1.0e-14)
-		{
-			break;
-		}
-	}
-
+	double alt_meter{};
+	TPolicy::solve(c_A, c_B, p, z, lat_rad, alt_meter);
 	return TAllocator::to_vec(Type(lat_rad), Type(lon_rad), Type(alt_meter));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::xyz2lla(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::rad::xyz2lla(
 	const Vec3& a_xyz)
 {
 	return rad::xyz2lla(
@@ -310,8 +423,8 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::rad::xyz2lla(
 }
 
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::xyz2lla(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::deg::xyz2lla(
 	Type a_x,
 	Type a_y,
 	Type a_z)
@@ -323,8 +436,8 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::xyz2lla(
 		TAllocator::get_z(value));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
-constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::xyz2lla(
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B, TPolicy>::deg::xyz2lla(
 	const Vec3& a_xyz)
 {
 	return deg::xyz2lla(
@@ -333,9 +446,200 @@ constexpr typename TAllocator::Vec3 spheroid<TAllocator, A, B>::deg::xyz2lla(
 		TAllocator::get_z(a_xyz));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::lla2xyz_batch(
+	std::span<const Type> a_latitude,
+	std::span<const Type> a_longitude,
+	std::span<const Type> a_altitude_meter,
+	std::span<Type> r_x,
+	std::span<Type> r_y,
+	std::span<Type> r_z,
+	Type a_angle_scale)
+{
+	const size_t count = std::min({a_latitude.size(), a_longitude.size(), a_altitude_meter.size(), r_x.size(), r_y.size(), r_z.size()});
+	if constexpr(std::is_same_v<Type, double>)
+	{
+		internal::lla2xyz_batch({
+			{a_latitude.data(), a_longitude.data(), a_altitude_meter.data()},
+			{r_x.data(), r_y.data(), r_z.data()},
+			count, c_A, c_B, a_angle_scale, {}});
+	}
+	else
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			const Vec3 xyz = rad::lla2xyz(a_latitude[i] * a_angle_scale, a_longitude[i] * a_angle_scale, a_altitude_meter[i]);
+			r_x[i] = TAllocator::get_x(xyz);
+			r_y[i] = TAllocator::get_y(xyz);
+			r_z[i] = TAllocator::get_z(xyz);
+		}
+	}
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::xyz2lla_batch(
+	std::span<const Type> a_x,
+	std::span<const Type> a_y,
+	std::span<const Type> a_z,
+	std::span<Type> r_latitude,
+	std::span<Type> r_longitude,
+	std::span<Type> r_altitude_meter,
+	Type a_angle_scale)
+{
+	const size_t count = std::min({a_x.size(), a_y.size(), a_z.size(), r_latitude.size(), r_longitude.size(), r_altitude_meter.size()});
+	if constexpr(std::is_same_v<Type, double> && requires { TPolicy::c_method; })
+	{
+		internal::xyz2lla_batch({
+			{a_x.data(), a_y.data(), a_z.data()},
+			{r_latitude.data(), r_longitude.data(), r_altitude_meter.data()},
+			count, c_A, c_B, a_angle_scale, TPolicy::c_method});
+	}
+	else
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			const Vec3 lla = rad::xyz2lla(a_x[i], a_y[i], a_z[i]);
+			r_latitude[i] = TAllocator::get_x(lla) / a_angle_scale;
+			r_longitude[i] = TAllocator::get_y(lla) / a_angle_scale;
+			r_altitude_meter[i] = TAllocator::get_z(lla);
+		}
+	}
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::rad::lla2xyz(
+	std::span<const Type> a_latitude_rad,
+	std::span<const Type> a_longitude_rad,
+	std::span<const Type> a_altitude_meter,
+	std::span<Type> r_x,
+	std::span<Type> r_y,
+	std::span<Type> r_z)
+{
+	lla2xyz_batch(a_latitude_rad, a_longitude_rad, a_altitude_meter, r_x, r_y, r_z, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::deg::lla2xyz(
+	std::span<const Type> a_latitude_deg,
+	std::span<const Type> a_longitude_deg,
+	std::span<const Type> a_altitude_meter,
+	std::span<Type> r_x,
+	std::span<Type> r_y,
+	std::span<Type> r_z)
+{
+	lla2xyz_batch(a_latitude_deg, a_longitude_deg, a_altitude_meter, r_x, r_y, r_z, radians(Type(1)));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::rad::xyz2lla(
+	std::span<const Type> a_x,
+	std::span<const Type> a_y,
+	std::span<const Type> a_z,
+	std::span<Type> r_latitude_rad,
+	std::span<Type> r_longitude_rad,
+	std::span<Type> r_altitude_meter)
+{
+	xyz2lla_batch(a_x, a_y, a_z, r_latitude_rad, r_longitude_rad, r_altitude_meter, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+void spheroid<TAllocator, A, B, TPolicy>::deg::xyz2lla(
+	std::span<const Type> a_x,
+	std::span<const Type> a_y,
+	std::span<const Type> a_z,
+	std::span<Type> r_latitude_deg,
+	std::span<Type> r_longitude_deg,
+	std::span<Type> r_altitude_meter)
+{
+	xyz2lla_batch(a_x, a_y, a_z, r_latitude_deg, r_longitude_deg, r_altitude_meter, radians(Type(1)));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+rtc_anchor spheroid<TAllocator, A, B, TPolicy>::lla2rtc_batch(
+	std::span<const Type> a_latitude,
+	std::span<const Type> a_longitude,
+	std::span<const Type> a_altitude_meter,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z,
+	Type a_angle_scale)
+{
+	// Chunks small enough for the stack are converted to double positions,
+	// the first pass finds the anchor and the second stores the offsets
+	constexpr const size_t c_chunk = 256;
+	double x[c_chunk], y[c_chunk], z[c_chunk];
+	const auto convert = [&](size_t a_offset, size_t a_count) {
+		if constexpr(std::is_same_v<Type, double>)
+		{
+			lla2xyz_batch(
+				a_latitude.subspan(a_offset, a_count),
+				a_longitude.subspan(a_offset, a_count),
+				a_altitude_meter.subspan(a_offset, a_count),
+				std::span<double>(x, a_count), std::span<double>(y, a_count), std::span<double>(z, a_count),
+				a_angle_scale);
+		}
+		else
+		{
+			for(size_t i = 0; i < a_count; i++)
+			{
+				const Vec3 xyz = rad::lla2xyz(
+					a_latitude[a_offset + i] * a_angle_scale,
+					a_longitude[a_offset + i] * a_angle_scale,
+					a_altitude_meter[a_offset + i]);
+				x[i] = TAllocator::get_x(xyz);
+				y[i] = TAllocator::get_y(xyz);
+				z[i] = TAllocator::get_z(xyz);
+			}
+		}
+	};
+
+	const size_t count = std::min({a_latitude.size(), a_longitude.size(), a_altitude_meter.size(), r_x.size(), r_y.size(), r_z.size()});
+	rtc_bounds bounds;
+	for(size_t offset = 0; offset < count; offset += c_chunk)
+	{
+		const size_t chunk = std::min(c_chunk, count - offset);
+		convert(offset, chunk);
+		bounds.add({x, chunk}, {y, chunk}, {z, chunk});
+	}
+
+	const rtc_anchor anchor = bounds.anchor();
+	for(size_t offset = 0; offset < count; offset += c_chunk)
+	{
+		const size_t chunk = std::min(c_chunk, count - offset);
+		convert(offset, chunk);
+		xyz2rtc(anchor, {x, chunk}, {y, chunk}, {z, chunk},
+			r_x.subspan(offset, chunk), r_y.subspan(offset, chunk), r_z.subspan(offset, chunk));
+	}
+	return anchor;
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+rtc_anchor spheroid<TAllocator, A, B, TPolicy>::rad::lla2rtc(
+	std::span<const Type> a_latitude_rad,
+	std::span<const Type> a_longitude_rad,
+	std::span<const Type> a_altitude_meter,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z)
+{
+	return lla2rtc_batch(a_latitude_rad, a_longitude_rad, a_altitude_meter, r_x, r_y, r_z, Type(1));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
+rtc_anchor spheroid<TAllocator, A, B, TPolicy>::deg::lla2rtc(
+	std::span<const Type> a_latitude_deg,
+	std::span<const Type> a_longitude_deg,
+	std::span<const Type> a_altitude_meter,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z)
+{
+	return lla2rtc_batch(a_latitude_deg, a_longitude_deg, a_altitude_meter, r_x, r_y, r_z, radians(Type(1)));
+}
+
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
 template<Axis X, Axis Y, Axis Z>
-constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B>::rad::lla2ltp(
+constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B, TPolicy>::rad::lla2ltp(
 	Type a_latitude_rad,
 	Type a_longitude_rad)
 {
@@ -344,10 +648,9 @@ constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B>::rad::lla2ltp(
 	static_assert(Y >= 0 && Y < 6, "Invalid Y axis");
 	static_assert(Z >= 0 && Z < 6, "Invalid Z axis");
 
-	const double c_lat = std::cos(a_latitude_rad);
-	const double s_lat = std::sin(a_latitude_rad);
-	const double c_lon = std::cos(a_longitude_rad);
-	const double s_lon = std::sin(a_longitude_rad);
+	double s_lat{}, c_lat{}, s_lon{}, c_lon{};
+	sin_cos(a_latitude_rad, s_lat, c_lat);
+	sin_cos(a_longitude_rad, s_lon, c_lon);
 
 	const double x0 = -s_lat * c_lon;
 	const double y0 = -s_lat * s_lon;
@@ -380,9 +683,9 @@ constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B>::rad::lla2ltp(
 		Type(vx2), Type(vy2), Type(vz2));
 }
 
-template <typename TAllocator, db_wrp A, db_wrp B>
+template <typename TAllocator, db_wrp A, db_wrp B, typename TPolicy>
 template<Axis X, Axis Y, Axis Z>
-constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B>::deg::lla2ltp(
+constexpr typename TAllocator::Mat3 spheroid<TAllocator, A, B, TPolicy>::deg::lla2ltp(
 	Type a_latitude_deg,
 	Type a_longitude_deg)
 {
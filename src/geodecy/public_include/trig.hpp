@@ -0,0 +1,170 @@
+
+#ifndef GEODECY_TRIG
+#define GEODECY_TRIG
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/// Forces inlining so the functions vectorize inside the batch kernels and no
+/// out of line copy compiled for another instruction set is shared between them
+#if defined(__GNUC__)
+#define GEODECY_INLINE [[gnu::always_inline]] inline
+#else
+#define GEODECY_INLINE inline
+#endif
+
+/// Branch free double precision trigonometry. Every branch is a select so loops
+/// calling these functions vectorize. Results are within 2 ulp of the standard
+/// library for the arguments used by geodetic math. All functions can be used
+/// in constant expressions
+namespace geodecy::math
+{
+
+namespace internal
+{
+	constexpr const double c_pio4   = 7.85398163397448309616E-1;
+	constexpr const double c_pio2   = 1.57079632679489661923E0;
+	constexpr const double c_pi     = 3.14159265358979323846E0;
+	constexpr const double c_2opi   = 6.36619772367581343076E-1;
+
+	/// Low bits of pi/4 lost to rounding
+	constexpr const double c_pio4Low = 3.061616997868383017935E-17;
+
+	/// pi/2 split into three parts for an exact range reduction
+	constexpr const double c_pio2Part1 = 1.57079625129699707031E0;
+	constexpr const double c_pio2Part2 = 7.54978941586159635336E-8;
+	constexpr const double c_pio2Part3 = 5.39030285815811905290E-15;
+
+	/// Adding 1.5 * 2^52 rounds to an integer kept in the low bits of the mantissa
+	constexpr const double c_roundShift = 6755399441055744.0;
+
+	/// tan(pi/8)
+	constexpr const double c_tanPi8 = 4.14213562373095048802E-1;
+
+	GEODECY_INLINE constexpr double sin_poly(double a_z)
+	{
+		return ((((( 1.58962301576546568060E-10 * a_z
+			- 2.50507477628578072866E-8) * a_z
+			+ 2.75573136213857245213E-6) * a_z
+			- 1.98412698295895385996E-4) * a_z
+			+ 8.33333333332211858878E-3) * a_z
+			- 1.66666666666666307295E-1);
+	}
+
+	GEODECY_INLINE constexpr double cos_poly(double a_z)
+	{
+		return (((((-1.13585365213876817300E-11 * a_z
+			+ 2.08757008419747316778E-9) * a_z
+			- 2.75573141792967388112E-7) * a_z
+			+ 2.48015872888517045348E-5) * a_z
+			- 1.38888888888730564116E-3) * a_z
+			+ 4.16666666666665929218E-2);
+	}
+
+	/// atan(x) for |x| <= tan(pi/8)
+	GEODECY_INLINE constexpr double atan_reduced(double a_x)
+	{
+		const double z = a_x * a_x;
+		const double p = (((-8.750608600031904122785E-1 * z
+			- 1.615753718733365076637E1) * z
+			- 7.500855792314704667340E1) * z
+			- 1.228866684490136173410E2) * z
+			- 6.485021904942025371773E1;
+		const double q = ((((z
+			+ 2.485846490142306297962E1) * z
+			+ 1.650270098316988542046E2) * z
+			+ 4.328810604912902668951E2) * z
+			+ 4.853903996359136964868E2) * z
+			+ 1.945506571482613964425E2;
+		return a_x + a_x * (z * p / q);
+	}
+
+	GEODECY_INLINE constexpr bool sign_bit(double a_value)
+	{
+		return __builtin_bit_cast(int64_t, a_value) < 0;
+	}
+
+	/// std::fabs and std::copysign are not constexpr before C++23
+	GEODECY_INLINE constexpr double abs(double a_value)
+	{
+		return __builtin_bit_cast(double, __builtin_bit_cast(uint64_t, a_value) & ~(uint64_t(1) << 63));
+	}
+
+	GEODECY_INLINE constexpr double copysign(double a_value, double a_sign)
+	{
+		return __builtin_bit_cast(double, __builtin_bit_cast(uint64_t, abs(a_value)) | (__builtin_bit_cast(uint64_t, a_sign) & (uint64_t(1) << 63)));
+	}
+}
+
+/// Sine and cosine of an angle, accurate for |angle| < 1e8 radians
+/// @param a_angle the angle in radians
+GEODECY_INLINE constexpr void sin_cos(double a_angle, double& r_sin, double& r_cos)
+{
+	using namespace internal;
+	const double shifted = a_angle * c_2opi + c_roundShift;
+	const uint64_t quadrant = __builtin_bit_cast(uint64_t, shifted);
+	const double q = shifted - c_roundShift;
+	const double x = ((a_angle - q * c_pio2Part1) - q * c_pio2Part2) - q * c_pio2Part3;
+
+	const double z = x * x;
+	const double s = x + x * z * sin_poly(z);
+	const double c = 1.0 - 0.5 * z + z * z * cos_poly(z);
+
+	const bool swap = (quadrant & 1) != 0;
+	const double sine = swap ? c : s;
+	const double cosine = swap ? s : c;
+	r_sin = (quadrant & 2) != 0 ? -sine : sine;
+	r_cos = ((quadrant + 1) & 2) != 0 ? -cosine : cosine;
+}
+
+/// Returns the angle of the vector (x, y) in the range [-pi, pi]
+GEODECY_INLINE constexpr double atan2(double a_y, double a_x)
+{
+	using namespace internal;
+	const double ax = internal::abs(a_x);
+	const double ay = internal::abs(a_y);
+	const bool swap = ay > ax;
+	const double numerator = swap ? ax : ay;
+	const double denominator = swap ? ay : ax;
+
+	// numerator / denominator is in [0, 1], values above tan(pi/8) are moved
+	// below it with atan(t) = pi/4 + atan((t - 1) / (t + 1)). A single division
+	// keeps the function free of branches that could trap
+	const bool shift = numerator > c_tanPi8 * denominator;
+	const double reduced = atan_reduced(
+		(shift ? numerator - denominator : numerator) /
+		(shift ? numerator + denominator : (denominator > 0.0 ? denominator : 1.0)));
+	double result = shift ? (reduced + c_pio4Low) + c_pio4 : reduced;
+	result = swap ? (c_pio4 - result + 2.0 * c_pio4Low) + c_pio4 : result;
+	result = sign_bit(a_x) ? c_pi - result : result;
+	return internal::copysign(result, a_y);
+}
+
+/// Square root, std::sqrt outside of constant expressions
+GEODECY_INLINE constexpr double sqrt(double a_value)
+{
+	if(std::is_constant_evaluated())
+	{
+		if(!(a_value > 0.0))
+		{
+			return a_value == 0.0 ? a_value : std::numeric_limits<double>::quiet_NaN();
+		}
+
+		// Halving the exponent is within 6% of the root, every Newton step
+		// doubles the correct digits
+		double root = __builtin_bit_cast(double, (__builtin_bit_cast(uint64_t, a_value) >> 1) + (uint64_t(1023) << 51));
+		for(int i = 0; i < 6; i++)
+		{
+			root = 0.5 * (root + a_value / root);
+		}
+		return root;
+	}
+
+	return std::sqrt(a_value);
+}
+
+} // geodecy::math
+
+#endif  // GEODECY_TRIG
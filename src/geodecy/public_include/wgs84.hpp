@@ -44,6 +44,8 @@ glm::dmat3 rpy(
 
 // TODO: Use this in the future?
 #include "spheroid.hpp"
+#include "geodesic.hpp"
+#include "geodetic_state.hpp"
 namespace geodecy {
 
 struct wgs84_glm_allocator
@@ -51,6 +53,7 @@ struct wgs84_glm_allocator
 	using Type = double;
 	using Vec3 = glm::dvec3;
 	using Mat3 = glm::dmat3;
+	using Quat = glm::dquat;
 
 	static constexpr Mat3 to_mat(
 		double a_x0, double a_y0, double a_z0,
@@ -83,9 +86,16 @@ struct wgs84_glm_allocator
 	{
 		return a_vec.z;
 	}
+
+	static Quat to_quat(const Mat3& a_mat)
+	{
+		return glm::quat_cast(a_mat);
+	}
 };
 
 using wgs84 = spheroid<wgs84_glm_allocator, 6378137.0, 6356752.314245>;
+using wgs84_geodesic = geodesic<wgs84_glm_allocator, 6378137.0, 6356752.314245>;
+using wgs84_geodetic_state = geodetic_state<wgs84>;
 
 } // geodecy
 
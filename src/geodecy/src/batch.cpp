@@ -0,0 +1,140 @@
+#include "batch_kernels.hpp"
+#include "geodesic_kernels.hpp"
+
+// Scalar kernels and the runtime selection of the instruction set. The AVX2
+// and AVX-512 kernels are only built for x86 with GCC or Clang, see CMakeLists.txt
+
+namespace geodecy::internal
+{
+
+#if defined(GEODECY_BATCH_X86)
+void lla2xyz_avx2(const batch_arguments& a_arguments);
+void xyz2lla_avx2(const batch_arguments& a_arguments);
+void lla2xyz_avx512(const batch_arguments& a_arguments);
+void xyz2lla_avx512(const batch_arguments& a_arguments);
+void geodesic_inverse_avx2(const geodesic_arguments& a_arguments);
+void geodesic_direct_avx2(const geodesic_arguments& a_arguments);
+void geodesic_inverse_avx512(const geodesic_arguments& a_arguments);
+void geodesic_direct_avx512(const geodesic_arguments& a_arguments);
+#endif
+
+static simd_level detect_simd_level()
+{
+#if defined(GEODECY_BATCH_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+	{
+		return simd_level::avx512;
+	}
+
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return simd_level::avx2;
+	}
+#endif
+	return simd_level::scalar;
+}
+
+static simd_level& active_simd_level()
+{
+	static simd_level s_level = supported_simd_level();
+	return s_level;
+}
+
+void lla2xyz_batch(const batch_arguments& a_arguments)
+{
+	switch(active_simd_level())
+	{
+#if defined(GEODECY_BATCH_X86)
+	case simd_level::avx512: lla2xyz_avx512(a_arguments); return;
+	case simd_level::avx2: lla2xyz_avx2(a_arguments); return;
+#endif
+	default: lla2xyz_kernel(a_arguments); return;
+	}
+}
+
+void xyz2lla_batch(const batch_arguments& a_arguments)
+{
+	switch(active_simd_level())
+	{
+#if defined(GEODECY_BATCH_X86)
+	case simd_level::avx512: xyz2lla_avx512(a_arguments); return;
+	case simd_level::avx2: xyz2lla_avx2(a_arguments); return;
+#endif
+	default: xyz2lla_kernel(a_arguments); return;
+	}
+}
+
+void geodesic_inverse_batch(const geodesic_arguments& a_arguments)
+{
+	switch(active_simd_level())
+	{
+#if defined(GEODECY_BATCH_X86)
+	case simd_level::avx512: geodesic_inverse_avx512(a_arguments); break;
+	case simd_level::avx2: geodesic_inverse_avx2(a_arguments); break;
+#endif
+	default: geodesic_inverse_kernel(a_arguments); break;
+	}
+
+	// Lines the kernels could not solve have a NaN distance
+	const double scale = a_arguments.angle_scale;
+	for(size_t i = 0; i < a_arguments.count; i++)
+	{
+		if(!std::isnan(a_arguments.output[0][i]))
+		{
+			continue;
+		}
+
+		double azi1, azi2;
+		geodesic_inverse(*a_arguments.constants,
+			a_arguments.latitude * scale, a_arguments.longitude * scale,
+			a_arguments.input[0][i] * scale, a_arguments.input[1][i] * scale,
+			a_arguments.output[0][i], azi1, azi2);
+		if(a_arguments.output[1] && a_arguments.output[2])
+		{
+			a_arguments.output[1][i] = azi1 / scale;
+			a_arguments.output[2][i] = azi2 / scale;
+		}
+	}
+}
+
+void geodesic_direct_batch(const geodesic_arguments& a_arguments)
+{
+	switch(active_simd_level())
+	{
+#if defined(GEODECY_BATCH_X86)
+	case simd_level::avx512: geodesic_direct_avx512(a_arguments); return;
+	case simd_level::avx2: geodesic_direct_avx2(a_arguments); return;
+#endif
+	default: geodesic_direct_kernel(a_arguments); return;
+	}
+}
+
+} // geodecy::internal
+
+namespace geodecy
+{
+
+simd_level supported_simd_level()
+{
+	static const simd_level s_level = internal::detect_simd_level();
+	return s_level;
+}
+
+simd_level batch_simd_level()
+{
+	return internal::active_simd_level();
+}
+
+bool set_batch_simd_level(simd_level a_level)
+{
+	if(a_level > supported_simd_level())
+	{
+		return false;
+	}
+
+	internal::active_simd_level() = a_level;
+	return true;
+}
+
+} // geodecy
@@ -0,0 +1,29 @@
+#include "batch_kernels.hpp"
+#include "geodesic_kernels.hpp"
+
+// Compiled with AVX-512F and AVX-512DQ enabled
+
+namespace geodecy::internal
+{
+
+void lla2xyz_avx512(const batch_arguments& a_arguments)
+{
+	lla2xyz_kernel(a_arguments);
+}
+
+void xyz2lla_avx512(const batch_arguments& a_arguments)
+{
+	xyz2lla_kernel(a_arguments);
+}
+
+void geodesic_inverse_avx512(const geodesic_arguments& a_arguments)
+{
+	geodesic_inverse_kernel(a_arguments);
+}
+
+void geodesic_direct_avx512(const geodesic_arguments& a_arguments)
+{
+	geodesic_direct_kernel(a_arguments);
+}
+
+} // geodecy::internal
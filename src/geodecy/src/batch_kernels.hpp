@@ -0,0 +1,105 @@
+
+#ifndef GEODECY_BATCH_KERNELS
+#define GEODECY_BATCH_KERNELS
+
+#include <cmath>
+
+#include "batch.hpp"
+#include "geodetic_policy.hpp"
+#include "trig.hpp"
+
+// Kernels shared by the batch translation units. Every unit compiles them for
+// its own instruction set, the anonymous namespace keeps the copies apart. Only
+// always inlined functions may be called, an out of line inline function from
+// the standard library could be shared with a unit compiled for another set
+
+namespace geodecy::internal
+{
+namespace
+{
+
+void lla2xyz_kernel(
+	const double* __restrict latitude,
+	const double* __restrict longitude,
+	const double* __restrict altitude,
+	double* __restrict x,
+	double* __restrict y,
+	double* __restrict z,
+	const batch_arguments& a_arguments)
+{
+	const double a = a_arguments.a;
+	const double es = 1.0 - (a_arguments.b * a_arguments.b) / (a * a);
+	const double scale = a_arguments.angle_scale;
+	const size_t count = a_arguments.count;
+	for(size_t i = 0; i < count; i++)
+	{
+		double sinLat, cosLat, sinLon, cosLon;
+		math::sin_cos(latitude[i] * scale, sinLat, cosLat);
+		math::sin_cos(longitude[i] * scale, sinLon, cosLon);
+
+		const double n = a / std::sqrt(1.0 - es * sinLat * sinLat);
+		const double horizontal = (n + altitude[i]) * cosLat;
+		x[i] = horizontal * cosLon;
+		y[i] = horizontal * sinLon;
+		z[i] = ((1.0 - es) * n + altitude[i]) * sinLat;
+	}
+}
+
+template <typename TPolicy>
+void xyz2lla_kernel(
+	const double* __restrict x,
+	const double* __restrict y,
+	const double* __restrict z,
+	double* __restrict latitude,
+	double* __restrict longitude,
+	double* __restrict altitude,
+	const batch_arguments& a_arguments)
+{
+	const double a = a_arguments.a;
+	const double b = a_arguments.b;
+	const double scale = 1.0 / a_arguments.angle_scale;
+	const size_t count = a_arguments.count;
+	for(size_t i = 0; i < count; i++)
+	{
+		const double p = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+
+		double lat, alt;
+		TPolicy::solve(a, b, p, z[i], lat, alt);
+		latitude[i] = lat * scale;
+		longitude[i] = math::atan2(y[i], x[i]) * scale;
+		altitude[i] = alt;
+	}
+}
+
+void lla2xyz_kernel(const batch_arguments& a_arguments)
+{
+	lla2xyz_kernel(
+		a_arguments.input[0], a_arguments.input[1], a_arguments.input[2],
+		a_arguments.output[0], a_arguments.output[1], a_arguments.output[2],
+		a_arguments);
+}
+
+template <typename TPolicy>
+void xyz2lla_kernel(const batch_arguments& a_arguments)
+{
+	xyz2lla_kernel<TPolicy>(
+		a_arguments.input[0], a_arguments.input[1], a_arguments.input[2],
+		a_arguments.output[0], a_arguments.output[1], a_arguments.output[2],
+		a_arguments);
+}
+
+void xyz2lla_kernel(const batch_arguments& a_arguments)
+{
+	switch(a_arguments.method)
+	{
+	case xyz2lla_method::bowring1: xyz2lla_kernel<geodetic_policy::bowring<1>>(a_arguments); return;
+	case xyz2lla_method::bowring2: xyz2lla_kernel<geodetic_policy::bowring<2>>(a_arguments); return;
+	case xyz2lla_method::heikkinen: xyz2lla_kernel<geodetic_policy::heikkinen>(a_arguments); return;
+	case xyz2lla_method::vermeille: xyz2lla_kernel<geodetic_policy::vermeille>(a_arguments); return;
+	}
+}
+
+} // anonymous
+} // geodecy::internal
+
+#endif  // GEODECY_BATCH_KERNELS
@@ -0,0 +1,327 @@
+#ifndef GEODECY_GEODESIC_KERNELS
+#define GEODECY_GEODESIC_KERNELS
+
+#include <cmath>
+#include <limits>
+
+#include "geodesic.hpp"
+#include "trig.hpp"
+
+// Branch free geodesic kernels, see batch_kernels.hpp for the rules of the
+// anonymous namespace. The inverse kernel runs a fixed number of Newton steps
+// from the starting point of geodesic_inverse_start without the astroid.
+// Lines it can not solve to full precision, meridians, equatorial and nearly
+// antipodal lines, get a NaN distance and are solved again one at a time by
+// geodesic_inverse_batch
+
+namespace geodecy::internal
+{
+namespace
+{
+
+/// Lines with points closer than this in sin(lon12) or to the equator and the
+/// poles in sin(bet) and cos(bet) take the scalar path
+constexpr const double c_geodesicSpecial = 1.0e-8;
+
+/// Converged longitude difference, a few times the scalar tolerance
+constexpr const double c_geodesicConverged = 16.0 * c_geodesicTol0;
+
+/// Rounds to the nearest integer in the default rounding mode for |x| < 2^51
+GEODECY_INLINE double round_nearest(double a_value)
+{
+	return (a_value + math::internal::c_roundShift) - math::internal::c_roundShift;
+}
+
+GEODECY_INLINE void newton_step(
+	const geodesic_constants& a_constants,
+	double a_sbet1, double a_cbet1, double a_dn1,
+	double a_sbet2, double a_cbet2, double a_dn2,
+	double a_slam12, double a_clam12,
+	double& r_salp1, double& r_calp1)
+{
+	double salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps, dv;
+	const double v = geodesic_lambda12(a_constants,
+		a_sbet1, a_cbet1, a_dn1, a_sbet2, a_cbet2, a_dn2,
+		r_salp1, r_calp1, a_slam12, a_clam12,
+		salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps,
+		true, dv);
+
+	// Steps leaving (0, pi) are skipped and the line takes the scalar path
+	// unless it converges anyway
+	const double dalp1 = -v / dv;
+	double sdalp1, cdalp1;
+	math::sin_cos(dalp1, sdalp1, cdalp1);
+	double nsalp1 = r_salp1 * cdalp1 + r_calp1 * sdalp1;
+	double ncalp1 = r_calp1 * cdalp1 - r_salp1 * sdalp1;
+	const bool valid = (dv > 0.0) & (math::internal::abs(dalp1) < math::internal::c_pi) & (nsalp1 > 0.0);
+	norm2(nsalp1, ncalp1);
+	r_salp1 = valid ? nsalp1 : r_salp1;
+	r_calp1 = valid ? ncalp1 : r_calp1;
+}
+
+template <bool Azimuths>
+void geodesic_inverse_kernel(
+	const double* __restrict latitude,
+	const double* __restrict longitude,
+	double* __restrict distance,
+	double* __restrict azimuth1,
+	double* __restrict azimuth2,
+	const geodesic_arguments& a_arguments)
+{
+	using math::internal::abs;
+	using math::internal::sign_bit;
+
+	const geodesic_constants constants = *a_arguments.constants;
+	const double f1 = constants.f1;
+	const double ep2 = constants.ep2;
+	const double n = constants.n;
+	const double scale = a_arguments.angle_scale;
+	const double lat1 = a_arguments.latitude * scale;
+	const double lon1 = a_arguments.longitude * scale;
+	const size_t count = a_arguments.count;
+	for(size_t i = 0; i < count; i++)
+	{
+		// Longitude difference in [0, 180]
+		double lon12 = longitude[i] * scale - lon1;
+		lon12 -= 360.0 * round_nearest(lon12 * (1.0 / 360.0));
+		const double lonsign0 = sign_bit(lon12) ? -1.0 : 1.0;
+		lon12 = abs(lon12);
+		const double lam12 = lon12 * c_degree;
+		double slam12, clam12;
+		math::sin_cos(lam12, slam12, clam12);
+
+		// Point 1 has the larger absolute latitude and lies south of the equator
+		const double lat2 = latitude[i] * scale;
+		const bool swap = abs(lat1) < abs(lat2);
+		const double lonsign = swap ? -lonsign0 : lonsign0;
+		const double latsign = sign_bit(swap ? lat2 : lat1) ? 1.0 : -1.0;
+		const double la1 = (swap ? lat2 : lat1) * latsign;
+		const double la2 = (swap ? lat1 : lat2) * latsign;
+
+		double sbet1, cbet1, sbet2, cbet2;
+		math::sin_cos(la1 * c_degree, sbet1, cbet1);
+		math::sin_cos(la2 * c_degree, sbet2, cbet2);
+		sbet1 *= f1;
+		sbet2 *= f1;
+		norm2(sbet1, cbet1);
+		norm2(sbet2, cbet2);
+
+		// Unlike sincosd math::sin_cos has no exact zero cosine at the poles, so
+		// cos(bet) needs no clamp and the poles take the scalar path anyway
+
+		const bool south = cbet1 < -sbet1;
+		sbet2 = south ? (cbet2 == cbet1 ? math::internal::copysign(sbet1, sbet2) : sbet2) : sbet2;
+		cbet2 = south ? cbet2 : (abs(sbet2) == -sbet1 ? cbet1 : cbet2);
+
+		const double dn1 = std::sqrt(1.0 + ep2 * sbet1 * sbet1);
+		const double dn2 = std::sqrt(1.0 + ep2 * sbet2 * sbet2);
+
+		// Starting point, geodesic_inverse_start without the astroid
+		const double sbet12 = sbet2 * cbet1 - cbet2 * sbet1;
+		const double cbet12 = cbet2 * cbet1 + sbet2 * sbet1;
+		const double sbet12a = sbet2 * cbet1 + cbet2 * sbet1;
+		const bool shortline = (cbet12 >= 0.0) & (sbet12 < 0.5) & (cbet2 * lam12 < 0.5);
+
+		double sbetm2 = (sbet1 + sbet2) * (sbet1 + sbet2);
+		sbetm2 /= sbetm2 + (cbet1 + cbet2) * (cbet1 + cbet2);
+		const double dnm = std::sqrt(1.0 + ep2 * sbetm2);
+		double somg12, comg12;
+		math::sin_cos(lam12 / (f1 * dnm), somg12, comg12);
+		somg12 = shortline ? somg12 : slam12;
+		comg12 = shortline ? comg12 : clam12;
+
+		const double somg12s = somg12 * somg12;
+		double salp1 = cbet2 * somg12;
+		double calp1 = comg12 >= 0.0
+			? sbet12 + cbet2 * sbet1 * somg12s / (1.0 + comg12)
+			: sbet12a - cbet2 * sbet1 * somg12s / (1.0 - comg12);
+		const double ssig12 = std::sqrt(salp1 * salp1 + calp1 * calp1);
+		const double csig12 = sbet1 * sbet2 + cbet1 * cbet2 * comg12;
+
+		// Bitwise operators, short circuits become branches the vectorizer rejects
+		const bool antipodal = !((abs(n) > 0.1) | (csig12 >= 0.0) | (ssig12 >= 6.0 * abs(n) * math::internal::c_pi * cbet1 * cbet1));
+		const bool special = (slam12 < c_geodesicSpecial)
+			| (sbet1 > -c_geodesicSpecial)
+			| (cbet1 < c_geodesicSpecial)
+			| (shortline & (ssig12 < constants.etol2))
+			| antipodal;
+
+		// sin(alp1) > 0 on every line that is not special, the sanity check of
+		// geodesic_inverse_start is not needed
+		salp1 /= ssig12;
+		calp1 /= ssig12;
+
+		newton_step(constants, sbet1, cbet1, dn1, sbet2, cbet2, dn2, slam12, clam12, salp1, calp1);
+		newton_step(constants, sbet1, cbet1, dn1, sbet2, cbet2, dn2, slam12, clam12, salp1, calp1);
+		newton_step(constants, sbet1, cbet1, dn1, sbet2, cbet2, dn2, slam12, clam12, salp1, calp1);
+		newton_step(constants, sbet1, cbet1, dn1, sbet2, cbet2, dn2, slam12, clam12, salp1, calp1);
+
+		double salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps, unused;
+		const double v = geodesic_lambda12(constants,
+			sbet1, cbet1, dn1, sbet2, cbet2, dn2,
+			salp1, calp1, slam12, clam12,
+			salp2, calp2, sig12, ssig1, csig1, ssig2, csig2, eps,
+			false, unused);
+
+		double s12b;
+		geodesic_lengths(eps, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, &s12b, nullptr);
+		const bool solved = !special & (abs(v) < c_geodesicConverged);
+		distance[i] = solved ? s12b * constants.b : std::numeric_limits<double>::quiet_NaN();
+
+		if constexpr(Azimuths)
+		{
+			// Undo the swap and the sign changes
+			const double swapp = swap ? -1.0 : 1.0;
+			const double s1 = (swap ? salp2 : salp1) * (swapp * lonsign);
+			const double c1 = (swap ? calp2 : calp1) * (swapp * latsign);
+			const double s2 = (swap ? salp1 : salp2) * (swapp * lonsign);
+			const double c2 = (swap ? calp1 : calp2) * (swapp * latsign);
+			azimuth1[i] = math::atan2(s1, c1) / (c_degree * scale);
+			azimuth2[i] = math::atan2(s2, c2) / (c_degree * scale);
+		}
+	}
+}
+
+template <bool Newton>
+void geodesic_direct_kernel(
+	const double* __restrict azimuth1,
+	const double* __restrict distance,
+	double* __restrict latitude,
+	double* __restrict longitude,
+	double* __restrict azimuth2,
+	const geodesic_arguments& a_arguments)
+{
+	using math::internal::abs;
+
+	const geodesic_constants constants = *a_arguments.constants;
+	const double f = constants.f;
+	const double f1 = constants.f1;
+	const double b = constants.b;
+	const double ep2 = constants.ep2;
+	const double scale = a_arguments.angle_scale;
+	const double lon1 = a_arguments.longitude * scale;
+
+	// The start point is shared by every line
+	double sbet1, cbet1;
+	math::sin_cos(a_arguments.latitude * scale * c_degree, sbet1, cbet1);
+	sbet1 *= f1;
+	norm2(sbet1, cbet1);
+	cbet1 = cbet1 > c_geodesicTiny ? cbet1 : c_geodesicTiny;
+
+	const size_t count = a_arguments.count;
+	for(size_t i = 0; i < count; i++)
+	{
+		double salp1, calp1;
+		math::sin_cos(azimuth1[i] * scale * c_degree, salp1, calp1);
+
+		// sin(alp1) * cos(bet1) = sin(alp0)
+		const double salp0 = salp1 * cbet1;
+		const double calp0 = std::sqrt(calp1 * calp1 + (salp1 * sbet1) * (salp1 * sbet1));
+
+		// tan(bet1) = tan(sig1) * cos(alp1), tan(omg1) = sin(alp0) * tan(sig1)
+		double ssig1 = sbet1;
+		const double somg1 = salp0 * sbet1;
+		double csig1 = (sbet1 != 0.0 || calp1 != 0.0) ? cbet1 * calp1 : 1.0;
+		const double comg1 = csig1;
+		norm2(ssig1, csig1);
+
+		const double k2 = calp0 * calp0 * ep2;
+		const double eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+
+		double c1[7], c1p[7], c3[7];
+		const double A1m1 = A1m1f(eps);
+		C1f(eps, c1);
+		C1pf(eps, c1p);
+		C3f(constants, eps, c3);
+		const double A3c = -f * salp0 * A3f(constants, eps);
+		const double B11 = sin_series(ssig1, csig1, c1);
+		const double B31 = sin_series(ssig1, csig1, c3);
+
+		// tau1 = sig1 + B11, tau2 = tau1 + tau12
+		double sB11, cB11;
+		math::sin_cos(B11, sB11, cB11);
+		const double stau1 = ssig1 * cB11 + csig1 * sB11;
+		const double ctau1 = csig1 * cB11 - ssig1 * sB11;
+
+		const double tau12 = distance[i] / (b * (1.0 + A1m1));
+		double s, c;
+		math::sin_cos(tau12, s, c);
+		const double B12 = -sin_series(stau1 * c + ctau1 * s, ctau1 * c - stau1 * s, c1p);
+		double sig12 = tau12 - (B12 - B11);
+		double ssig12, csig12;
+		math::sin_cos(sig12, ssig12, csig12);
+		if constexpr(Newton)
+		{
+			const double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+			const double csig2 = csig1 * csig12 - ssig1 * ssig12;
+			const double serr = (1.0 + A1m1) * (sig12 + (sin_series(ssig2, csig2, c1) - B11)) - distance[i] / b;
+			sig12 = sig12 - serr / std::sqrt(1.0 + k2 * ssig2 * ssig2);
+			math::sin_cos(sig12, ssig12, csig12);
+		}
+
+		// sig2 = sig1 + sig12, sin(bet2) = cos(alp0) * sin(sig2)
+		const double ssig2 = ssig1 * csig12 + csig1 * ssig12;
+		double csig2 = csig1 * csig12 - ssig1 * ssig12;
+		const double sbet2 = calp0 * ssig2;
+		double cbet2 = std::sqrt(salp0 * salp0 + (calp0 * csig2) * (calp0 * csig2));
+		csig2 = cbet2 == 0.0 ? c_geodesicTiny : csig2;
+		cbet2 = cbet2 == 0.0 ? c_geodesicTiny : cbet2;
+
+		// tan(alp0) = cos(sig2) * tan(alp2), tan(omg2) = sin(alp0) * tan(sig2)
+		const double salp2 = salp0;
+		const double calp2 = calp0 * csig2;
+		const double somg2 = salp0 * ssig2;
+		const double comg2 = csig2;
+		const double omg12 = math::atan2(somg2 * comg1 - comg2 * somg1, comg2 * comg1 + somg2 * somg1);
+		const double lam12 = omg12 + A3c * (sig12 + (sin_series(ssig2, csig2, c3) - B31));
+
+		double lon2 = lon1 + lam12 / c_degree;
+		lon2 -= 360.0 * round_nearest(lon2 * (1.0 / 360.0));
+
+		latitude[i] = math::atan2(sbet2, f1 * cbet2) / (c_degree * scale);
+		longitude[i] = lon2 / scale;
+		azimuth2[i] = math::atan2(salp2, calp2) / (c_degree * scale);
+	}
+}
+
+void geodesic_inverse_kernel(const geodesic_arguments& a_arguments)
+{
+	if(a_arguments.output[1] && a_arguments.output[2])
+	{
+		geodesic_inverse_kernel<true>(
+			a_arguments.input[0], a_arguments.input[1],
+			a_arguments.output[0], a_arguments.output[1], a_arguments.output[2],
+			a_arguments);
+	}
+	else
+	{
+		geodesic_inverse_kernel<false>(
+			a_arguments.input[0], a_arguments.input[1],
+			a_arguments.output[0], nullptr, nullptr,
+			a_arguments);
+	}
+}
+
+void geodesic_direct_kernel(const geodesic_arguments& a_arguments)
+{
+	// The reverted distance series needs one Newton step above a flattening of 1/100
+	if(math::internal::abs(a_arguments.constants->f) > 0.01)
+	{
+		geodesic_direct_kernel<true>(
+			a_arguments.input[0], a_arguments.input[1],
+			a_arguments.output[0], a_arguments.output[1], a_arguments.output[2],
+			a_arguments);
+	}
+	else
+	{
+		geodesic_direct_kernel<false>(
+			a_arguments.input[0], a_arguments.input[1],
+			a_arguments.output[0], a_arguments.output[1], a_arguments.output[2],
+			a_arguments);
+	}
+}
+
+} // anonymous
+} // geodecy::internal
+
+#endif  // GEODECY_GEODESIC_KERNELS
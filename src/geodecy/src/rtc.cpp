@@ -0,0 +1,111 @@
+#include "rtc.hpp"
+
+#include <algorithm>
+
+namespace geodecy
+{
+
+/// The largest relative rounding error of a float, 2^-24
+constexpr const double c_floatRoundingError = 1.0 / 16777216.0;
+
+void rtc_bounds::add(
+	std::span<const double> a_x,
+	std::span<const double> a_y,
+	std::span<const double> a_z)
+{
+	const std::span<const double> axes[3] = {a_x, a_y, a_z};
+	const size_t count = std::min({a_x.size(), a_y.size(), a_z.size()});
+	for(int axis = 0; axis < 3; axis++)
+	{
+		const double* values = axes[axis].data();
+		double low = minimum[axis];
+		double high = maximum[axis];
+		for(size_t i = 0; i < count; i++)
+		{
+			low = values[i] < low ? values[i] : low;
+			high = values[i] > high ? values[i] : high;
+		}
+		minimum[axis] = low;
+		maximum[axis] = high;
+	}
+}
+
+rtc_anchor rtc_bounds::anchor() const
+{
+	if(minimum[0] > maximum[0])
+	{
+		return {0.0, 0.0, 0.0, 0.0};
+	}
+
+	// Offsets from the center are at most half the extent of the box
+	double extent = 0.0;
+	for(int axis = 0; axis < 3; axis++)
+	{
+		extent = std::max(extent, 0.5 * (maximum[axis] - minimum[axis]));
+	}
+
+	return {
+		0.5 * (minimum[0] + maximum[0]),
+		0.5 * (minimum[1] + maximum[1]),
+		0.5 * (minimum[2] + maximum[2]),
+		extent * c_floatRoundingError};
+}
+
+void xyz2rtc(
+	const rtc_anchor& a_anchor,
+	std::span<const double> a_x,
+	std::span<const double> a_y,
+	std::span<const double> a_z,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z)
+{
+	const size_t count = std::min({a_x.size(), a_y.size(), a_z.size(), r_x.size(), r_y.size(), r_z.size()});
+	const double* __restrict x = a_x.data();
+	const double* __restrict y = a_y.data();
+	const double* __restrict z = a_z.data();
+	float* __restrict outX = r_x.data();
+	float* __restrict outY = r_y.data();
+	float* __restrict outZ = r_z.data();
+	for(size_t i = 0; i < count; i++)
+	{
+		outX[i] = static_cast<float>(x[i] - a_anchor.x);
+		outY[i] = static_cast<float>(y[i] - a_anchor.y);
+		outZ[i] = static_cast<float>(z[i] - a_anchor.z);
+	}
+}
+
+rtc_anchor xyz2rtc(
+	std::span<const double> a_x,
+	std::span<const double> a_y,
+	std::span<const double> a_z,
+	std::span<float> r_x,
+	std::span<float> r_y,
+	std::span<float> r_z)
+{
+	rtc_bounds bounds;
+	bounds.add(a_x, a_y, a_z);
+	const rtc_anchor anchor = bounds.anchor();
+	xyz2rtc(anchor, a_x, a_y, a_z, r_x, r_y, r_z);
+	return anchor;
+}
+
+void rtc2xyz(
+	const rtc_anchor& a_anchor,
+	std::span<const float> a_x,
+	std::span<const float> a_y,
+	std::span<const float> a_z,
+	std::span<double> r_x,
+	std::span<double> r_y,
+	std::span<double> r_z)
+{
+	const size_t count = std::min({a_x.size(), a_y.size(), a_z.size(), r_x.size(), r_y.size(), r_z.size()});
+	for(size_t i = 0; i < count; i++)
+	{
+		r_x[i] = a_anchor.x + a_x[i];
+		r_y[i] = a_anchor.y + a_y[i];
+		r_z[i] = a_anchor.z + a_z[i];
+	}
+}
+
+} // geodecy
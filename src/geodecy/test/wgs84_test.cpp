@@ -4,7 +4,10 @@
 
 #include <glm/gtx/string_cast.hpp>
 
+#include <cmath>
 #include <random>
+#include <type_traits>
+#include <vector>
 
 #include "wgs84.hpp"
 
@@ -195,6 +198,401 @@ TEST(wgs84_test, ecef2lla)
 	}
 }
 
+TEST(wgs84_test, batch_matches_scalar)
+{
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+	std::uniform_real_distribution<double> altitude(-1'000'000.0, 36'000'000.0);
+
+	// An odd count leaves a remainder after every vector width
+	const size_t count = 1001;
+	std::vector<double> lat(count), lon(count), alt(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		lat[i] = latitude(random);
+		lon[i] = longitude(random);
+		alt[i] = altitude(random);
+	}
+
+	lat[0] = 90.0;
+	lat[1] = -90.0;
+	lon[2] = 180.0;
+	lon[3] = -180.0;
+	alt[4] = 0.0;
+
+	const geodecy::simd_level supported = geodecy::supported_simd_level();
+	for(int level = 0; level <= static_cast<int>(supported); level++)
+	{
+		ASSERT_TRUE(geodecy::set_batch_simd_level(static_cast<geodecy::simd_level>(level)));
+
+		std::vector<double> x(count), y(count), z(count);
+		wgs84::deg::lla2xyz(lat, lon, alt, x, y, z);
+
+		std::vector<double> outLat(count), outLon(count), outAlt(count);
+		wgs84::deg::xyz2lla(x, y, z, outLat, outLon, outAlt);
+		for(size_t i = 0; i < count; i++)
+		{
+			const auto xyz = wgs84::deg::lla2xyz(lat[i], lon[i], alt[i]);
+			EXPECT_NEAR(x[i], xyz.x, 1e-6) << "level " << level << " point " << i;
+			EXPECT_NEAR(y[i], xyz.y, 1e-6) << "level " << level << " point " << i;
+			EXPECT_NEAR(z[i], xyz.z, 1e-6) << "level " << level << " point " << i;
+
+			// The longitude of the poles is undefined and -180 is the same as 180
+			EXPECT_NEAR(outLat[i], lat[i], 1e-12) << "level " << level << " point " << i;
+			if(std::abs(lat[i]) < 90.0)
+			{
+				EXPECT_NEAR(std::remainder(outLon[i] - lon[i], 360.0), 0.0, 1e-12) << "level " << level << " point " << i;
+			}
+			EXPECT_NEAR(outAlt[i], alt[i], 1e-6) << "level " << level << " point " << i;
+		}
+
+		// Radians take the same path without the scaling
+		std::vector<double> radLat(count), radLon(count), radAlt(count);
+		wgs84::rad::xyz2lla(x, y, z, radLat, radLon, radAlt);
+		EXPECT_NEAR(radLat[7], outLat[7] * c_deg2rad, 1e-14);
+		EXPECT_NEAR(radLon[7], outLon[7] * c_deg2rad, 1e-14);
+	}
+
+	EXPECT_FALSE(geodecy::set_batch_simd_level(static_cast<geodecy::simd_level>(static_cast<int>(supported) + 1)));
+	geodecy::set_batch_simd_level(supported);
+}
+
+template <typename TPolicy>
+static void expect_policy_round_trip(double a_latitudeTolerance, double a_altitudeTolerance)
+{
+	using policy_spheroid = spheroid<wgs84_glm_allocator, wgs84::c_A, wgs84::c_B, TPolicy>;
+
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+	std::uniform_real_distribution<double> altitude(-1'000'000.0, 36'000'000.0);
+
+	const size_t count = 1001;
+	std::vector<double> lat(count), lon(count), alt(count), x(count), y(count), z(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		lat[i] = latitude(random);
+		lon[i] = longitude(random);
+		alt[i] = altitude(random);
+	}
+
+	lat[0] = 90.0;
+	lat[1] = -90.0;
+	lat[2] = 0.0;
+	alt[3] = 0.0;
+	policy_spheroid::deg::lla2xyz(lat, lon, alt, x, y, z);
+
+	std::vector<double> outLat(count), outLon(count), outAlt(count);
+	policy_spheroid::deg::xyz2lla(x, y, z, outLat, outLon, outAlt);
+	for(size_t i = 0; i < count; i++)
+	{
+		const auto lla = policy_spheroid::deg::xyz2lla(x[i], y[i], z[i]);
+		EXPECT_NEAR(lla.x, lat[i], a_latitudeTolerance) << "point " << i;
+		EXPECT_NEAR(lla.z, alt[i], a_altitudeTolerance) << "point " << i;
+		EXPECT_NEAR(outLat[i], lat[i], a_latitudeTolerance) << "point " << i;
+		EXPECT_NEAR(outAlt[i], alt[i], a_altitudeTolerance) << "point " << i;
+	}
+}
+
+TEST(wgs84_test, geodetic_policies)
+{
+	// The iterative altitude loses millimeters to cancellation and a single
+	// Bowring step is only exact close to the surface
+	expect_policy_round_trip<geodetic_policy::iterative>(1e-12, 1e-2);
+	expect_policy_round_trip<geodetic_policy::bowring<1>>(1e-6, 1e-6);
+	expect_policy_round_trip<geodetic_policy::bowring<2>>(1e-12, 1e-6);
+	expect_policy_round_trip<geodetic_policy::heikkinen>(1e-12, 1e-6);
+	expect_policy_round_trip<geodetic_policy::vermeille>(1e-12, 1e-6);
+}
+
+TEST(wgs84_test, rtc_offsets)
+{
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(59.0, 60.0);
+	std::uniform_real_distribution<double> longitude(17.5, 18.5);
+	std::uniform_real_distribution<double> altitude(0.0, 12'000.0);
+
+	// A tile of about 110 by 60 km, more points than one chunk
+	const size_t count = 1001;
+	std::vector<double> lat(count), lon(count), alt(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		lat[i] = latitude(random);
+		lon[i] = longitude(random);
+		alt[i] = altitude(random);
+	}
+
+	std::vector<float> offsetX(count), offsetY(count), offsetZ(count);
+	const rtc_anchor anchor = wgs84::deg::lla2rtc(lat, lon, alt, offsetX, offsetY, offsetZ);
+	EXPECT_GT(anchor.max_error_meter, 0.0);
+	EXPECT_LT(anchor.max_error_meter, 0.01);
+
+	std::vector<double> x(count), y(count), z(count);
+	rtc2xyz(anchor, offsetX, offsetY, offsetZ, x, y, z);
+	for(size_t i = 0; i < count; i++)
+	{
+		const auto xyz = wgs84::deg::lla2xyz(lat[i], lon[i], alt[i]);
+		EXPECT_NEAR(x[i], xyz.x, anchor.max_error_meter) << "point " << i;
+		EXPECT_NEAR(y[i], xyz.y, anchor.max_error_meter) << "point " << i;
+		EXPECT_NEAR(z[i], xyz.z, anchor.max_error_meter) << "point " << i;
+	}
+
+	// Radians give the same anchor
+	std::vector<double> radLat(count), radLon(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		radLat[i] = lat[i] * c_deg2rad;
+		radLon[i] = lon[i] * c_deg2rad;
+	}
+	const rtc_anchor radAnchor = wgs84::rad::lla2rtc(radLat, radLon, alt, offsetX, offsetY, offsetZ);
+	EXPECT_NEAR(radAnchor.x, anchor.x, 1e-6);
+	EXPECT_NEAR(radAnchor.y, anchor.y, 1e-6);
+	EXPECT_NEAR(radAnchor.z, anchor.z, 1e-6);
+
+	const rtc_anchor empty = xyz2rtc({}, {}, {}, {}, {}, {});
+	EXPECT_EQ(empty.max_error_meter, 0.0);
+}
+
+TEST(wgs84_test, geodetic_state)
+{
+	// Stored by value in ecs storages
+	static_assert(std::is_trivially_copyable_v<wgs84_geodetic_state>);
+
+	wgs84_geodetic_state state{wgs84::deg::lla2xyz(59.6519, 17.9186, 42.0)};
+	const glm::dvec3 lla = wgs84::deg::xyz2lla(state.position());
+	EXPECT_EQ(state.lla(), lla);
+	EXPECT_EQ(state.nwu(), wgs84::deg::lla2nwu(lla.x, lla.y));
+	EXPECT_EQ(state.nwu_quaternion(), glm::quat_cast(wgs84::deg::lla2nwu(lla.x, lla.y)));
+	EXPECT_NEAR(state.prime_vertical_radius(), 6'394'095.604, 1e-3);
+
+	// Writing the position drops every cached value
+	const glm::dvec3 moved = wgs84::deg::lla2xyz(-33.9461, 151.1772, 6.0);
+	state.set_position(moved);
+	EXPECT_NEAR(state.latitude(), -33.9461, 1e-12);
+	EXPECT_NEAR(state.longitude(), 151.1772, 1e-12);
+	EXPECT_NEAR(state.altitude(), 6.0, 1e-6);
+	EXPECT_EQ(state.nwu(), wgs84::deg::lla2nwu(state.latitude(), state.longitude()));
+	EXPECT_EQ(state.nwu_quaternion(), glm::quat_cast(state.nwu()));
+
+	// A known lla is kept as given
+	state.set_lla(10.0, 20.0, 30.0);
+	EXPECT_EQ(state.lla(), glm::dvec3(10.0, 20.0, 30.0));
+	EXPECT_EQ(state.position(), wgs84::deg::lla2xyz(10.0, 20.0, 30.0));
+	EXPECT_EQ(state.nwu(), wgs84::deg::lla2nwu(10.0, 20.0));
+
+	// The batched update only converts the states that moved
+	std::vector<wgs84_geodetic_state> states(300);
+	for(size_t i = 0; i < states.size(); i++)
+	{
+		states[i].set_position(wgs84::deg::lla2xyz(static_cast<double>(i) * 0.5 - 75.0, static_cast<double>(i), 1000.0));
+	}
+	states[7].set_lla(1.0, 2.0, 3.0);
+	wgs84_geodetic_state::update(states);
+	for(size_t i = 0; i < states.size(); i++)
+	{
+		if(i == 7)
+		{
+			EXPECT_EQ(states[i].lla(), glm::dvec3(1.0, 2.0, 3.0));
+			continue;
+		}
+
+		const glm::dvec3 expected = wgs84::deg::xyz2lla(states[i].position());
+		EXPECT_NEAR(states[i].latitude(), expected.x, 1e-12) << "state " << i;
+		EXPECT_NEAR(states[i].longitude(), expected.y, 1e-12) << "state " << i;
+		EXPECT_NEAR(states[i].altitude(), expected.z, 1e-6) << "state " << i;
+	}
+}
+
+TEST(wgs84_test, geodesics)
+{
+	// Reference values from GeographicLib
+	const auto jfkLhr = wgs84_geodesic::deg::inverse(40.6, -73.8, 51.6, -0.5);
+	EXPECT_NEAR(jfkLhr.x, 5551759.400, 1e-3);
+	EXPECT_NEAR(jfkLhr.y, 51.198882845, 1e-9);
+	EXPECT_NEAR(jfkLhr.z, 107.821776735, 1e-9);
+
+	const auto antipodal = wgs84_geodesic::deg::inverse(-30.0, 0.0, 29.9, 179.8);
+	EXPECT_NEAR(antipodal.x, 19989832.828, 1e-3);
+	EXPECT_NEAR(antipodal.y, 161.890524736, 1e-9);
+	EXPECT_NEAR(antipodal.z, 18.090737246, 1e-9);
+
+	const auto meridian = wgs84_geodesic::deg::inverse(0.0, 0.0, 90.0, 0.0);
+	EXPECT_NEAR(meridian.x, 10001965.729, 1e-3);
+
+	const auto lhr = wgs84_geodesic::deg::direct(40.6, -73.8, jfkLhr.y, jfkLhr.x);
+	EXPECT_NEAR(lhr.x, 51.6, 1e-11);
+	EXPECT_NEAR(lhr.y, -0.5, 1e-11);
+	EXPECT_NEAR(lhr.z, jfkLhr.z, 1e-11);
+
+	const auto radians = wgs84_geodesic::rad::inverse(40.6 * c_deg2rad, -73.8 * c_deg2rad, 51.6 * c_deg2rad, -0.5 * c_deg2rad);
+	EXPECT_NEAR(radians.x, jfkLhr.x, 1e-6);
+	EXPECT_NEAR(radians.y, jfkLhr.y * c_deg2rad, 1e-12);
+
+	std::minstd_rand random{};
+	std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+	std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+	std::uniform_real_distribution<double> distance(0.0, 20'000'000.0);
+
+	// An odd count leaves a remainder after every vector width
+	const size_t count = 1001;
+	std::vector<double> lat(count), lon(count), azi(count), length(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		lat[i] = latitude(random);
+		lon[i] = longitude(random);
+		azi[i] = longitude(random);
+		length[i] = distance(random);
+	}
+
+	// Lines the kernels hand to the scalar solution: the same meridian, the
+	// opposite meridian, the equator, a pole, nearly antipodal and coincident
+	const double lat1 = 0.5;
+	const double lon1 = 10.0;
+	lon[0] = lon1;
+	lon[1] = lon1 + 180.0;
+	lat[2] = lat1;
+	lat[3] = -90.0;
+	lat[4] = -0.4;
+	lon[4] = lon1 - 179.7;
+	lat[5] = lat1;
+	lon[5] = lon1;
+
+	const geodecy::simd_level supported = geodecy::supported_simd_level();
+	for(int level = 0; level <= static_cast<int>(supported); level++)
+	{
+		ASSERT_TRUE(geodecy::set_batch_simd_level(static_cast<geodecy::simd_level>(level)));
+
+		std::vector<double> s12(count), azi1(count), azi2(count);
+		wgs84_geodesic::deg::inverse(lat1, lon1, lat, lon, s12, azi1, azi2);
+		for(size_t i = 0; i < count; i++)
+		{
+			const auto line = wgs84_geodesic::deg::inverse(lat1, lon1, lat[i], lon[i]);
+			EXPECT_NEAR(s12[i], line.x, 1e-7) << "level " << level << " point " << i;
+			EXPECT_NEAR(std::remainder(azi1[i] - line.y, 360.0), 0.0, 1e-9) << "level " << level << " point " << i;
+			EXPECT_NEAR(std::remainder(azi2[i] - line.z, 360.0), 0.0, 1e-9) << "level " << level << " point " << i;
+		}
+
+		// Empty azimuth spans only compute the distances
+		std::vector<double> distancesOnly(count);
+		wgs84_geodesic::deg::inverse(lat1, lon1, lat, lon, distancesOnly, {}, {});
+		for(size_t i = 0; i < count; i++)
+		{
+			EXPECT_NEAR(distancesOnly[i], s12[i], 1e-7) << "level " << level << " point " << i;
+		}
+
+		// Rows of the matrix are the one to many distances
+		std::vector<double> matrix(2 * count);
+		const double rowLat[] = {lat1, lat[7]};
+		const double rowLon[] = {lon1, lon[7]};
+		wgs84_geodesic::deg::distances(rowLat, rowLon, lat, lon, matrix);
+		for(size_t i = 0; i < count; i++)
+		{
+			EXPECT_NEAR(matrix[i], s12[i], 1e-7) << "level " << level << " point " << i;
+			EXPECT_NEAR(matrix[count + i], wgs84_geodesic::deg::inverse(lat[7], lon[7], lat[i], lon[i]).x, 1e-7)
+				<< "level " << level << " point " << i;
+		}
+
+		std::vector<double> lat2(count), lon2(count), outAzi2(count);
+		wgs84_geodesic::deg::direct(lat1, lon1, azi, length, lat2, lon2, outAzi2);
+		for(size_t i = 0; i < count; i++)
+		{
+			const auto end = wgs84_geodesic::deg::direct(lat1, lon1, azi[i], length[i]);
+			EXPECT_NEAR(lat2[i], end.x, 1e-11) << "level " << level << " point " << i;
+			EXPECT_NEAR(std::remainder(lon2[i] - end.y, 360.0), 0.0, 1e-11) << "level " << level << " point " << i;
+			EXPECT_NEAR(std::remainder(outAzi2[i] - end.z, 360.0), 0.0, 1e-11) << "level " << level << " point " << i;
+		}
+	}
+
+	geodecy::set_batch_simd_level(supported);
+}
+
+/// Sites baked into tables at compile time
+constexpr const glm::dvec3 c_sitesLla[] = {
+	{59.6519, 17.9186, 42.0},     // Stockholm Arlanda
+	{51.4779, -0.0015, 46.0},     // Greenwich
+	{-33.9399, 151.1753, 6.0},    // Sydney
+	{90.0, 0.0, 0.0},             // North pole
+};
+
+constexpr const glm::dvec3 c_sitesXyz[] = {
+	wgs84::deg::lla2xyz(c_sitesLla[0]),
+	wgs84::deg::lla2xyz(c_sitesLla[1]),
+	wgs84::deg::lla2xyz(c_sitesLla[2]),
+	wgs84::deg::lla2xyz(c_sitesLla[3]),
+};
+
+constexpr const glm::dvec3 c_sitesBack[] = {
+	wgs84::deg::xyz2lla(c_sitesXyz[0]),
+	wgs84::deg::xyz2lla(c_sitesXyz[1]),
+	wgs84::deg::xyz2lla(c_sitesXyz[2]),
+	wgs84::deg::xyz2lla(c_sitesXyz[3]),
+};
+
+constexpr const glm::dmat3 c_sitesNwu[] = {
+	wgs84::deg::lla2nwu(c_sitesLla[0].x, c_sitesLla[0].y),
+	wgs84::deg::lla2nwu(c_sitesLla[2].x, c_sitesLla[2].y),
+};
+
+constexpr bool near(double a_value, double a_expected, double a_tolerance)
+{
+	return a_value - a_expected <= a_tolerance && a_expected - a_value <= a_tolerance;
+}
+
+/// Meters are compared relative to the radius of the earth
+constexpr const double c_meterTolerance = 1e-9 * wgs84::c_A;
+
+// Expected values computed in long double
+static_assert(near(c_sitesXyz[0].x, 3073948.364861, c_meterTolerance));
+static_assert(near(c_sitesXyz[0].y, 993960.388567, c_meterTolerance));
+static_assert(near(c_sitesXyz[0].z, 5481020.681424, c_meterTolerance));
+static_assert(near(c_sitesXyz[1].x, 3980601.155435, c_meterTolerance));
+static_assert(near(c_sitesXyz[1].y, -104.211895, c_meterTolerance));
+static_assert(near(c_sitesXyz[2].x, -4640685.638461, c_meterTolerance));
+static_assert(near(c_sitesXyz[2].z, -3540921.261224, c_meterTolerance));
+static_assert(near(c_sitesXyz[3].z, wgs84::c_B, c_meterTolerance));
+
+static_assert(near(c_sitesBack[0].x, c_sitesLla[0].x, 1e-9));
+static_assert(near(c_sitesBack[0].y, c_sitesLla[0].y, 1e-9));
+static_assert(near(c_sitesBack[0].z, c_sitesLla[0].z, c_meterTolerance));
+static_assert(near(c_sitesBack[1].y, c_sitesLla[1].y, 1e-9));
+static_assert(near(c_sitesBack[2].x, c_sitesLla[2].x, 1e-9));
+static_assert(near(c_sitesBack[2].y, c_sitesLla[2].y, 1e-9));
+static_assert(near(c_sitesBack[3].x, 90.0, 1e-9));
+static_assert(near(c_sitesBack[3].z, 0.0, c_meterTolerance));
+
+static_assert(near(c_sitesNwu[0][0][0], -0.821112886018, 1e-9));
+static_assert(near(c_sitesNwu[0][0][1], -0.265506633935, 1e-9));
+static_assert(near(c_sitesNwu[0][0][2], 0.505252269418, 1e-9));
+static_assert(near(c_sitesNwu[1][0][0], -0.489146160342, 1e-9));
+static_assert(near(c_sitesNwu[1][0][1], 0.269185042484, 1e-9));
+static_assert(near(c_sitesNwu[1][0][2], 0.829623677775, 1e-9));
+
+TEST(wgs84_test, constexpr_matches_runtime)
+{
+	for(size_t i = 0; i < std::size(c_sitesLla); i++)
+	{
+		const glm::dvec3 xyz = wgs84::deg::lla2xyz(c_sitesLla[i]);
+		EXPECT_NEAR(c_sitesXyz[i].x, xyz.x, c_meterTolerance) << "site " << i;
+		EXPECT_NEAR(c_sitesXyz[i].y, xyz.y, c_meterTolerance) << "site " << i;
+		EXPECT_NEAR(c_sitesXyz[i].z, xyz.z, c_meterTolerance) << "site " << i;
+
+		const glm::dvec3 lla = wgs84::deg::xyz2lla(xyz);
+		EXPECT_NEAR(c_sitesBack[i].x, lla.x, 1e-9) << "site " << i;
+		EXPECT_NEAR(c_sitesBack[i].y, lla.y, 1e-9) << "site " << i;
+		EXPECT_NEAR(c_sitesBack[i].z, lla.z, c_meterTolerance) << "site " << i;
+	}
+
+	const glm::dmat3 nwu = wgs84::deg::lla2nwu(c_sitesLla[2].x, c_sitesLla[2].y);
+	for(int column = 0; column < 3; column++)
+	{
+		for(int row = 0; row < 3; row++)
+		{
+			EXPECT_NEAR(c_sitesNwu[1][column][row], nwu[column][row], 1e-9);
+		}
+	}
+}
+
 /*
 TEST(wgs84_test, ecef2lla_2)
 {
@@ -23,13 +23,30 @@ namespace render::plane
 
 struct Plane
 {
-	glm::dvec3 position{};
+	/// The position and the lla, local tangent plane derived from it. Moving
+	/// the plane with setPosition costs at most one xyz2lla per update
+	wgs84_geodetic_state state{};
 	glm::dquat rotation{glm::identity<glm::dquat>()};
 
-	[[nodiscard]] glm::dmat3 getLocalTangentPlane() const
+	[[nodiscard]] const glm::dvec3& getPosition() const
 	{
-		auto lla = wgs84::deg::xyz2lla(position);
-		return wgs84::deg::lla2nwu(lla.x, lla.y);
+		return state.position();
+	}
+
+	void setPosition(const glm::dvec3& a_position)
+	{
+		state.set_position(a_position);
+	}
+
+	/// Move the plane to a known lla without converting the position back
+	void setLLA(double a_latitude_deg, double a_longitude_deg, double a_altitude_meter)
+	{
+		state.set_lla(a_latitude_deg, a_longitude_deg, a_altitude_meter);
+	}
+
+	[[nodiscard]] const glm::dmat3& getLocalTangentPlane() const
+	{
+		return state.nwu();
 	}
 
 	[[nodiscard]] glm::dvec3 getForwardVector() const
@@ -39,25 +56,22 @@ struct Plane
 
 	[[nodiscard]] double getAltitude() const
 	{
-		auto lla = wgs84::deg::xyz2lla(position);
-		return lla.z;
+		return state.altitude();
 	}
 
 	[[nodiscard]] double getLatitude() const
 	{
-		auto lla = wgs84::deg::xyz2lla(position);
-		return lla.x;
+		return state.latitude();
 	}
 
 	[[nodiscard]] double getLongitude() const
 	{
-		auto lla = wgs84::deg::xyz2lla(position);
-		return lla.y;
+		return state.longitude();
 	}
 
-	[[nodiscard]] glm::dvec3 getLLA() const
+	[[nodiscard]] const glm::dvec3& getLLA() const
 	{
-		return wgs84::deg::xyz2lla(position);
+		return state.lla();
 	}
 
 	/// Get local tangent plane (roll pitch yaw)
@@ -65,8 +79,7 @@ struct Plane
 	{
 		// rotation = nwu * rpy
 		// localRotation = (nwu ^ -1) * nwu * rpy = rpy
-		const auto nwu = getLocalTangentPlane();
-		const auto localRotation = glm::inverse(glm::quat_cast(nwu)) * rotation;
+		const auto localRotation = glm::inverse(state.nwu_quaternion()) * rotation;
 
 		// GLM assumes XYZ we use YZX therefore, we need to move these methods arround
 		double roll = glm::pitch(localRotation);
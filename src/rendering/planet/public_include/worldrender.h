@@ -6,9 +6,12 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <functional>
 
 #include <thread>
 
+#include "stats.hpp"
+
 namespace render
 {
 
@@ -22,9 +25,21 @@ public:
 	bool init();
 
 	void run();
+
+	/// Set the function that updates the simulation, it is called once per
+	/// frame before the frame is rendered
+	void setFrameUpdate(std::function<void()> a_update);
+
+	/// Set the function that provides registry statistics for the overlay,
+	/// it is called once per frame
+	void setRegistryStats(std::function<ecs::registry_stats()> a_provider);
 private:
 	void renderFrame();
 	void renderGui();
+	void renderRegistryStats();
+
+	std::function<void()> m_frameUpdate;
+	std::function<ecs::registry_stats()> m_registryStats;
 
 	double m_targetFps = 60;
 
@@ -161,25 +161,20 @@ void WorldRenderer::renderFrame()
 	{
 		glm::dvec3 forwardVector = testPlane.getForwardVector();
 		glm::dvec3 newPosition =
-			testPlane.position
+			testPlane.getPosition()
 			+ (forwardVector * glm::dvec3(xx * speed_mps));
 
 		// Calculate fly height
 		double flyHeight = testPlane.getAltitude() + (zz * speed_mps / 2.0);
 		flyHeight = std::max(-1'000'000.0, flyHeight);
 
-		// Calculate gravity up and clamp position
-		glm::dvec3 gravityUp;
+		// Calculate gravity up and clamp position, the only xyz2lla of the update
+		const glm::dvec3 gravityUp = testPlane.getLocalTangentPlane() * glm::dvec3(0, 0, 1);
 		{
-			auto nwu = testPlane.getLocalTangentPlane();
 			auto lla = wgs84::deg::xyz2lla(newPosition);
-
-			gravityUp = nwu * glm::dvec3(0, 0, 1);
-			newPosition = wgs84::deg::lla2xyz(lla.x, lla.y, flyHeight);
+			testPlane.setLLA(lla.x, lla.y, flyHeight);
 		}
 
-		testPlane.position = newPosition;
-
 		// Rotate around
 		testPlane.rotation = glm::quat_cast(
 			glm::rotate(glm::dmat4(1.0), glm::radians(yawDir * 2 + 0.0), gravityUp)
@@ -189,9 +184,7 @@ void WorldRenderer::renderFrame()
 
 		// Apply curvature fix
 		{
-			auto n_lla = wgs84::deg::xyz2lla(newPosition);
-			auto n_nwu = wgs84::deg::lla2nwu(n_lla.x, n_lla.y);
-			auto n_up = n_nwu * glm::dvec3(0, 0, 1);
+			auto n_up = testPlane.getLocalTangentPlane() * glm::dvec3(0, 0, 1);
 
 			// Rotation needed to fix rotation
 			glm::dvec3 axis = glm::normalize(glm::cross(gravityUp, n_up));
@@ -210,7 +203,7 @@ void WorldRenderer::renderFrame()
 
 		if(cameraMode == 0) // Top down
 		{
-			auto lla = wgs84::deg::xyz2lla(testPlane.position);
+			const auto& lla = testPlane.getLLA();
 			renderCamera.position = wgs84::deg::lla2xyz(lla.x, lla.y, lla.z + 3'000'000);
 			renderCamera.rotation = testPlane.getLocalTangentPlane()
 				* glm::dmat3(glm::angleAxis(glm::radians(90.0), glm::dvec3(0, 1, 0)));
@@ -218,7 +211,7 @@ void WorldRenderer::renderFrame()
 		else if(cameraMode == 1) // FOV
 		{
 			renderCamera.rotation = testPlane.rotation;
-			renderCamera.position = testPlane.position;
+			renderCamera.position = testPlane.getPosition();
 		}
 	}
 
@@ -233,7 +226,7 @@ void WorldRenderer::renderFrame()
 		glUseProgram(geometry_test_data.programId);
 		glm::dmat4 lodViewMatrixDouble = glm::translate(
 			glm::dmat4(viewMatrix),
-			glm::dvec3(testPlane.position) * glm::dvec3(1.0 / wgs84::c_A, 1.0 / wgs84::c_A, 1.0 / wgs84::c_B));
+			glm::dvec3(testPlane.getPosition()) * glm::dvec3(1.0 / wgs84::c_A, 1.0 / wgs84::c_A, 1.0 / wgs84::c_B));
 		lodViewMatrixDouble = glm::scale(lodViewMatrixDouble, glm::dvec3(0.2));
 
 		lodViewMatrixDouble = lodViewMatrixDouble * glm::dmat4(testPlane.rotation);
@@ -335,9 +328,80 @@ void WorldRenderer::renderGui()
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
 	ImGui::End();
 
+	renderRegistryStats();
+
 	ImGui::ShowDemoWindow();
 }
 
+void WorldRenderer::setFrameUpdate(std::function<void()> a_update)
+{
+	m_frameUpdate = std::move(a_update);
+}
+
+void WorldRenderer::setRegistryStats(std::function<ecs::registry_stats()> a_provider)
+{
+	m_registryStats = std::move(a_provider);
+}
+
+void WorldRenderer::renderRegistryStats()
+{
+	if(!m_registryStats)
+	{
+		return;
+	}
+
+	constexpr double c_MiB = 1024.0 * 1024.0;
+	const ecs::registry_stats stats = m_registryStats();
+
+	ImGui::SetNextWindowPos({0, 250}, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize({640, 220}, ImGuiCond_FirstUseEver);
+	ImGui::Begin("ECS");
+	ImGui::Text("Entities: %zu", stats.entities);
+	ImGui::Text("Reserved: %.2f MiB", stats.bytes_reserved / c_MiB);
+	ImGui::Text("Names:    %zu (%.2f MiB)", stats.names, stats.name_pool_bytes / c_MiB);
+	ImGui::Separator();
+
+	const auto storageRow = [](const ecs::storage_stats& a_stats)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(a_stats.name.data(), a_stats.name.data() + a_stats.name.size());
+		ImGui::TableNextColumn();
+		ImGui::Text("%zu", a_stats.live);
+		ImGui::TableNextColumn();
+		ImGui::Text("%zu", a_stats.sleeping);
+		ImGui::TableNextColumn();
+		ImGui::Text("%zu x %zu", a_stats.pages, a_stats.page_size);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f MiB", a_stats.bytes_reserved / c_MiB);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f %%", a_stats.fragmentation * 100.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f ms", a_stats.last_frame_iteration_ms);
+	};
+
+	if(ImGui::BeginTable("storages", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+	{
+		ImGui::TableSetupColumn("Storage");
+		ImGui::TableSetupColumn("Live");
+		ImGui::TableSetupColumn("Sleeping");
+		ImGui::TableSetupColumn("Pages");
+		ImGui::TableSetupColumn("Reserved");
+		ImGui::TableSetupColumn("Fragmentation");
+		ImGui::TableSetupColumn("Iteration");
+		ImGui::TableHeadersRow();
+
+		storageRow(stats.entity_storage);
+		for(const auto& item : stats.component_storages)
+		{
+			storageRow(item);
+		}
+
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+
 void WorldRenderer::run()
 {
 	std::printf("OpenGL version: %s\n", glGetString(GL_VERSION));
@@ -380,7 +444,7 @@ void WorldRenderer::run()
 	frameData.renderCamera.position = wgs84::deg::lla2xyz(0, 0, 3'000'000);
 	frameData.renderCamera.rotation = glm::quat_cast(wgs84::deg::lla2nwu(90, 0));
 
-	frameData.testPlane.position = wgs84::deg::lla2xyz(0, 0, 1000);
+	frameData.testPlane.setLLA(0, 0, 1000);
 	frameData.testPlane.rotation = glm::quat_cast(wgs84::deg::lla2nwu(0, 0))
 		* glm::angleAxis(glm::radians(-90.0), glm::dvec3(0, 0, 1))
 		* glm::angleAxis(glm::radians(-45.0), glm::dvec3(0, 1, 0));
@@ -388,7 +452,7 @@ void WorldRenderer::run()
 	// {
 	//	 double lat = 27.986065;
 	//	 double lon = 86.922623;
-	//	 frameData.testPlane.position = wgs84::deg::lla2xyz(lat, lon, 1000);
+	//	 frameData.testPlane.setLLA(lat, lon, 1000);
 	//	 frameData.testPlane.rotation = glm::quat_cast(wgs84::deg::lla2nwu(lat, lon));
 	// }
 
@@ -416,6 +480,12 @@ void WorldRenderer::run()
 			nextSecond += seconds(1);
 		}
 
+		// Update simulation
+		if(m_frameUpdate)
+		{
+			m_frameUpdate();
+		}
+
 		// Render frame
 		renderFrame();
 
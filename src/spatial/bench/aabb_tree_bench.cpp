@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "aabb_tree.hpp"
+#include "registry.hpp"
+
+// Measures refitting the tree after every aircraft moved one tick, and ray picking
+// and line of sight queries against 100k aircraft
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+
+	spatial::aabb bounds() const { return spatial::aabb::around(position, 50.0); }
+};
+
+constexpr const size_t c_entityCount = 100'000;
+constexpr const double c_radius = 6'381'000.0;
+constexpr const size_t c_queryCount = 10'000;
+constexpr const int c_ticks = 20;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+using bench_registry = ecs::registry<ecs::component<transform, c_entityCount>>;
+
+static void run(bench_registry& a_registry, const std::vector<transform>& a_initial, double a_margin)
+{
+	using namespace std::chrono;
+	size_t i = 0;
+	a_registry.getComponentsOfType<transform>().each([&](ecs::entity, transform& a_transform) { a_transform = a_initial[i++]; });
+
+	auto start = high_resolution_clock::now();
+	spatial::aabb_tree tree(a_margin);
+	tree.synchronize<transform>(a_registry, &transform::bounds);
+	const double buildTime = elapsed_ms(start);
+
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	std::vector<size_t> targets;
+	std::vector<spatial::ray> rays(c_queryCount);
+	std::vector<spatial::ray> segments;
+	for(size_t q = 0; q < c_queryCount; q++)
+	{
+		// Line of sight from aircraft to points 20 km away
+		targets.push_back(random() % a_initial.size());
+		const glm::dvec3 from = a_initial[random() % a_initial.size()].position;
+		segments.push_back({from, glm::dvec3(normal(random), normal(random), normal(random)) * 20'000.0, 1.0});
+	}
+
+	double moveTime = 0, refitTime = 0, rayTime = 0, batchTime = 0, segmentTime = 0;
+	size_t moved = 0, hits = 0, blocked = 0;
+	std::vector<std::optional<spatial::ray_hit>> results;
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		start = high_resolution_clock::now();
+		a_registry.getComponentsOfType<transform>().each([](ecs::entity, transform& a_transform)
+		{
+			a_transform.position = glm::normalize(a_transform.position + a_transform.velocity) * c_radius;
+		});
+		moveTime += elapsed_ms(start);
+
+		// Picking rays from 500 km above random aircraft
+		for(size_t q = 0; q < c_queryCount; q++)
+		{
+			const glm::dvec3 target = a_registry.getComponentsOfType<transform>().get(targets[q])->position;
+			const glm::dvec3 up = glm::normalize(target);
+			rays[q] = {target + up * 500'000.0, -up, 600'000.0};
+		}
+
+		start = high_resolution_clock::now();
+		moved += tree.synchronize<transform>(a_registry, &transform::bounds);
+		refitTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		hits = 0;
+		for(const spatial::ray& value : rays)
+		{
+			hits += tree.raycast(value).has_value();
+		}
+		rayTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		tree.raycast(rays, results);
+		batchTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		blocked = 0;
+		for(const spatial::ray& value : segments)
+		{
+			blocked += !tree.segment_query(value.origin + value.direction * 0.01, value.origin + value.direction, [](ecs::entity, double) { return false; });
+		}
+		segmentTime += elapsed_ms(start);
+	}
+
+	std::printf("margin %.0f m, height %d, %.1f MB, build %.2f ms\n", a_margin, tree.height(), static_cast<double>(tree.bytes_reserved()) / (1024.0 * 1024.0), buildTime);
+	std::printf("  %-28s: %.4f ms/tick\n", "integrate positions", moveTime / c_ticks);
+	std::printf("  %-28s: %.4f ms/tick (%zu refit)\n", "synchronize", refitTime / c_ticks, moved / c_ticks);
+	std::printf("  %-28s: %.4f ms/tick (%zu hits)\n", "raycasts", rayTime / c_ticks, hits);
+	std::printf("  %-28s: %.4f ms/tick (%zu threads)\n", "batch raycasts", batchTime / c_ticks, ecs::thread_pool::shared().size());
+	std::printf("  %-28s: %.4f ms/tick (%zu blocked)\n", "line of sight", segmentTime / c_ticks, blocked);
+}
+
+int main()
+{
+	auto registry = std::make_unique<bench_registry>();
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	std::vector<transform> initial;
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		// 250 m/s in a random direction tangent to the sphere
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const glm::dvec3 direction = glm::normalize(glm::cross(up, glm::dvec3(normal(random), normal(random), normal(random))));
+		initial.push_back(transform{up * c_radius, direction * 250.0});
+		registry->addComponent<transform>(registry->createEntity(), initial.back());
+	}
+
+	run(*registry, initial, 0.0);
+	run(*registry, initial, 1000.0);
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "lod_scheduler.hpp"
+
+// Integrates 100k and 1M aircraft every tick and through the distance based
+// schedule. The schedule keeps the far update budget fixed so the cost per tick
+// should stay flat when the world grows 10 times
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+};
+
+constexpr const size_t c_maxEntityCount = 1'000'000;
+constexpr const double c_radius = 6'381'000.0;
+constexpr const int c_ticks = 64;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+using bench_registry = ecs::registry<ecs::component<transform, c_maxEntityCount>>;
+
+static void integrate(transform& r_transform, double a_dt)
+{
+	r_transform.position = glm::normalize(r_transform.position + r_transform.velocity * a_dt) * c_radius;
+}
+
+static void run(size_t a_count)
+{
+	using namespace std::chrono;
+	auto registry = std::make_unique<bench_registry>();
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	for(size_t i = 0; i < a_count; i++)
+	{
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const glm::dvec3 direction = glm::normalize(glm::cross(up, glm::dvec3(normal(random), normal(random), normal(random))));
+		registry->addComponent<transform>(registry->createEntity(), transform{up * c_radius, direction * 250.0});
+	}
+
+	const double dt = 1.0 / 60.0;
+	auto start = high_resolution_clock::now();
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		registry->getComponentsOfType<transform>().each([dt](ecs::entity, transform& r_transform) { integrate(r_transform, dt); });
+	}
+
+	const double everyTick = elapsed_ms(start) / c_ticks;
+
+	spatial::lod_scheduler scheduler({{200'000.0, 1}, {1'000'000.0, 4}, {0.0, 16}}, 4'000);
+	scheduler.set_observer(glm::dvec3(c_radius + 10'000.0, 0, 0));
+	start = high_resolution_clock::now();
+	scheduler.synchronize<transform>(*registry, &transform::position);
+	const double synchronizeTime = elapsed_ms(start);
+
+	size_t updates = 0;
+	start = high_resolution_clock::now();
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		updates += scheduler.run<transform>(*registry, &transform::position, dt, [](ecs::entity, transform& r_transform, double a_dt)
+		{
+			integrate(r_transform, a_dt);
+		});
+	}
+
+	const double scheduled = elapsed_ms(start) / c_ticks;
+
+	std::printf("%zu entities\n", a_count);
+	std::printf("  %-28s: %.4f ms/tick\n", "every tick", everyTick);
+	std::printf("  %-28s: %.4f ms/tick (%zu updates/tick, far period %u)\n", "scheduled", scheduled, updates / c_ticks, scheduler.period(2));
+	std::printf("  %-28s: %.4f ms\n", "synchronize", synchronizeTime);
+}
+
+int main()
+{
+	run(100'000);
+	run(1'000'000);
+	return 0;
+}
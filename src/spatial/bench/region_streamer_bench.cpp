@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "region_streamer.hpp"
+
+// Streams 500k aircraft around a camera flying around the globe, once with the
+// blobs kept in memory and once with the blobs written to a temporary directory
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+};
+
+constexpr const size_t c_entityCount = 500'000;
+constexpr const double c_radius = 6'381'000.0;
+constexpr const int c_ticks = 2'000;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+using bench_registry = ecs::registry<ecs::component<transform, c_entityCount>>;
+using bench_streamer = spatial::region_streamer<bench_registry, transform>;
+
+static void run(const char* a_name, const std::filesystem::path& a_directory)
+{
+	auto registry = std::make_unique<bench_registry>();
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const glm::dvec3 direction = glm::normalize(glm::cross(up, glm::dvec3(normal(random), normal(random), normal(random))));
+		registry->addComponent<transform>(registry->createEntity(), transform{up * c_radius, direction * 250.0});
+	}
+
+	// 384 regions about 1000 km wide, the camera is 1000 km above the ground
+	bench_streamer streamer(spatial::face_partition(8), c_radius, 1'500'000.0, 2'500'000.0, a_directory);
+	double updateTime = 0, maxUpdate = 0;
+	size_t maxResident = 0, loaded = 0, unloaded = 0, maxBytes = 0;
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		// One orbit over the ticks
+		const double angle = 6.283185307179586 * tick / c_ticks;
+		const glm::dvec3 camera = glm::dvec3(std::cos(angle), 0.3, std::sin(angle)) * (c_radius + 1'000'000.0) / std::sqrt(1.09);
+
+		registry->getComponentsOfType<transform>().each([](ecs::entity, transform& a_transform)
+		{
+			a_transform.position = glm::normalize(a_transform.position + a_transform.velocity) * c_radius;
+		});
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const auto stats = streamer.update<transform>(*registry, camera, &transform::position);
+		const double time = elapsed_ms(start);
+		if(tick > 0)
+		{
+			updateTime += time;
+			maxUpdate = std::max(maxUpdate, time);
+		}
+		else
+		{
+			// Storing the whole world at startup is not part of the steady state
+			streamer.wait();
+		}
+
+		loaded += stats.loaded;
+		unloaded += stats.unloaded;
+		maxResident = std::max(maxResident, registry->getComponentsOfType<transform>().total_size());
+		maxBytes = std::max(maxBytes, streamer.stored_bytes());
+	}
+
+	streamer.wait();
+	std::printf("%s\n", a_name);
+	std::printf("  %-28s: %.4f ms/tick (max %.4f ms, first tick excluded)\n", "update", updateTime / (c_ticks - 1), maxUpdate);
+	std::printf("  %-28s: %zu loaded, %zu unloaded\n", "streamed", loaded, unloaded);
+	std::printf("  %-28s: %zu of %zu entities\n", "max resident", maxResident, c_entityCount);
+	std::printf("  %-28s: %.2f MB\n", "max blob memory", static_cast<double>(maxBytes) / (1024.0 * 1024.0));
+}
+
+int main()
+{
+	run("in memory", {});
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "region_streamer_bench";
+	run("files", directory);
+	std::filesystem::remove_all(directory);
+	return 0;
+}
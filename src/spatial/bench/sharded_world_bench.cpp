@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "sharded_world.hpp"
+
+// Measures 120k moving aircraft in a world split into 1, 6 and 24 shards. The
+// aircraft move fast so dozens cross a shard boundary every tick
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+};
+
+constexpr const size_t c_entityCount = 120'000;
+constexpr const double c_radius = 6'381'000.0;
+constexpr const int c_ticks = 20;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+using bench_registry = ecs::registry<ecs::component<transform, c_entityCount>>;
+
+static void run(int a_subdivisions, const std::vector<transform>& a_initial)
+{
+	using namespace std::chrono;
+	spatial::sharded_world<bench_registry> world{spatial::face_partition(a_subdivisions)};
+	for(const transform& initial : a_initial)
+	{
+		const auto [entity, local] = world.create(initial.position);
+		world.shard(world.locate(entity)->shard).addComponent<transform>(local, initial);
+	}
+
+	double systemTime = 0, frameTime = 0;
+	size_t migrated = 0;
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		auto start = high_resolution_clock::now();
+		world.each_shard([](bench_registry& a_registry, size_t)
+		{
+			a_registry.getComponentsOfType<transform>().each([](ecs::entity, transform& a_transform)
+			{
+				a_transform.position = glm::normalize(a_transform.position + a_transform.velocity) * c_radius;
+			});
+		});
+		systemTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		migrated += world.end_frame<transform>(&transform::position);
+		frameTime += elapsed_ms(start);
+	}
+
+	std::printf("%zu shards\n", world.shard_count());
+	std::printf("  %-28s: %.4f ms/tick\n", "systems", systemTime / c_ticks);
+	std::printf("  %-28s: %.4f ms/tick (%zu migrations/tick)\n", "end frame", frameTime / c_ticks, migrated / c_ticks);
+}
+
+int main()
+{
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	std::vector<transform> initial;
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		// 2 km per tick in a random direction tangent to the sphere
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const glm::dvec3 direction = glm::normalize(glm::cross(up, glm::dvec3(normal(random), normal(random), normal(random))));
+		initial.push_back(transform{up * c_radius, direction * 2'000.0});
+	}
+
+	std::printf("%zu threads\n", ecs::thread_pool::shared().size());
+	for(int subdivisions : {0, 1, 2})
+	{
+		run(subdivisions, initial);
+	}
+
+	return 0;
+}
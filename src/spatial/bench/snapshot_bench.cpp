@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "registry.hpp"
+#include "snapshot.hpp"
+#include "quantize.hpp"
+
+// Streams snapshots of 1M aircraft through a temporary file into a replica
+// registry. A tenth of the aircraft move every tick, the rest are parked
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dquat rotation;
+};
+
+/// Quantized transform, 20 bytes without padding
+struct packed_transform
+{
+	spatial::quantized_position position;
+	uint32_t rotation[2];
+};
+
+template <>
+struct ecs::snapshot_traits<transform>
+{
+	using packed = packed_transform;
+
+	static packed pack(const transform& a_value)
+	{
+		const uint64_t rotation = spatial::pack_rotation(a_value.rotation);
+		return {spatial::quantize_position(a_value.position), {static_cast<uint32_t>(rotation), static_cast<uint32_t>(rotation >> 32)}};
+	}
+
+	static void unpack(const packed& a_packed, transform& r_value)
+	{
+		r_value.position = spatial::dequantize_position(a_packed.position);
+		r_value.rotation = spatial::unpack_rotation<glm::dquat>(a_packed.rotation[0] | static_cast<uint64_t>(a_packed.rotation[1]) << 32);
+	}
+};
+
+constexpr const size_t c_entityCount = 1'000'000;
+constexpr const double c_radius = 6'381'000.0;
+constexpr const int c_ticks = 30;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+static double megabytes(size_t a_bytes)
+{
+	return static_cast<double>(a_bytes) / (1024.0 * 1024.0);
+}
+
+using bench_registry = ecs::registry<ecs::component<transform, c_entityCount>>;
+
+int main()
+{
+	using namespace std::chrono;
+	auto source = std::make_unique<bench_registry>();
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	std::vector<ecs::entity> moving;
+	for(size_t i = 0; i < c_entityCount; i++)
+	{
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const ecs::entity entity = source->createEntity();
+		source->addComponent<transform>(entity, transform{up * c_radius, glm::dquat(1.0, 0.0, 0.0, 0.0)});
+		if(i % 10 == 0)
+		{
+			moving.push_back(entity);
+		}
+	}
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "snapshot_bench.bin";
+	ecs::snapshot_encoder<bench_registry, transform> encoder;
+	std::vector<std::byte> buffer;
+	std::vector<size_t> sizes;
+	double deltaEncodeTime = 0;
+	{
+		std::ofstream file(path, std::ios::binary);
+		for(int tick = 0; tick < c_ticks; tick++)
+		{
+			// 4 m and a small turn per tick
+			for(const ecs::entity entity : moving)
+			{
+				transform& value = *source->getComponent<transform>(entity);
+				value.position = glm::normalize(value.position + glm::dvec3(4.0, 0.0, 0.0)) * c_radius;
+				const double angle = 0.0005 * (tick + 1);
+				value.rotation = glm::dquat(std::cos(angle), 0.0, 0.0, std::sin(angle));
+			}
+
+			buffer.clear();
+			const auto start = high_resolution_clock::now();
+			encoder.acknowledge(encoder.encode(*source, buffer));
+			deltaEncodeTime += tick > 0 ? elapsed_ms(start) : 0.0;
+
+			file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+			sizes.push_back(buffer.size());
+		}
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	std::vector<char> stream((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::filesystem::remove(path);
+
+	auto replica = std::make_unique<bench_registry>();
+	ecs::snapshot_decoder<bench_registry, transform> decoder;
+	const auto bytes = std::as_bytes(std::span(stream));
+	size_t offset = 0;
+	int decoded = 0;
+	const auto start = high_resolution_clock::now();
+	while(offset < bytes.size())
+	{
+		const ecs::snapshot_result result = decoder.decode(bytes.subspan(offset), *replica);
+		if(result.status != ecs::snapshot_status::applied)
+		{
+			break;
+		}
+
+		offset += result.bytes;
+		decoded++;
+	}
+	const double decodeTime = elapsed_ms(start);
+
+	size_t deltaBytes = 0;
+	for(size_t i = 1; i < sizes.size(); i++)
+	{
+		deltaBytes += sizes[i];
+	}
+
+	const size_t rawBytes = c_entityCount * sizeof(transform);
+	const double deltaSize = static_cast<double>(deltaBytes) / (c_ticks - 1);
+	std::printf("%zu entities, %zu moving, %d snapshots decoded\n", c_entityCount, moving.size(), decoded);
+	std::printf("  %-28s: %.2f MB\n", "raw state", megabytes(rawBytes));
+	std::printf("  %-28s: %.2f MB (ratio %.1f)\n", "full snapshot", megabytes(sizes[0]), static_cast<double>(rawBytes) / static_cast<double>(sizes[0]));
+	std::printf("  %-28s: %.2f MB (ratio %.1f)\n", "delta snapshot", megabytes(static_cast<size_t>(deltaSize)), static_cast<double>(rawBytes) / deltaSize);
+	std::printf("  %-28s: %.4f ms/snapshot (%.0f MB/s of state)\n", "encode delta", deltaEncodeTime / (c_ticks - 1),
+		megabytes(rawBytes) * (c_ticks - 1) / (deltaEncodeTime / 1000.0));
+	std::printf("  %-28s: %.4f ms/snapshot (%.0f MB/s of stream)\n", "decode", decodeTime / decoded,
+		megabytes(bytes.size()) / (decodeTime / 1000.0));
+	std::printf("  %-28s: %zu entities\n", "replica", replica->getComponentsOfType<transform>().size());
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "spatial_hash.hpp"
+
+// Measures one simulation tick of moving aircraft: integrating the positions,
+// updating the spatial index and running "all aircraft within 50 km" queries
+
+struct transform
+{
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+};
+
+constexpr const double c_radius = 6'381'000.0;
+constexpr const double c_queryRadius = 50'000.0;
+constexpr const double c_tickSeconds = 1.0;
+constexpr const size_t c_queryCount = 1000;
+constexpr const int c_ticks = 20;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point a_start)
+{
+	using namespace std::chrono;
+	return static_cast<double>(duration_cast<nanoseconds>(high_resolution_clock::now() - a_start).count()) / 1'000'000.0;
+}
+
+template <size_t Count>
+static void run()
+{
+	using namespace std::chrono;
+	using bench_registry = ecs::registry<ecs::component<transform, Count>>;
+	auto registry = std::make_unique<bench_registry>();
+
+	// Aircraft spread over the sphere flying at 250 m/s in random directions
+	std::minstd_rand random{};
+	std::normal_distribution<double> normal;
+	for(size_t i = 0; i < Count; i++)
+	{
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		const glm::dvec3 direction = glm::normalize(glm::cross(up, glm::dvec3(normal(random), normal(random), normal(random))));
+		registry->template addComponent<transform>(registry->createEntity(), transform{up * c_radius, direction * 250.0});
+	}
+
+	std::vector<glm::dvec3> centers;
+	registry->template getComponentsOfType<transform>().each([&](ecs::entity, transform& a_transform)
+	{
+		if(centers.size() < c_queryCount)
+		{
+			centers.push_back(a_transform.position);
+		}
+	});
+
+	spatial::spatial_hash index(c_queryRadius);
+	index.synchronize<transform>(*registry, &transform::position);
+
+	std::vector<ecs::entity> found;
+	std::vector<std::vector<ecs::entity>> batch;
+	double moveTime = 0, updateTime = 0, queryTime = 0, batchTime = 0;
+	size_t neighbors = 0;
+	for(int tick = 0; tick < c_ticks; tick++)
+	{
+		auto start = high_resolution_clock::now();
+		registry->template getComponentsOfType<transform>().each([](ecs::entity, transform& a_transform)
+		{
+			a_transform.position = glm::normalize(a_transform.position + a_transform.velocity * c_tickSeconds) * c_radius;
+		});
+		moveTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		index.synchronize<transform>(*registry, &transform::position);
+		updateTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		neighbors = 0;
+		for(const glm::dvec3& center : centers)
+		{
+			found.clear();
+			index.query_radius(center, c_queryRadius, found);
+			neighbors += found.size();
+		}
+		queryTime += elapsed_ms(start);
+
+		start = high_resolution_clock::now();
+		index.query_radius(centers, c_queryRadius, batch);
+		batchTime += elapsed_ms(start);
+	}
+
+	std::printf("%zu entities, %zu occupied cells, %.1f MB\n", Count, index.cell_count(), static_cast<double>(index.bytes_reserved()) / (1024.0 * 1024.0));
+	std::printf("  %-28s: %.4f ms/tick\n", "integrate positions", moveTime / c_ticks);
+	std::printf("  %-28s: %.4f ms/tick\n", "update index", updateTime / c_ticks);
+	std::printf("  %-28s: %.4f ms/tick (%zu neighbors)\n", "radius queries", queryTime / c_ticks, neighbors);
+	std::printf("  %-28s: %.4f ms/tick (%zu threads)\n", "batch radius queries", batchTime / c_ticks, ecs::thread_pool::shared().size());
+}
+
+int main()
+{
+	run<100'000>();
+	run<1'000'000>();
+	return 0;
+}
@@ -0,0 +1,584 @@
+
+#ifndef SPATIAL_AABB_TREE_H
+#define SPATIAL_AABB_TREE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "bounds.hpp"
+#include "entity.hpp"
+#include "entity_set.hpp"
+#include "parallel.hpp"
+
+namespace spatial
+{
+
+/// Ray in ECEF meters. The direction should be normalized so hit distances are in meters
+struct ray
+{
+	glm::dvec3 origin;
+	glm::dvec3 direction;
+	double max_distance{std::numeric_limits<double>::infinity()};
+};
+
+struct ray_hit
+{
+	ecs::entity entity;
+	double distance;
+};
+
+/// Dynamic bounding volume tree over entity bounds. Leaves store the exact bounds
+/// of an entity inside enlarged bounds, an entity is only reinserted once it
+/// leaves its enlarged bounds. Inserting and removing leaves rotates the tree to
+/// keep it balanced
+class aabb_tree
+{
+	static constexpr int32_t null_node = -1;
+
+	/// Maximum traversal stack, the balancing keeps the height logarithmic so this is never reached
+	static constexpr size_t c_stackSize = 128;
+
+	/// Number of batch queries evaluated by one task
+	static constexpr size_t c_batchSize = 64;
+
+public:
+	/// @param a_margin distance in meters the bounds of a leaf are enlarged by, entities
+	///                 moving less than this distance do not change the tree
+	explicit aabb_tree(double a_margin = 0.0)
+		: m_margin{a_margin}
+	{}
+
+	/// Returns the number of entities in the tree
+	[[nodiscard]] size_t size() const { return m_entities.size(); }
+	[[nodiscard]] bool empty() const { return m_entities.empty(); }
+
+	/// Returns the height of the tree, a tree with a single leaf has height 0
+	[[nodiscard]] int32_t height() const { return m_root == null_node ? 0 : m_nodes[m_root].height; }
+
+	/// Returns true if the entity is part of the tree
+	[[nodiscard]] bool contains(ecs::entity a_entity) const { return m_entities.contains(a_entity); }
+
+	/// Returns the exact bounds of an entity or nullptr if the entity is not part of the tree
+	[[nodiscard]] const aabb* bounds(ecs::entity a_entity) const
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		return index < m_bounds.size() ? &m_bounds[index] : nullptr;
+	}
+
+	/// Insert an entity or update its bounds
+	/// @param a_bounds the exact bounds of the entity in ECEF meters
+	/// @return true if the entity was inserted or moved inside the tree
+	bool update(ecs::entity a_entity, const aabb& a_bounds)
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			const int32_t leaf = allocate_node();
+			m_nodes[leaf].box = a_bounds.expanded(m_margin);
+			m_nodes[leaf].height = 0;
+			m_nodes[leaf].entry = static_cast<uint32_t>(index);
+			m_entities.insert(a_entity);
+			m_bounds.push_back(a_bounds);
+			m_leaves.push_back(leaf);
+			m_stamps.push_back(m_generation);
+			insert_leaf(leaf);
+			return true;
+		}
+
+		const int32_t leaf = m_leaves[index];
+		m_stamps[index] = m_generation;
+		m_bounds[index] = a_bounds;
+		if(m_nodes[leaf].box.contains(a_bounds))
+		{
+			return false;
+		}
+
+		remove_leaf(leaf);
+		m_nodes[leaf].box = a_bounds.expanded(m_margin);
+		insert_leaf(leaf);
+		return true;
+	}
+
+	/// Remove an entity from the tree
+	/// @return false if the entity was not part of the tree
+	bool erase(ecs::entity a_entity)
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			return false;
+		}
+
+		erase_index(index);
+		return true;
+	}
+
+	/// Remove every entity, keeps the allocated memory
+	void clear()
+	{
+		m_entities.clear();
+		m_bounds.clear();
+		m_leaves.clear();
+		m_stamps.clear();
+		m_nodes.clear();
+		m_root = null_node;
+		m_free = null_node;
+	}
+
+	/// Update the bounds of every entity with a component and remove all other
+	/// entities. Only entities that left their enlarged bounds are moved in the tree
+	/// @param a_registry the registry owning the components
+	/// @param a_projection member pointer or function returning the aabb of a component
+	/// @return the number of entities inserted or moved
+	template <typename Component, typename Registry, typename Projection>
+	size_t synchronize(Registry& a_registry, const Projection& a_projection)
+	{
+		m_generation++;
+		size_t moved = 0;
+		auto& storage = a_registry.template getComponentsOfType<Component>();
+		const auto index = [this, &a_projection, &moved](auto a_first, auto a_last)
+		{
+			for(; a_first != a_last; ++a_first)
+			{
+				moved += update(a_first.owner(), std::invoke(a_projection, *a_first));
+			}
+		};
+
+		index(storage.begin(), storage.end());
+		auto sleeping = storage.sleeping();
+		index(sleeping.begin(), sleeping.end());
+
+		for(size_t i = m_entities.size(); i-- > 0;)
+		{
+			if(m_stamps[i] != m_generation)
+			{
+				erase_index(i);
+			}
+		}
+
+		return moved;
+	}
+
+	/// Find the nearest entity whose bounds are hit by a ray
+	[[nodiscard]] std::optional<ray_hit> raycast(const ray& a_ray) const
+	{
+		std::optional<ray_hit> result;
+		if(m_root == null_node)
+		{
+			return result;
+		}
+
+		const glm::dvec3 inverse = 1.0 / a_ray.direction;
+		double best = a_ray.max_distance;
+		double distance;
+		if(!intersect(m_nodes[m_root].box, a_ray.origin, inverse, best, distance))
+		{
+			return result;
+		}
+
+		// Children are pushed far to near so the nearest one is visited first and
+		// later nodes can be skipped once a closer hit is known
+		std::array<std::pair<int32_t, double>, c_stackSize> stack;
+		size_t count = 0;
+		stack[count++] = {m_root, distance};
+		while(count > 0)
+		{
+			const auto [index, entry] = stack[--count];
+			if(entry > best)
+			{
+				continue;
+			}
+
+			const node& current = m_nodes[index];
+			if(current.is_leaf())
+			{
+				if(intersect(m_bounds[current.entry], a_ray.origin, inverse, best, distance))
+				{
+					best = distance;
+					result = ray_hit{m_entities[current.entry], distance};
+				}
+
+				continue;
+			}
+
+			double first, second;
+			const bool hitFirst = intersect(m_nodes[current.child1].box, a_ray.origin, inverse, best, first);
+			const bool hitSecond = intersect(m_nodes[current.child2].box, a_ray.origin, inverse, best, second);
+			if(hitFirst && hitSecond)
+			{
+				const bool firstNearer = first <= second;
+				stack[count++] = firstNearer ? std::pair{current.child2, second} : std::pair{current.child1, first};
+				stack[count++] = firstNearer ? std::pair{current.child1, first} : std::pair{current.child2, second};
+			}
+			else if(hitFirst)
+			{
+				stack[count++] = {current.child1, first};
+			}
+			else if(hitSecond)
+			{
+				stack[count++] = {current.child2, second};
+			}
+		}
+
+		return result;
+	}
+
+	/// Find the nearest hit of many rays in parallel. The tree must not be
+	/// modified while the queries run
+	/// @param r_hits resized to one result per ray
+	/// @param a_pool the threads evaluating the queries
+	void raycast(std::span<const ray> a_rays, std::vector<std::optional<ray_hit>>& r_hits, ecs::thread_pool& a_pool = ecs::thread_pool::shared()) const
+	{
+		r_hits.resize(a_rays.size());
+		const size_t batches = (a_rays.size() + c_batchSize - 1) / c_batchSize;
+		a_pool.run(batches, [&](size_t a_batch)
+		{
+			const size_t last = std::min(a_rays.size(), (a_batch + 1) * c_batchSize);
+			for(size_t i = a_batch * c_batchSize; i < last; i++)
+			{
+				r_hits[i] = raycast(a_rays[i]);
+			}
+		});
+	}
+
+	/// Call a function for every entity whose bounds intersect a line segment, in no
+	/// particular order. Returning false from the function stops the query, which
+	/// makes line of sight tests stop at the first blocker
+	/// @param a_func function called with (ecs::entity, double fraction) returning bool,
+	///               fraction is where the segment enters the bounds, 0 at a_from and 1 at a_to
+	/// @return false if the function stopped the query
+	template <typename Func>
+	bool segment_query(const glm::dvec3& a_from, const glm::dvec3& a_to, Func&& a_func) const
+	{
+		const glm::dvec3 inverse = 1.0 / (a_to - a_from);
+		double fraction;
+		return traverse(
+			[&](const aabb& a_box) { return intersect(a_box, a_from, inverse, 1.0, fraction); },
+			[&](uint32_t a_entry) { return !intersect(m_bounds[a_entry], a_from, inverse, 1.0, fraction) || a_func(m_entities[a_entry], fraction); });
+	}
+
+	/// Call a function for every entity whose bounds overlap a box, in no particular order
+	/// @param a_func function called with (ecs::entity) returning bool, false stops the query
+	/// @return false if the function stopped the query
+	template <typename Func>
+	bool for_each_overlap(const aabb& a_box, Func&& a_func) const
+	{
+		return traverse(
+			[&a_box](const aabb& a_node) { return a_box.overlaps(a_node); },
+			[&](uint32_t a_entry) { return !a_box.overlaps(m_bounds[a_entry]) || a_func(m_entities[a_entry]); });
+	}
+
+	/// Returns the number of bytes reserved by the tree
+	[[nodiscard]] size_t bytes_reserved() const
+	{
+		return m_entities.bytes_reserved()
+			+ m_bounds.capacity() * sizeof(aabb)
+			+ m_leaves.capacity() * sizeof(int32_t)
+			+ m_stamps.capacity() * sizeof(uint32_t)
+			+ m_nodes.capacity() * sizeof(node);
+	}
+
+private:
+	struct node
+	{
+		/// Bounds of the subtree, enlarged by the margin for leaves
+		aabb box;
+		int32_t parent{null_node};
+		int32_t child1{null_node};
+		int32_t child2{null_node};
+		/// Height of the subtree, 0 for leaves and -1 for free nodes
+		int32_t height{0};
+		/// Index of the entity of a leaf in m_entities
+		uint32_t entry{0};
+
+		[[nodiscard]] bool is_leaf() const { return child1 == null_node; }
+	};
+
+	double m_margin;
+
+	// Per entity data, index i belongs to m_entities[i]
+	ecs::entity_set m_entities;
+	std::vector<aabb> m_bounds;
+	std::vector<int32_t> m_leaves;
+	std::vector<uint32_t> m_stamps;
+	uint32_t m_generation{0};
+
+	std::vector<node> m_nodes;
+	int32_t m_root{null_node};
+	/// First free node, free nodes are linked through their parent index
+	int32_t m_free{null_node};
+
+	/// Slab test of a ray against a box
+	/// @param a_inverse the reciprocal of the ray direction
+	/// @param r_distance where the ray enters the box, 0 if the origin is inside
+	static bool intersect(const aabb& a_box, const glm::dvec3& a_origin, const glm::dvec3& a_inverse, double a_maxDistance, double& r_distance)
+	{
+		const glm::dvec3 lower = (a_box.min - a_origin) * a_inverse;
+		const glm::dvec3 upper = (a_box.max - a_origin) * a_inverse;
+		const double enter = std::max(std::max(std::min(lower.x, upper.x), std::min(lower.y, upper.y)), std::max(std::min(lower.z, upper.z), 0.0));
+		const double exit = std::min(std::min(std::max(lower.x, upper.x), std::max(lower.y, upper.y)), std::min(std::max(lower.z, upper.z), a_maxDistance));
+		r_distance = enter;
+		return enter <= exit;
+	}
+
+	/// Depth first traversal of the nodes accepted by a test
+	/// @param a_test called with the bounds of a node, false skips the subtree
+	/// @param a_visit called with the entity index of every accepted leaf, false stops the traversal
+	template <typename Test, typename Visit>
+	bool traverse(const Test& a_test, const Visit& a_visit) const
+	{
+		if(m_root == null_node)
+		{
+			return true;
+		}
+
+		std::array<int32_t, c_stackSize> stack;
+		size_t count = 0;
+		stack[count++] = m_root;
+		while(count > 0)
+		{
+			const node& current = m_nodes[stack[--count]];
+			if(!a_test(current.box))
+			{
+				continue;
+			}
+
+			if(current.is_leaf())
+			{
+				if(!a_visit(current.entry))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			stack[count++] = current.child1;
+			stack[count++] = current.child2;
+		}
+
+		return true;
+	}
+
+	int32_t allocate_node()
+	{
+		if(m_free == null_node)
+		{
+			m_nodes.emplace_back();
+			return static_cast<int32_t>(m_nodes.size() - 1);
+		}
+
+		const int32_t index = m_free;
+		m_free = m_nodes[index].parent;
+		m_nodes[index] = node{};
+		return index;
+	}
+
+	void free_node(int32_t a_index)
+	{
+		m_nodes[a_index].parent = m_free;
+		m_nodes[a_index].height = -1;
+		m_free = a_index;
+	}
+
+	/// Remove an entity, the last entity is moved into the gap like the entity set does
+	void erase_index(size_t a_index)
+	{
+		const int32_t leaf = m_leaves[a_index];
+		remove_leaf(leaf);
+		free_node(leaf);
+		m_entities.erase(m_entities[a_index]);
+		m_bounds[a_index] = m_bounds.back();
+		m_leaves[a_index] = m_leaves.back();
+		m_stamps[a_index] = m_stamps.back();
+		m_nodes[m_leaves[a_index]].entry = static_cast<uint32_t>(a_index);
+		m_bounds.pop_back();
+		m_leaves.pop_back();
+		m_stamps.pop_back();
+	}
+
+	/// Recompute the bounds and height of an inner node from its children
+	void refit(int32_t a_index)
+	{
+		node& current = m_nodes[a_index];
+		const node& first = m_nodes[current.child1];
+		const node& second = m_nodes[current.child2];
+		current.box = aabb::merge(first.box, second.box);
+		current.height = 1 + std::max(first.height, second.height);
+	}
+
+	/// Walk to the root rebalancing and refitting every ancestor
+	void refit_ancestors(int32_t a_index)
+	{
+		while(a_index != null_node)
+		{
+			a_index = rebalance(a_index);
+			refit(a_index);
+			a_index = m_nodes[a_index].parent;
+		}
+	}
+
+	void replace_child(int32_t a_parent, int32_t a_old, int32_t a_new)
+	{
+		if(a_parent == null_node)
+		{
+			m_root = a_new;
+		}
+		else if(m_nodes[a_parent].child1 == a_old)
+		{
+			m_nodes[a_parent].child1 = a_new;
+		}
+		else
+		{
+			m_nodes[a_parent].child2 = a_new;
+		}
+	}
+
+	/// Insert a leaf next to the sibling that increases the total surface area the least
+	void insert_leaf(int32_t a_leaf)
+	{
+		if(m_root == null_node)
+		{
+			m_root = a_leaf;
+			m_nodes[a_leaf].parent = null_node;
+			return;
+		}
+
+		const aabb box = m_nodes[a_leaf].box;
+		int32_t index = m_root;
+		while(!m_nodes[index].is_leaf())
+		{
+			const node& current = m_nodes[index];
+			const double area = current.box.surface_area();
+			const double combinedArea = aabb::merge(current.box, box).surface_area();
+
+			// Cost of pairing the leaf with this node, and the cost added to every
+			// ancestor when descending further
+			const double cost = 2.0 * combinedArea;
+			const double inheritance = 2.0 * (combinedArea - area);
+			const auto descend = [this, &box, inheritance](int32_t a_child)
+			{
+				const node& child = m_nodes[a_child];
+				const double merged = aabb::merge(child.box, box).surface_area();
+				return inheritance + (child.is_leaf() ? merged : merged - child.box.surface_area());
+			};
+
+			const double cost1 = descend(current.child1);
+			const double cost2 = descend(current.child2);
+			if(cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+
+			index = cost1 < cost2 ? current.child1 : current.child2;
+		}
+
+		const int32_t sibling = index;
+		const int32_t oldParent = m_nodes[sibling].parent;
+		const int32_t parent = allocate_node();
+		node& created = m_nodes[parent];
+		created.parent = oldParent;
+		created.box = aabb::merge(box, m_nodes[sibling].box);
+		created.height = m_nodes[sibling].height + 1;
+		created.child1 = sibling;
+		created.child2 = a_leaf;
+		replace_child(oldParent, sibling, parent);
+		m_nodes[sibling].parent = parent;
+		m_nodes[a_leaf].parent = parent;
+
+		refit_ancestors(parent);
+	}
+
+	/// Detach a leaf, its parent is replaced by the sibling of the leaf
+	void remove_leaf(int32_t a_leaf)
+	{
+		if(a_leaf == m_root)
+		{
+			m_root = null_node;
+			return;
+		}
+
+		const int32_t parent = m_nodes[a_leaf].parent;
+		const int32_t grandParent = m_nodes[parent].parent;
+		const int32_t sibling = m_nodes[parent].child1 == a_leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+		replace_child(grandParent, parent, sibling);
+		m_nodes[sibling].parent = grandParent;
+		free_node(parent);
+
+		refit_ancestors(grandParent);
+	}
+
+	/// Rotate a child of an inner node up when one subtree is more than one level
+	/// deeper than the other
+	/// @return the node that took the place of a_index
+	int32_t rebalance(int32_t a_index)
+	{
+		node& a = m_nodes[a_index];
+		if(a.is_leaf() || a.height < 2)
+		{
+			return a_index;
+		}
+
+		const int32_t balance = m_nodes[a.child2].height - m_nodes[a.child1].height;
+		if(balance > 1)
+		{
+			return rotate(a_index, a.child2);
+		}
+
+		if(balance < -1)
+		{
+			return rotate(a_index, a.child1);
+		}
+
+		return a_index;
+	}
+
+	/// Move the deeper child up into the place of its parent, the parent adopts the
+	/// shallower grandchild
+	/// @param a_index the unbalanced node
+	/// @param a_deep the deeper child that is rotated up
+	int32_t rotate(int32_t a_index, int32_t a_deep)
+	{
+		node& a = m_nodes[a_index];
+		node& up = m_nodes[a_deep];
+		const int32_t f = up.child1;
+		const int32_t g = up.child2;
+
+		up.parent = a.parent;
+		replace_child(a.parent, a_index, a_deep);
+		a.parent = a_deep;
+
+		// The deeper grandchild stays below the rotated node, the other one moves to a_index
+		const bool keepFirst = m_nodes[f].height > m_nodes[g].height;
+		const int32_t kept = keepFirst ? f : g;
+		const int32_t moved = keepFirst ? g : f;
+		up.child1 = a_index;
+		up.child2 = kept;
+		if(a.child1 == a_deep)
+		{
+			a.child1 = moved;
+		}
+		else
+		{
+			a.child2 = moved;
+		}
+
+		m_nodes[moved].parent = a_index;
+		refit(a_index);
+		refit(a_deep);
+		return a_deep;
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_AABB_TREE_H
@@ -0,0 +1,64 @@
+
+#ifndef SPATIAL_BOUNDS_H
+#define SPATIAL_BOUNDS_H
+
+#include <algorithm>
+
+#include <glm/vec3.hpp>
+
+namespace spatial
+{
+
+/// Axis aligned bounding box in ECEF meters
+struct aabb
+{
+	glm::dvec3 min;
+	glm::dvec3 max;
+
+	/// Returns a box around a point
+	/// @param a_extent distance from the point to every face of the box
+	static aabb around(const glm::dvec3& a_center, double a_extent)
+	{
+		return {a_center - glm::dvec3(a_extent), a_center + glm::dvec3(a_extent)};
+	}
+
+	/// Returns the smallest box containing both boxes
+	static aabb merge(const aabb& a_first, const aabb& a_second)
+	{
+		return {
+			glm::dvec3(std::min(a_first.min.x, a_second.min.x), std::min(a_first.min.y, a_second.min.y), std::min(a_first.min.z, a_second.min.z)),
+			glm::dvec3(std::max(a_first.max.x, a_second.max.x), std::max(a_first.max.y, a_second.max.y), std::max(a_first.max.z, a_second.max.z))
+		};
+	}
+
+	/// Returns the box grown by a distance on every side
+	[[nodiscard]] aabb expanded(double a_distance) const
+	{
+		return {min - glm::dvec3(a_distance), max + glm::dvec3(a_distance)};
+	}
+
+	/// Returns true if the other box is fully inside this box
+	[[nodiscard]] bool contains(const aabb& a_other) const
+	{
+		return (min.x <= a_other.min.x) & (min.y <= a_other.min.y) & (min.z <= a_other.min.z)
+			& (a_other.max.x <= max.x) & (a_other.max.y <= max.y) & (a_other.max.z <= max.z);
+	}
+
+	/// Returns true if the boxes touch or overlap
+	[[nodiscard]] bool overlaps(const aabb& a_other) const
+	{
+		return (min.x <= a_other.max.x) & (min.y <= a_other.max.y) & (min.z <= a_other.max.z)
+			& (a_other.min.x <= max.x) & (a_other.min.y <= max.y) & (a_other.min.z <= max.z);
+	}
+
+	/// Returns the surface area, used as the cost of a box in bounding volume trees
+	[[nodiscard]] double surface_area() const
+	{
+		const glm::dvec3 size = max - min;
+		return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_BOUNDS_H
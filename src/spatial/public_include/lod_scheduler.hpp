@@ -0,0 +1,405 @@
+
+#ifndef SPATIAL_LOD_SCHEDULER_H
+#define SPATIAL_LOD_SCHEDULER_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "entity.hpp"
+#include "entity_set.hpp"
+
+namespace spatial
+{
+
+/// Update rate of the entities within a distance of the observer
+struct lod_tier
+{
+	/// Entities up to this distance in meters use the tier, ignored for the last tier
+	double max_distance;
+
+	/// Entities are updated every period ticks, rounded up to a power of two
+	uint32_t period;
+};
+
+/// Schedules system updates by distance to an observer. Every entity belongs to
+/// the first tier whose distance covers it and is updated once every period ticks
+/// of that tier. Entities of a tier are spread over period buckets so each tick
+/// updates one bucket per tier and the work per tick stays even. Updated entities
+/// receive the time since their previous update so systems work with variable dt.
+///
+/// With a far budget the period of the last tier doubles until at most that many
+/// far entities are updated per tick, so the cost per tick stays constant when the
+/// world grows and only the update rate of the far entities drops
+class lod_scheduler
+{
+public:
+	/// @param a_tiers tiers ordered by distance, the last tier covers every remaining entity
+	/// @param a_farBudget far entities updated per tick, 0 keeps the period of the last tier
+	explicit lod_scheduler(const std::vector<lod_tier>& a_tiers, size_t a_farBudget = 0)
+		: m_farBudget{a_farBudget}
+	{
+		for(const lod_tier& tier : a_tiers)
+		{
+			const uint32_t period = std::bit_ceil(std::max<uint32_t>(tier.period, 1));
+			m_tiers.push_back({tier.max_distance, period, period, 0, 0, std::vector<std::vector<uint32_t>>(period)});
+		}
+
+		if(m_tiers.empty())
+		{
+			m_tiers.push_back({0.0, 1, 1, 0, 0, std::vector<std::vector<uint32_t>>(1)});
+		}
+
+		m_tiers.back().max_distance = std::numeric_limits<double>::infinity();
+	}
+
+	/// Returns the number of scheduled entities
+	[[nodiscard]] size_t size() const { return m_entities.size(); }
+	[[nodiscard]] bool empty() const { return m_entities.empty(); }
+
+	/// Returns true if the entity is scheduled
+	[[nodiscard]] bool contains(ecs::entity a_entity) const { return m_entities.contains(a_entity); }
+
+	/// Returns the number of ticks run
+	[[nodiscard]] uint64_t tick() const { return m_tick; }
+
+	/// Returns the sum of the dt of every tick run
+	[[nodiscard]] double time() const { return m_time; }
+
+	/// Returns the number of tiers
+	[[nodiscard]] size_t tier_count() const { return m_tiers.size(); }
+
+	/// Returns the current period of a tier
+	[[nodiscard]] uint32_t period(size_t a_tier) const { return m_tiers[a_tier].period; }
+
+	/// Returns the number of entities in a tier
+	[[nodiscard]] size_t tier_size(size_t a_tier) const { return m_tiers[a_tier].size; }
+
+	/// Returns the tier of an entity or tier_count() if it is not scheduled
+	[[nodiscard]] size_t tier_of(ecs::entity a_entity) const
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		return index < m_entryTiers.size() ? m_entryTiers[index] : m_tiers.size();
+	}
+
+	/// Returns the observer the distances are measured from
+	[[nodiscard]] const glm::dvec3& observer() const { return m_observer; }
+
+	/// Move the observer. Entities pick up their new tier when they are updated next
+	/// @param a_observer ECEF position in meters, usually the camera position
+	void set_observer(const glm::dvec3& a_observer) { m_observer = a_observer; }
+
+	/// Schedule an entity or move it to the tier of a new position
+	/// @param a_position ECEF position in meters
+	void update(ecs::entity a_entity, const glm::dvec3& a_position)
+	{
+		const size_t tier = tier_at(a_position);
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			m_entities.insert(a_entity);
+			m_entryTiers.push_back(tier);
+			m_entryPhases.push_back(0);
+			m_entrySlots.push_back(0);
+			m_lastTimes.push_back(m_time);
+			m_stamps.push_back(m_generation);
+			attach(index, tier);
+			return;
+		}
+
+		m_stamps[index] = m_generation;
+		if(m_entryTiers[index] != tier)
+		{
+			detach(index);
+			attach(index, tier);
+		}
+	}
+
+	/// Remove an entity from the schedule
+	/// @return false if the entity was not scheduled
+	bool erase(ecs::entity a_entity)
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			return false;
+		}
+
+		erase_index(index);
+		return true;
+	}
+
+	/// Schedule every entity with a component and remove all other entities.
+	/// Sleeping components are included, they stay scheduled and are skipped by
+	/// run. This visits every entity, call it when entities were added or removed
+	/// @param a_registry the registry owning the components
+	/// @param a_projection member pointer or function returning the ECEF position of a component
+	template <typename Component, typename Registry, typename Projection>
+	void synchronize(Registry& a_registry, const Projection& a_projection)
+	{
+		m_generation++;
+		auto& storage = a_registry.template getComponentsOfType<Component>();
+		const auto index = [this, &a_projection](auto a_first, auto a_last)
+		{
+			for(; a_first != a_last; ++a_first)
+			{
+				update(a_first.owner(), glm::dvec3(std::invoke(a_projection, *a_first)));
+			}
+		};
+
+		index(storage.begin(), storage.end());
+		auto sleeping = storage.sleeping();
+		index(sleeping.begin(), sleeping.end());
+
+		for(size_t i = m_entities.size(); i-- > 0;)
+		{
+			if(m_stamps[i] != m_generation)
+			{
+				erase_index(i);
+			}
+		}
+
+		fit_far_budget();
+	}
+
+	/// Run one tick. The entities in the due bucket of every tier are updated and
+	/// move to the tier of their new position. Sleeping entities are skipped but stay
+	/// scheduled and entities that lost the component are removed from the schedule
+	/// @param a_registry the registry owning the components
+	/// @param a_projection member pointer or function returning the ECEF position of a component
+	/// @param a_dt length of the tick in seconds
+	/// @param a_func function called with (entity, Component&, double dt) where dt is the time since the previous update of the entity
+	/// @return the number of updated entities
+	template <typename Component, typename Registry, typename Projection, typename Func>
+	size_t run(Registry& a_registry, const Projection& a_projection, double a_dt, Func&& a_func)
+	{
+		m_time += a_dt;
+		m_due.clear();
+
+		// Updating reorders the buckets so the due entities are gathered first
+		for(const tier& current : m_tiers)
+		{
+			for(const uint32_t entry : current.phases[m_tick & (current.period - 1)])
+			{
+				m_due.push_back(m_entities[entry]);
+			}
+		}
+
+		size_t result = 0;
+		for(const ecs::entity entity : m_due)
+		{
+			Component* component = a_registry.template getComponent<Component>(entity);
+			if(component == nullptr)
+			{
+				erase(entity);
+				continue;
+			}
+
+			if(a_registry.isSleeping(entity))
+			{
+				continue;
+			}
+
+			const size_t index = m_entities.index_of(entity);
+			a_func(entity, *component, m_time - m_lastTimes[index]);
+			m_lastTimes[index] = m_time;
+
+			const size_t tier = tier_at(glm::dvec3(std::invoke(a_projection, *component)));
+			if(m_entryTiers[index] != tier)
+			{
+				detach(index);
+				attach(index, tier);
+			}
+
+			result++;
+		}
+
+		m_tick++;
+		fit_far_budget();
+		return result;
+	}
+
+	/// Returns the number of bytes reserved by the schedule
+	[[nodiscard]] size_t bytes_reserved() const
+	{
+		size_t result = (m_entryTiers.capacity() + m_entryPhases.capacity() + m_entrySlots.capacity() + m_stamps.capacity()) * sizeof(uint32_t)
+			+ m_due.capacity() * sizeof(ecs::entity)
+			+ m_lastTimes.capacity() * sizeof(double);
+		for(const tier& current : m_tiers)
+		{
+			for(const auto& bucket : current.phases)
+			{
+				result += bucket.capacity() * sizeof(uint32_t);
+			}
+		}
+
+		return result;
+	}
+
+private:
+	struct tier
+	{
+		double max_distance;
+		uint32_t period;
+
+		/// Period given on construction, the far budget never goes below it
+		uint32_t base_period;
+
+		/// Phase the next entity joins, new entities are dealt round robin
+		uint32_t next_phase;
+		size_t size;
+
+		/// Entry indices of the entities updated on ticks where tick % period is the phase
+		std::vector<std::vector<uint32_t>> phases;
+	};
+
+	std::vector<tier> m_tiers;
+	size_t m_farBudget;
+	glm::dvec3 m_observer{0.0};
+	uint64_t m_tick{0};
+	double m_time{0.0};
+
+	ecs::entity_set m_entities;
+	std::vector<uint32_t> m_entryTiers;
+	std::vector<uint32_t> m_entryPhases;
+
+	/// Position of every entry inside its phase bucket
+	std::vector<uint32_t> m_entrySlots;
+	std::vector<double> m_lastTimes;
+	std::vector<uint32_t> m_stamps;
+	uint32_t m_generation{0};
+	std::vector<ecs::entity> m_due;
+
+	[[nodiscard]] size_t tier_at(const glm::dvec3& a_position) const
+	{
+		const glm::dvec3 offset = a_position - m_observer;
+		const double distance2 = glm::dot(offset, offset);
+		size_t result = 0;
+		while(distance2 > m_tiers[result].max_distance * m_tiers[result].max_distance)
+		{
+			result++;
+		}
+
+		return result;
+	}
+
+	void attach(size_t a_index, size_t a_tier)
+	{
+		tier& target = m_tiers[a_tier];
+		const uint32_t phase = target.next_phase;
+		target.next_phase = (phase + 1) & (target.period - 1);
+		target.size++;
+
+		auto& bucket = target.phases[phase];
+		m_entryTiers[a_index] = static_cast<uint32_t>(a_tier);
+		m_entryPhases[a_index] = phase;
+		m_entrySlots[a_index] = static_cast<uint32_t>(bucket.size());
+		bucket.push_back(static_cast<uint32_t>(a_index));
+	}
+
+	void detach(size_t a_index)
+	{
+		tier& source = m_tiers[m_entryTiers[a_index]];
+		auto& bucket = source.phases[m_entryPhases[a_index]];
+		const uint32_t slot = m_entrySlots[a_index];
+		bucket[slot] = bucket.back();
+		m_entrySlots[bucket[slot]] = slot;
+		bucket.pop_back();
+		source.size--;
+	}
+
+	void erase_index(size_t a_index)
+	{
+		detach(a_index);
+		m_entities.erase(m_entities[a_index]);
+
+		const size_t last = m_entryTiers.size() - 1;
+		if(a_index != last)
+		{
+			m_entryTiers[a_index] = m_entryTiers[last];
+			m_entryPhases[a_index] = m_entryPhases[last];
+			m_entrySlots[a_index] = m_entrySlots[last];
+			m_lastTimes[a_index] = m_lastTimes[last];
+			m_stamps[a_index] = m_stamps[last];
+			m_tiers[m_entryTiers[a_index]].phases[m_entryPhases[a_index]][m_entrySlots[a_index]] = static_cast<uint32_t>(a_index);
+		}
+
+		m_entryTiers.pop_back();
+		m_entryPhases.pop_back();
+		m_entrySlots.pop_back();
+		m_lastTimes.pop_back();
+		m_stamps.pop_back();
+	}
+
+	/// Double or halve the period of the last tier so a bucket holds about the far budget.
+	/// Splitting phase p into p and p + period keeps every entity on the same ticks modulo
+	/// the old period so no entity waits longer than the new period
+	void fit_far_budget()
+	{
+		if(m_farBudget == 0)
+		{
+			return;
+		}
+
+		tier& last = m_tiers.back();
+		while(last.size > m_farBudget * last.period)
+		{
+			const uint32_t period = last.period;
+			last.phases.resize(period * 2);
+			for(uint32_t phase = 0; phase < period; phase++)
+			{
+				auto& bucket = last.phases[phase];
+				auto& upper = last.phases[phase + period];
+				size_t kept = 0;
+				for(size_t i = 0; i < bucket.size(); i++)
+				{
+					const uint32_t entry = bucket[i];
+					if((i & 1) == 0)
+					{
+						m_entrySlots[entry] = static_cast<uint32_t>(kept);
+						bucket[kept++] = entry;
+					}
+					else
+					{
+						m_entryPhases[entry] = phase + period;
+						m_entrySlots[entry] = static_cast<uint32_t>(upper.size());
+						upper.push_back(entry);
+					}
+				}
+
+				bucket.resize(kept);
+			}
+
+			last.period = period * 2;
+			last.next_phase &= last.period - 1;
+		}
+
+		while(last.period > last.base_period && last.size * 4 < m_farBudget * last.period)
+		{
+			const uint32_t period = last.period / 2;
+			for(uint32_t phase = 0; phase < period; phase++)
+			{
+				auto& bucket = last.phases[phase];
+				for(const uint32_t entry : last.phases[phase + period])
+				{
+					m_entryPhases[entry] = phase;
+					m_entrySlots[entry] = static_cast<uint32_t>(bucket.size());
+					bucket.push_back(entry);
+				}
+			}
+
+			last.phases.resize(period);
+			last.period = period;
+			last.next_phase &= period - 1;
+		}
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_LOD_SCHEDULER_H
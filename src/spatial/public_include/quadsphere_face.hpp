@@ -0,0 +1,136 @@
+
+#ifndef SPATIAL_QUADSPHERE_FACE_H
+#define SPATIAL_QUADSPHERE_FACE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "bounds.hpp"
+
+namespace spatial
+{
+
+constexpr const int c_faceCount = 6;
+
+/// Orientation of a quadsphere face in ECEF. The face covers the directions where
+/// sign * p[axis] is at least |p[u]| and |p[v]|
+struct face_frame
+{
+	int axis;
+	double sign;
+	int u;
+	int v;
+};
+
+/// Faces in the order used by render::quadsphere::QuadTree. The renderer draws ECEF
+/// with the y and z axes flipped so face 1 is -Y and face 3 is +Y in ECEF
+constexpr const face_frame c_faceFrames[c_faceCount] = {
+	{0,  1.0, 1, 2},
+	{1, -1.0, 0, 2},
+	{0, -1.0, 1, 2},
+	{1,  1.0, 0, 2},
+	{2,  1.0, 0, 1},
+	{2, -1.0, 0, 1},
+};
+
+/// Returns the quadsphere face containing the direction of an ECEF position
+inline int face_of(const glm::dvec3& a_position)
+{
+	const double x = std::abs(a_position.x);
+	const double y = std::abs(a_position.y);
+	const double z = std::abs(a_position.z);
+	if(x >= y && x >= z)
+	{
+		return a_position.x >= 0 ? 0 : 2;
+	}
+
+	if(y >= z)
+	{
+		return a_position.y >= 0 ? 3 : 1;
+	}
+
+	return a_position.z >= 0 ? 4 : 5;
+}
+
+/// Returns a bitmask of the faces whose region a box might touch, bit i is face i.
+/// The test is conservative, boxes near an edge can report a face they miss
+inline uint32_t faces_touching(const aabb& a_box)
+{
+	uint32_t result = 0;
+	for(int i = 0; i < c_faceCount; i++)
+	{
+		const face_frame& frame = c_faceFrames[i];
+		const double height = frame.sign > 0 ? a_box.max[frame.axis] : -a_box.min[frame.axis];
+		const bool touches = (height >= a_box.min[frame.u]) & (height >= -a_box.max[frame.u])
+			& (height >= a_box.min[frame.v]) & (height >= -a_box.max[frame.v]);
+		result |= static_cast<uint32_t>(touches) << i;
+	}
+
+	return result;
+}
+
+/// Splits the sphere into regions along quadsphere faces. Every face is split into
+/// a grid of cells the same way render::quadsphere::QuadTree splits its faces
+class face_partition
+{
+public:
+	/// @param a_subdivisions cells along each edge of a face, 0 keeps the whole sphere in one region
+	explicit face_partition(int a_subdivisions = 1)
+		: m_subdivisions{std::max(a_subdivisions, 0)}
+	{}
+
+	/// Returns the number of regions
+	[[nodiscard]] size_t count() const
+	{
+		return m_subdivisions == 0 ? 1 : static_cast<size_t>(c_faceCount * m_subdivisions * m_subdivisions);
+	}
+
+	/// Returns the region containing the direction of an ECEF position
+	[[nodiscard]] size_t operator()(const glm::dvec3& a_position) const
+	{
+		if(m_subdivisions == 0)
+		{
+			return 0;
+		}
+
+		const int face = face_of(a_position);
+		const face_frame& frame = c_faceFrames[face];
+		const double height = std::abs(a_position[frame.axis]);
+		const auto cell = [this, height](double a_value)
+		{
+			const double projected = height > 0 ? a_value / height : 0.0;
+			return std::clamp(static_cast<int>((projected + 1.0) * 0.5 * m_subdivisions), 0, m_subdivisions - 1);
+		};
+
+		return static_cast<size_t>((face * m_subdivisions + cell(a_position[frame.v])) * m_subdivisions + cell(a_position[frame.u]));
+	}
+
+	/// Returns the number of cells along each edge of a face
+	[[nodiscard]] int subdivisions() const { return m_subdivisions; }
+
+	/// Returns the unit direction of a point inside a region, the partition must be subdivided
+	/// @param a_u position along the u axis of the face inside the region, 0 to 1
+	/// @param a_v position along the v axis of the face inside the region, 0 to 1
+	[[nodiscard]] glm::dvec3 direction(size_t a_region, double a_u = 0.5, double a_v = 0.5) const
+	{
+		const size_t cells = static_cast<size_t>(m_subdivisions);
+		const face_frame& frame = c_faceFrames[a_region / (cells * cells)];
+		const double scale = 2.0 / m_subdivisions;
+		glm::dvec3 result(0.0);
+		result[frame.axis] = frame.sign;
+		result[frame.u] = (static_cast<double>(a_region % cells) + a_u) * scale - 1.0;
+		result[frame.v] = (static_cast<double>(a_region / cells % cells) + a_v) * scale - 1.0;
+		return glm::normalize(result);
+	}
+
+private:
+	int m_subdivisions;
+};
+
+} // spatial
+
+#endif  // SPATIAL_QUADSPHERE_FACE_H
@@ -0,0 +1,125 @@
+
+#ifndef SPATIAL_QUANTIZE_H
+#define SPATIAL_QUANTIZE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+namespace spatial
+{
+
+/// Default step of quantized positions in meters
+constexpr const double c_positionStep = 0.01;
+
+/// ECEF position as whole steps, 1 cm steps cover 21000 km from the center of the earth in 32 bits
+struct quantized_position
+{
+	int32_t x;
+	int32_t y;
+	int32_t z;
+};
+
+/// Round an ECEF position to whole steps
+/// @param a_step size of a step in meters
+inline quantized_position quantize_position(const glm::dvec3& a_position, double a_step = c_positionStep)
+{
+	const auto quantize = [a_step](double a_value)
+	{
+		return static_cast<int32_t>(std::clamp(std::round(a_value / a_step), -2147483647.0, 2147483647.0));
+	};
+
+	return {quantize(a_position.x), quantize(a_position.y), quantize(a_position.z)};
+}
+
+/// Returns the ECEF position of a quantized position
+/// @param a_step size of a step in meters, must match quantize_position
+inline glm::dvec3 dequantize_position(const quantized_position& a_position, double a_step = c_positionStep)
+{
+	return glm::dvec3(a_position.x, a_position.y, a_position.z) * a_step;
+}
+
+namespace internal
+{
+	/// Bits of each of the three quaternion components stored by pack_rotation
+	constexpr const int c_rotationBits = 20;
+	constexpr const double c_rotationRange = 0.7071067811865476;
+}
+
+/// Pack a unit quaternion into 62 bits with the smallest three method. The largest
+/// component is dropped and rebuilt from the other three, which lie within
+/// +-1/sqrt(2) and are stored with 20 bits each, an error below 1e-6
+/// @param a_rotation a unit quaternion with x, y, z and w members such as glm::quat
+template <typename Quaternion>
+uint64_t pack_rotation(const Quaternion& a_rotation)
+{
+	double values[4] = {
+		static_cast<double>(a_rotation.x),
+		static_cast<double>(a_rotation.y),
+		static_cast<double>(a_rotation.z),
+		static_cast<double>(a_rotation.w)};
+
+	int largest = 0;
+	for(int i = 1; i < 4; i++)
+	{
+		largest = std::abs(values[i]) > std::abs(values[largest]) ? i : largest;
+	}
+
+	// q and -q are the same rotation so the dropped component is kept positive
+	const double sign = values[largest] < 0 ? -1.0 : 1.0;
+	constexpr double scale = ((1 << internal::c_rotationBits) - 1) / (2.0 * internal::c_rotationRange);
+	uint64_t result = static_cast<uint64_t>(largest);
+	int shift = 2;
+	for(int i = 0; i < 4; i++)
+	{
+		if(i == largest)
+		{
+			continue;
+		}
+
+		const double value = std::clamp(values[i] * sign, -internal::c_rotationRange, internal::c_rotationRange);
+		result |= static_cast<uint64_t>(std::llround((value + internal::c_rotationRange) * scale)) << shift;
+		shift += internal::c_rotationBits;
+	}
+
+	return result;
+}
+
+/// Returns the unit quaternion packed by pack_rotation
+template <typename Quaternion>
+Quaternion unpack_rotation(uint64_t a_packed)
+{
+	constexpr double scale = (2.0 * internal::c_rotationRange) / ((1 << internal::c_rotationBits) - 1);
+	constexpr uint64_t mask = (uint64_t(1) << internal::c_rotationBits) - 1;
+	const int largest = static_cast<int>(a_packed & 3);
+	double values[4];
+	double sum = 0.0;
+	int shift = 2;
+	for(int i = 0; i < 4; i++)
+	{
+		if(i == largest)
+		{
+			continue;
+		}
+
+		values[i] = static_cast<double>((a_packed >> shift) & mask) * scale - internal::c_rotationRange;
+		sum += values[i] * values[i];
+		shift += internal::c_rotationBits;
+	}
+
+	values[largest] = std::sqrt(std::max(0.0, 1.0 - sum));
+
+	using value_type = decltype(Quaternion{}.x);
+	Quaternion result{};
+	result.x = static_cast<value_type>(values[0]);
+	result.y = static_cast<value_type>(values[1]);
+	result.z = static_cast<value_type>(values[2]);
+	result.w = static_cast<value_type>(values[3]);
+	return result;
+}
+
+} // spatial
+
+#endif  // SPATIAL_QUANTIZE_H
@@ -0,0 +1,571 @@
+
+#ifndef SPATIAL_REGION_STREAMER_H
+#define SPATIAL_REGION_STREAMER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "cold.hpp"
+#include "entity.hpp"
+#include "quadsphere_face.hpp"
+
+namespace spatial
+{
+
+/// Work done by one region_streamer::update
+struct stream_stats
+{
+	size_t loaded{0};
+	size_t unloaded{0};
+	size_t resident_regions{0};
+
+	/// Regions whose blob files could not be read, see region_streamer::failed
+	size_t failed{0};
+};
+
+/// Pages entities in and out of a registry by region. Entities in regions far from
+/// a focus point, usually the position of render::camera::Camera, are written into a
+/// compact blob per region and removed from the registry. When the focus comes close
+/// again the blob is read back and the entities are recreated. Blobs are kept in memory
+/// or written to a directory by a background thread, so the resident entity count and
+/// the memory used only depend on the regions around the focus.
+///
+/// Without a directory every blob stays in memory, only the registry shrinks and
+/// stored_bytes grows with every stored entity. That mode is meant for tests and small
+/// worlds, streaming a large world needs a directory.
+///
+/// Only the listed components are stored, they are copied as bytes. Entities get new
+/// ids when they are restored and entities without the position component never stream
+template <typename Registry, typename... Components>
+class region_streamer
+{
+	static_assert(sizeof...(Components) > 0 && sizeof...(Components) <= 32, "Streamer needs 1 to 32 components");
+	static_assert((std::is_trivially_copyable_v<Components> && ...), "Streamed components are stored as bytes");
+	static_assert((!ecs::has_cold_v<Components> && ...), "Cold data is not streamed");
+
+public:
+	/// @param a_partition regions that are loaded and unloaded as a whole
+	/// @param a_radius radius of the sphere the regions are measured on
+	/// @param a_loadDistance regions closer than this to the focus are loaded
+	/// @param a_unloadDistance regions farther than this are stored, keep it above a_loadDistance so
+	///        regions on the border do not stream every frame
+	/// @param a_directory directory the blobs are written to, empty keeps them in memory
+	region_streamer(face_partition a_partition, double a_radius, double a_loadDistance, double a_unloadDistance,
+		std::filesystem::path a_directory = {})
+		: m_partition{a_partition}
+		, m_loadDistance{a_loadDistance}
+		, m_unloadDistance{std::max(a_loadDistance, a_unloadDistance)}
+		, m_directory{std::move(a_directory)}
+		, m_regions(a_partition.count())
+	{
+		for(size_t i = 0; i < m_regions.size(); i++)
+		{
+			region& current = m_regions[i];
+			if(m_partition.subdivisions() == 0)
+			{
+				current.extent = std::numeric_limits<double>::infinity();
+				continue;
+			}
+
+			current.center = m_partition.direction(i) * a_radius;
+			for(const double corner : {0.0, 1.0})
+			{
+				current.extent = std::max(current.extent, glm::length(m_partition.direction(i, corner, 0.0) * a_radius - current.center));
+				current.extent = std::max(current.extent, glm::length(m_partition.direction(i, corner, 1.0) * a_radius - current.center));
+			}
+		}
+
+		if(!m_directory.empty())
+		{
+			std::filesystem::create_directories(m_directory);
+			m_worker = std::thread([this]() { work(); });
+		}
+	}
+
+	region_streamer(const region_streamer&) = delete;
+	region_streamer& operator=(const region_streamer&) = delete;
+
+	/// Finishes every queued write before returning. Queued and unfinished loads are
+	/// dropped, the files of their regions stay in the directory
+	~region_streamer()
+	{
+		if(m_worker.joinable())
+		{
+			{
+				std::lock_guard lock(m_mutex);
+				std::erase_if(m_jobs, [](const job& a_job) { return a_job.kind == job_kind::read; });
+				m_stop = true;
+			}
+
+			m_wake.notify_all();
+			m_worker.join();
+		}
+	}
+
+	/// Restore regions that finished loading, decide which regions are resident and
+	/// store the entities that are outside of them
+	/// @param r_registry the registry holding the resident entities
+	/// @param a_focus ECEF position the regions are loaded around
+	/// @param a_projection member pointer or function returning the ECEF position of a Position component
+	template <typename Position, typename Projection>
+	stream_stats update(Registry& r_registry, const glm::dvec3& a_focus, const Projection& a_projection)
+	{
+		static_assert(((std::is_same_v<Position, Components>) || ...), "Position must be streamed");
+		stream_stats result;
+		finish_loads(r_registry, result);
+
+		for(size_t i = 0; i < m_regions.size(); i++)
+		{
+			region& current = m_regions[i];
+			const double distance = std::max(0.0, glm::length(a_focus - current.center) - current.extent);
+			if((current.state == region_state::resident || current.state == region_state::failed) && distance > m_unloadDistance)
+			{
+				current.state = region_state::stored;
+			}
+			else if(current.state == region_state::stored && distance < m_loadDistance)
+			{
+				if(current.files == 0)
+				{
+					result.loaded += restore(r_registry, current, {});
+					continue;
+				}
+
+				current.state = region_state::loading;
+				queue({i, 0, current.files, {}, job_kind::read});
+				current.files = 0;
+			}
+		}
+
+		auto& storage = r_registry.template getComponentsOfType<Position>();
+		m_leaving.clear();
+		const auto collect = [this, &a_projection](auto a_begin, auto a_end)
+		{
+			for(auto it = a_begin; it != a_end; ++it)
+			{
+				const size_t index = m_partition(glm::dvec3(std::invoke(a_projection, *it)));
+				if(m_regions[index].state != region_state::resident)
+				{
+					m_leaving.emplace_back(it.owner(), index);
+				}
+			}
+		};
+
+		collect(storage.begin(), storage.end());
+		auto sleeping = storage.sleeping();
+		collect(sleeping.begin(), sleeping.end());
+
+		for(const auto& [entity, index] : m_leaving)
+		{
+			encode(r_registry, entity, m_regions[index].memory);
+			m_regions[index].entities++;
+			r_registry.removeEntity(entity);
+		}
+
+		result.unloaded = m_leaving.size();
+
+		if(!m_directory.empty())
+		{
+			for(size_t i = 0; i < m_regions.size(); i++)
+			{
+				region& current = m_regions[i];
+				if((current.state == region_state::stored || current.state == region_state::failed) && !current.memory.empty())
+				{
+					queue({i, current.files++, 0, std::move(current.memory), job_kind::write});
+					std::vector<std::byte>().swap(current.memory);
+				}
+			}
+		}
+
+		result.resident_regions = static_cast<size_t>(std::count_if(m_regions.begin(), m_regions.end(),
+			[](const region& a_region) { return a_region.state == region_state::resident; }));
+		return result;
+	}
+
+	/// Wait until the background thread finished every queued write and read
+	void wait()
+	{
+		std::unique_lock lock(m_mutex);
+		m_idle.wait(lock, [this]() { return m_jobs.empty() && !m_busy; });
+	}
+
+	/// Returns true if the entities of a region are in the registry
+	[[nodiscard]] bool resident(size_t a_region) const { return m_regions[a_region].state == region_state::resident; }
+
+	/// Returns true if the last load of a region failed. The files of the region are
+	/// kept and it is loaded again once the focus left the region and came back
+	[[nodiscard]] bool failed(size_t a_region) const { return m_regions[a_region].state == region_state::failed; }
+
+	/// Returns the number of entities stored outside of the registry
+	[[nodiscard]] size_t stored_entities() const
+	{
+		size_t result = 0;
+		for(const region& current : m_regions)
+		{
+			result += current.entities;
+		}
+
+		return result;
+	}
+
+	/// Returns the bytes of blobs kept in memory, blobs queued for writing are not included
+	[[nodiscard]] size_t stored_bytes() const
+	{
+		size_t result = 0;
+		for(const region& current : m_regions)
+		{
+			result += current.memory.capacity();
+		}
+
+		return result;
+	}
+
+private:
+	enum class region_state : uint8_t
+	{
+		resident,
+		stored,
+		loading,
+		failed,
+	};
+
+	struct region
+	{
+		glm::dvec3 center{0.0};
+		double extent{0.0};
+		region_state state{region_state::resident};
+
+		/// Entities stored in memory and in files
+		size_t entities{0};
+
+		/// Number of blob files written for the region
+		size_t files{0};
+		std::vector<std::byte> memory;
+	};
+
+	/// Prefix of every stored entity, followed by the bytes of every component in mask
+	struct record_header
+	{
+		uint32_t mask;
+		uint32_t sleeping;
+	};
+
+	enum class job_kind : uint8_t
+	{
+		write,
+		read,
+		remove,
+	};
+
+	/// Blob file to write or blob files to read or remove. Files are removed after
+	/// their entities were restored so no entity is lost if the streamer is destroyed
+	/// while a read is queued
+	struct job
+	{
+		size_t region;
+		size_t file;
+		size_t files;
+		std::vector<std::byte> bytes;
+		job_kind kind;
+	};
+
+	enum class outcome : uint8_t
+	{
+		loaded,
+		read_failed,
+		write_failed,
+	};
+
+	/// Bytes read from files, a read that failed or bytes of a write that failed
+	struct completion
+	{
+		size_t region;
+		size_t files;
+		std::vector<std::byte> bytes;
+		outcome result;
+	};
+
+	face_partition m_partition;
+	double m_loadDistance;
+	double m_unloadDistance;
+	std::filesystem::path m_directory;
+	std::vector<region> m_regions;
+	std::vector<std::pair<ecs::entity, size_t>> m_leaving;
+
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_idle;
+	std::deque<job> m_jobs;
+	std::vector<completion> m_completed;
+	bool m_busy{false};
+	bool m_stop{false};
+
+	static void encode(Registry& r_registry, ecs::entity a_entity, std::vector<std::byte>& r_blob)
+	{
+		const size_t headerOffset = r_blob.size();
+		r_blob.resize(headerOffset + sizeof(record_header));
+		record_header header{0, r_registry.isSleeping(a_entity) ? 1u : 0u};
+		uint32_t bit = 1;
+		([&]()
+		{
+			if(const Components* component = r_registry.template getComponent<Components>(a_entity); component != nullptr)
+			{
+				const auto* bytes = reinterpret_cast<const std::byte*>(component);
+				r_blob.insert(r_blob.end(), bytes, bytes + sizeof(Components));
+				header.mask |= bit;
+			}
+
+			bit <<= 1;
+		}(), ...);
+
+		std::memcpy(r_blob.data() + headerOffset, &header, sizeof(record_header));
+	}
+
+	/// Returns true if a blob holds whole records only, a truncated file ends inside a record
+	static bool complete(std::span<const std::byte> a_blob)
+	{
+		size_t offset = 0;
+		while(offset != a_blob.size())
+		{
+			if(a_blob.size() - offset < sizeof(record_header))
+			{
+				return false;
+			}
+
+			record_header header;
+			std::memcpy(&header, a_blob.data() + offset, sizeof(record_header));
+			offset += sizeof(record_header);
+
+			uint32_t bit = 1;
+			((offset += (header.mask & bit) ? sizeof(Components) : 0, bit <<= 1), ...);
+			if(offset > a_blob.size())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static size_t decode(Registry& r_registry, const std::vector<std::byte>& a_blob)
+	{
+		size_t count = 0;
+		const std::byte* it = a_blob.data();
+		const std::byte* end = it + a_blob.size();
+		while(it != end)
+		{
+			record_header header;
+			std::memcpy(&header, it, sizeof(record_header));
+			it += sizeof(record_header);
+
+			const ecs::entity entity = r_registry.createEntity();
+			uint32_t bit = 1;
+			([&]()
+			{
+				if(header.mask & bit)
+				{
+					alignas(Components) std::byte value[sizeof(Components)];
+					std::memcpy(value, it, sizeof(Components));
+					it += sizeof(Components);
+					r_registry.template addComponent<Components>(entity, *std::launder(reinterpret_cast<Components*>(value)));
+				}
+
+				bit <<= 1;
+			}(), ...);
+
+			if(header.sleeping != 0)
+			{
+				r_registry.sleep(entity);
+			}
+
+			count++;
+		}
+
+		return count;
+	}
+
+	size_t restore(Registry& r_registry, region& r_region, const std::vector<std::byte>& a_loaded)
+	{
+		const size_t result = decode(r_registry, a_loaded) + decode(r_registry, r_region.memory);
+		std::vector<std::byte>().swap(r_region.memory);
+		r_region.entities = 0;
+		r_region.state = region_state::resident;
+		return result;
+	}
+
+	void finish_loads(Registry& r_registry, stream_stats& r_stats)
+	{
+		std::vector<completion> completed;
+		{
+			std::lock_guard lock(m_mutex);
+			completed.swap(m_completed);
+		}
+
+		// Completions arrive in queue order so a failed write is back in memory
+		// before a later read of the same region restores it
+		for(completion& current : completed)
+		{
+			region& target = m_regions[current.region];
+			switch(current.result)
+			{
+			case outcome::loaded:
+				r_stats.loaded += restore(r_registry, target, current.bytes);
+				queue({current.region, 0, current.files, {}, job_kind::remove});
+				break;
+			case outcome::read_failed:
+				// New files of the region are numbered after the kept ones
+				target.files = current.files;
+				target.state = region_state::failed;
+				r_stats.failed++;
+				break;
+			case outcome::write_failed:
+				target.memory.insert(target.memory.end(), current.bytes.begin(), current.bytes.end());
+				break;
+			}
+		}
+	}
+
+	[[nodiscard]] std::filesystem::path file_path(size_t a_region, size_t a_file) const
+	{
+		return m_directory / ("region_" + std::to_string(a_region) + "_" + std::to_string(a_file) + ".bin");
+	}
+
+	void queue(job a_job)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.push_back(std::move(a_job));
+		}
+
+		m_wake.notify_one();
+	}
+
+	void work()
+	{
+		while(true)
+		{
+			job current;
+			{
+				std::unique_lock lock(m_mutex);
+				m_wake.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+				if(m_jobs.empty())
+				{
+					return;
+				}
+
+				current = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				m_busy = true;
+			}
+
+			completion done{current.region, current.files, {}, outcome::loaded};
+			switch(current.kind)
+			{
+			case job_kind::write:
+				if(!write_file(file_path(current.region, current.file), current.bytes))
+				{
+					done.bytes = std::move(current.bytes);
+					done.result = outcome::write_failed;
+				}
+				break;
+			case job_kind::read:
+				if(!read_files(current.region, current.files, done.bytes))
+				{
+					std::vector<std::byte>().swap(done.bytes);
+					done.result = outcome::read_failed;
+				}
+				break;
+			case job_kind::remove:
+				for(size_t i = 0; i < current.files; i++)
+				{
+					std::error_code error;
+					std::filesystem::remove(file_path(current.region, i), error);
+				}
+				break;
+			}
+
+			{
+				std::lock_guard lock(m_mutex);
+				if(current.kind == job_kind::read || done.result == outcome::write_failed)
+				{
+					m_completed.push_back(std::move(done));
+				}
+
+				m_busy = false;
+			}
+
+			m_idle.notify_all();
+		}
+	}
+
+	/// Write a blob file, a file that could not be written completely is removed
+	static bool write_file(const std::filesystem::path& a_path, const std::vector<std::byte>& a_bytes)
+	{
+		std::ofstream file(a_path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(a_bytes.data()), static_cast<std::streamsize>(a_bytes.size()));
+		file.close();
+		if(!file)
+		{
+			std::error_code error;
+			std::filesystem::remove(a_path, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Append the blob files of a region, the files are not removed
+	/// @return false if a file could not be read completely
+	bool read_files(size_t a_region, size_t a_files, std::vector<std::byte>& r_bytes) const
+	{
+		// Files of failed writes are missing, their bytes went back to memory
+		for(size_t i = 0; i < a_files; i++)
+		{
+			std::ifstream file(file_path(a_region, i), std::ios::binary | std::ios::ate);
+			if(!file)
+			{
+				continue;
+			}
+
+			const std::streamsize size = file.tellg();
+			if(size < 0)
+			{
+				return false;
+			}
+
+			const size_t offset = r_bytes.size();
+			r_bytes.resize(offset + static_cast<size_t>(size));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(r_bytes.data() + offset), size);
+			if(file.gcount() != size || !complete(std::span<const std::byte>(r_bytes).subspan(offset)))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_REGION_STREAMER_H
@@ -0,0 +1,238 @@
+
+#ifndef SPATIAL_SHARDED_WORLD_H
+#define SPATIAL_SHARDED_WORLD_H
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "entity.hpp"
+#include "parallel.hpp"
+#include "quadsphere_face.hpp"
+
+namespace spatial
+{
+
+/// Entity of a sharded world, the id stays the same when the entity moves between shards
+struct world_entity
+{
+	static constexpr size_t invalid{std::numeric_limits<size_t>::max()};
+
+	size_t id{invalid};
+};
+
+/// World split into one registry per region of a face_partition. Systems run on
+/// every shard in parallel and only touch their own shard, changes to entities of
+/// other shards are deferred. At the end of a frame entities that left their region
+/// migrate to the shard of their new region and the deferred changes are applied
+template <typename Registry>
+class sharded_world
+{
+public:
+	/// Shard and local entity of a world entity
+	struct location
+	{
+		size_t shard;
+		ecs::entity entity;
+	};
+
+	explicit sharded_world(face_partition a_partition)
+		: m_partition{a_partition}
+		, m_globals(a_partition.count())
+		, m_migrations(a_partition.count())
+		, m_commands(a_partition.count())
+	{
+		m_shards.reserve(a_partition.count());
+		for(size_t i = 0; i < a_partition.count(); i++)
+		{
+			m_shards.push_back(std::make_unique<Registry>());
+		}
+	}
+
+	/// Returns the number of shards
+	[[nodiscard]] size_t shard_count() const { return m_shards.size(); }
+
+	/// Returns the registry of a shard
+	[[nodiscard]] Registry& shard(size_t a_shard) { return *m_shards[a_shard]; }
+
+	/// Returns the partition deciding which shard owns a position
+	[[nodiscard]] const face_partition& partition() const { return m_partition; }
+
+	/// Returns the number of entities in all shards
+	[[nodiscard]] size_t size() const { return m_locations.size() - m_removed; }
+
+	/// Create an entity in the shard owning a position
+	/// @param a_position ECEF position of the entity
+	/// @return the world entity and its entity inside the shard
+	std::pair<world_entity, ecs::entity> create(const glm::dvec3& a_position)
+	{
+		const size_t shard = m_partition(a_position);
+		const ecs::entity local = m_shards[shard]->createEntity();
+		const world_entity result{m_locations.size()};
+		m_locations.push_back({shard, local});
+		link(shard, local, result);
+		return {result, local};
+	}
+
+	/// Returns where an entity lives or nullptr if it was removed
+	[[nodiscard]] const location* locate(world_entity a_entity) const
+	{
+		return a_entity.id < m_locations.size() && m_locations[a_entity.id].entity.id() != ecs::entity::invalid
+			? &m_locations[a_entity.id] : nullptr;
+	}
+
+	/// Returns the world entity of an entity inside a shard
+	[[nodiscard]] world_entity global(size_t a_shard, ecs::entity a_entity) const
+	{
+		const auto& globals = m_globals[a_shard];
+		return a_entity.id() < globals.size() ? world_entity{globals[a_entity.id()]} : world_entity{};
+	}
+
+	/// Remove an entity from its shard. Must not be called while systems run, use defer
+	void remove(world_entity a_entity)
+	{
+		const location* current = locate(a_entity);
+		if(current == nullptr)
+		{
+			return;
+		}
+
+		m_shards[current->shard]->removeEntity(current->entity);
+		unlink(current->shard, current->entity);
+		m_locations[a_entity.id].entity = ecs::entity{};
+		m_removed++;
+	}
+
+	/// Run a function on every shard in parallel. Parallel queries the function
+	/// runs on the same pool run inline on the thread of its shard
+	/// @param a_func function called with (Registry&, size_t shard), it may only modify its own shard
+	/// @param a_pool the threads running the shards
+	template <typename Func>
+	void each_shard(Func&& a_func, ecs::thread_pool& a_pool = ecs::thread_pool::shared())
+	{
+		a_pool.run(m_shards.size(), [this, &a_func](size_t a_shard) { a_func(*m_shards[a_shard], a_shard); });
+	}
+
+	/// Queue a change to an entity that may live in another shard. Commands run in
+	/// end_frame after the migrations, ordered by the shard that queued them
+	/// @param a_fromShard the shard whose system queues the command, every shard has its own queue
+	/// @param a_command function called with (Registry&, ecs::entity) of the shard owning the entity
+	void defer(size_t a_fromShard, world_entity a_target, std::function<void(Registry&, ecs::entity)> a_command)
+	{
+		m_commands[a_fromShard].push_back({a_target, std::move(a_command)});
+	}
+
+	/// Finish a frame. Every shard looks for active and sleeping entities whose position
+	/// left its region in parallel, the entities are then moved to their new shard in
+	/// one batch in shard order and the deferred commands are applied
+	/// @param a_projection member pointer or function returning the ECEF position of a component
+	/// @param a_pool the threads checking the shards
+	/// @return the number of entities that changed shard
+	template <typename Component, typename Projection>
+	size_t end_frame(const Projection& a_projection, ecs::thread_pool& a_pool = ecs::thread_pool::shared())
+	{
+		a_pool.run(m_shards.size(), [this, &a_projection](size_t a_shard)
+		{
+			auto& migrations = m_migrations[a_shard];
+			migrations.clear();
+			const auto find = [&](auto a_first, auto a_last)
+			{
+				for(; a_first != a_last; ++a_first)
+				{
+					const size_t target = m_partition(glm::dvec3(std::invoke(a_projection, *a_first)));
+					if(target != a_shard)
+					{
+						migrations.push_back({a_first.owner(), target});
+					}
+				}
+			};
+
+			auto& storage = m_shards[a_shard]->template getComponentsOfType<Component>();
+			find(storage.begin(), storage.end());
+			auto sleeping = storage.sleeping();
+			find(sleeping.begin(), sleeping.end());
+		});
+
+		size_t moved = 0;
+		for(size_t shard = 0; shard < m_shards.size(); shard++)
+		{
+			for(const auto& [local, target] : m_migrations[shard])
+			{
+				const world_entity entity = global(shard, local);
+				const ecs::entity result = m_shards[shard]->moveEntity(local, *m_shards[target]);
+				unlink(shard, local);
+				m_locations[entity.id] = {target, result};
+				link(target, result, entity);
+				moved++;
+			}
+		}
+
+		for(auto& commands : m_commands)
+		{
+			for(auto& [target, command] : commands)
+			{
+				if(const location* current = locate(target); current != nullptr)
+				{
+					command(*m_shards[current->shard], current->entity);
+				}
+			}
+
+			commands.clear();
+		}
+
+		return moved;
+	}
+
+private:
+	struct migration
+	{
+		ecs::entity entity;
+		size_t target;
+	};
+
+	struct command
+	{
+		world_entity target;
+		std::function<void(Registry&, ecs::entity)> func;
+	};
+
+	face_partition m_partition;
+	std::vector<std::unique_ptr<Registry>> m_shards;
+	std::vector<location> m_locations;
+	size_t m_removed{0};
+
+	/// World entity ids of the entities of every shard, indexed by the local entity id
+	std::vector<std::vector<size_t>> m_globals;
+	std::vector<std::vector<migration>> m_migrations;
+	std::vector<std::vector<command>> m_commands;
+
+	void link(size_t a_shard, ecs::entity a_local, world_entity a_entity)
+	{
+		auto& globals = m_globals[a_shard];
+		if(a_local.id() >= globals.size())
+		{
+			globals.resize(a_local.id() + 1, world_entity::invalid);
+		}
+
+		globals[a_local.id()] = a_entity.id;
+	}
+
+	/// Forget the world entity of a local entity that was removed or moved away
+	void unlink(size_t a_shard, ecs::entity a_local)
+	{
+		auto& globals = m_globals[a_shard];
+		if(a_local.id() < globals.size())
+		{
+			globals[a_local.id()] = world_entity::invalid;
+		}
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_SHARDED_WORLD_H
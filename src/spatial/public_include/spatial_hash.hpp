@@ -0,0 +1,496 @@
+
+#ifndef SPATIAL_SPATIAL_HASH_H
+#define SPATIAL_SPATIAL_HASH_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "entity.hpp"
+#include "entity_set.hpp"
+#include "parallel.hpp"
+
+namespace spatial
+{
+
+/// Hashed uniform grid over ECEF positions in meters. Every entity lives in the
+/// cell containing its position, cells are found through an open addressing
+/// table so only occupied cells use memory. Moving an entity inside its cell
+/// only writes the position, crossing a cell border moves one index.
+///
+/// Cell coordinates have 21 bits per axis, so distinct cells reach 2^20 cell sizes
+/// from the center of the earth, see extent. Positions farther out share the border
+/// cells, queries there still return correct results but test more candidates.
+/// Cells must be at least 6.1 m to cover the surface of the earth and 40.2 m to
+/// reach the geostationary orbit
+class spatial_hash
+{
+	/// Bits used by each cell coordinate inside a cell key
+	static constexpr int c_cellBits = 21;
+	static constexpr int64_t c_cellBias = int64_t(1) << (c_cellBits - 1);
+
+	/// Empty cells are reclaimed once there are this many and they are more than half of all cells
+	static constexpr size_t c_compactThreshold = 1024;
+
+	/// Number of batch queries evaluated by one task
+	static constexpr size_t c_batchSize = 64;
+
+public:
+	/// @param a_cellSize edge length of a grid cell in meters, pick it close to the common query radius
+	explicit spatial_hash(double a_cellSize)
+		: m_cellSize{a_cellSize}
+		, m_inverseCellSize{1.0 / a_cellSize}
+	{}
+
+	/// Returns the edge length of a grid cell in meters
+	[[nodiscard]] double cell_size() const { return m_cellSize; }
+
+	/// Returns the distance from the center of the earth along each axis that is
+	/// covered by distinct cells
+	[[nodiscard]] double extent() const { return m_cellSize * static_cast<double>(c_cellBias); }
+
+	/// Returns the number of indexed entities
+	[[nodiscard]] size_t size() const { return m_entities.size(); }
+	[[nodiscard]] bool empty() const { return m_entities.empty(); }
+
+	/// Returns the number of occupied cells
+	[[nodiscard]] size_t cell_count() const { return m_cells.size() - m_emptyCells; }
+
+	/// Returns true if the entity is indexed
+	[[nodiscard]] bool contains(ecs::entity a_entity) const { return m_entities.contains(a_entity); }
+
+	/// Returns the indexed position of an entity or nullptr if the entity is not indexed
+	[[nodiscard]] const glm::dvec3* position(ecs::entity a_entity) const
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		return index < m_positions.size() ? &m_positions[index] : nullptr;
+	}
+
+	/// Insert an entity or move it to a new position
+	/// @param a_position ECEF position in meters
+	void update(ecs::entity a_entity, const glm::dvec3& a_position)
+	{
+		const uint64_t key = key_of(a_position);
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			m_entities.insert(a_entity);
+			m_positions.push_back(a_position);
+			m_entryKeys.push_back(key);
+			m_entryCells.push_back(0);
+			m_entrySlots.push_back(0);
+			m_stamps.push_back(m_generation);
+			attach(index, key);
+			return;
+		}
+
+		m_positions[index] = a_position;
+		m_stamps[index] = m_generation;
+		if(m_entryKeys[index] != key)
+		{
+			m_entryKeys[index] = key;
+			detach(index);
+			attach(index, key);
+			compact_if_sparse();
+		}
+	}
+
+	/// Remove an entity from the index
+	/// @return false if the entity was not indexed
+	bool erase(ecs::entity a_entity)
+	{
+		const size_t index = m_entities.index_of(a_entity);
+		if(index == m_entities.size())
+		{
+			return false;
+		}
+
+		erase_index(index);
+		compact_if_sparse();
+		return true;
+	}
+
+	/// Remove every entity, keeps the allocated memory of the entity arrays
+	void clear()
+	{
+		m_entities.clear();
+		m_positions.clear();
+		m_entryKeys.clear();
+		m_entryCells.clear();
+		m_entrySlots.clear();
+		m_stamps.clear();
+		m_cells.clear();
+		m_emptyCells = 0;
+		std::fill(m_table.begin(), m_table.end(), table_slot{});
+	}
+
+	/// Index the positions of every entity with a component and remove all other
+	/// entities. Sleeping components are indexed as well
+	/// @param a_registry the registry owning the components
+	/// @param a_projection member pointer or function returning the ECEF position of a component
+	template <typename Component, typename Registry, typename Projection>
+	void synchronize(Registry& a_registry, const Projection& a_projection)
+	{
+		m_generation++;
+		auto& storage = a_registry.template getComponentsOfType<Component>();
+		const auto index = [this, &a_projection](auto a_first, auto a_last)
+		{
+			for(; a_first != a_last; ++a_first)
+			{
+				update(a_first.owner(), glm::dvec3(std::invoke(a_projection, *a_first)));
+			}
+		};
+
+		index(storage.begin(), storage.end());
+		auto sleeping = storage.sleeping();
+		index(sleeping.begin(), sleeping.end());
+
+		for(size_t i = m_entities.size(); i-- > 0;)
+		{
+			if(m_stamps[i] != m_generation)
+			{
+				erase_index(i);
+			}
+		}
+
+		compact_if_sparse();
+	}
+
+	/// Call a function for every entity within a distance of a point
+	/// @param a_center ECEF position in meters
+	/// @param a_radius distance in meters
+	/// @param a_func function called with (ecs::entity, const glm::dvec3& position)
+	template <typename Func>
+	void for_each_in_radius(const glm::dvec3& a_center, double a_radius, Func&& a_func) const
+	{
+		const double radiusSquared = a_radius * a_radius;
+		const glm::dvec3 extent(a_radius);
+		for_each_cell(a_center - extent, a_center + extent, [&](const cell& a_cell)
+		{
+			for(uint32_t entry : a_cell.entries)
+			{
+				const glm::dvec3 offset = m_positions[entry] - a_center;
+				if(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= radiusSquared)
+				{
+					a_func(m_entities[entry], m_positions[entry]);
+				}
+			}
+		});
+	}
+
+	/// Call a function for every entity inside an axis aligned box
+	/// @param a_min lowest ECEF corner in meters
+	/// @param a_max highest ECEF corner in meters
+	/// @param a_func function called with (ecs::entity, const glm::dvec3& position)
+	template <typename Func>
+	void for_each_in_box(const glm::dvec3& a_min, const glm::dvec3& a_max, Func&& a_func) const
+	{
+		for_each_cell(a_min, a_max, [&](const cell& a_cell)
+		{
+			for(uint32_t entry : a_cell.entries)
+			{
+				const glm::dvec3& position = m_positions[entry];
+				if((position.x >= a_min.x) & (position.x <= a_max.x)
+				 & (position.y >= a_min.y) & (position.y <= a_max.y)
+				 & (position.z >= a_min.z) & (position.z <= a_max.z))
+				{
+					a_func(m_entities[entry], position);
+				}
+			}
+		});
+	}
+
+	/// Find every entity within a distance of a point
+	/// @param r_result the entities are appended to this list
+	void query_radius(const glm::dvec3& a_center, double a_radius, std::vector<ecs::entity>& r_result) const
+	{
+		for_each_in_radius(a_center, a_radius, [&r_result](ecs::entity a_entity, const glm::dvec3&) { r_result.push_back(a_entity); });
+	}
+
+	/// Find every entity inside an axis aligned box
+	/// @param r_result the entities are appended to this list
+	void query_box(const glm::dvec3& a_min, const glm::dvec3& a_max, std::vector<ecs::entity>& r_result) const
+	{
+		for_each_in_box(a_min, a_max, [&r_result](ecs::entity a_entity, const glm::dvec3&) { r_result.push_back(a_entity); });
+	}
+
+	/// Find the entities within a distance of many points in parallel. The index
+	/// must not be modified while the queries run
+	/// @param a_centers ECEF positions in meters
+	/// @param r_results resized to one list per center, the lists are cleared and reused
+	/// @param a_pool the threads evaluating the queries
+	void query_radius(std::span<const glm::dvec3> a_centers, double a_radius, std::vector<std::vector<ecs::entity>>& r_results,
+		ecs::thread_pool& a_pool = ecs::thread_pool::shared()) const
+	{
+		r_results.resize(a_centers.size());
+		const size_t batches = (a_centers.size() + c_batchSize - 1) / c_batchSize;
+		a_pool.run(batches, [&](size_t a_batch)
+		{
+			const size_t last = std::min(a_centers.size(), (a_batch + 1) * c_batchSize);
+			for(size_t i = a_batch * c_batchSize; i < last; i++)
+			{
+				r_results[i].clear();
+				query_radius(a_centers[i], a_radius, r_results[i]);
+			}
+		});
+	}
+
+	/// Returns the number of bytes reserved by the index
+	[[nodiscard]] size_t bytes_reserved() const
+	{
+		size_t entries = 0;
+		for(const auto& value : m_cells)
+		{
+			entries += value.entries.capacity() * sizeof(uint32_t);
+		}
+
+		return m_entities.bytes_reserved()
+			+ m_positions.capacity() * sizeof(glm::dvec3)
+			+ m_entryKeys.capacity() * sizeof(uint64_t)
+			+ (m_entryCells.capacity() + m_entrySlots.capacity() + m_stamps.capacity()) * sizeof(uint32_t)
+			+ m_cells.capacity() * sizeof(cell) + entries
+			+ m_table.capacity() * sizeof(table_slot);
+	}
+
+private:
+	struct cell
+	{
+		uint64_t key;
+		std::vector<uint32_t> entries;
+	};
+
+	/// Slot of the cell table, cell is the index into m_cells plus one and zero for empty slots
+	struct table_slot
+	{
+		uint64_t key{0};
+		uint32_t cell{0};
+	};
+
+	double m_cellSize;
+	double m_inverseCellSize;
+
+	// Per entity data, index i belongs to m_entities[i]
+	ecs::entity_set m_entities;
+	std::vector<glm::dvec3> m_positions;
+	std::vector<uint64_t> m_entryKeys;
+	std::vector<uint32_t> m_entryCells;
+	std::vector<uint32_t> m_entrySlots;
+	std::vector<uint32_t> m_stamps;
+	uint32_t m_generation{0};
+
+	std::vector<cell> m_cells;
+	std::vector<table_slot> m_table;
+	size_t m_emptyCells{0};
+
+	[[nodiscard]] int64_t coordinate(double a_value) const
+	{
+		// Clamped before the conversion, positions far outside the extent do not fit an int64_t
+		const double bias = static_cast<double>(c_cellBias);
+		return static_cast<int64_t>(std::clamp(std::floor(a_value * m_inverseCellSize), -bias, bias - 1.0));
+	}
+
+	[[nodiscard]] static uint64_t pack(int64_t a_x, int64_t a_y, int64_t a_z)
+	{
+		return static_cast<uint64_t>(a_x + c_cellBias)
+			| (static_cast<uint64_t>(a_y + c_cellBias) << c_cellBits)
+			| (static_cast<uint64_t>(a_z + c_cellBias) << (c_cellBits * 2));
+	}
+
+	[[nodiscard]] uint64_t key_of(const glm::dvec3& a_position) const
+	{
+		return pack(coordinate(a_position.x), coordinate(a_position.y), coordinate(a_position.z));
+	}
+
+	[[nodiscard]] static uint64_t hash(uint64_t a_key)
+	{
+		a_key ^= a_key >> 33;
+		a_key *= 0xff51afd7ed558ccdull;
+		a_key ^= a_key >> 33;
+		a_key *= 0xc4ceb9fe1a85ec53ull;
+		a_key ^= a_key >> 33;
+		return a_key;
+	}
+
+	/// Returns the index of a cell or m_cells.size() if the cell does not exist
+	[[nodiscard]] size_t find_cell(uint64_t a_key) const
+	{
+		if(m_table.empty())
+		{
+			return m_cells.size();
+		}
+
+		const size_t mask = m_table.size() - 1;
+		for(size_t i = hash(a_key) & mask; m_table[i].cell != 0; i = (i + 1) & mask)
+		{
+			if(m_table[i].key == a_key)
+			{
+				return m_table[i].cell - 1;
+			}
+		}
+
+		return m_cells.size();
+	}
+
+	void insert_slot(uint64_t a_key, uint32_t a_cell)
+	{
+		const size_t mask = m_table.size() - 1;
+		size_t i = hash(a_key) & mask;
+		while(m_table[i].cell != 0)
+		{
+			i = (i + 1) & mask;
+		}
+
+		m_table[i] = {a_key, a_cell + 1};
+	}
+
+	/// Rebuild the cell table with a number of slots
+	void rehash(size_t a_slots)
+	{
+		m_table.assign(a_slots, table_slot{});
+		for(size_t i = 0; i < m_cells.size(); i++)
+		{
+			insert_slot(m_cells[i].key, static_cast<uint32_t>(i));
+		}
+	}
+
+	size_t find_or_create_cell(uint64_t a_key)
+	{
+		const size_t index = find_cell(a_key);
+		if(index != m_cells.size())
+		{
+			return index;
+		}
+
+		// Keep the table at most half full so probe sequences stay short
+		if((m_cells.size() + 1) * 2 > m_table.size())
+		{
+			rehash(std::max<size_t>(64, m_table.size() * 2));
+		}
+
+		m_cells.push_back(cell{a_key, {}});
+		m_emptyCells++;
+		insert_slot(a_key, static_cast<uint32_t>(index));
+		return index;
+	}
+
+	void attach(size_t a_index, uint64_t a_key)
+	{
+		const size_t index = find_or_create_cell(a_key);
+		auto& entries = m_cells[index].entries;
+		m_emptyCells -= entries.empty();
+		m_entryCells[a_index] = static_cast<uint32_t>(index);
+		m_entrySlots[a_index] = static_cast<uint32_t>(entries.size());
+		entries.push_back(static_cast<uint32_t>(a_index));
+	}
+
+	/// Remove an entry from its cell, empty cells are kept until the next compaction
+	void detach(size_t a_index)
+	{
+		auto& entries = m_cells[m_entryCells[a_index]].entries;
+		const uint32_t slot = m_entrySlots[a_index];
+		entries[slot] = entries.back();
+		m_entrySlots[entries[slot]] = slot;
+		entries.pop_back();
+		m_emptyCells += entries.empty();
+	}
+
+	/// Remove an entry, the last entry is moved into the gap like the entity set does
+	void erase_index(size_t a_index)
+	{
+		detach(a_index);
+		m_entities.erase(m_entities[a_index]);
+
+		const size_t last = m_positions.size() - 1;
+		if(a_index != last)
+		{
+			m_positions[a_index] = m_positions[last];
+			m_entryKeys[a_index] = m_entryKeys[last];
+			m_entryCells[a_index] = m_entryCells[last];
+			m_entrySlots[a_index] = m_entrySlots[last];
+			m_stamps[a_index] = m_stamps[last];
+			m_cells[m_entryCells[a_index]].entries[m_entrySlots[a_index]] = static_cast<uint32_t>(a_index);
+		}
+
+		m_positions.pop_back();
+		m_entryKeys.pop_back();
+		m_entryCells.pop_back();
+		m_entrySlots.pop_back();
+		m_stamps.pop_back();
+	}
+
+	/// Drop the empty cells once they dominate the table
+	void compact_if_sparse()
+	{
+		if(m_emptyCells < c_compactThreshold || m_emptyCells * 2 < m_cells.size())
+		{
+			return;
+		}
+
+		std::erase_if(m_cells, [](const cell& a_cell) { return a_cell.entries.empty(); });
+		for(size_t i = 0; i < m_cells.size(); i++)
+		{
+			for(uint32_t entry : m_cells[i].entries)
+			{
+				m_entryCells[entry] = static_cast<uint32_t>(i);
+			}
+		}
+
+		m_emptyCells = 0;
+		rehash(std::max<size_t>(64, std::bit_ceil(m_cells.size() * 2)));
+	}
+
+	/// Call a function for every occupied cell overlapping a box
+	template <typename Func>
+	void for_each_cell(const glm::dvec3& a_min, const glm::dvec3& a_max, const Func& a_func) const
+	{
+		const int64_t minX = coordinate(a_min.x), maxX = coordinate(a_max.x);
+		const int64_t minY = coordinate(a_min.y), maxY = coordinate(a_max.y);
+		const int64_t minZ = coordinate(a_min.z), maxZ = coordinate(a_max.z);
+		const uint64_t covered = static_cast<uint64_t>(maxX - minX + 1)
+			* static_cast<uint64_t>(maxY - minY + 1)
+			* static_cast<uint64_t>(maxZ - minZ + 1);
+
+		// Large boxes cover more cells than exist, test the existing cells instead
+		if(covered > m_cells.size())
+		{
+			const uint64_t mask = (uint64_t(1) << c_cellBits) - 1;
+			for(const auto& value : m_cells)
+			{
+				const int64_t x = static_cast<int64_t>(value.key & mask) - c_cellBias;
+				const int64_t y = static_cast<int64_t>((value.key >> c_cellBits) & mask) - c_cellBias;
+				const int64_t z = static_cast<int64_t>(value.key >> (c_cellBits * 2)) - c_cellBias;
+				if(x >= minX && x <= maxX && y >= minY && y <= maxY && z >= minZ && z <= maxZ)
+				{
+					a_func(value);
+				}
+			}
+
+			return;
+		}
+
+		for(int64_t z = minZ; z <= maxZ; z++)
+		{
+			for(int64_t y = minY; y <= maxY; y++)
+			{
+				for(int64_t x = minX; x <= maxX; x++)
+				{
+					const size_t index = find_cell(pack(x, y, z));
+					if(index != m_cells.size())
+					{
+						a_func(m_cells[index]);
+					}
+				}
+			}
+		}
+	}
+};
+
+} // spatial
+
+#endif  // SPATIAL_SPATIAL_HASH_H
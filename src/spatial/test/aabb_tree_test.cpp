@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "aabb_tree.hpp"
+#include "registry.hpp"
+
+struct body
+{
+	glm::dvec3 position;
+	double radius;
+
+	spatial::aabb bounds() const { return spatial::aabb::around(position, radius); }
+};
+
+using test_registry = ecs::registry<
+	ecs::component<body, 1024>>;
+
+// Nearest hit of a ray against the bounds of every body
+static std::optional<spatial::ray_hit> brute_force_raycast(test_registry& a_registry, const spatial::ray& a_ray)
+{
+	std::optional<spatial::ray_hit> result;
+	a_registry.getComponentsOfType<body>().each([&](ecs::entity a_entity, body& a_body)
+	{
+		const spatial::aabb box = a_body.bounds();
+		double enter = 0.0;
+		double exit = a_ray.max_distance;
+		for(int axis = 0; axis < 3; axis++)
+		{
+			const double first = (box.min[axis] - a_ray.origin[axis]) / a_ray.direction[axis];
+			const double second = (box.max[axis] - a_ray.origin[axis]) / a_ray.direction[axis];
+			enter = std::max(enter, std::min(first, second));
+			exit = std::min(exit, std::max(first, second));
+		}
+
+		if(enter <= exit && (!result.has_value() || enter < result->distance))
+		{
+			result = spatial::ray_hit{a_entity, enter};
+		}
+	});
+
+	return result;
+}
+
+TEST(aabb_tree_test, update_and_erase)
+{
+	test_registry registry;
+	spatial::aabb_tree tree(1.0);
+
+	const ecs::entity a = registry.createEntity();
+	const ecs::entity b = registry.createEntity();
+	EXPECT_TRUE(tree.update(a, spatial::aabb::around(glm::dvec3(0, 0, 0), 1.0)));
+	EXPECT_TRUE(tree.update(b, spatial::aabb::around(glm::dvec3(10, 0, 0), 1.0)));
+	EXPECT_EQ(tree.size(), 2);
+	EXPECT_EQ(tree.height(), 1);
+
+	// Moving inside the margin keeps the leaf, moving further reinserts it
+	EXPECT_FALSE(tree.update(a, spatial::aabb::around(glm::dvec3(0.5, 0, 0), 1.0)));
+	EXPECT_EQ(tree.bounds(a)->min, glm::dvec3(-0.5, -1, -1));
+	EXPECT_TRUE(tree.update(a, spatial::aabb::around(glm::dvec3(5, 0, 0), 1.0)));
+
+	EXPECT_TRUE(tree.erase(a));
+	EXPECT_FALSE(tree.erase(a));
+	EXPECT_EQ(tree.bounds(a), nullptr);
+	EXPECT_EQ(tree.size(), 1);
+	EXPECT_EQ(tree.height(), 0);
+
+	const auto hit = tree.raycast({glm::dvec3(-100, 0, 0), glm::dvec3(1, 0, 0)});
+	ASSERT_TRUE(hit.has_value());
+	EXPECT_EQ(hit->entity.id(), b.id());
+	EXPECT_DOUBLE_EQ(hit->distance, 109.0);
+}
+
+TEST(aabb_tree_test, balanced)
+{
+	test_registry registry;
+	spatial::aabb_tree tree;
+
+	// Sorted insertion degenerates an unbalanced tree into a list
+	for(int i = 0; i < 1024; i++)
+	{
+		tree.update(registry.createEntity(), spatial::aabb::around(glm::dvec3(i * 10.0, 0, 0), 1.0));
+	}
+
+	EXPECT_LE(tree.height(), 20);
+}
+
+TEST(aabb_tree_test, raycast_matches_brute_force)
+{
+	test_registry registry;
+	spatial::aabb_tree tree(5.0);
+	std::mt19937 random(3);
+	std::uniform_real_distribution<double> coordinate(-1000.0, 1000.0);
+	std::uniform_real_distribution<double> size(1.0, 30.0);
+	std::normal_distribution<double> normal;
+
+	for(int i = 0; i < 500; i++)
+	{
+		registry.addComponent<body>(registry.createEntity(), body{glm::dvec3(coordinate(random), coordinate(random), coordinate(random)), size(random)});
+	}
+
+	for(int step = 0; step < 3; step++)
+	{
+		registry.getComponentsOfType<body>().each([&](ecs::entity, body& a_body)
+		{
+			a_body.position += glm::dvec3(normal(random), normal(random), normal(random)) * 4.0;
+		});
+		tree.synchronize<body>(registry, &body::bounds);
+
+		std::vector<spatial::ray> rays;
+		for(int i = 0; i < 100; i++)
+		{
+			const glm::dvec3 direction = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+			rays.push_back({glm::dvec3(coordinate(random), coordinate(random), coordinate(random)), direction, 1500.0});
+		}
+
+		std::vector<std::optional<spatial::ray_hit>> hits;
+		tree.raycast(rays, hits);
+		ASSERT_EQ(hits.size(), rays.size());
+		for(size_t i = 0; i < rays.size(); i++)
+		{
+			const auto expected = brute_force_raycast(registry, rays[i]);
+			const auto hit = tree.raycast(rays[i]);
+			ASSERT_EQ(hit.has_value(), expected.has_value());
+			ASSERT_EQ(hits[i].has_value(), expected.has_value());
+			if(expected.has_value())
+			{
+				EXPECT_DOUBLE_EQ(hit->distance, expected->distance);
+				EXPECT_EQ(hits[i]->entity.id(), hit->entity.id());
+			}
+		}
+	}
+
+	const spatial::aabb box{glm::dvec3(-200, -300, -100), glm::dvec3(250, 100, 400)};
+	size_t expected = 0;
+	registry.getComponentsOfType<body>().each([&](ecs::entity, body& a_body) { expected += box.overlaps(a_body.bounds()); });
+	size_t found = 0;
+	tree.for_each_overlap(box, [&found](ecs::entity) { found++; return true; });
+	EXPECT_EQ(found, expected);
+}
+
+TEST(aabb_tree_test, segment_query)
+{
+	test_registry registry;
+	spatial::aabb_tree tree;
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 5; i++)
+	{
+		entities.push_back(registry.createEntity());
+		tree.update(entities.back(), spatial::aabb::around(glm::dvec3(i * 100.0, 0, 0), 10.0));
+	}
+
+	// Line of sight from the first to the last entity is blocked by the ones in between
+	const auto blocked = [&](const glm::dvec3& a_from, const glm::dvec3& a_to)
+	{
+		return !tree.segment_query(a_from, a_to, [&](ecs::entity a_entity, double)
+		{
+			return a_entity.id() == entities.front().id() || a_entity.id() == entities.back().id();
+		});
+	};
+
+	EXPECT_TRUE(blocked(glm::dvec3(0, 0, 0), glm::dvec3(400, 0, 0)));
+	EXPECT_FALSE(blocked(glm::dvec3(0, 50, 0), glm::dvec3(400, 50, 0)));
+	EXPECT_FALSE(blocked(glm::dvec3(0, 0, 0), glm::dvec3(50, 0, 0)));
+
+	std::vector<double> fractions;
+	tree.segment_query(glm::dvec3(-100, 0, 0), glm::dvec3(300, 0, 0), [&](ecs::entity, double a_fraction)
+	{
+		fractions.push_back(a_fraction);
+		return true;
+	});
+	std::sort(fractions.begin(), fractions.end());
+	ASSERT_EQ(fractions.size(), 4);
+	EXPECT_DOUBLE_EQ(fractions[0], 0.225);
+	EXPECT_DOUBLE_EQ(fractions[3], 0.975);
+}
+
+TEST(aabb_tree_test, synchronize)
+{
+	test_registry registry;
+	spatial::aabb_tree tree(2.0);
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 100; i++)
+	{
+		entities.push_back(registry.createEntity());
+		registry.addComponent<body>(entities.back(), body{glm::dvec3(i * 10.0, 0, 0), 1.0});
+	}
+
+	EXPECT_EQ(tree.synchronize<body>(registry, &body::bounds), 100);
+	EXPECT_EQ(tree.synchronize<body>(registry, &body::bounds), 0);
+
+	// Only entities that leave their enlarged bounds are refit
+	registry.getComponent<body>(entities[3])->position.x += 1.0;
+	registry.getComponent<body>(entities[4])->position.x += 3.0;
+	registry.getComponent<body>(entities[5])->position.y -= 5.0;
+	EXPECT_EQ(tree.synchronize<body>(registry, &body::bounds), 2);
+
+	registry.sleep(entities[10]);
+	registry.removeComponent<body>(entities[20]);
+	registry.removeEntity(entities[30]);
+	EXPECT_EQ(tree.synchronize<body>(registry, &body::bounds), 0);
+	EXPECT_EQ(tree.size(), 98);
+	EXPECT_TRUE(tree.contains(entities[10]));
+	EXPECT_FALSE(tree.contains(entities[20]));
+	EXPECT_FALSE(tree.contains(entities[30]));
+	EXPECT_EQ(tree.bounds(entities[3])->min.x, 30.0);
+
+	const auto hit = tree.raycast({glm::dvec3(195, 0, 0), glm::dvec3(1, 0, 0)});
+	ASSERT_TRUE(hit.has_value());
+	EXPECT_EQ(hit->entity.id(), entities[21].id());
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "registry.hpp"
+#include "lod_scheduler.hpp"
+
+struct unit
+{
+	glm::dvec3 position;
+};
+
+using lod_registry = ecs::registry<
+	ecs::component<unit, 1024>>;
+
+static const std::vector<spatial::lod_tier> c_tiers = {
+	{100.0, 1},
+	{1000.0, 4},
+	{0.0, 8},
+};
+
+static void spawn(lod_registry& r_registry, size_t a_count, double a_distance)
+{
+	for(size_t i = 0; i < a_count; i++)
+	{
+		r_registry.addComponent<unit>(r_registry.createEntity(), unit{glm::dvec3(a_distance, static_cast<double>(i) * 0.001, 0)});
+	}
+}
+
+TEST(lod_scheduler_test, periods_and_dt)
+{
+	lod_registry registry;
+	spawn(registry, 10, 50.0);
+	spawn(registry, 40, 500.0);
+	spawn(registry, 80, 5000.0);
+
+	spatial::lod_scheduler scheduler(c_tiers);
+	scheduler.synchronize<unit>(registry, &unit::position);
+	EXPECT_EQ(scheduler.tier_size(0), 10u);
+	EXPECT_EQ(scheduler.tier_size(1), 40u);
+	EXPECT_EQ(scheduler.tier_size(2), 80u);
+
+	struct history
+	{
+		int updates{0};
+		double dt{0.0};
+		double last{0.0};
+	};
+
+	std::map<size_t, history> histories;
+	for(int tick = 0; tick < 16; tick++)
+	{
+		// Buckets are balanced so every tick updates the same number of entities
+		const double dt = 0.01 * (1 + tick % 3);
+		const size_t updated = scheduler.run<unit>(registry, &unit::position, dt, [&](ecs::entity a_entity, unit&, double a_dt)
+		{
+			history& current = histories[a_entity.id()];
+			current.updates++;
+			current.dt += a_dt;
+			current.last = scheduler.time();
+		});
+		EXPECT_EQ(updated, 10u + 40u / 4 + 80u / 8);
+	}
+
+	registry.each<unit>([&](ecs::entity a_entity, unit& a_unit)
+	{
+		const history& current = histories[a_entity.id()];
+		const int expected = a_unit.position.x < 100.0 ? 16 : a_unit.position.x < 1000.0 ? 4 : 2;
+		EXPECT_EQ(current.updates, expected);
+		EXPECT_DOUBLE_EQ(current.dt, current.last);
+	});
+}
+
+TEST(lod_scheduler_test, entities_change_tier)
+{
+	lod_registry registry;
+	spawn(registry, 4, 50.0);
+
+	spatial::lod_scheduler scheduler(c_tiers);
+	scheduler.synchronize<unit>(registry, &unit::position);
+	scheduler.run<unit>(registry, &unit::position, 0.1, [](ecs::entity, unit& r_unit, double) { r_unit.position.x = 5000.0; });
+	EXPECT_EQ(scheduler.tier_size(0), 0u);
+	EXPECT_EQ(scheduler.tier_size(2), 4u);
+
+	// Moving the observer changes the tier on the next update
+	scheduler.set_observer(glm::dvec3(5000.0, 0, 0));
+	for(int tick = 0; tick < 8; tick++)
+	{
+		scheduler.run<unit>(registry, &unit::position, 0.1, [](ecs::entity, unit&, double) {});
+	}
+
+	EXPECT_EQ(scheduler.tier_size(0), 4u);
+	EXPECT_EQ(scheduler.run<unit>(registry, &unit::position, 0.1, [](ecs::entity, unit&, double) {}), 4u);
+
+	// Removed and sleeping entities are not updated
+	const ecs::entity first = registry.getComponentsOfType<unit>().begin().owner();
+	registry.removeEntity(first);
+	registry.sleep(registry.getComponentsOfType<unit>().begin().owner());
+	EXPECT_EQ(scheduler.run<unit>(registry, &unit::position, 0.1, [](ecs::entity, unit&, double) {}), 2u);
+	EXPECT_EQ(scheduler.size(), 3u);
+
+	// Sleeping entities stay scheduled when synchronizing
+	scheduler.synchronize<unit>(registry, &unit::position);
+	EXPECT_EQ(scheduler.size(), 3u);
+	EXPECT_EQ(scheduler.run<unit>(registry, &unit::position, 0.1, [](ecs::entity, unit&, double) {}), 2u);
+}
+
+TEST(lod_scheduler_test, many_tiers)
+{
+	// Tier indices are not limited to a byte
+	std::vector<spatial::lod_tier> tiers;
+	for(int i = 0; i < 300; i++)
+	{
+		tiers.push_back({static_cast<double>(i + 1), 1});
+	}
+
+	lod_registry registry;
+	spawn(registry, 2, 280.5);
+
+	spatial::lod_scheduler scheduler(tiers);
+	scheduler.synchronize<unit>(registry, &unit::position);
+	EXPECT_EQ(scheduler.tier_size(280), 2u);
+	EXPECT_EQ(scheduler.tier_of(registry.getComponentsOfType<unit>().begin().owner()), 280u);
+}
+
+TEST(lod_scheduler_test, far_budget)
+{
+	lod_registry registry;
+	spawn(registry, 1000, 5000.0);
+
+	spatial::lod_scheduler scheduler(c_tiers, 100);
+	scheduler.synchronize<unit>(registry, &unit::position);
+	EXPECT_EQ(scheduler.period(2), 16u);
+
+	std::map<size_t, int> updates;
+	for(int tick = 0; tick < 16; tick++)
+	{
+		const size_t updated = scheduler.run<unit>(registry, &unit::position, 0.1, [&](ecs::entity a_entity, unit&, double) { updates[a_entity.id()]++; });
+		EXPECT_LE(updated, 100u);
+	}
+
+	EXPECT_EQ(updates.size(), 1000u);
+	EXPECT_TRUE(std::all_of(updates.begin(), updates.end(), [](const auto& a_pair) { return a_pair.second == 1; }));
+
+	// The period shrinks back once the tier empties, but not below the configured period
+	std::vector<ecs::entity> entities;
+	registry.each<unit>([&](ecs::entity a_entity, unit&) { entities.push_back(a_entity); });
+	for(size_t i = 0; i < 900; i++)
+	{
+		registry.removeEntity(entities[i]);
+	}
+
+	scheduler.synchronize<unit>(registry, &unit::position);
+	EXPECT_EQ(scheduler.size(), 100u);
+	EXPECT_EQ(scheduler.period(2), 8u);
+}
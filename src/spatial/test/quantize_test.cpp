@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "quantize.hpp"
+
+struct rotation
+{
+	double x, y, z, w;
+};
+
+TEST(quantize_test, position_round_trip)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<double> coordinate(-7'000'000.0, 7'000'000.0);
+	for(int i = 0; i < 1000; i++)
+	{
+		const glm::dvec3 position(coordinate(random), coordinate(random), coordinate(random));
+		const glm::dvec3 restored = spatial::dequantize_position(spatial::quantize_position(position));
+		EXPECT_LE(glm::length(restored - position), spatial::c_positionStep);
+	}
+
+	// Steps are counted from the center so equal positions always quantize equally
+	const auto a = spatial::quantize_position(glm::dvec3(1.004, -1.006, 0.0));
+	EXPECT_EQ(a.x, 100);
+	EXPECT_EQ(a.y, -101);
+	EXPECT_EQ(a.z, 0);
+}
+
+TEST(quantize_test, rotation_round_trip)
+{
+	std::mt19937 random(4);
+	std::normal_distribution<double> normal;
+	for(int i = 0; i < 1000; i++)
+	{
+		rotation value{normal(random), normal(random), normal(random), normal(random)};
+		const double length = std::sqrt(value.x * value.x + value.y * value.y + value.z * value.z + value.w * value.w);
+		value = {value.x / length, value.y / length, value.z / length, value.w / length};
+
+		const uint64_t packed = spatial::pack_rotation(value);
+		EXPECT_LT(packed >> 62, 1u);
+		const rotation restored = spatial::unpack_rotation<rotation>(packed);
+
+		// q and -q are the same rotation
+		const double dot = value.x * restored.x + value.y * restored.y + value.z * restored.z + value.w * restored.w;
+		EXPECT_GT(std::abs(dot), 1.0 - 1e-9);
+	}
+}
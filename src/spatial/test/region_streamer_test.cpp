@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "registry.hpp"
+#include "region_streamer.hpp"
+
+struct location
+{
+	glm::dvec3 position;
+};
+
+struct cargo
+{
+	int value;
+};
+
+using stream_registry = ecs::registry<
+	ecs::component<location, 1024>,
+	ecs::component<cargo, 1024>>;
+
+using stream_record = std::tuple<double, double, double, int, bool>;
+
+static std::vector<stream_record> records(stream_registry& a_registry)
+{
+	std::vector<stream_record> result;
+	const auto add = [&](auto a_begin, auto a_end)
+	{
+		for(auto it = a_begin; it != a_end; ++it)
+		{
+			const cargo* load = a_registry.getComponent<cargo>(it.owner());
+			result.emplace_back(it->position.x, it->position.y, it->position.z, load != nullptr ? load->value : -1, a_registry.isSleeping(it.owner()));
+		}
+	};
+
+	auto& storage = a_registry.getComponentsOfType<location>();
+	add(storage.begin(), storage.end());
+	auto sleeping = storage.sleeping();
+	add(sleeping.begin(), sleeping.end());
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static void populate(stream_registry& r_registry)
+{
+	std::mt19937 random(5);
+	std::normal_distribution<double> normal;
+	for(int i = 0; i < 600; i++)
+	{
+		const ecs::entity entity = r_registry.createEntity();
+		r_registry.addComponent<location>(entity, location{glm::normalize(glm::dvec3(normal(random), normal(random), normal(random))) * 1000.0});
+		if(i % 3 == 0)
+		{
+			r_registry.addComponent<cargo>(entity, cargo{i});
+		}
+
+		if(i % 5 == 0)
+		{
+			r_registry.sleep(entity);
+		}
+	}
+}
+
+static size_t count_on_face(const std::vector<stream_record>& a_records, int a_face)
+{
+	return static_cast<size_t>(std::count_if(a_records.begin(), a_records.end(), [a_face](const stream_record& a_record)
+	{
+		return spatial::face_of(glm::dvec3(std::get<0>(a_record), std::get<1>(a_record), std::get<2>(a_record))) == a_face;
+	}));
+}
+
+// Regions of a unit cube face on a sphere of radius 1000 reach about 920 from their center
+using test_streamer = spatial::region_streamer<stream_registry, location, cargo>;
+constexpr const double c_loadDistance = 100.0;
+constexpr const double c_unloadDistance = 500.0;
+
+TEST(region_streamer_test, streams_in_memory)
+{
+	stream_registry registry;
+	populate(registry);
+	const auto initial = records(registry);
+
+	test_streamer streamer(spatial::face_partition(1), 1000.0, c_loadDistance, c_unloadDistance);
+	auto stats = streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position);
+	EXPECT_EQ(stats.resident_regions, 1u);
+	EXPECT_TRUE(streamer.resident(0));
+	EXPECT_EQ(registry.getComponentsOfType<location>().total_size(), count_on_face(initial, 0));
+	EXPECT_EQ(stats.unloaded, initial.size() - count_on_face(initial, 0));
+	EXPECT_EQ(streamer.stored_entities(), stats.unloaded);
+	EXPECT_GT(streamer.stored_bytes(), 0u);
+
+	stats = streamer.update<location>(registry, glm::dvec3(-1100, 0, 0), &location::position);
+	EXPECT_TRUE(streamer.resident(2));
+	EXPECT_FALSE(streamer.resident(0));
+	EXPECT_EQ(stats.loaded, count_on_face(initial, 2));
+	EXPECT_EQ(stats.unloaded, count_on_face(initial, 0));
+
+	// Every region is close to the center of the sphere
+	stats = streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+	EXPECT_EQ(stats.resident_regions, 6u);
+	EXPECT_EQ(streamer.stored_entities(), 0u);
+	EXPECT_EQ(streamer.stored_bytes(), 0u);
+	EXPECT_EQ(records(registry), initial);
+}
+
+TEST(region_streamer_test, moving_entity_is_stored)
+{
+	stream_registry registry;
+	test_streamer streamer(spatial::face_partition(1), 1000.0, c_loadDistance, c_unloadDistance);
+	const ecs::entity entity = registry.createEntity();
+	registry.addComponent<location>(entity, location{glm::dvec3(1000, 0, 0)});
+	registry.addComponent<cargo>(entity, cargo{7});
+
+	EXPECT_EQ(streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position).unloaded, 0u);
+
+	// Crossing into a stored region stores the entity
+	registry.getComponent<location>(entity)->position = glm::dvec3(0, 0, 1000);
+	EXPECT_EQ(streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position).unloaded, 1u);
+	EXPECT_FALSE(registry.isValid(entity));
+
+	EXPECT_EQ(streamer.update<location>(registry, glm::dvec3(0, 0, 1100), &location::position).loaded, 1u);
+	EXPECT_EQ(registry.getComponentsOfType<cargo>().size(), 1u);
+	EXPECT_EQ(registry.getComponentsOfType<cargo>().begin()->value, 7);
+}
+
+TEST(region_streamer_test, streams_through_files)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "region_streamer_test";
+	std::filesystem::remove_all(directory);
+
+	stream_registry registry;
+	populate(registry);
+	const auto initial = records(registry);
+	{
+		// Cells of a face split in four reach about 610 from their center
+		test_streamer streamer(spatial::face_partition(2), 1000.0, 650.0, 1000.0, directory);
+		streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position);
+		EXPECT_EQ(streamer.stored_bytes(), 0u);
+		streamer.wait();
+		EXPECT_FALSE(std::filesystem::is_empty(directory));
+
+		// Loads finish on the background thread and are restored by the next update
+		streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+		streamer.wait();
+		const auto stats = streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+		EXPECT_EQ(stats.resident_regions, 24u);
+		EXPECT_EQ(streamer.stored_entities(), 0u);
+		EXPECT_EQ(records(registry), initial);
+
+		// Files are removed by the background thread after their entities were restored
+		streamer.wait();
+		EXPECT_TRUE(std::filesystem::is_empty(directory));
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+TEST(region_streamer_test, truncated_file_fails_load)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "region_streamer_truncated_test";
+	std::filesystem::remove_all(directory);
+
+	stream_registry registry;
+	populate(registry);
+	const auto initial = records(registry);
+	{
+		test_streamer streamer(spatial::face_partition(1), 1000.0, c_loadDistance, c_unloadDistance, directory);
+		streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position);
+		streamer.wait();
+
+		const std::filesystem::path path = directory / "region_2_0.bin";
+		std::vector<char> bytes(std::filesystem::file_size(path));
+		std::ifstream(path, std::ios::binary).read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		std::filesystem::resize_file(path, bytes.size() - 1);
+
+		streamer.update<location>(registry, glm::dvec3(-1100, 0, 0), &location::position);
+		streamer.wait();
+		auto stats = streamer.update<location>(registry, glm::dvec3(-1100, 0, 0), &location::position);
+		EXPECT_EQ(stats.failed, 1u);
+		EXPECT_EQ(stats.loaded, 0u);
+		EXPECT_TRUE(streamer.failed(2));
+		EXPECT_TRUE(std::filesystem::exists(path));
+		EXPECT_EQ(streamer.stored_entities(), initial.size());
+
+		// The load is not repeated while the focus stays in the region
+		streamer.wait();
+		EXPECT_EQ(streamer.update<location>(registry, glm::dvec3(-1100, 0, 0), &location::position).failed, 0u);
+
+		std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position);
+		EXPECT_FALSE(streamer.failed(2));
+		streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+		streamer.wait();
+		stats = streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+		EXPECT_EQ(stats.resident_regions, 6u);
+		EXPECT_EQ(records(registry), initial);
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+TEST(region_streamer_test, destroying_keeps_queued_loads)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "region_streamer_destroy_test";
+	std::filesystem::remove_all(directory);
+
+	stream_registry registry;
+	populate(registry);
+	{
+		test_streamer streamer(spatial::face_partition(1), 1000.0, c_loadDistance, c_unloadDistance, directory);
+		streamer.update<location>(registry, glm::dvec3(1100, 0, 0), &location::position);
+		streamer.wait();
+
+		// Queue the loads of every stored region and destroy the streamer before they are restored
+		streamer.update<location>(registry, glm::dvec3(0.0), &location::position);
+	}
+
+	const auto files = std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator());
+	EXPECT_EQ(files, 5);
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "registry.hpp"
+#include "sharded_world.hpp"
+
+struct craft
+{
+	glm::dvec3 position;
+	int fuel;
+};
+
+using shard_registry = ecs::registry<
+	ecs::component<craft, 1024>>;
+
+TEST(sharded_world_test, face_partition_regions)
+{
+	EXPECT_EQ(spatial::face_partition(0).count(), 1u);
+	EXPECT_EQ(spatial::face_partition(1).count(), 6u);
+	EXPECT_EQ(spatial::face_partition(2).count(), 24u);
+
+	const spatial::face_partition faces(1);
+	EXPECT_EQ(faces(glm::dvec3(1, 0, 0)), 0u);
+	EXPECT_EQ(faces(glm::dvec3(0, -1, 0)), 1u);
+	EXPECT_EQ(faces(glm::dvec3(0, 0, -1)), 5u);
+
+	// Face 0 uses y along u and z along v, cells are numbered row by row
+	const spatial::face_partition cells(2);
+	EXPECT_EQ(cells(glm::dvec3(1, -0.5, -0.5)), 0u);
+	EXPECT_EQ(cells(glm::dvec3(1, 0.5, -0.5)), 1u);
+	EXPECT_EQ(cells(glm::dvec3(1, -0.5, 0.5)), 2u);
+	EXPECT_EQ(cells(glm::dvec3(-1, 0.5, 0.5)), 11u);
+	EXPECT_EQ(cells(glm::dvec3(0, 0, -1)), 23u);
+}
+
+TEST(sharded_world_test, migrate_between_shards)
+{
+	spatial::sharded_world<shard_registry> world(spatial::face_partition(1));
+	ASSERT_EQ(world.shard_count(), 6u);
+
+	std::vector<spatial::world_entity> entities;
+	std::vector<ecs::entity> locals;
+	for(int i = 0; i < 6; i++)
+	{
+		glm::dvec3 position(0.0);
+		position[spatial::c_faceFrames[i].axis] = spatial::c_faceFrames[i].sign * 1000.0;
+		const auto [entity, local] = world.create(position);
+		world.shard(world.locate(entity)->shard).addComponent<craft>(local, craft{position, i});
+		entities.push_back(entity);
+		locals.push_back(local);
+		EXPECT_EQ(world.locate(entity)->shard, static_cast<size_t>(i));
+	}
+
+	// Every shard moves its craft onto the next face
+	std::atomic<int> visited = 0;
+	world.each_shard([&](shard_registry& a_registry, size_t a_shard)
+	{
+		visited++;
+		a_registry.getComponentsOfType<craft>().each([a_shard](ecs::entity, craft& a_craft)
+		{
+			const size_t next = (a_shard + 1) % spatial::c_faceCount;
+			a_craft.position = glm::dvec3(0.0);
+			a_craft.position[spatial::c_faceFrames[next].axis] = spatial::c_faceFrames[next].sign * 1000.0;
+		});
+	});
+	EXPECT_EQ(visited, 6);
+
+	EXPECT_EQ(world.end_frame<craft>(&craft::position), 6u);
+	EXPECT_EQ(world.size(), 6u);
+	for(int i = 0; i < 6; i++)
+	{
+		const auto* location = world.locate(entities[i]);
+		ASSERT_NE(location, nullptr);
+		EXPECT_EQ(location->shard, static_cast<size_t>((i + 1) % spatial::c_faceCount));
+		EXPECT_EQ(world.shard(location->shard).getComponent<craft>(location->entity)->fuel, i);
+		EXPECT_EQ(world.global(location->shard, location->entity).id, entities[i].id);
+		EXPECT_EQ(world.shard(location->shard).getComponentsOfType<craft>().size(), 1u);
+
+		// The local entity left behind no longer maps to the world entity
+		EXPECT_EQ(world.global(i, locals[i]).id, spatial::world_entity::invalid);
+	}
+
+	EXPECT_EQ(world.end_frame<craft>(&craft::position), 0u);
+
+	const auto removed = *world.locate(entities[2]);
+	world.remove(entities[2]);
+	EXPECT_EQ(world.locate(entities[2]), nullptr);
+	EXPECT_EQ(world.global(removed.shard, removed.entity).id, spatial::world_entity::invalid);
+	EXPECT_EQ(world.size(), 5u);
+}
+
+TEST(sharded_world_test, migrate_sleeping_entities)
+{
+	spatial::sharded_world<shard_registry> world(spatial::face_partition(1));
+	const auto [entity, local] = world.create(glm::dvec3(1000, 0, 0));
+	world.shard(0).addComponent<craft>(local, craft{glm::dvec3(0, 0, 1000), 3});
+	world.shard(0).sleep(local);
+
+	EXPECT_EQ(world.end_frame<craft>(&craft::position), 1u);
+	const auto* location = world.locate(entity);
+	ASSERT_NE(location, nullptr);
+	EXPECT_EQ(location->shard, 4u);
+	EXPECT_TRUE(world.shard(4).isSleeping(location->entity));
+	EXPECT_EQ(world.global(0, local).id, spatial::world_entity::invalid);
+	EXPECT_EQ(world.global(4, location->entity).id, entity.id);
+}
+
+TEST(sharded_world_test, nested_parallel_queries)
+{
+	spatial::sharded_world<shard_registry> world(spatial::face_partition(1));
+	for(int i = 0; i < 6; i++)
+	{
+		for(int j = 0; j < 1000; j++)
+		{
+			glm::dvec3 position(0.0);
+			position[spatial::c_faceFrames[i].axis] = spatial::c_faceFrames[i].sign * 1000.0;
+			const auto [entity, local] = world.create(position);
+			world.shard(i).addComponent<craft>(local, craft{position, 1});
+		}
+	}
+
+	// Systems reduce over their shard on the pool that runs the shards
+	ecs::thread_pool pool(3);
+	std::atomic<int> fuel = 0;
+	world.each_shard([&](shard_registry& a_registry, size_t)
+	{
+		fuel += a_registry.reduce<craft>(pool, 0,
+			[](const craft& a_craft) { return a_craft.fuel; },
+			[](int a, int b) { return a + b; });
+	}, pool);
+	EXPECT_EQ(fuel, 6000);
+}
+
+TEST(sharded_world_test, deferred_commands_follow_migration)
+{
+	spatial::sharded_world<shard_registry> world(spatial::face_partition(1));
+	const auto [target, local] = world.create(glm::dvec3(1000, 0, 0));
+	world.shard(0).addComponent<craft>(local, craft{glm::dvec3(1000, 0, 0), 10});
+
+	// A system on face 4 refuels the craft that leaves face 0 in the same frame
+	world.each_shard([&, target = target](shard_registry& a_registry, size_t a_shard)
+	{
+		if(a_shard == 0)
+		{
+			a_registry.getComponentsOfType<craft>().each([](ecs::entity, craft& a_craft) { a_craft.position = glm::dvec3(0, 0, 1000); });
+		}
+		else if(a_shard == 4)
+		{
+			world.defer(a_shard, target, [](shard_registry& a_owner, ecs::entity a_entity) { a_owner.getComponent<craft>(a_entity)->fuel += 5; });
+		}
+	});
+
+	EXPECT_EQ(world.end_frame<craft>(&craft::position), 1u);
+	const auto* location = world.locate(target);
+	ASSERT_NE(location, nullptr);
+	EXPECT_EQ(location->shard, 4u);
+	EXPECT_EQ(world.shard(4).getComponent<craft>(location->entity)->fuel, 15);
+
+	// Commands are applied once
+	world.end_frame<craft>(&craft::position);
+	EXPECT_EQ(world.shard(4).getComponent<craft>(location->entity)->fuel, 15);
+}
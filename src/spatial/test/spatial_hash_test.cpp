@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "spatial_hash.hpp"
+
+struct transform
+{
+	glm::dvec3 position;
+};
+
+using test_registry = ecs::registry<
+	ecs::component<transform, 256>>;
+
+static std::vector<size_t> sorted_ids(const std::vector<ecs::entity>& a_entities)
+{
+	std::vector<size_t> result;
+	for(ecs::entity value : a_entities)
+	{
+		result.push_back(value.id());
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static std::vector<size_t> brute_force_radius(test_registry& a_registry, const glm::dvec3& a_center, double a_radius)
+{
+	std::vector<ecs::entity> result;
+	a_registry.getComponentsOfType<transform>().each([&](ecs::entity a_entity, transform& a_transform)
+	{
+		const glm::dvec3 offset = a_transform.position - a_center;
+		if(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= a_radius * a_radius)
+		{
+			result.push_back(a_entity);
+		}
+	});
+
+	return sorted_ids(result);
+}
+
+TEST(spatial_hash_test, update_and_erase)
+{
+	test_registry registry;
+	spatial::spatial_hash index(1000.0);
+
+	const ecs::entity a = registry.createEntity();
+	const ecs::entity b = registry.createEntity();
+	index.update(a, glm::dvec3(10, 10, 10));
+	index.update(b, glm::dvec3(-10, 10, 10));
+	EXPECT_EQ(index.size(), 2);
+	EXPECT_EQ(index.cell_count(), 2);
+
+	// Moving inside a cell keeps the cell, moving across a border changes it
+	index.update(a, glm::dvec3(900, 10, 10));
+	EXPECT_EQ(index.cell_count(), 2);
+	index.update(a, glm::dvec3(-900, 10, 10));
+	EXPECT_EQ(index.cell_count(), 1);
+	EXPECT_EQ(*index.position(a), glm::dvec3(-900, 10, 10));
+
+	std::vector<ecs::entity> found;
+	index.query_radius(glm::dvec3(-900, 0, 10), 15.0, found);
+	EXPECT_EQ(sorted_ids(found), std::vector<size_t>{a.id()});
+
+	EXPECT_TRUE(index.erase(a));
+	EXPECT_FALSE(index.erase(a));
+	EXPECT_FALSE(index.contains(a));
+	EXPECT_EQ(index.position(a), nullptr);
+	EXPECT_EQ(*index.position(b), glm::dvec3(-10, 10, 10));
+	EXPECT_EQ(index.size(), 1);
+}
+
+TEST(spatial_hash_test, positions_outside_extent)
+{
+	test_registry registry;
+	spatial::spatial_hash index(1.0);
+	EXPECT_DOUBLE_EQ(index.extent(), 1048576.0);
+
+	// Both positions fold into the same border cell but queries stay exact
+	const ecs::entity near = registry.createEntity();
+	const ecs::entity far = registry.createEntity();
+	index.update(near, glm::dvec3(2e6, 0, 0));
+	index.update(far, glm::dvec3(1e30, 0, 0));
+	EXPECT_EQ(index.cell_count(), 1);
+
+	std::vector<ecs::entity> found;
+	index.query_radius(glm::dvec3(2e6, 0, 0), 1.0, found);
+	EXPECT_EQ(sorted_ids(found), std::vector<size_t>{near.id()});
+}
+
+TEST(spatial_hash_test, queries_match_brute_force)
+{
+	test_registry registry;
+	spatial::spatial_hash index(500.0);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> coordinate(-4000.0, 4000.0);
+
+	for(int i = 0; i < 200; i++)
+	{
+		const ecs::entity entity = registry.createEntity();
+		registry.addComponent<transform>(entity, transform{glm::dvec3(coordinate(random), coordinate(random), coordinate(random))});
+	}
+
+	for(int step = 0; step < 3; step++)
+	{
+		// Move every entity, some of them across cell borders
+		registry.getComponentsOfType<transform>().each([&](ecs::entity, transform& a_transform)
+		{
+			a_transform.position += glm::dvec3(coordinate(random), coordinate(random), coordinate(random)) * 0.1;
+		});
+		index.synchronize<transform>(registry, &transform::position);
+		ASSERT_EQ(index.size(), 200);
+
+		std::vector<glm::dvec3> centers;
+		for(int q = 0; q < 20; q++)
+		{
+			centers.emplace_back(coordinate(random), coordinate(random), coordinate(random));
+		}
+
+		for(double radius : {100.0, 1200.0, 20000.0})
+		{
+			std::vector<std::vector<ecs::entity>> batch;
+			index.query_radius(centers, radius, batch);
+			ASSERT_EQ(batch.size(), centers.size());
+			for(size_t q = 0; q < centers.size(); q++)
+			{
+				std::vector<ecs::entity> found;
+				index.query_radius(centers[q], radius, found);
+				EXPECT_EQ(sorted_ids(found), brute_force_radius(registry, centers[q], radius));
+				EXPECT_EQ(sorted_ids(batch[q]), sorted_ids(found));
+			}
+		}
+	}
+
+	const glm::dvec3 min(-1000, -2000, -500);
+	const glm::dvec3 max(1500, 300, 2500);
+	std::vector<ecs::entity> expected;
+	registry.getComponentsOfType<transform>().each([&](ecs::entity a_entity, transform& a_transform)
+	{
+		const glm::dvec3& p = a_transform.position;
+		if(p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z)
+		{
+			expected.push_back(a_entity);
+		}
+	});
+
+	std::vector<ecs::entity> found;
+	index.query_box(min, max, found);
+	EXPECT_EQ(sorted_ids(found), sorted_ids(expected));
+}
+
+TEST(spatial_hash_test, synchronize)
+{
+	test_registry registry;
+	spatial::spatial_hash index(100.0);
+
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 10; i++)
+	{
+		const ecs::entity entity = registry.createEntity();
+		registry.addComponent<transform>(entity, transform{glm::dvec3(i * 50.0, 0, 0)});
+		entities.push_back(entity);
+	}
+
+	index.synchronize<transform>(registry, &transform::position);
+	EXPECT_EQ(index.size(), 10);
+
+	// Sleeping entities stay indexed, removed components are dropped
+	registry.sleep(entities[2]);
+	registry.removeComponent<transform>(entities[5]);
+	registry.removeEntity(entities[7]);
+	index.synchronize<transform>(registry, [](const transform& a_transform) { return a_transform.position * 2.0; });
+	EXPECT_EQ(index.size(), 8);
+	EXPECT_TRUE(index.contains(entities[2]));
+	EXPECT_FALSE(index.contains(entities[5]));
+	EXPECT_FALSE(index.contains(entities[7]));
+	EXPECT_EQ(*index.position(entities[9]), glm::dvec3(900, 0, 0));
+
+	std::vector<ecs::entity> found;
+	index.query_radius(glm::dvec3(500, 0, 0), 150.0, found);
+	EXPECT_EQ(sorted_ids(found), sorted_ids({entities[4], entities[6]}));
+}
+
+TEST(spatial_hash_test, compaction)
+{
+	test_registry registry;
+	spatial::spatial_hash index(1.0);
+	const ecs::entity entity = registry.createEntity();
+
+	// Every update leaves an empty cell behind until the index compacts
+	for(int i = 0; i < 50000; i++)
+	{
+		index.update(entity, glm::dvec3(i, 0, 0));
+	}
+
+	EXPECT_EQ(index.cell_count(), 1);
+	EXPECT_LT(index.bytes_reserved(), 256 * 1024);
+
+	std::vector<ecs::entity> found;
+	index.query_radius(glm::dvec3(49999, 0, 0), 0.5, found);
+	EXPECT_EQ(found.size(), 1);
+}
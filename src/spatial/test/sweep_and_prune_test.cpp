@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "registry.hpp"
+#include "sweep_and_prune.hpp"
+
+struct body
+{
+	glm::dvec3 position;
+	double radius;
+
+	spatial::aabb bounds() const { return spatial::aabb::around(position, radius); }
+};
+
+using test_registry = ecs::registry<
+	ecs::component<body, 1024>>;
+
+static std::vector<spatial::contact> brute_force_pairs(test_registry& a_registry)
+{
+	std::vector<std::pair<ecs::entity, spatial::aabb>> boxes;
+	a_registry.getComponentsOfType<body>().each([&](ecs::entity a_entity, body& a_body) { boxes.emplace_back(a_entity, a_body.bounds()); });
+
+	std::vector<spatial::contact> result;
+	for(size_t i = 0; i < boxes.size(); i++)
+	{
+		for(size_t j = i + 1; j < boxes.size(); j++)
+		{
+			if(boxes[i].second.overlaps(boxes[j].second))
+			{
+				const ecs::entity a = boxes[i].first;
+				const ecs::entity b = boxes[j].first;
+				result.push_back(a.id() < b.id() ? spatial::contact{a, b} : spatial::contact{b, a});
+			}
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static std::vector<spatial::contact> difference(const std::vector<spatial::contact>& a_first, const std::vector<spatial::contact>& a_second)
+{
+	std::vector<spatial::contact> result;
+	std::set_difference(a_first.begin(), a_first.end(), a_second.begin(), a_second.end(), std::back_inserter(result));
+	return result;
+}
+
+// Bodies on a sphere so the face variant sees pairs across face edges
+template <typename Broadphase>
+static void check_against_brute_force(Broadphase& a_broadphase)
+{
+	test_registry registry;
+	std::mt19937 random(11);
+	std::normal_distribution<double> normal;
+	std::uniform_real_distribution<double> size(5.0, 40.0);
+	std::vector<ecs::entity> entities;
+	for(int i = 0; i < 600; i++)
+	{
+		const glm::dvec3 up = glm::normalize(glm::dvec3(normal(random), normal(random), normal(random)));
+		entities.push_back(registry.createEntity());
+		registry.addComponent<body>(entities.back(), body{up * 1000.0, size(random)});
+	}
+
+	std::vector<spatial::contact> previous;
+	for(int step = 0; step < 6; step++)
+	{
+		registry.getComponentsOfType<body>().each([&](ecs::entity, body& a_body)
+		{
+			a_body.position += glm::dvec3(normal(random), normal(random), normal(random)) * 8.0;
+		});
+
+		// Remove and spawn a few bodies between ticks
+		if(step % 2 == 1)
+		{
+			registry.removeEntity(entities[step]);
+			registry.addComponent<body>(registry.createEntity(), body{glm::dvec3(0, 0, 1000), 30.0});
+		}
+
+		a_broadphase.template synchronize<body>(registry, &body::bounds);
+		a_broadphase.find_pairs();
+
+		const auto expected = brute_force_pairs(registry);
+		EXPECT_EQ(a_broadphase.pairs(), expected);
+		EXPECT_EQ(a_broadphase.entered(), difference(expected, previous));
+		EXPECT_EQ(a_broadphase.exited(), difference(previous, expected));
+		previous = expected;
+	}
+}
+
+TEST(sweep_and_prune_test, matches_brute_force)
+{
+	spatial::sweep_and_prune broadphase(1);
+	check_against_brute_force(broadphase);
+}
+
+TEST(sweep_and_prune_test, faces_match_brute_force)
+{
+	spatial::face_sweep_and_prune broadphase;
+	check_against_brute_force(broadphase);
+}
+
+TEST(sweep_and_prune_test, events)
+{
+	test_registry registry;
+	spatial::sweep_and_prune broadphase;
+	const ecs::entity a = registry.createEntity();
+	const ecs::entity b = registry.createEntity();
+
+	broadphase.update(a, spatial::aabb::around(glm::dvec3(0, 0, 0), 1.0));
+	broadphase.update(b, spatial::aabb::around(glm::dvec3(5, 0, 0), 1.0));
+	broadphase.find_pairs();
+	EXPECT_TRUE(broadphase.pairs().empty());
+
+	broadphase.update(b, spatial::aabb::around(glm::dvec3(1.5, 0, 0), 1.0));
+	broadphase.find_pairs();
+	ASSERT_EQ(broadphase.entered().size(), 1);
+	EXPECT_EQ(broadphase.entered()[0].first.id(), a.id());
+	EXPECT_EQ(broadphase.entered()[0].second.id(), b.id());
+	EXPECT_TRUE(broadphase.exited().empty());
+
+	// Staying in contact reports no events
+	broadphase.update(b, spatial::aabb::around(glm::dvec3(-1.5, 0, 0), 1.0));
+	broadphase.find_pairs();
+	EXPECT_EQ(broadphase.pairs().size(), 1);
+	EXPECT_TRUE(broadphase.entered().empty());
+	EXPECT_TRUE(broadphase.exited().empty());
+
+	EXPECT_TRUE(broadphase.erase(a));
+	broadphase.find_pairs();
+	EXPECT_TRUE(broadphase.pairs().empty());
+	ASSERT_EQ(broadphase.exited().size(), 1);
+	EXPECT_EQ(broadphase.exited()[0].first.id(), a.id());
+	EXPECT_EQ(broadphase.size(), 1);
+}
+
+TEST(sweep_and_prune_test, quadsphere_faces)
+{
+	EXPECT_EQ(spatial::face_of(glm::dvec3(1, 0, 0)), 0);
+	EXPECT_EQ(spatial::face_of(glm::dvec3(0, -1, 0)), 1);
+	EXPECT_EQ(spatial::face_of(glm::dvec3(-1, 0, 0)), 2);
+	EXPECT_EQ(spatial::face_of(glm::dvec3(0, 1, 0)), 3);
+	EXPECT_EQ(spatial::face_of(glm::dvec3(0, 0, 1)), 4);
+	EXPECT_EQ(spatial::face_of(glm::dvec3(0, 0, -1)), 5);
+
+	EXPECT_EQ(spatial::faces_touching(spatial::aabb::around(glm::dvec3(10, 2, -3), 1.0)), 1u << 0);
+	EXPECT_EQ(spatial::faces_touching(spatial::aabb::around(glm::dvec3(10, 10, 0), 1.0)), (1u << 0) | (1u << 3));
+	EXPECT_EQ(spatial::faces_touching(spatial::aabb::around(glm::dvec3(0, 0, 0), 1.0)), 63u);
+}